@@ -11,8 +11,8 @@ class MythBackend {
 
 // MYTH_PROTO_VERSION is defined in libmyth in mythtv/libs/libmyth/mythcontext.h
 // and should be the current MythTV protocol version.
-    static $protocol_version        = '75';
-    static $protocol_token          = 'SweetRock';
+    static $protocol_version        = '76';
+    static $protocol_token          = 'FireWilde';
 
 // The character string used by the backend to separate records
     static $backend_separator       = '[]:[]';
@@ -0,0 +1,211 @@
+/*
+ * Benchmark for the image kernels used by the mythcommflag
+ * CannyEdgeDetector:
+ *
+ *  convolve: pgm_convolve_radial() with the Gaussian mask of
+ *            CannyEdgeDetector
+ *  sgm:      sgm_init_exclude()
+ *  edges:    edge_mark_uniform_exclude()
+ *
+ * It is built from mythcommflag's own pgm.cpp and EdgeDetector.cpp and
+ * runs them as CannyEdgeDetector::detectEdges() does, over the luma plane
+ * of every frame of a raw YUV 4:2:0 file.  Make such a file from a
+ * recording with
+ *
+ *   ffmpeg -i recording.ts -t 60 -f rawvideo -pix_fmt yuv420p frames.yuv
+ *
+ * With -s the kernels are made to take their scalar paths.  A checksum of
+ * every output is printed, run it with and without -s, or built from the
+ * sources to be compared, and the checksums have to match.
+ *
+ * compile with
+ *   S=../../..; C=$S/programs/mythcommflag
+ *   g++ -O2 -I$C -I$S/libs/libmythtv -I$S/libs/libmythbase \
+ *       -I$S/libs/libmyth -I$S/libs/libmythui -I$S/external/FFmpeg \
+ *       -I$S $(pkg-config --cflags QtCore QtGui) \
+ *       -o commflagbench commflagbench.cpp $C/pgm.cpp $C/EdgeDetector.cpp \
+ *       -L$S/libs/libmythtv -lmythtv-0.26 \
+ *       -L$S/external/FFmpeg/libavcodec -lmythavcodec \
+ *       -L$S/external/FFmpeg/libavutil -lmythavutil \
+ *       -L$S/libs/libmythbase -lmythbase-0.26 \
+ *       $(pkg-config --libs QtCore QtGui)
+ * usage: commflagbench [-s] <frames.yuv> <width> <height> [percentile]
+ *
+ * Run it with LD_LIBRARY_PATH pointing at the libraries it was linked
+ * against.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <algorithm>
+#include <vector>
+
+extern "C" {
+#include "libavcodec/avcodec.h"
+#include "libavutil/cpu.h"
+}
+
+#include "pgm.h"
+#include "EdgeDetector.h"
+
+static double now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+/* The mask CannyEdgeDetector computes for sigma = 0.5 */
+static int make_mask(double *mask)
+{
+    const double sigma = 0.5;
+    const double two_sigma2 = 2 * sigma * sigma;
+    const int radius = std::max(2, (int)roundf(4 * sigma));
+    double sum = 1.0;
+    mask[radius] = 1.0;
+    for (int rr = 1; rr <= radius; rr++)
+    {
+        double val = exp(-(rr * rr) / two_sigma2);
+        mask[radius + rr] = val;
+        mask[radius - rr] = val;
+        sum += 2 * val;
+    }
+    for (int ii = 0; ii < 2 * radius + 1; ii++)
+        mask[ii] /= sum;
+    return radius;
+}
+
+/* FNV-1a, to compare the outputs of separate runs */
+static uint64_t checksum(uint64_t hash, const void *data, size_t len)
+{
+    const unsigned char *ptr = (const unsigned char *)data;
+    for (size_t ii = 0; ii < len; ii++)
+    {
+        hash ^= ptr[ii];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-s] <frames.yuv> <width> <height> "
+            "[percentile]\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+    int arg = 1;
+    bool scalar = false;
+    if (arg < argc && !strcmp(argv[arg], "-s"))
+    {
+        scalar = true;
+        arg++;
+    }
+    if (argc - arg < 3)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    const char *filename = argv[arg];
+    const int width = atoi(argv[arg + 1]);
+    const int height = atoi(argv[arg + 2]);
+    const int percentile = (argc - arg > 3) ? atoi(argv[arg + 3]) : 85;
+    if (width < 16 || height < 16 || percentile < 0 || percentile > 99)
+    {
+        fprintf(stderr, "%s: bad dimensions or percentile\n", argv[0]);
+        return 1;
+    }
+
+    /* pgm_use_sse2() looks at the CPU flags once, on its first call */
+    if (scalar)
+        av_force_cpu_flags(0);
+
+    FILE *f = fopen(filename, "rb");
+    if (!f)
+    {
+        perror(filename);
+        return 1;
+    }
+
+    double mask[16];
+    const int radius = make_mask(mask);
+    const int pw = width + 2 * radius;
+    const int ph = height + 2 * radius;
+    const size_t framesize = (size_t)width * height * 3 / 2;
+
+    AVPicture s1, s2, convolved, edges;
+    if (avpicture_alloc(&s1, PIX_FMT_GRAY8, pw, ph) ||
+        avpicture_alloc(&s2, PIX_FMT_GRAY8, pw, ph) ||
+        avpicture_alloc(&convolved, PIX_FMT_GRAY8, pw, ph) ||
+        avpicture_alloc(&edges, PIX_FMT_GRAY8, width, height))
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    std::vector<unsigned int> sgm(pw * ph), sgmsorted(width * height);
+    std::vector<unsigned char> frame(framesize);
+
+    double t[3] = { 0, 0, 0 };
+    uint64_t sums[3] = { 14695981039346656037ULL, 14695981039346656037ULL,
+                         14695981039346656037ULL };
+    long frames = 0, failures = 0;
+
+    while (fread(&frame[0], 1, framesize, f) == framesize)
+    {
+        AVPicture pgm;
+        memset(&pgm, 0, sizeof(pgm));
+        pgm.data[0] = &frame[0];
+        pgm.linesize[0] = width;
+
+        double t0 = now();
+        int ret = pgm_convolve_radial(&convolved, &s1, &s2, &pgm, height,
+                                      mask, radius);
+        double t1 = now();
+        edgeDetector::sgm_init_exclude(&sgm[0], &convolved, ph,
+                                       radius, radius, 0, 0);
+        double t2 = now();
+        ret |= edgeDetector::edge_mark_uniform_exclude(
+            &edges, height, radius, &sgm[0], &sgmsorted[0], percentile,
+            0, 0, 0, 0);
+        double t3 = now();
+
+        if (ret)
+            failures++;
+        t[0] += t1 - t0;
+        t[1] += t2 - t1;
+        t[2] += t3 - t2;
+        sums[0] = checksum(sums[0], convolved.data[0], pw * ph);
+        sums[1] = checksum(sums[1], &sgm[0], sgm.size() * sizeof(sgm[0]));
+        sums[2] = checksum(sums[2], edges.data[0], width * height);
+        frames++;
+    }
+    fclose(f);
+
+    avpicture_free(&edges);
+    avpicture_free(&convolved);
+    avpicture_free(&s2);
+    avpicture_free(&s1);
+
+    if (!frames)
+    {
+        fprintf(stderr, "%s: no complete %dx%d frames\n", filename,
+                width, height);
+        return 1;
+    }
+
+    printf("%ld frames of %dx%d, %s kernels, %ld failed\n", frames,
+           width, height, pgm_use_sse2() ? "SSE2" : "scalar", failures);
+    const char *names[3] = { "convolve", "sgm", "edges" };
+    for (int ii = 0; ii < 3; ii++)
+    {
+        printf("%-9s %8.3f ms/frame  checksum %016llx\n", names[ii],
+               t[ii] * 1000 / frames, (unsigned long long)sums[ii]);
+    }
+    return failures ? 2 : 0;
+}
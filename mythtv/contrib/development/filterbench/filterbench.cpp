@@ -0,0 +1,414 @@
+/*
+ * Benchmark and exactness check for the instruction set specific code
+ * paths of the deinterlacing filters:
+ *
+ *  yadifdeint:   the C, MMX2 and SSE2 versions of filter_line
+ *  greedyhdeint: the MMX, 3DNow and SSE (integer SSE) versions, it has
+ *                no C or SSE2 version
+ *  kerneldeint:  the C, MMX and SSE2 line filters
+ *
+ * The filter plugins are loaded as MythTV loads them, and one instance of
+ * each filter is created per code path, with av_force_cpu_flags() making
+ * the filter pick that path.  Every instance deinterlaces both fields of
+ * the same frames, and each output is compared byte for byte with the one
+ * of the first path.  Paths the CPU does not have are skipped.
+ *
+ * The frames are synthetic, noise with moving edges, unless a raw YUV
+ * 4:2:0 file is given.  Make one from a 1080i recording with
+ *
+ *   ffmpeg -i recording.ts -t 10 -f rawvideo -pix_fmt yuv420p frames.yuv
+ *
+ * The greedyh paths are not expected to match exactly, its MMX and 3DNow
+ * versions round differently from the SSE one.
+ *
+ * compile with
+ *   g++ -O2 -I../../../libs/libmythtv -I../../../libs/libmythbase \
+ *       -I../../../external/FFmpeg \
+ *       -o filterbench filterbench.cpp -ldl
+ * usage: filterbench [-f frames.yuv] [-s WIDTHxHEIGHT] [-n frames]
+ *                    <libyadifdeint.so|libgreedyhdeint.so|libkerneldeint.so>...
+ *
+ * Run it with LD_LIBRARY_PATH pointing at the libmythavutil the filters
+ * were linked against.
+ */
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "filter.h"
+
+/* From libavutil/cpu.h, the filters link against the bundled copy */
+#define AV_CPU_FLAG_MMX          0x0001
+#define AV_CPU_FLAG_MMX2         0x0002
+#define AV_CPU_FLAG_3DNOW        0x0004
+#define AV_CPU_FLAG_SSE          0x0008
+#define AV_CPU_FLAG_SSE2         0x0010
+
+typedef void (*force_cpu_flags_fn)(int flags);
+typedef int  (*get_cpu_flags_fn)(void);
+
+struct Path
+{
+    const char *name;
+    int         flags;
+};
+
+static const Path kYadifPaths[] =
+{
+    { "C",     0 },
+    { "MMX2",  AV_CPU_FLAG_MMX | AV_CPU_FLAG_MMX2 },
+    { "SSE2",  AV_CPU_FLAG_MMX | AV_CPU_FLAG_MMX2 |
+               AV_CPU_FLAG_SSE | AV_CPU_FLAG_SSE2 },
+    { NULL,    0 },
+};
+
+static const Path kGreedyHPaths[] =
+{
+    { "MMX",   AV_CPU_FLAG_MMX },
+    { "3DNow", AV_CPU_FLAG_MMX | AV_CPU_FLAG_3DNOW },
+    { "SSE",   AV_CPU_FLAG_MMX | AV_CPU_FLAG_MMX2 | AV_CPU_FLAG_SSE },
+    { NULL,    0 },
+};
+
+static const Path kKernelPaths[] =
+{
+    { "C",     0 },
+    { "MMX",   AV_CPU_FLAG_MMX },
+    { "SSE2",  AV_CPU_FLAG_MMX | AV_CPU_FLAG_SSE | AV_CPU_FLAG_SSE2 },
+    { NULL,    0 },
+};
+
+struct Instance
+{
+    const char    *name;
+    VideoFilter   *filter;
+    unsigned char *buf;
+    double         seconds;
+    long long      mismatches;      /* differing bytes */
+    int            badframes;       /* outputs with any differing byte */
+    int            maxdiff;
+};
+
+static double now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static unsigned char *alloc_frame(size_t size)
+{
+    void *buf = NULL;
+    /* The filters read a little past the end of the last line */
+    if (posix_memalign(&buf, 64, size + 64))
+        return NULL;
+    memset(buf, 0, size + 64);
+    return (unsigned char *)buf;
+}
+
+/* Noise with edges at several angles that move from frame to frame, so
+ * yadif's spatial and temporal checks and greedyh's motion search all
+ * have something to do. */
+static void make_synthetic(unsigned char *buf, int width, int height,
+                           int frameno)
+{
+    unsigned int seed = 12345 + frameno * 7919;
+    unsigned char *y = buf;
+    for (int row = 0; row < height; row++)
+    {
+        for (int col = 0; col < width; col++)
+        {
+            seed = seed * 1103515245 + 12345;
+            int noise = (seed >> 16) & 0x1f;
+            int edge1 = ((col + row + frameno * 6) / 24) & 1;
+            int edge2 = ((col * 3 - row + frameno * 4) / 40) & 1;
+            int edge3 = ((row + frameno * 2) / 16) & 1;
+            y[row * width + col] =
+                16 + noise + edge1 * 90 + edge2 * 60 + edge3 * 40;
+        }
+    }
+
+    unsigned char *u = buf + width * height;
+    unsigned char *v = u + (width / 2) * (height / 2);
+    for (int row = 0; row < height / 2; row++)
+    {
+        for (int col = 0; col < width / 2; col++)
+        {
+            u[row * (width / 2) + col] =
+                128 + (((col + frameno * 3) / 12) & 1) * 40 - 20;
+            v[row * (width / 2) + col] =
+                128 + (((row + col / 2) / 10) & 1) * 30 - 15;
+        }
+    }
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-f frames.yuv] [-s WIDTHxHEIGHT] "
+            "[-n frames] <filter.so>...\n", prog);
+}
+
+static bool bench_plugin(const char *path, force_cpu_flags_fn force_flags,
+                         int cpu_flags,
+                         const std::vector<unsigned char*> &frames,
+                         int width, int height)
+{
+    void *handle = dlopen(path, RTLD_NOW | RTLD_GLOBAL);
+    if (!handle)
+    {
+        fprintf(stderr, "%s\n", dlerror());
+        return false;
+    }
+
+    FilterInfo *info = (FilterInfo *)dlsym(handle, "filter_table");
+    if (!info || !info->name)
+    {
+        fprintf(stderr, "%s: no filter_table\n", path);
+        return false;
+    }
+
+    const Path *paths = NULL;
+    if (!strcmp(info->name, "yadifdeint"))
+        paths = kYadifPaths;
+    else if (!strcmp(info->name, "greedyhdeint"))
+        paths = kGreedyHPaths;
+    else if (!strcmp(info->name, "kerneldeint"))
+        paths = kKernelPaths;
+    else
+    {
+        fprintf(stderr, "%s: don't know the code paths of %s\n",
+                path, info->name);
+        return false;
+    }
+
+    const size_t framesize = (size_t)width * height * 3 / 2;
+    std::vector<Instance> instances;
+    for (; paths->name; paths++)
+    {
+        if ((paths->flags & cpu_flags) != paths->flags)
+        {
+            printf("%-14s %-6s skipped, not supported by this CPU\n",
+                   info->name, paths->name);
+            continue;
+        }
+
+        Instance inst;
+        memset(&inst, 0, sizeof(inst));
+        inst.name = paths->name;
+
+        /* The filters choose their code path when they are created */
+        force_flags(paths->flags);
+        int w = width, h = height;
+        inst.filter = info->filter_init(FMT_YV12, FMT_YV12, &w, &h,
+                                        (char *)"", 1);
+        force_flags(-1);
+        if (!inst.filter)
+        {
+            fprintf(stderr, "%s: could not create %s\n", path, paths->name);
+            return false;
+        }
+        inst.filter->handle = handle;
+        inst.filter->inpixfmt = FMT_YV12;
+        inst.filter->outpixfmt = FMT_YV12;
+        inst.filter->info = info;
+        inst.filter->slices = NULL;
+
+        inst.buf = alloc_frame(framesize);
+        if (!inst.buf)
+        {
+            fprintf(stderr, "out of memory\n");
+            return false;
+        }
+        instances.push_back(inst);
+    }
+
+    if (instances.empty())
+        return true;
+
+    int outputs = 0;
+    for (unsigned int ii = 0; ii < frames.size(); ii++)
+    {
+        for (int field = 0; field < 2; field++)
+        {
+            for (unsigned int jj = 0; jj < instances.size(); jj++)
+            {
+                Instance &inst = instances[jj];
+                VideoFrame frame;
+                memset(&frame, 0, sizeof(frame));
+                memcpy(inst.buf, frames[ii], framesize);
+                init(&frame, FMT_YV12, inst.buf, width, height,
+                     framesize, NULL, NULL, 16.0f / 9, 29.97);
+                frame.frameNumber = ii;
+
+                double start = now();
+                inst.filter->filter(inst.filter, &frame, field);
+                inst.seconds += now() - start;
+
+                if (jj == 0)
+                    continue;
+
+                const unsigned char *ref = instances[0].buf;
+                long long diffs = 0;
+                for (size_t kk = 0; kk < framesize; kk++)
+                {
+                    if (inst.buf[kk] != ref[kk])
+                    {
+                        int diff = abs(inst.buf[kk] - ref[kk]);
+                        if (diff > inst.maxdiff)
+                            inst.maxdiff = diff;
+                        diffs++;
+                    }
+                }
+                inst.mismatches += diffs;
+                if (diffs)
+                    inst.badframes++;
+            }
+            outputs++;
+        }
+    }
+
+    for (unsigned int jj = 0; jj < instances.size(); jj++)
+    {
+        Instance &inst = instances[jj];
+        printf("%-14s %-6s %8.2f fps", info->name, inst.name,
+               inst.seconds > 0 ? outputs / inst.seconds : 0.0);
+        if (jj == 0)
+            printf("  (reference)\n");
+        else
+            printf("  %d/%d outputs differ from %s, %lld bytes, "
+                   "max difference %d\n", inst.badframes, outputs,
+                   instances[0].name, inst.mismatches, inst.maxdiff);
+
+        if (inst.filter->cleanup)
+            inst.filter->cleanup(inst.filter);
+        free(inst.filter);
+        free(inst.buf);
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    const char *yuvfile = NULL;
+    int width = 1920, height = 1080;
+    int nframes = 60;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:s:n:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'f':
+                yuvfile = optarg;
+                break;
+            case 's':
+                if (sscanf(optarg, "%dx%d", &width, &height) != 2)
+                {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'n':
+                nframes = atoi(optarg);
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (optind >= argc || width < 32 || height < 32 ||
+        (width & 15) || (height & 3) || nframes < 2)
+    {
+        usage(argv[0]);
+        fprintf(stderr, "The width must be a multiple of 16, the height a "
+                "multiple of 4, and at least 2 frames are needed.\n");
+        return 1;
+    }
+
+    const size_t framesize = (size_t)width * height * 3 / 2;
+    std::vector<unsigned char*> frames;
+    FILE *f = NULL;
+    if (yuvfile && !(f = fopen(yuvfile, "rb")))
+    {
+        perror(yuvfile);
+        return 1;
+    }
+
+    for (int ii = 0; ii < nframes; ii++)
+    {
+        unsigned char *buf = alloc_frame(framesize);
+        if (!buf)
+        {
+            fprintf(stderr, "out of memory\n");
+            return 1;
+        }
+        if (f)
+        {
+            if (fread(buf, 1, framesize, f) != framesize)
+            {
+                free(buf);
+                break;
+            }
+        }
+        else
+        {
+            make_synthetic(buf, width, height, ii);
+        }
+        frames.push_back(buf);
+    }
+    if (f)
+        fclose(f);
+
+    if (frames.size() < 2)
+    {
+        fprintf(stderr, "%s: fewer than 2 frames of %dx%d\n",
+                yuvfile, width, height);
+        return 1;
+    }
+
+    printf("%u %s frames of %dx%d, both fields of each\n",
+           (unsigned int)frames.size(), yuvfile ? "recorded" : "synthetic",
+           width, height);
+
+    for (int ii = optind; ii < argc; ii++)
+    {
+        /* Loads libmythavutil as well, if the plugin was found */
+        if (!dlopen(argv[ii], RTLD_NOW | RTLD_GLOBAL))
+        {
+            fprintf(stderr, "%s\n", dlerror());
+            return 1;
+        }
+
+        force_cpu_flags_fn force_flags = (force_cpu_flags_fn)
+            dlsym(RTLD_DEFAULT, "av_force_cpu_flags");
+        get_cpu_flags_fn get_flags = (get_cpu_flags_fn)
+            dlsym(RTLD_DEFAULT, "av_get_cpu_flags");
+        if (!force_flags || !get_flags)
+        {
+            fprintf(stderr, "%s: libavutil has no av_force_cpu_flags()\n",
+                    argv[ii]);
+            return 1;
+        }
+
+        force_flags(-1);
+        if (!bench_plugin(argv[ii], force_flags, get_flags(), frames,
+                          width, height))
+        {
+            return 1;
+        }
+    }
+
+    for (unsigned int ii = 0; ii < frames.size(); ii++)
+        free(frames[ii]);
+
+    return 0;
+}
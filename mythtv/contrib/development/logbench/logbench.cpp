@@ -0,0 +1,253 @@
+/*
+ * Benchmark for handing log messages from LOG() to LoggerThread.
+ *
+ * It is linked against libmythbase and runs the real LoggerThread, with
+ * the console output redirected into a pipe that a reader thread
+ * drains, so a message counts as delivered once LoggerThread has
+ * written it out.  Two things are measured:
+ *
+ *  flood: several MThreads log as fast as they can (or with a gap
+ *         between messages), the latency of each LOG() call and the
+ *         time until every message was written out are reported
+ *  probe: one MThread logs single messages 20 ms apart, the time from
+ *         each LOG() call to its line being written out is reported,
+ *         which shows how long an idle LoggerThread takes to wake up
+ *
+ * Build it once against each libmythbase to be compared and run them
+ * with the same arguments.
+ *
+ * compile with
+ *   g++ -O2 -I../../../libs/libmythbase $(pkg-config --cflags QtCore) \
+ *       -o logbench logbench.cpp \
+ *       -L../../../libs/libmythbase -lmythbase-0.26 \
+ *       $(pkg-config --libs QtCore)
+ * usage: logbench [threads] [messages per thread] [gap in us] [probes]
+ *
+ * Run it with LD_LIBRARY_PATH pointing at the libmythbase it was linked
+ * against.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QAtomicInt>
+
+#include "mythlogging.h"
+#include "loggingserver.h"
+#include "mythcorecontext.h"
+#include "mthread.h"
+
+static inline uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int                   pipe_fd[2];
+static QAtomicInt            flood_lines(0);
+static std::vector<uint64_t> probe_seen;    // written by the reader only
+static QAtomicInt            probe_lines(0);
+
+/// Reads what LoggerThread writes to the console
+class Reader : public MThread
+{
+  public:
+    Reader() : MThread("LogBenchReader") { }
+
+  protected:
+    void run(void)
+    {
+        char buf[65536];
+        std::string line;
+        ssize_t len;
+        while ((len = read(pipe_fd[0], buf, sizeof(buf))) > 0)
+        {
+            uint64_t t = now_ns();
+            for (ssize_t i = 0; i < len; i++)
+            {
+                if (buf[i] != '\n')
+                {
+                    line += buf[i];
+                    continue;
+                }
+
+                const char *probe = strstr(line.c_str(), "logbench probe ");
+                if (probe)
+                {
+                    int n = atoi(probe + 15);
+                    if (n >= 0 && n < (int)probe_seen.size())
+                        probe_seen[n] = t;
+                    probe_lines.fetchAndAddOrdered(1);
+                }
+                else if (strstr(line.c_str(), "logbench flood "))
+                    flood_lines.fetchAndAddOrdered(1);
+                line.clear();
+            }
+        }
+    }
+};
+
+class Producer : public MThread
+{
+  public:
+    Producer(int count, int gap, uint64_t *latency) :
+        MThread("LogBenchProducer"),
+        m_count(count), m_gap(gap), m_latency(latency) { }
+
+  protected:
+    void run(void)
+    {
+        RunProlog();
+        for (int i = 0; i < m_count; i++)
+        {
+            uint64_t t0 = now_ns();
+            LOG(VB_GENERAL, LOG_INFO,
+                QString("logbench flood %1 on pid 0x%2")
+                    .arg(i).arg(i & 0x1fff, 0, 16));
+            m_latency[i] = now_ns() - t0;
+            if (m_gap)
+                usleep(m_gap);
+        }
+        RunEpilog();
+    }
+
+  private:
+    int       m_count;
+    int       m_gap;
+    uint64_t *m_latency;
+};
+
+class Prober : public MThread
+{
+  public:
+    Prober(int count, uint64_t *sent) :
+        MThread("LogBenchProber"), m_count(count), m_sent(sent) { }
+
+  protected:
+    void run(void)
+    {
+        RunProlog();
+        for (int i = 0; i < m_count; i++)
+        {
+            m_sent[i] = now_ns();
+            LOG(VB_GENERAL, LOG_INFO, QString("logbench probe %1").arg(i));
+            usleep(20000);
+        }
+        RunEpilog();
+    }
+
+  private:
+    int       m_count;
+    uint64_t *m_sent;
+};
+
+static void wait_for(QAtomicInt &lines, int expected)
+{
+    for (int i = 0; i < 5000 && (int)lines < expected; i++)
+        usleep(1000);
+}
+
+static void report(const char *name, std::vector<uint64_t> &ns)
+{
+    std::sort(ns.begin(), ns.end());
+    size_t n = ns.size();
+    fprintf(stderr, "%-6s p50 %9llu ns  p99 %10llu ns  p99.9 %10llu ns  "
+            "max %10llu ns\n", name,
+            (unsigned long long)ns[n / 2],
+            (unsigned long long)ns[n * 99 / 100],
+            (unsigned long long)ns[n * 999 / 1000],
+            (unsigned long long)ns[n - 1]);
+}
+
+int main(int argc, char **argv)
+{
+    int threads = (argc > 1) ? atoi(argv[1]) : 4;
+    int count   = (argc > 2) ? atoi(argv[2]) : 200000;
+    int gap     = (argc > 3) ? atoi(argv[3]) : 0;
+    int probes  = (argc > 4) ? atoi(argv[4]) : 100;
+
+    if (threads < 1 || count < 1 || gap < 0 || probes < 1)
+    {
+        fprintf(stderr, "usage: %s [threads] [messages per thread] "
+                "[gap in us] [probes]\n", argv[0]);
+        return 1;
+    }
+
+    QCoreApplication app(argc, argv);
+    // Log to an in-process mythlogserver instead of launching one
+    QCoreApplication::setApplicationName(MYTH_APPNAME_MYTHLOGSERVER);
+
+    // LoggerThread writes the console output into the pipe
+    if (pipe(pipe_fd) < 0 || dup2(pipe_fd[1], STDOUT_FILENO) < 0)
+    {
+        perror("pipe");
+        return 1;
+    }
+    probe_seen.resize(probes);
+
+    Reader reader;
+    reader.start();
+
+    logServerStart();
+    logStart("", 0, 0, -1, LOG_INFO, false, false);
+
+    fprintf(stderr, "%d producer threads, %d messages each, %d us apart\n",
+            threads, count, gap);
+
+    std::vector<uint64_t> latency((size_t)threads * count);
+    std::vector<Producer *> producers;
+    for (int i = 0; i < threads; i++)
+        producers.push_back(new Producer(count, gap,
+                                         &latency[(size_t)i * count]));
+
+    uint64_t t0 = now_ns();
+    for (int i = 0; i < threads; i++)
+        producers[i]->start();
+    for (int i = 0; i < threads; i++)
+        producers[i]->wait();
+    uint64_t t1 = now_ns();
+    wait_for(flood_lines, threads * count);
+    uint64_t t2 = now_ns();
+
+    for (int i = 0; i < threads; i++)
+        delete producers[i];
+
+    fprintf(stderr, "flood  %10.0f msg/s, all written out after %.1f ms, "
+            "%d of %d lines\n",
+            (double)latency.size() * 1e9 / (double)(t1 - t0),
+            (double)(t2 - t0) / 1e6, (int)flood_lines, threads * count);
+    report("call", latency);
+
+    std::vector<uint64_t> sent(probes);
+    Prober prober(probes, &sent[0]);
+    prober.start();
+    prober.wait();
+    wait_for(probe_lines, probes);
+
+    std::vector<uint64_t> delivery;
+    for (int i = 0; i < probes; i++)
+        if (probe_seen[i])
+            delivery.push_back(probe_seen[i] - sent[i]);
+    fprintf(stderr, "probe  %d of %d lines written out\n",
+            (int)delivery.size(), probes);
+    if (!delivery.empty())
+        report("wakeup", delivery);
+
+    logStop();
+    logServerStop();
+    close(pipe_fd[1]);
+    close(STDOUT_FILENO);
+    reader.wait();
+
+    return 0;
+}
@@ -0,0 +1,133 @@
+#!/usr/bin/env python
+# -*- coding: UTF-8 -*-
+#
+# schedbench.py - Benchmark for the mythbackend scheduler.
+#
+# Generates a synthetic XMLTV guide for loading with
+#     mythfilldatabase --file --sourceid <n> --xmlfile <file>
+# and replays the "Reschedule requested for ..." lines of a captured
+# mythbackend log (run with -v schedule) against a running backend,
+# timing each pass until the backend announces SCHEDULE_CHANGE.
+#
+# Usage:
+#     schedbench.py guide --channels 100 --days 14 > guide.xml
+#     schedbench.py replay [--mode full|incremental|both] mythbackend.log
+
+import re
+import sys
+import time
+import random
+import optparse
+from datetime import datetime, timedelta
+
+from MythTV import MythBE, MythDB
+from MythTV.static import BACKEND_SEP
+
+TITLES = ['News', 'Weather', 'Movie', 'Cooking', 'Sports Tonight',
+          'Documentary', 'Quiz', 'Soap', 'Drama', 'Comedy', 'Kids',
+          'Science', 'History', 'Travel', 'Music', 'Talk']
+
+def guide(opts):
+    out = sys.stdout
+    rnd = random.Random(opts.seed)
+    start = datetime.utcnow().replace(minute=0, second=0, microsecond=0)
+    out.write('<?xml version="1.0" encoding="UTF-8"?>\n')
+    out.write('<tv generator-info-name="schedbench">\n')
+    for chan in range(1, opts.channels + 1):
+        out.write('  <channel id="%d.schedbench">\n' % chan)
+        out.write('    <display-name>Bench %d</display-name>\n' % chan)
+        out.write('  </channel>\n')
+    for chan in range(1, opts.channels + 1):
+        t = start
+        end = start + timedelta(days=opts.days)
+        while t < end:
+            length = timedelta(minutes=rnd.choice([30, 30, 60, 60, 90, 120]))
+            title = '%s %d' % (rnd.choice(TITLES), rnd.randint(1, opts.titles))
+            episode = rnd.randint(1, 500)
+            out.write('  <programme start="%s +0000" stop="%s +0000" '
+                      'channel="%d.schedbench">\n' %
+                      (t.strftime('%Y%m%d%H%M%S'),
+                       (t + length).strftime('%Y%m%d%H%M%S'), chan))
+            out.write('    <title>%s</title>\n' % title)
+            out.write('    <sub-title>Episode %d</sub-title>\n' % episode)
+            out.write('    <desc>Synthetic listing %d of %s.</desc>\n' %
+                      (episode, title))
+            out.write('    <episode-num system="dd_progid">'
+                      'EP%06d%04d</episode-num>\n' %
+                      (hash(title) % 1000000, episode))
+            out.write('  </programme>\n')
+            t += length
+    out.write('</tv>\n')
+
+def read_requests(logfile):
+    pattern = re.compile(r'Reschedule requested for (.*)$')
+    requests = []
+    for line in open(logfile):
+        match = pattern.search(line.rstrip('\n'))
+        if match:
+            requests.append(match.group(1).split(' | '))
+    return requests
+
+def replay_once(be, requests):
+    times = []
+    for request in requests:
+        lock = be.allocateEventLock(re.escape(BACKEND_SEP).join(
+                    ['BACKEND_MESSAGE', 'SCHEDULE_CHANGE', 'empty']))
+        begin = time.time()
+        be.backendCommand(BACKEND_SEP.join(['RESCHEDULE_RECORDINGS'] +
+                                           request))
+        lock.wait()
+        times.append(time.time() - begin)
+    return times
+
+def report(mode, times):
+    if not times:
+        print '%-12s no requests replayed' % mode
+        return
+    times = sorted(times)
+    pick = lambda p: times[min(len(times) - 1, int(len(times) * p))]
+    print '%-12s %5d passes  total %8.2fs  mean %6.3fs  ' \
+          'p50 %6.3fs  p90 %6.3fs  max %6.3fs' % \
+          (mode, len(times), sum(times), sum(times) / len(times),
+           pick(0.5), pick(0.9), times[-1])
+
+def replay(opts, logfile):
+    requests = read_requests(logfile)
+    if opts.limit:
+        requests = requests[:opts.limit]
+    db = MythDB()
+    be = MythBE(db=db)
+    modes = ['full', 'incremental'] if opts.mode == 'both' else [opts.mode]
+    for mode in modes:
+        db.settings.NULL['SchedIncremental'] = \
+            '1' if mode == 'incremental' else '0'
+        # The backend caches settings, make it read the new mode
+        be.clearSettings()
+        # Start every mode from a fully loaded scheduler
+        replay_once(be, [['MATCH 0 0 0 - schedbench']])
+        report(mode, replay_once(be, requests))
+
+def main():
+    parser = optparse.OptionParser(
+        usage='%prog guide [options] | replay [options] <logfile>')
+    parser.add_option('--channels', type='int', default=100)
+    parser.add_option('--days', type='int', default=14)
+    parser.add_option('--titles', type='int', default=50,
+                      help='distinct titles per title stem')
+    parser.add_option('--seed', type='int', default=1)
+    parser.add_option('--mode', default='both',
+                      help='full, incremental or both')
+    parser.add_option('--limit', type='int', default=0,
+                      help='replay at most this many requests')
+    opts, args = parser.parse_args()
+
+    if args[:1] == ['guide']:
+        guide(opts)
+    elif args[:1] == ['replay'] and len(args) == 2:
+        replay(opts, args[1])
+    else:
+        parser.print_usage()
+        sys.exit(1)
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,117 @@
+/*
+ * Check that periodic position map saves grow a recording's seek index
+ * instead of rewriting it.
+ *
+ * It does what ProgramInfo::SavePositionMapDelta() does with the file
+ * during a recording: one complete Write() and then repeated Append()s
+ * of new entries.  Each Append() has to succeed, grow the file by
+ * exactly one block and leave it at the same inode, since Write()
+ * replaces the file with a renamed temporary one.  Finally ReadAll()
+ * has to return every entry that was saved.
+ *
+ * compile with
+ *   g++ -O2 -I../../../libs/libmyth -I../../../libs/libmythbase \
+ *       $(pkg-config --cflags QtCore) \
+ *       -o seekindexcheck seekindexcheck.cpp \
+ *       ../../../libs/libmyth/seekindexfile.cpp \
+ *       -L../../../libs/libmythbase -lmythbase-0.26 \
+ *       $(pkg-config --libs QtCore)
+ * usage: seekindexcheck [directory] [saves]
+ *
+ * Run it with LD_LIBRARY_PATH pointing at the libmythbase it was linked
+ * against.  It exits with 0 if every check passed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include <QByteArray>
+#include <QString>
+#include <QFile>
+#include <QDir>
+
+#include "seekindexfile.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char *what, int save)
+{
+    if (ok)
+        return;
+    fprintf(stderr, "FAIL: save %d: %s\n", save, what);
+    failures++;
+}
+
+static bool file_stat(const QString &path, struct stat &st)
+{
+    QByteArray name = QFile::encodeName(path);
+    return stat(name.constData(), &st) == 0;
+}
+
+int main(int argc, char **argv)
+{
+    QString dir   = (argc > 1) ? QString(argv[1]) : QDir::tempPath();
+    int     saves = (argc > 2) ? atoi(argv[2]) : 10;
+
+    QString recording = QDir(dir).absoluteFilePath("seekindexcheck.ts");
+    QString seekpath  = SeekIndexFile::PathFor(recording);
+
+    // The recording only has to exist for the staleness check
+    QFile rec(recording);
+    if (!rec.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        fprintf(stderr, "Could not create %s\n",
+                recording.toLocal8Bit().constData());
+        return 2;
+    }
+    rec.close();
+
+    frm_pos_map_t expected;
+    uint64_t frame = 0, offset = 0;
+
+    // The first save writes a complete file
+    pos_map_by_type_t maps;
+    for (int i = 0; i < 100; i++, frame += 12, offset += 188 * 400)
+        maps[MARK_GOP_BYFRAME][frame] = offset;
+    expected = maps[MARK_GOP_BYFRAME];
+    check(SeekIndexFile::Write(recording, maps), "Write() failed", 0);
+
+    struct stat first;
+    check(file_stat(seekpath, first), "no seek index after Write()", 0);
+
+    struct stat last = first;
+    for (int save = 1; save <= saves; save++)
+    {
+        frm_pos_map_t delta;
+        for (int i = 0; i < 25; i++, frame += 12, offset += 188 * 400)
+            delta[frame] = offset;
+
+        check(SeekIndexFile::Append(recording, MARK_GOP_BYFRAME, delta),
+              "Append() failed, the caller would rewrite the file", save);
+
+        struct stat now;
+        check(file_stat(seekpath, now), "seek index is gone", save);
+        check(now.st_ino == first.st_ino,
+              "the file was replaced instead of appended to", save);
+        check(now.st_size > last.st_size, "the file did not grow", save);
+        last = now;
+
+        frm_pos_map_t::const_iterator it = delta.begin();
+        for (; it != delta.end(); ++it)
+            expected[it.key()] = *it;
+    }
+
+    pos_map_by_type_t read;
+    check(SeekIndexFile::ReadAll(recording, read), "ReadAll() failed", saves);
+    check(read.value(MARK_GOP_BYFRAME) == expected,
+          "ReadAll() returned different entries", saves);
+
+    SeekIndexFile::Remove(recording);
+    QFile::remove(recording);
+
+    printf("%d appends, %lld bytes, %s\n", saves, (long long)last.st_size,
+           failures ? "FAILED" : "ok");
+
+    return failures ? 1 : 0;
+}
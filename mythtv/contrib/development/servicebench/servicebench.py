@@ -0,0 +1,112 @@
+#!/usr/bin/env python
+# -*- coding: UTF-8 -*-
+#
+# servicebench.py - Benchmark for large services API responses.
+#
+# Requests a services API URL from a running backend, once buffered and
+# once streamed, and reports the time to the first byte, the total time
+# and the size of each response. A response is buffered by the backend
+# when the request carries an If-None-Match header, so both modes can be
+# compared against the same backend. If the backend runs on this host,
+# pass its pid to also report its peak RSS for each mode; that needs the
+# permission to reset the peak through /proc/<pid>/clear_refs.
+#
+# Usage:
+#     servicebench.py [--host localhost] [--port 6544] [--count 5]
+#                     [--json] [--pid <mythbackend pid>] [path]
+#
+# The path defaults to /Dvr/GetRecordedList.
+
+import sys
+import time
+import socket
+import optparse
+
+def request(opts, path, streamed):
+    headers = ['GET %s HTTP/1.1' % path,
+               'Host: %s:%d' % (opts.host, opts.port),
+               'Connection: close']
+    if opts.json:
+        headers.append('Accept: application/json')
+    if opts.gzip:
+        headers.append('Accept-Encoding: gzip')
+    if not streamed:
+        headers.append('If-None-Match: "servicebench"')
+
+    sock = socket.create_connection((opts.host, opts.port))
+    begin = time.time()
+    sock.sendall('\r\n'.join(headers) + '\r\n\r\n')
+
+    first = None
+    size = 0
+    head = ''
+    while True:
+        data = sock.recv(65536)
+        if not data:
+            break
+        if first is None:
+            first = time.time() - begin
+        if len(head) < 4096:
+            head += data[:4096]
+        size += len(data)
+    total = time.time() - begin
+    sock.close()
+
+    chunked = 'transfer-encoding: chunked' in \
+              head.split('\r\n\r\n')[0].lower()
+    return first or total, total, size, chunked
+
+def reset_peak(pid):
+    try:
+        open('/proc/%d/clear_refs' % pid, 'w').write('5')
+        return True
+    except IOError:
+        return False
+
+def read_peak(pid):
+    for line in open('/proc/%d/status' % pid):
+        if line.startswith('VmHWM:'):
+            return int(line.split()[1])
+    return 0
+
+def run(opts, path, streamed):
+    mode = 'streamed' if streamed else 'buffered'
+    reset = opts.pid and reset_peak(opts.pid)
+    results = [request(opts, path, streamed) for i in range(opts.count)]
+
+    first = sorted(r[0] for r in results)
+    total = sorted(r[1] for r in results)
+    print '%-9s %3d requests  ttfb p50 %7.3fs max %7.3fs  ' \
+          'total p50 %7.3fs max %7.3fs  %9d bytes%s' % \
+          (mode, len(results), first[len(first) / 2], first[-1],
+           total[len(total) / 2], total[-1], results[-1][2],
+           '' if results[-1][3] == streamed else '  (not %s)' % mode)
+    if opts.pid:
+        print '%-9s peak RSS %d kB%s' % \
+              (mode, read_peak(opts.pid),
+               '' if reset else ' (since backend start, reset failed)')
+
+def main():
+    parser = optparse.OptionParser(usage='%prog [options] [path]')
+    parser.add_option('--host', default='localhost')
+    parser.add_option('--port', type='int', default=6544)
+    parser.add_option('--count', type='int', default=5,
+                      help='requests per mode')
+    parser.add_option('--json', action='store_true',
+                      help='ask for JSON instead of XML')
+    parser.add_option('--gzip', action='store_true',
+                      help='accept gzip encoded responses')
+    parser.add_option('--pid', type='int', default=0,
+                      help='mythbackend pid, to report its peak RSS')
+    opts, args = parser.parse_args()
+
+    if len(args) > 1:
+        parser.print_usage()
+        sys.exit(1)
+    path = args[0] if args else '/Dvr/GetRecordedList'
+
+    run(opts, path, False)
+    run(opts, path, True)
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,146 @@
+/*
+ * Benchmark for the transport stream scanning done in
+ * MPEGStreamData::ProcessData() and ProcessTSPacket().
+ *
+ * It is linked against libmythtv and feeds a recorded TS to the real
+ * MPEGStreamData in the same chunks a stream handler would, carrying the
+ * unprocessed remainder of each chunk over to the next one.  The PIDs
+ * seen at the start of the file are set up in the mix a recorder of a
+ * full mux uses: the PSI PIDs below 0x20 are listened to, every third of
+ * the others is an audio PID and the rest are written.
+ *
+ * Build it once against each libmythtv to be compared and run them with
+ * the same file and arguments.  The packet counts have to match.
+ *
+ * compile with
+ *   g++ -O2 -I../../../libs/libmythtv -I../../../libs/libmythtv/mpeg \
+ *       -I../../../libs/libmythbase $(pkg-config --cflags QtCore) \
+ *       -o tsscanbench tsscanbench.cpp \
+ *       -L../../../libs/libmythtv -lmythtv-0.26 \
+ *       -L../../../libs/libmythbase -lmythbase-0.26 \
+ *       $(pkg-config --libs QtCore)
+ * usage: tsscanbench <file.ts> [passes] [chunk size]
+ *
+ * Run it with LD_LIBRARY_PATH pointing at the libraries it was linked
+ * against.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "mpegstreamdata.h"
+#include "streamlisteners.h"
+#include "tspacket.h"
+
+/// Counts the packets MPEGStreamData hands on to the recorder
+class PacketCounter : public TSPacketListener, public TSPacketListenerAV
+{
+  public:
+    PacketCounter() : written(0), audio(0), video(0) { }
+
+    bool ProcessTSPacket(const TSPacket &)      { written++; return true; }
+    bool ProcessAudioTSPacket(const TSPacket &) { audio++;   return true; }
+    bool ProcessVideoTSPacket(const TSPacket &) { video++;   return true; }
+
+    unsigned long written;
+    unsigned long audio;
+    unsigned long video;
+};
+
+static double now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <file.ts> [passes] [chunk size]\n",
+                argv[0]);
+        return 1;
+    }
+    int passes = (argc > 2) ? atoi(argv[2]) : 10;
+    int chunk  = (argc > 3) ? atoi(argv[3]) : 128 * 1024;
+    if (passes < 1 || chunk < (int)TSPacket::kSize)
+    {
+        fprintf(stderr, "usage: %s <file.ts> [passes] [chunk size]\n",
+                argv[0]);
+        return 1;
+    }
+
+    FILE *f = fopen(argv[1], "rb");
+    if (!f)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    std::vector<unsigned char> data;
+    unsigned char block[65536];
+    size_t n;
+    while ((n = fread(block, 1, sizeof(block), f)) > 0)
+        data.insert(data.end(), block, block + n);
+    fclose(f);
+    if (data.size() < 2 * TSPacket::kSize)
+    {
+        fprintf(stderr, "%s: file too short\n", argv[1]);
+        return 1;
+    }
+
+    MPEGStreamData sd(-1, false);
+    PacketCounter counter;
+    sd.AddWritingListener(&counter);
+    sd.AddAVListener(&counter);
+
+    for (size_t i = 0; i + TSPacket::kSize <= data.size() &&
+             i < 100000 * TSPacket::kSize; i += TSPacket::kSize)
+    {
+        if (data[i] != SYNC_BYTE)
+            continue;
+        uint pid = ((data[i + 1] << 8) | data[i + 2]) & 0x1fff;
+        if (pid < 0x20)
+            sd.AddListeningPID(pid);
+        else if (pid % 3 == 0)
+            sd.AddAudioPID(pid);
+        else
+            sd.AddWritingPID(pid);
+    }
+
+    // The stream handlers keep the remainder at the start of their buffer
+    std::vector<unsigned char> buffer(chunk + 2 * TSPacket::kSize);
+    const int len = data.size();
+
+    double t0 = now();
+    for (int i = 0; i < passes; i++)
+    {
+        int pos = 0, remainder = 0;
+        while (pos < len)
+        {
+            int size = std::min(chunk, len - pos);
+            memcpy(&buffer[remainder], &data[pos], size);
+            pos += size;
+            size += remainder;
+
+            remainder = sd.ProcessData(&buffer[0], size);
+            if (remainder > 0 && remainder < size)
+                memmove(&buffer[0], &buffer[size - remainder], remainder);
+            else
+                remainder = 0;
+        }
+    }
+    double t1 = now();
+
+    double mb = (double)len * passes / (1024.0 * 1024.0);
+    printf("%lu written, %lu audio, %lu video packets per pass\n",
+           counter.written / passes, counter.audio / passes,
+           counter.video / passes);
+    printf("ProcessData(): %8.1f MB/s\n", mb / (t1 - t0));
+    return 0;
+}
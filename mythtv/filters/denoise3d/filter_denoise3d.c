@@ -46,6 +46,9 @@ typedef struct ThisFilter
     uint8_t *prev;
     uint8_t coefs[4][512];
 
+    /* The frame being filtered, for the slice function */
+    VideoFrame *frame;
+
     void (*filtfunc)(uint8_t*, uint8_t*, uint8_t*,
                      int, int, uint8_t*, uint8_t*);
 
@@ -307,13 +310,18 @@ static int alloc_prev(ThisFilter *filter, int size)
 
 static int imax(int a, int b) { return (a > b) ? a : b; }
 
+static int line_pitch(VideoFrame *frame)
+{
+    return imax(imax(frame->pitches[0], frame->pitches[1]), frame->pitches[2]);
+}
+
 static int init_buf(ThisFilter *filter, VideoFrame *frame)
 {
     if (!alloc_prev(filter, frame->size))
         return 0;
 
-    int sz = imax(imax(frame->pitches[0], frame->pitches[1]), frame->pitches[2]);
-    if (!alloc_line(filter, sz))
+    /* A line buffer for each plane, as the planes may be filtered at once */
+    if (!alloc_line(filter, line_pitch(frame) * 3))
         return 0;
 
     if ((filter->prev_size  != frame->size)       ||
@@ -332,43 +340,55 @@ static int init_buf(ThisFilter *filter, VideoFrame *frame)
     return 1;
 }
 
-static int denoise3DFilter(VideoFilter *f, VideoFrame *frame, int field)
+/* Each plane is filtered from top to bottom, so a plane is one slice */
+static void denoise3DSlice(void *arg, int this_slice, int total_slices)
 {
-    (void)field;
-    ThisFilter *filter = (ThisFilter*) f;
-    TF_VARS;
+    ThisFilter *filter = (ThisFilter*) arg;
+    VideoFrame *frame = filter->frame;
+    int plane, last_plane, height, coef;
 
-    if (!init_buf(filter, frame))
-        return -1;
-
-    TF_START;
+    plane = (total_slices > 1) ? this_slice : 0;
+    last_plane = (total_slices > 1) ? this_slice : 2;
 
 #ifdef MMX
     if (filter->mm_flags & AV_CPU_FLAG_MMX)
         emms();
 #endif
 
-    (filter->filtfunc)(frame->buf   + frame->offsets[0],
-                       filter->prev + frame->offsets[0],
-                       filter->line,  frame->pitches[0], frame->height,
-                       filter->coefs[0] + 256,
-                       filter->coefs[1] + 256);
-
-    (filter->filtfunc)(frame->buf   + frame->offsets[1],
-                       filter->prev + frame->offsets[1],
-                       filter->line,  frame->pitches[1], frame->height >> 1,
-                       filter->coefs[2] + 256,
-                       filter->coefs[3] + 256);
-
-    (filter->filtfunc)(frame->buf   + frame->offsets[2],
-                       filter->prev + frame->offsets[2],
-                       filter->line,  frame->pitches[2], frame->height >> 1,
-                       filter->coefs[2] + 256,
-                       filter->coefs[3] + 256);
+    for (; plane <= last_plane; plane++)
+    {
+        height = plane ? frame->height >> 1 : frame->height;
+        coef = plane ? 2 : 0;
+
+        (filter->filtfunc)(frame->buf   + frame->offsets[plane],
+                           filter->prev + frame->offsets[plane],
+                           filter->line + plane * line_pitch(frame),
+                           frame->pitches[plane], height,
+                           filter->coefs[coef] + 256,
+                           filter->coefs[coef + 1] + 256);
+    }
+
 #ifdef MMX
     if (filter->mm_flags & AV_CPU_FLAG_MMX)
         emms();
 #endif
+}
+
+static int denoise3DFilter(VideoFilter *f, VideoFrame *frame, int field)
+{
+    (void)field;
+    ThisFilter *filter = (ThisFilter*) f;
+    TF_VARS;
+
+    if (!init_buf(filter, frame))
+        return -1;
+
+    TF_START;
+
+    filter->frame = frame;
+    filter_run_slices(f, denoise3DSlice, filter,
+                      filter_slice_count(f) > 1 ? 3 : 1);
+    filter->frame = NULL;
 
     TF_END(filter, "Denoise3D: ");
     return 0;
@@ -44,7 +44,7 @@ void (*yv12_to_yuy2)
    const unsigned char *u_src, int u_src_pitch, 
    const unsigned char *v_src, int v_src_pitch, 
    unsigned char *yuy2_map, int yuy2_pitch,
-   int width, int height, int progressive);
+   int width, int height, int progressive, int more_rows);
 
 void (*yuy2_to_yv12)
   (const unsigned char *yuy2_map, int yuy2_pitch,
@@ -72,7 +72,7 @@ static void yv12_to_yuy2_c
  const unsigned char *u_src, int u_src_pitch, 
  const unsigned char *v_src, int v_src_pitch, 
  unsigned char *yuy2_map, int yuy2_pitch,
- int width, int height, int progressive) 
+ int width, int height, int progressive, int more_rows) 
 {
 
     uint8_t *p_line1, *p_line2 = yuy2_map;
@@ -108,7 +108,7 @@ static void yv12_to_yuy2_c
             p_y2 += i_source_margin;
             p_u += i_source_u_margin;
             p_v += i_source_v_margin;
-            if ( i_y > 1 ) 
+            if ( i_y > 1 || more_rows ) 
             {
                 p_u2 += i_source_u_margin;
                 p_v2 += i_source_v_margin;
@@ -141,7 +141,7 @@ static void yv12_to_yuy2_c
             p_y2 += i_source_margin + y_src_pitch;
             p_u += i_source_u_margin + u_src_pitch;
             p_v += i_source_v_margin + v_src_pitch;
-            if ( i_y > 1 ) 
+            if ( i_y > 1 || more_rows ) 
             {
                 p_u2 += i_source_u_margin + u_src_pitch;
                 p_v2 += i_source_v_margin + v_src_pitch;
@@ -177,7 +177,7 @@ static void yv12_to_yuy2_c
             p_y2 += i_source_margin + y_src_pitch;
             p_u += i_source_u_margin + u_src_pitch;
             p_v += i_source_v_margin + v_src_pitch;
-            if ( i_y > 1 ) 
+            if ( i_y > 1 || more_rows ) 
             {
                 p_u2 += i_source_u_margin + u_src_pitch;
                 p_v2 += i_source_v_margin + v_src_pitch;
@@ -237,7 +237,7 @@ static void yv12_to_yuy2_mmxext
  const unsigned char *u_src, int u_src_pitch, 
  const unsigned char *v_src, int v_src_pitch, 
  unsigned char *yuy2_map, int yuy2_pitch,
- int width, int height, int progressive ) 
+ int width, int height, int progressive, int more_rows ) 
 {
     uint8_t *p_line1, *p_line2 = yuy2_map;
     const uint8_t *p_y1, *p_y2 = y_src;
@@ -275,7 +275,7 @@ static void yv12_to_yuy2_mmxext
             p_y2 += i_source_margin;
             p_u += i_source_u_margin;
             p_v += i_source_v_margin;
-            if ( i_y > 1 ) 
+            if ( i_y > 1 || more_rows ) 
             {
                 p_u2 += i_source_u_margin;
                 p_v2 += i_source_v_margin;
@@ -312,7 +312,7 @@ static void yv12_to_yuy2_mmxext
             p_y2 += i_source_margin + y_src_pitch;
             p_u += i_source_u_margin + u_src_pitch;
             p_v += i_source_v_margin + v_src_pitch;
-            if ( i_y > 1 ) 
+            if ( i_y > 1 || more_rows ) 
             {
                 p_u2 += i_source_u_margin + u_src_pitch;
                 p_v2 += i_source_v_margin + v_src_pitch;
@@ -352,7 +352,7 @@ static void yv12_to_yuy2_mmxext
             p_y2 += i_source_margin + y_src_pitch;
             p_u += i_source_u_margin + u_src_pitch;
             p_v += i_source_v_margin + v_src_pitch;
-            if ( i_y > 1 ) 
+            if ( i_y > 1 || more_rows ) 
             {
                 p_u2 += i_source_u_margin + u_src_pitch;
                 p_v2 += i_source_v_margin + v_src_pitch;
@@ -1,12 +1,14 @@
 #ifndef _COLOR_H_
 #define _COLOR_H_
 
+/* more_rows is non zero when converting a slice of a picture that continues
+ * below height, so the last chroma rows are interpolated from the next. */
 extern void (*yv12_to_yuy2)
   (const unsigned char *y_src, int y_src_pitch, 
    const unsigned char *u_src, int u_src_pitch, 
    const unsigned char *v_src, int v_src_pitch, 
    unsigned char *yuy2_map, int yuy2_pitch,
-   int width, int height, int progressive);
+   int width, int height, int progressive, int more_rows);
 
 extern void (*yuy2_to_yv12)
   (const unsigned char *yuy2_map, int yuy2_pitch,
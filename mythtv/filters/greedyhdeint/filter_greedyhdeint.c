@@ -88,6 +88,13 @@ typedef struct ThisFilter
     int width;
     int height;
 
+    /* The frame being filtered, for the slice functions */
+    VideoFrame *frame;
+    int field;
+    int cur_frame;
+    int last_frame;
+    int bottom_field;
+
     int mm_flags;
     TF_STRUCT;
 } ThisFilter;
@@ -115,20 +122,124 @@ static void AllocFilter(ThisFilter* filter, int width, int height)
     }
 }
 
-#include <sys/time.h>
-#include <time.h>
+/* The colour conversions are sliced on multiples of four rows, which keeps
+ * the chroma rows of both fields of an interlaced frame in one slice. */
+static void slice_rows(int height, int this_slice, int total_slices,
+                       int *start, int *end)
+{
+    *start = (height * this_slice / total_slices) & ~3;
+    if (this_slice + 1 >= total_slices)
+        *end = height;
+    else
+        *end = (height * (this_slice + 1) / total_slices) & ~3;
+}
+
+static void ToYUY2Slice(void *arg, int this_slice, int total_slices)
+{
+    ThisFilter *filter = (ThisFilter *) arg;
+    VideoFrame *frame = filter->frame;
+    int start, end;
+
+    slice_rows(frame->height, this_slice, total_slices, &start, &end);
+    if (start >= end)
+        return;
+
+    yv12_to_yuy2(
+        frame->buf + frame->offsets[0] + start * frame->pitches[0],
+        frame->pitches[0],
+        frame->buf + frame->offsets[1] + (start >> 1) * frame->pitches[1],
+        frame->pitches[1],
+        frame->buf + frame->offsets[2] + (start >> 1) * frame->pitches[2],
+        frame->pitches[2],
+        filter->frames[filter->cur_frame] + start * 2 * frame->width,
+        2 * frame->width, frame->width, end - start,
+        1 - frame->interlaced_frame, end < frame->height);
+}
+
+static void DeintSlice(void *arg, int this_slice, int total_slices)
+{
+    ThisFilter *filter = (ThisFilter *) arg;
+    VideoFrame *frame = filter->frame;
+    int lines = frame->height / 2 - 1;
+    int first_line = lines * this_slice / total_slices;
+    int last_line = lines * (this_slice + 1) / total_slices;
+
+#ifdef MMX
+    /* SSE Version has best quality. 3DNOW and MMX a litte bit impure */
+    if (filter->mm_flags & AV_CPU_FLAG_SSE)
+    {
+        greedyh_filter_sse(
+            filter->deint_frame, 2 * frame->width,
+            filter->frames[filter->cur_frame],
+            filter->frames[filter->last_frame],
+            filter->bottom_field, filter->field, frame->width, frame->height,
+            first_line, last_line);
+    }
+    else if (filter->mm_flags & AV_CPU_FLAG_3DNOW)
+    {
+        greedyh_filter_3dnow(
+            filter->deint_frame, 2 * frame->width,
+            filter->frames[filter->cur_frame],
+            filter->frames[filter->last_frame],
+            filter->bottom_field, filter->field, frame->width, frame->height,
+            first_line, last_line);
+    }
+    else if (filter->mm_flags & AV_CPU_FLAG_MMX)
+    {
+        greedyh_filter_mmx(
+            filter->deint_frame, 2 * frame->width,
+            filter->frames[filter->cur_frame],
+            filter->frames[filter->last_frame],
+            filter->bottom_field, filter->field, frame->width, frame->height,
+            first_line, last_line);
+    }
+    else
+#endif
+    {
+        /* TODO plain old C implementation */
+        (void) first_line;
+        (void) last_line;
+    }
+}
+
+static void ToYV12Slice(void *arg, int this_slice, int total_slices)
+{
+    ThisFilter *filter = (ThisFilter *) arg;
+    VideoFrame *frame = filter->frame;
+    int start, end;
+
+    slice_rows(frame->height, this_slice, total_slices, &start, &end);
+    if (start >= end)
+        return;
+
+    yuy2_to_yv12(
+        filter->deint_frame + start * 2 * frame->width, 2 * frame->width,
+        frame->buf + frame->offsets[0] + start * frame->pitches[0],
+        frame->pitches[0],
+        frame->buf + frame->offsets[1] + (start >> 1) * frame->pitches[1],
+        frame->pitches[1],
+        frame->buf + frame->offsets[2] + (start >> 1) * frame->pitches[2],
+        frame->pitches[2],
+        frame->width, end - start);
+}
 
 static int GreedyHDeint (VideoFilter * f, VideoFrame * frame, int field)
 {
     ThisFilter *filter = (ThisFilter *) f;
-    TF_VARS;
 
     int last_frame = 0;
     int cur_frame = 0;
     int bottom_field = 0;
 
+    /* Each slice of the deinterlacer needs a few lines to itself */
+    int slices = filter_slice_count(f);
+    if (slices > frame->height / 16)
+        slices = 1;
+
     AllocFilter((ThisFilter*)f, frame->width, frame->height);
 
+    filter->frame = frame;
+
     if (filter->last_framenr != frame->frameNumber)
     {
         //this is no double call, really a new frame
@@ -146,16 +257,12 @@ static int GreedyHDeint (VideoFilter * f, VideoFrame * frame, int field)
             case FMT_YV12:
                 //must convert from yv12 planar to yuv422 packed
                 //only needed on first call for this frame
-                yv12_to_yuy2(
-                        frame->buf + frame->offsets[0], frame->pitches[0],
-                        frame->buf + frame->offsets[1], frame->pitches[1],
-                        frame->buf + frame->offsets[2], frame->pitches[2],
-                        filter->frames[cur_frame], 2 * frame->width,
-                        frame->width, frame->height,
-                        1 - frame->interlaced_frame);
+                filter->cur_frame = cur_frame;
+                filter_run_slices(f, ToYUY2Slice, filter, slices);
                 break;
             default:
                 fprintf(stderr, "Unsupported pixel format.\n");
+                filter->frame = NULL;
                 return 0;
         }
 
@@ -174,35 +281,11 @@ static int GreedyHDeint (VideoFilter * f, VideoFrame * frame, int field)
     if (!filter->got_frames[last_frame])
         last_frame = cur_frame;
 
-#ifdef MMX
-    /* SSE Version has best quality. 3DNOW and MMX a litte bit impure */
-    if (filter->mm_flags & AV_CPU_FLAG_SSE)
-    {
-        greedyh_filter_sse(
-            filter->deint_frame, 2 * frame->width,
-            filter->frames[cur_frame], filter->frames[last_frame],
-            bottom_field, field, frame->width, frame->height);
-    }
-    else if (filter->mm_flags & AV_CPU_FLAG_3DNOW)
-    {
-        greedyh_filter_3dnow(
-            filter->deint_frame, 2 * frame->width,
-            filter->frames[cur_frame], filter->frames[last_frame],
-            bottom_field, field, frame->width, frame->height);
-    }
-    else if (filter->mm_flags & AV_CPU_FLAG_MMX)
-    {
-        greedyh_filter_mmx(
-            filter->deint_frame, 2 * frame->width,
-            filter->frames[cur_frame], filter->frames[last_frame],
-            bottom_field, field, frame->width, frame->height);
-    }
-    else
-#endif
-    {
-        /* TODO plain old C implementation */
-        (void) bottom_field;
-    }
+    filter->cur_frame = cur_frame;
+    filter->last_frame = last_frame;
+    filter->bottom_field = bottom_field;
+    filter->field = field;
+    filter_run_slices(f, DeintSlice, filter, slices);
 
 #if 0
       apply_chroma_filter(filter->deint_frame, frame->width * 2,
@@ -210,14 +293,10 @@ static int GreedyHDeint (VideoFilter * f, VideoFrame * frame, int field)
 #endif
 
     /* convert back to yv12, cause myth only works with this format */
-    yuy2_to_yv12(
-        filter->deint_frame, 2 * frame->width,
-        frame->buf + frame->offsets[0], frame->pitches[0],
-        frame->buf + frame->offsets[1], frame->pitches[1],
-        frame->buf + frame->offsets[2], frame->pitches[2],
-        frame->width, frame->height);
+    filter_run_slices(f, ToYV12Slice, filter, slices);
 
     filter->last_framenr = frame->frameNumber;
+    filter->frame = NULL;
 
     return 0;
 }
@@ -251,10 +330,14 @@ static VideoFilter* GreedyHDeintFilter(VideoFrameType inpixfmt,
     filter->height = 0;
     memset(filter->frames, 0, sizeof(filter->frames));
     filter->deint_frame = 0;
+    filter->frame = NULL;
 
     AllocFilter(filter, *width, *height);
 
     init_yuv_conversion();
+#if ARCH_X86
+    greedyh_init_parms();
+#endif
 #ifdef MMX
     filter->mm_flags = av_get_cpu_flags();
     TF_INIT(filter);
@@ -31,13 +31,34 @@ static int64_t __attribute__((__used__)) MotionThreshold;
 static int64_t __attribute__((__used__)) MotionSense;
 static int64_t __attribute__((__used__)) QW256B;
 
+// Set up our two parms that are actually evaluated for each pixel.  This is
+// done once, not by each slice, as the slices of a frame run concurrently.
+static void greedyh_init_parms(void)
+{
+    int64_t i;
+
+    i=GreedyMaxComb;
+    MaxComb = i << 56 | i << 48 | i << 40 | i << 32 | i << 24 | i << 16 | i << 8 | i;
+
+    i = GreedyMotionThreshold;		// scale to range of 0-257
+    MotionThreshold = i << 48 | i << 32 | i << 16 | i | UVMask;
+
+    i = GreedyMotionSense;		// scale to range of 0-257
+    MotionSense = i << 48 | i << 32 | i << 16 | i;
+    
+    i = 0xffffffff - 256;
+    QW256B =  i << 48 |  i << 32 | i << 16 | i;  // save a couple instr on PMINSW instruct.
+}
+
 #endif
 
+// Deinterlaces the output lines of field lines first_line to last_line - 1,
+// out of the height / 2 - 1 lines that are interpolated.
 static void FUNCT_NAME(uint8_t *output, int outstride,
                   unsigned char* cur, unsigned char* last, 
-                  int bottom_field, int second_field, int width, int height )
+                  int bottom_field, int second_field, int width, int height,
+                  int first_line, int last_line )
 {
-    int64_t i;
     int stride = (width*2);
     int InfoIsOdd = bottom_field;
 
@@ -56,19 +77,6 @@ static void FUNCT_NAME(uint8_t *output, int outstride,
 
     int64_t LastAvg=0;			//interp value from left qword
 
-    // Set up our two parms that are actually evaluated for each pixel
-    i=GreedyMaxComb;
-    MaxComb = i << 56 | i << 48 | i << 40 | i << 32 | i << 24 | i << 16 | i << 8 | i;
-
-    i = GreedyMotionThreshold;		// scale to range of 0-257
-    MotionThreshold = i << 48 | i << 32 | i << 16 | i | UVMask;
-
-    i = GreedyMotionSense;		// scale to range of 0-257
-    MotionSense = i << 48 | i << 32 | i << 16 | i;
-    
-    i = 0xffffffff - 256;
-    QW256B =  i << 48 |  i << 32 | i << 16 | i;  // save a couple instr on PMINSW instruct.
-
     // copy first even line no matter what, and the first odd line if we're
     // processing an EVEN field. (note diff from other deint rtns.)
     if ( second_field ) 
@@ -92,13 +100,15 @@ static void FUNCT_NAME(uint8_t *output, int outstride,
         L2P += stride;
 
         // copy first even line
-        memcpy(Dest, L1, stride);
+        if (first_line == 0)
+            memcpy(Dest, L1, stride);
         Dest += outstride;
     } 
     else 
     {
         // copy first even line
-        memcpy(Dest, L2, stride);
+        if (first_line == 0)
+            memcpy(Dest, L2, stride);
         Dest += outstride;
 
         L1 += stride;
@@ -107,11 +117,48 @@ static void FUNCT_NAME(uint8_t *output, int outstride,
         L2P += Pitch;
 
         // then first odd line
-        memcpy(Dest, L1, stride);
+        if (first_line == 0)
+            memcpy(Dest, L1, stride);
         Dest += outstride;
     }
 
-    for (Line = 0; Line < (FieldHeight - 1); ++Line) 
+    // skip to the first line of this slice
+    L1   += first_line * Pitch;
+    L2   += first_line * Pitch;
+    L3   += first_line * Pitch;
+    L2P  += first_line * Pitch;
+    Dest += first_line * 2 * outstride;
+
+    // a slice starting part way down carries on with the bob value that
+    // the slice above left behind for the last qword of its final line
+    if (first_line > 0)
+    {
+        const unsigned char *PrevL1 = L1 - Pitch + stride - 8;
+        const unsigned char *PrevL3 = L3 - Pitch + stride - 8;
+
+        __asm__ __volatile__
+            (
+             "movq  (%1),           %%mm6\n\t"
+             "movq  (%2),           %%mm3\n\t"
+             V_PAVGB ("%%mm6", "%%mm3", "%%mm4", MANGLE(ShiftMask))
+             "movq  %%mm6,          %0\n\t"
+
+             : "=m"(LastAvg)
+
+             : "r"(PrevL1),
+               "r"(PrevL3)
+
+             :
+#if ARCH_X86_32
+               "st", "st(1)", "st(2)", "st(3)", "st(4)", "st(5)", "st(6)", "st(7)",
+#elif ARCH_X86_64
+               "mm3", "mm4", "mm6",
+#endif
+               "memory"
+            );
+    }
+
+    for (Line = first_line; Line < last_line; ++Line) 
     {
         LoopCtr = stride / 8 - 1; // there are LineLength / 8 qwords per line but do 1 less, adj at end of loop
 
@@ -324,7 +371,7 @@ static void FUNCT_NAME(uint8_t *output, int outstride,
         L2P += Pitch;
     }
 
-    if (InfoIsOdd) 
+    if (InfoIsOdd && last_line == (FieldHeight - 1)) 
     {
         memcpy(Dest, L2, stride);
     }
@@ -2,7 +2,6 @@
 
 #include <stdlib.h>
 #include <stdio.h>
-#include <unistd.h>
 
 #include "mythconfig.h"
 #if HAVE_STDINT_H
@@ -11,7 +10,6 @@
 
 #include <string.h>
 #include <math.h>
-#include <pthread.h>
 
 #include "filter.h"
 #include "frame.h"
@@ -36,25 +34,12 @@ static const mmx_t mm_cpool[] = { { 0x0000000000000000LL }, };
 #define mmx_t int
 #endif
 
-struct DeintThread
-{
-    int       ready;
-    pthread_t id;
-    int       exists;
-};
-
 typedef struct ThisFilter
 {
     VideoFilter vf;
 
-    struct DeintThread *threads;
     VideoFrame *frame;
     int         field;
-    int         ready;
-    int         kill_threads;
-    int         actual_threads;
-    int         requested_threads;
-    pthread_mutex_t mutex;
 
     int       skipchroma;
     int       mm_flags;
@@ -206,6 +191,114 @@ static void line_filter_mmx(uint8_t *dst, int width, int start_width,
 
     line_filter_c(dst, width, X, src1, src2, src3, src4, src5);
 }
+
+DECLARE_ALIGNED(16, static const int16_t, xmm_lthr)[8] =
+    { -THRESHOLD, -THRESHOLD, -THRESHOLD, -THRESHOLD,
+      -THRESHOLD, -THRESHOLD, -THRESHOLD, -THRESHOLD };
+DECLARE_ALIGNED(16, static const int16_t, xmm_hthr)[8] =
+    { THRESHOLD - 1, THRESHOLD - 1, THRESHOLD - 1, THRESHOLD - 1,
+      THRESHOLD - 1, THRESHOLD - 1, THRESHOLD - 1, THRESHOLD - 1 };
+
+/* The same as mmx_start() and mmx_end() on 16 pixels at a time.  It is a
+ * single asm block, the compiler may use the xmm registers in between two
+ * of them.  STORE_BUF is spliced in after src1 has been read, so the fast
+ * version can replace it with src3 in the same pass. */
+#define SSE2_KERNEL(STORE_BUF) \
+    __asm__ volatile( \
+        "pxor      %%xmm7, %%xmm7  \n\t" \
+        "movdqu    (%[s2]), %%xmm0 \n\t" \
+        "movdqa    %%xmm0, %%xmm1  \n\t" \
+        "punpcklbw %%xmm7, %%xmm0  \n\t" \
+        "punpckhbw %%xmm7, %%xmm1  \n\t" \
+        "movdqa    %%xmm0, %%xmm5  \n\t" /* src2 */ \
+        "movdqa    %%xmm1, %%xmm6  \n\t" \
+        "movdqu    (%[s4]), %%xmm2 \n\t" \
+        "movdqa    %%xmm2, %%xmm3  \n\t" \
+        "punpcklbw %%xmm7, %%xmm2  \n\t" \
+        "punpckhbw %%xmm7, %%xmm3  \n\t" \
+        "paddw     %%xmm2, %%xmm0  \n\t" \
+        "paddw     %%xmm3, %%xmm1  \n\t" \
+        "psllw     $2, %%xmm0      \n\t" /* (src2 + src4) * 4 */ \
+        "psllw     $2, %%xmm1      \n\t" \
+        "movdqu    (%[s3]), %%xmm4 \n\t" \
+        "movdqa    %%xmm4, %%xmm2  \n\t" \
+        "movdqa    %%xmm4, %%xmm3  \n\t" \
+        "punpcklbw %%xmm7, %%xmm2  \n\t" \
+        "punpckhbw %%xmm7, %%xmm3  \n\t" \
+        "psllw     $1, %%xmm2      \n\t" \
+        "psllw     $1, %%xmm3      \n\t" \
+        "paddw     %%xmm2, %%xmm0  \n\t" /* + src3 * 2 */ \
+        "paddw     %%xmm3, %%xmm1  \n\t" \
+        "movdqu    (%[s1]), %%xmm2 \n\t" \
+        STORE_BUF \
+        "movdqa    %%xmm2, %%xmm3  \n\t" \
+        "punpcklbw %%xmm7, %%xmm2  \n\t" \
+        "punpckhbw %%xmm7, %%xmm3  \n\t" \
+        "psubusw   %%xmm2, %%xmm0  \n\t" /* - src1 */ \
+        "psubusw   %%xmm3, %%xmm1  \n\t" \
+        "movdqu    (%[s5]), %%xmm2 \n\t" \
+        "movdqa    %%xmm2, %%xmm3  \n\t" \
+        "punpcklbw %%xmm7, %%xmm2  \n\t" \
+        "punpckhbw %%xmm7, %%xmm3  \n\t" \
+        "psubusw   %%xmm2, %%xmm0  \n\t" /* - src5 */ \
+        "psubusw   %%xmm3, %%xmm1  \n\t" \
+        "psrlw     $3, %%xmm0      \n\t" \
+        "psrlw     $3, %%xmm1      \n\t" \
+        "packuswb  %%xmm1, %%xmm0  \n\t" /* filtered */ \
+        "movdqa    %%xmm4, %%xmm2  \n\t" \
+        "movdqa    %%xmm4, %%xmm3  \n\t" \
+        "punpcklbw %%xmm7, %%xmm2  \n\t" \
+        "punpckhbw %%xmm7, %%xmm3  \n\t" \
+        "psubw     %%xmm5, %%xmm2  \n\t" /* src3 - src2 */ \
+        "psubw     %%xmm6, %%xmm3  \n\t" \
+        "movdqa    %%xmm2, %%xmm5  \n\t" \
+        "movdqa    %%xmm3, %%xmm6  \n\t" \
+        "pcmpgtw   %[lthr], %%xmm2 \n\t" \
+        "pcmpgtw   %[lthr], %%xmm3 \n\t" \
+        "pcmpgtw   %[hthr], %%xmm5 \n\t" \
+        "pcmpgtw   %[hthr], %%xmm6 \n\t" \
+        "packsswb  %%xmm3, %%xmm2  \n\t" \
+        "packsswb  %%xmm6, %%xmm5  \n\t" \
+        "pxor      %%xmm5, %%xmm2  \n\t" /* set where src3 is kept */ \
+        "movdqa    %%xmm2, %%xmm3  \n\t" \
+        "pandn     %%xmm0, %%xmm2  \n\t" \
+        "pand      %%xmm4, %%xmm3  \n\t" \
+        "por       %%xmm2, %%xmm3  \n\t" \
+        "movdqu    %%xmm3, (%[dst]) \n\t" \
+        : \
+        : [dst]  "r"(dst + X), \
+          [s1]   "r"(src1 + X), \
+          [s2]   "r"(src2 + X), \
+          [s3]   "r"(src3 + X), \
+          [s4]   "r"(src4 + X), \
+          [s5]   "r"(src5 + X), \
+          [lthr] "m"(*xmm_lthr), \
+          [hthr] "m"(*xmm_hthr) \
+        : XMM_CLOBBERS("xmm0", "xmm1", "xmm2", "xmm3", \
+                       "xmm4", "xmm5", "xmm6", "xmm7",) "memory")
+
+static void line_filter_sse2_fast(uint8_t *dst, int width, int start_width,
+                                  uint8_t *buf, uint8_t *src2, uint8_t *src3,
+                                  uint8_t *src4, uint8_t *src5)
+{
+    int X;
+    uint8_t *src1 = buf;
+    for (X = start_width; X < width - 15; X += 16)
+        SSE2_KERNEL("movdqu    %%xmm4, (%[s1]) \n\t");
+
+    line_filter_mmx_fast(dst, width, X, buf, src2, src3, src4, src5);
+}
+
+static void line_filter_sse2(uint8_t *dst, int width, int start_width,
+                             uint8_t *src1, uint8_t *src2, uint8_t *src3,
+                             uint8_t *src4, uint8_t *src5)
+{
+    int X;
+    for (X = start_width; X < width - 15; X += 16)
+        SSE2_KERNEL("");
+
+    line_filter_mmx(dst, width, X, src1, src2, src3, src4, src5);
+}
 #endif
 
 static void store_ref(struct ThisFilter *p, uint8_t *src, int src_offsets[3],
@@ -417,37 +510,16 @@ static void filter_func(struct ThisFilter *p, uint8_t *dst, int dst_offsets[3],
 #endif
 }
 
-static void *KernelThread(void *args)
+static void KernelSlice(void *arg, int this_slice, int total_slices)
 {
-    ThisFilter *filter = (ThisFilter*)args;
-
-    pthread_mutex_lock(&(filter->mutex));
-    int num = filter->actual_threads;
-    filter->actual_threads = num + 1;
-    pthread_mutex_unlock(&(filter->mutex));
-
-    while (!filter->kill_threads)
-    {
-        usleep(1000);
-        if (filter->ready &&
-            filter->frame != NULL &&
-            filter->threads[num].ready)
-        {
-            filter_func(
-                filter, filter->frame->buf, filter->frame->offsets,
-                filter->frame->pitches, filter->frame->width,
-                filter->frame->height, filter->field,
-                filter->frame->top_field_first, filter->double_rate,
-                filter->dirty_frame, num, filter->actual_threads);
-
-            pthread_mutex_lock(&(filter->mutex));
-            filter->ready = filter->ready - 1;
-            filter->threads[num].ready = 0;
-            pthread_mutex_unlock(&(filter->mutex));
-        }
-    }
-    pthread_exit(NULL);
-    return NULL;
+    ThisFilter *filter = (ThisFilter*)arg;
+
+    filter_func(
+        filter, filter->frame->buf, filter->frame->offsets,
+        filter->frame->pitches, filter->frame->width,
+        filter->frame->height, filter->field,
+        filter->frame->top_field_first, filter->double_rate,
+        filter->dirty_frame, this_slice, total_slices);
 }
 
 static int KernelDeint(VideoFilter *f, VideoFrame *frame, int field)
@@ -480,28 +552,12 @@ static int KernelDeint(VideoFilter *f, VideoFrame *frame, int field)
         }
     }
 
-    if (filter->actual_threads > 1 && filter->double_rate)
-    {
-        int i;
-        for (i = 0; i < filter->actual_threads; i++)
-            filter->threads[i].ready = 1;
-        filter->frame = frame;
-        filter->field = field;
-        filter->ready = filter->actual_threads;
-        i = 0;
-        while (filter->ready > 0 && i < 1000)
-        {
-            usleep(1000);
-            i++;
-        }
-    }
-    else
-    {
-        filter_func(
-            filter, frame->buf, frame->offsets, frame->pitches,
-            frame->width, frame->height, field, frame->top_field_first,
-            filter->double_rate, filter->dirty_frame, 0, 1);
-    }
+    // Single rate deinterlacing works in place, so it can not be sliced
+    filter->frame = frame;
+    filter->field = field;
+    filter_run_slices(f, KernelSlice, filter,
+                      filter->double_rate ? filter_slice_count(f) : 1);
+    filter->frame = NULL;
 
     filter->last_framenr = frame->frameNumber;
 
@@ -522,15 +578,6 @@ static void CleanupKernelDeintFilter(VideoFilter *f)
             free(*p);
         *p= NULL;
     }
-
-    if (filter->threads != NULL)
-    {
-        filter->kill_threads = 1;
-        for (i = 0; i < filter->requested_threads; i++)
-            if (filter->threads[i].exists)
-                pthread_join(filter->threads[i].id, NULL);
-        free(filter->threads);
-    }
 }
 
 static VideoFilter *NewKernelDeintFilter(VideoFrameType inpixfmt,
@@ -567,6 +614,11 @@ static VideoFilter *NewKernelDeintFilter(VideoFrameType inpixfmt,
         filter->line_filter = &line_filter_mmx;
         filter->line_filter_fast = &line_filter_mmx_fast;
     }
+    if (filter->mm_flags & AV_CPU_FLAG_SSE2)
+    {
+        filter->line_filter = &line_filter_sse2;
+        filter->line_filter_fast = &line_filter_sse2_fast;
+    }
 #endif
 
     filter->skipchroma   = 0;
@@ -590,67 +642,6 @@ static VideoFilter *NewKernelDeintFilter(VideoFrameType inpixfmt,
 
     filter->frame = NULL;
     filter->field = 0;
-    filter->ready = 0;
-    filter->kill_threads = 0;
-    filter->actual_threads  = 0;
-    filter->requested_threads  = threads;
-    filter->threads = NULL; 
-
-    if (filter->requested_threads > 1)
-    {
-        filter->threads = (struct DeintThread *) calloc(threads,
-                          sizeof(struct DeintThread));
-        if (filter->threads == NULL)
-        {
-            LOG(VB_GENERAL, LOG_ERR, "KernelDeint: failed to allocate memory "
-                    "for threads - falling back to existing, single thread.");
-            filter->requested_threads = 1;
-        }
-    }
-
-    if (filter->requested_threads > 1)
-    {
-        pthread_mutex_init(&(filter->mutex), NULL);
-        int success = 0;
-        for (int i = 0; i < filter->requested_threads; i++)
-        {
-            if (pthread_create(&(filter->threads[i].id), NULL,
-                               KernelThread, (void*)filter) != 0)
-                filter->threads[i].exists = 0;
-            else
-            {
-                success++;
-                filter->threads[i].exists = 1;
-            }
-        }
-
-        if (success < filter->requested_threads)
-        {
-            LOG(VB_GENERAL, LOG_NOTICE,
-                "KernelDeint: failed to create all threads - "
-                "falling back to existing, single thread.");
-        }
-        else
-        {
-            int timeout = 0;
-            while (filter->actual_threads != filter->requested_threads)
-            {
-                timeout++;
-                if (timeout > 5000)
-                {
-                    LOG(VB_GENERAL, LOG_NOTICE,
-                        "KernelDeint: waited too long for "
-                        "threads to start.- continuing.");
-                    break;
-                }
-                usleep(1000);
-            }
-            LOG(VB_PLAYBACK, LOG_INFO, "KernelDeint: Created threads.");
-        }
-    }
-
-    if (filter->actual_threads < 1 )
-        LOG(VB_PLAYBACK, LOG_INFO, "KernelDeint: Using existing thread.");
 
     return (VideoFilter *) filter;
 }
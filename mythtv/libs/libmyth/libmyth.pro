@@ -33,6 +33,7 @@ HEADERS += mythterminal.h
 HEADERS += remoteutil.h
 HEADERS += rawsettingseditor.h
 HEADERS += programinfo.h          programinfoupdater.h
+HEADERS += seekindexfile.h
 HEADERS += programtypes.h         recordingtypes.h
 HEADERS += mythrssmanager.h       netgrabbermanager.h
 HEADERS += rssparse.h             netutils.h
@@ -61,6 +62,7 @@ SOURCES += mythterminal.cpp
 SOURCES += remoteutil.cpp
 SOURCES += rawsettingseditor.cpp
 SOURCES += programinfo.cpp        programinfoupdater.cpp
+SOURCES += seekindexfile.cpp
 SOURCES += programtypes.cpp       recordingtypes.cpp
 SOURCES += mythrssmanager.cpp     netgrabbermanager.cpp
 SOURCES += rssparse.cpp           netutils.cpp
@@ -110,7 +112,7 @@ inc.files += visual.h output.h langsettings.h
 inc.files += mythexp.h mythpluginapi.h storagegroupeditor.h
 inc.files += mythconfigdialogs.h mythconfiggroups.h
 inc.files += mythterminal.h       remoteutil.h
-inc.files += programinfo.h
+inc.files += programinfo.h        seekindexfile.h
 inc.files += programtypes.h       recordingtypes.h
 inc.files += mythrssmanager.h     netgrabbermanager.h
 inc.files += rssparse.h           netutils.h
@@ -22,6 +22,7 @@ using namespace std;
 
 // MythTV headers
 #include "programinfoupdater.h"
+#include "seekindexfile.h"
 #include "mythcorecontext.h"
 #include "mythscheduler.h"
 #include "mythmiscutil.h"
@@ -3291,6 +3292,21 @@ void ProgramInfo::SaveMarkupFlag(MarkTypes type) const
     SaveMarkupMap(flagMap, type);
 }
 
+/** \brief Returns true if the position map of this recording is also
+ *         kept in a SeekIndexFile.
+ *
+ *  This is the case when the "SeekIndexFiles" setting is enabled, or
+ *  when a seek index already exists and so needs to be kept in step.
+ */
+bool ProgramInfo::UseSeekIndexFile(void) const
+{
+    if (!IsRecording() || SeekIndexFile::PathFor(pathname).isEmpty())
+        return false;
+
+    return gCoreContext->GetNumSetting("SeekIndexFiles", 0) ||
+           SeekIndexFile::Exists(pathname);
+}
+
 void ProgramInfo::QueryPositionMap(
     frm_pos_map_t &posMap, MarkTypes type) const
 {
@@ -3303,6 +3319,15 @@ void ProgramInfo::QueryPositionMap(
     }
 
     posMap.clear();
+
+    // Reading the seek index next to a local recording is much quicker
+    // than fetching one recordedseek row per keyframe.
+    if (IsRecording() && SeekIndexFile::Read(pathname, type, posMap) &&
+        !posMap.isEmpty())
+    {
+        return;
+    }
+
     MSqlQuery query(MSqlQuery::InitCon());
 
     if (IsVideo())
@@ -3346,6 +3371,14 @@ void ProgramInfo::ClearPositionMap(MarkTypes type) const
         return;
     }
 
+    if (IsRecording() && SeekIndexFile::Exists(pathname))
+    {
+        pos_map_by_type_t maps;
+        SeekIndexFile::ReadAll(pathname, maps);
+        maps.remove(type);
+        SeekIndexFile::Write(pathname, maps);
+    }
+
     MSqlQuery query(MSqlQuery::InitCon());
 
     if (IsVideo())
@@ -3423,6 +3456,39 @@ void ProgramInfo::SavePositionMap(
         return;
     }
 
+    if (UseSeekIndexFile())
+    {
+        pos_map_by_type_t maps;
+        SeekIndexFile::ReadAll(pathname, maps);
+
+        frm_pos_map_t &fileMap = maps[type];
+        frm_pos_map_t::iterator fit = fileMap.begin();
+        while (fit != fileMap.end())
+        {
+            uint64_t frame = fit.key();
+            if (((min_frame < 0) || (frame >= (uint64_t)min_frame)) &&
+                ((max_frame < 0) || (frame <= (uint64_t)max_frame)))
+            {
+                fit = fileMap.erase(fit);
+            }
+            else
+                ++fit;
+        }
+
+        frm_pos_map_t::const_iterator pit = posMap.begin();
+        for (; pit != posMap.end(); ++pit)
+        {
+            uint64_t frame = pit.key();
+            if (((min_frame < 0) || (frame >= (uint64_t)min_frame)) &&
+                ((max_frame < 0) || (frame <= (uint64_t)max_frame)))
+            {
+                fileMap[frame] = *pit;
+            }
+        }
+
+        SeekIndexFile::Write(pathname, maps);
+    }
+
     MSqlQuery query(MSqlQuery::InitCon());
     QString comp;
 
@@ -3564,6 +3630,25 @@ void ProgramInfo::SavePositionMapDelta(
             break;
         }
     }
+
+    // A seek index started in the middle of a recording, or left behind
+    // by an older version, is rewritten from the complete database map.
+    if (UseSeekIndexFile() && !SeekIndexFile::Append(pathname, type, posMap))
+    {
+        pos_map_by_type_t maps;
+        if (SeekIndexFile::ReadAll(pathname, maps))
+        {
+            frm_pos_map_t::const_iterator it = posMap.begin();
+            for (; it != posMap.end(); ++it)
+                maps[type][it.key()] = *it;
+        }
+        else
+        {
+            // There is no usable seek index, so this reads the database
+            QueryPositionMap(maps[type], type);
+        }
+        SeekIndexFile::Write(pathname, maps);
+    }
 }
 
 /// \brief Store aspect ratio of a frame in the recordedmark table
@@ -4734,15 +4819,7 @@ bool LoadFromRecorded(
     const QMap<QString, ProgramInfo*> &recMap,
     int sort)
 {
-    destination.clear();
-
-    QString     fs_db_name = "";
-    QDateTime   rectime    = MythDate::current().addSecs(
-        -gCoreContext->GetNumSetting("RecordOverTime"));
-
-    // ----------------------------------------------------------------------
-
-    QString thequery = ProgramInfo::kFromRecordedQuery;
+    QString thequery;
     if (possiblyInProgressRecordingsOnly)
         thequery += "WHERE r.endtime >= NOW() AND r.starttime <= NOW() ";
 
@@ -4751,8 +4828,37 @@ bool LoadFromRecorded(
     if (sort < 0)
         thequery += "DESC ";
 
+    return LoadFromRecorded(destination, thequery, MSqlBindings(),
+                            inUseMap, isJobRunning, recMap);
+}
+
+/** \brief Load a ProgramList from the recorded table.
+ *  \param destination     ProgramList to fill
+ *  \param sql             WHERE, ORDER BY and LIMIT clauses appended to
+ *                         the query, the recorded table is aliased as "r"
+ *  \param bindings        values for the placeholders used in \e sql
+ *  \param inUseMap        in-use programs map
+ *  \param isJobRunning    job map
+ *  \param recMap          recording map
+ *  \return true if it succeeds, false if it fails.
+ */
+bool LoadFromRecorded(
+    ProgramList &destination,
+    const QString &sql, const MSqlBindings &bindings,
+    const QMap<QString,uint32_t> &inUseMap,
+    const QMap<QString,bool> &isJobRunning,
+    const QMap<QString, ProgramInfo*> &recMap)
+{
+    destination.clear();
+
+    QDateTime   rectime    = MythDate::current().addSecs(
+        -gCoreContext->GetNumSetting("RecordOverTime"));
+
+    // ----------------------------------------------------------------------
+
     MSqlQuery query(MSqlQuery::InitCon());
-    query.prepare(thequery);
+    query.prepare(ProgramInfo::kFromRecordedQuery + sql);
+    query.bindValues(bindings);
 
     if (!query.exec())
     {
@@ -4893,6 +4999,7 @@ QString SkipTypeToString(int flags)
     bool logo  = COMM_DETECT_LOGO  & flags;
     bool exp   = COMM_DETECT_2     & flags;
     bool prePst= COMM_DETECT_PREPOSTROLL & flags;
+    bool fast  = COMM_DETECT_FAST & flags;
 
     if (blank && scene && logo)
         ret = QObject::tr("All Available Methods");
@@ -4913,6 +5020,8 @@ QString SkipTypeToString(int flags)
         ret = QObject::tr("Experimental") + ": " + ret;
     else if(prePst)
         ret = QObject::tr("Pre & Post Roll") + ": " + ret;
+    else if (fast)
+        ret = QObject::tr("Fast") + ": " + ret;
 
     return ret;
 }
@@ -4928,6 +5037,7 @@ deque<int> GetPreferredSkipTypeCombinations(void)
     tmp.push_back(COMM_DETECT_2 | COMM_DETECT_BLANK | COMM_DETECT_LOGO);
     tmp.push_back(COMM_DETECT_PREPOSTROLL | COMM_DETECT_BLANK |
                   COMM_DETECT_SCENE);
+    tmp.push_back(COMM_DETECT_FAST | COMM_DETECT_BLANK);
     return tmp;
 }
 
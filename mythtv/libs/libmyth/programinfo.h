@@ -583,6 +583,7 @@ class MPUBLIC ProgramInfo
     void SavePositionMap(frm_pos_map_t &, MarkTypes type,
                          int64_t min_frm = -1, int64_t max_frm = -1) const;
     void SavePositionMapDelta(frm_pos_map_t &, MarkTypes type) const;
+    bool UseSeekIndexFile(void) const;
 
     /// Sends event out that the ProgramInfo should be reloaded.
     void SendUpdateEvent(void);
@@ -738,6 +739,14 @@ MPUBLIC bool LoadFromRecorded(
     const QMap<QString, ProgramInfo*> &recMap,
     int                 sort = 0);
 
+MPUBLIC bool LoadFromRecorded(
+    ProgramList        &destination,
+    const QString      &sql,
+    const MSqlBindings &bindings,
+    const QMap<QString,uint32_t> &inUseMap,
+    const QMap<QString,bool> &isJobRunning,
+    const QMap<QString, ProgramInfo*> &recMap);
+
 template<typename TYPE>
 bool LoadFromScheduler(
     AutoDeleteDeque<TYPE*> &destination,
@@ -113,7 +113,11 @@ typedef enum SkipTypes {
     COMM_DETECT_PREPOSTROLL = 0x00000200,
     COMM_DETECT_PREPOSTROLL_ALL = (COMM_DETECT_PREPOSTROLL
                                    | COMM_DETECT_BLANKS
-                                   | COMM_DETECT_SCENE)
+                                   | COMM_DETECT_SCENE),
+
+    /* Works from the bitstream, only decoding keyframes. */
+    COMM_DETECT_FAST        = 0x00000400,
+    COMM_DETECT_FAST_BLANK  = COMM_DETECT_FAST | COMM_DETECT_BLANKS
 } SkipType;
 
 MPUBLIC QString SkipTypeToString(int);
@@ -36,6 +36,61 @@ vector<ProgramInfo *> *RemoteGetRecordedList(int sort)
     return info;
 }
 
+/** \brief Fetches the changes to the recording list since a list the
+ *         caller already has.
+ *
+ *  Pass 0 for \e epoch and \e generation to fetch the whole list; on
+ *  success they are set to identify the list the backend sent and should
+ *  be passed in on the next call. If \e full is set on return \e changed
+ *  holds the whole list, otherwise it holds the recordings added or
+ *  changed since the last call and \e removed holds the unique keys of
+ *  the recordings which were deleted.
+ *
+ *  \return true on success
+ */
+bool RemoteGetRecordingsSince(
+    uint &epoch, uint &generation, bool &full,
+    vector<ProgramInfo *> &changed, QStringList &removed)
+{
+    QStringList strlist(QString("QUERY_RECORDINGS_SINCE %1 %2")
+                        .arg(epoch).arg(generation));
+
+    if (!gCoreContext->SendReceiveStringList(strlist) ||
+        (strlist.size() < 4) ||
+        ((strlist[0] != "FULL") && (strlist[0] != "DELTA")))
+    {
+        return false;
+    }
+
+    bool is_full = (strlist[0] == "FULL");
+    int numrecordings = strlist[3].toInt();
+    if ((numrecordings < 0) ||
+        (numrecordings * NUMPROGRAMLINES + (is_full ? 4 : 5) >
+         (int)strlist.size()))
+    {
+        LOG(VB_GENERAL, LOG_ERR,
+            "RemoteGetRecordingsSince() list size appears to be incorrect.");
+        return false;
+    }
+
+    QStringList::const_iterator it = strlist.begin() + 4;
+    for (int i = 0; i < numrecordings; i++)
+        changed.push_back(new ProgramInfo(it, strlist.end()));
+
+    if (!is_full)
+    {
+        int numremoved = (*it).toInt();
+        for (++it; (numremoved > 0) && (it != strlist.end()); --numremoved)
+            removed.push_back(*it++);
+    }
+
+    epoch      = strlist[1].toUInt();
+    generation = strlist[2].toUInt();
+    full       = is_full;
+
+    return true;
+}
+
 bool RemoteGetLoad(float load[3])
 {
     QStringList strlist(QString("QUERY_LOAD"));
@@ -13,6 +13,9 @@ class ProgramInfo;
 class MythEvent;
 
 MPUBLIC vector<ProgramInfo *> *RemoteGetRecordedList(int sort);
+MPUBLIC bool RemoteGetRecordingsSince(
+    uint &epoch, uint &generation, bool &full,
+    vector<ProgramInfo *> &changed, QStringList &removed);
 MPUBLIC bool RemoteGetLoad(float load[3]);
 MPUBLIC bool RemoteGetUptime(time_t &uptime);
 MPUBLIC
@@ -0,0 +1,350 @@
+// C headers
+#include <stdio.h>
+#include <string.h>
+
+// Qt headers
+#include <QByteArray>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QFile>
+#include <QDir>
+
+// MythTV headers
+#include "seekindexfile.h"
+#include "mythlogging.h"
+
+#define LOC QString("SeekIndexFile: ")
+
+static const char    kSeekIndexMagic[8] = { 'M','Y','T','H','S','E','E','K' };
+static const uchar   kSeekIndexVersion  = 2;
+static const int     kSeekIndexHeaderSize = 16;
+static const int     kSeekIndexBlockHeaderSize = 6;
+/// Recorders append at least every 10 seconds, a recording modified much
+/// later than its seek index was changed by something else.
+static const int     kSeekIndexMaxLag   = 60;
+
+static void put_varint(QByteArray &buf, uint64_t val)
+{
+    while (val >= 0x80)
+    {
+        buf.append((char)((val & 0x7f) | 0x80));
+        val >>= 7;
+    }
+    buf.append((char)val);
+}
+
+static bool good_header(const uchar *data, qint64 size)
+{
+    return size >= kSeekIndexHeaderSize &&
+        !memcmp(data, kSeekIndexMagic, sizeof(kSeekIndexMagic)) &&
+        data[8] == kSeekIndexVersion;
+}
+
+static bool get_varint(const uchar *&p, const uchar *end, uint64_t &val)
+{
+    val = 0;
+    for (uint shift = 0; p < end && shift < 64; shift += 7)
+    {
+        uchar byte = *p++;
+        val |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static QByteArray make_header(void)
+{
+    QByteArray header(kSeekIndexHeaderSize, '\0');
+    memcpy(header.data(), kSeekIndexMagic, sizeof(kSeekIndexMagic));
+    header[8] = (char)kSeekIndexVersion;
+    return header;
+}
+
+static QByteArray make_block(MarkTypes type, const frm_pos_map_t &posMap)
+{
+    QByteArray block(kSeekIndexBlockHeaderSize, '\0');
+    block.append((char)(int8_t)type);
+    put_varint(block, posMap.size());
+
+    uint64_t last_frame = 0, last_offset = 0;
+    frm_pos_map_t::const_iterator it = posMap.begin();
+    for (; it != posMap.end(); ++it)
+    {
+        // Offsets only go backwards on a broken stream, but zigzag
+        // encoding keeps that from costing ten bytes per entry.
+        int64_t delta = (int64_t)(*it - last_offset);
+        put_varint(block, it.key() - last_frame);
+        put_varint(block, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+        last_frame  = it.key();
+        last_offset = *it;
+    }
+
+    uint32_t len = block.size() - kSeekIndexBlockHeaderSize;
+    block[0] = (char)(len & 0xff);
+    block[1] = (char)((len >> 8) & 0xff);
+    block[2] = (char)((len >> 16) & 0xff);
+    block[3] = (char)((len >> 24) & 0xff);
+
+    quint16 crc = qChecksum(block.constData() + kSeekIndexBlockHeaderSize,
+                            len);
+    block[4] = (char)(crc & 0xff);
+    block[5] = (char)((crc >> 8) & 0xff);
+    return block;
+}
+
+/// True if \a recording was modified well after its seek index \a path
+static bool is_stale(const QString &recording, const QString &path)
+{
+    QFileInfo recinfo(recording);
+    QFileInfo seekinfo(path);
+    if (!recinfo.exists())
+        return false;
+
+    if (seekinfo.lastModified().secsTo(recinfo.lastModified()) <=
+        kSeekIndexMaxLag)
+    {
+        return false;
+    }
+
+    LOG(VB_GENERAL, LOG_WARNING, LOC +
+        QString("Ignoring %1, it is older than the recording").arg(path));
+    return true;
+}
+
+/** \brief Returns the path of the seek index for a recording, or an empty
+ *         string if the recording is not a local file.
+ */
+QString SeekIndexFile::PathFor(const QString &recording)
+{
+    if (recording.isEmpty() || recording.contains("://") ||
+        !QDir::isAbsolutePath(recording))
+    {
+        return QString();
+    }
+    return recording + ".seek";
+}
+
+bool SeekIndexFile::Exists(const QString &recording)
+{
+    QString path = PathFor(recording);
+    return !path.isEmpty() && QFile::exists(path);
+}
+
+/** \brief Reads the entries of one MarkTypes from a recording's seek index.
+ *  \return false if there is no usable seek index for the recording
+ */
+bool SeekIndexFile::Read(const QString &recording, MarkTypes type,
+                         frm_pos_map_t &posMap)
+{
+    pos_map_by_type_t maps;
+    QString path = PathFor(recording);
+    if (path.isEmpty())
+        return false;
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || is_stale(recording, path))
+        return false;
+
+    qint64 size = file.size();
+    bool ok;
+    uchar *data = (size > 0) ? file.map(0, size) : NULL;
+    if (data)
+    {
+        ok = Parse(data, size, type, maps);
+        file.unmap(data);
+    }
+    else
+    {
+        QByteArray buf = file.readAll();
+        ok = Parse((const uchar *)buf.constData(), buf.size(), type, maps);
+    }
+
+    if (ok)
+        posMap = maps.value(type);
+    return ok;
+}
+
+/** \brief Reads the entries of every MarkTypes from a recording's seek index.
+ *  \return false if there is no usable seek index for the recording
+ */
+bool SeekIndexFile::ReadAll(const QString &recording, pos_map_by_type_t &maps)
+{
+    maps.clear();
+    QString path = PathFor(recording);
+    if (path.isEmpty())
+        return false;
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || is_stale(recording, path))
+        return false;
+
+    QByteArray buf = file.readAll();
+    if (Parse((const uchar *)buf.constData(), buf.size(), MARK_ALL, maps))
+        return true;
+
+    maps.clear();
+    return false;
+}
+
+bool SeekIndexFile::Parse(const uchar *data, qint64 size, MarkTypes type,
+                          pos_map_by_type_t &maps)
+{
+    if (!good_header(data, size))
+    {
+        LOG(VB_GENERAL, LOG_WARNING, LOC + "Ignoring file with bad header");
+        return false;
+    }
+
+    qint64 pos = kSeekIndexHeaderSize;
+    while (pos + kSeekIndexBlockHeaderSize <= size)
+    {
+        uint32_t len = data[pos] | (data[pos+1] << 8) |
+                       (data[pos+2] << 16) | ((uint32_t)data[pos+3] << 24);
+        quint16  crc = data[pos+4] | (data[pos+5] << 8);
+
+        // A short final block is one still being written
+        if (len < 2 || pos + kSeekIndexBlockHeaderSize + len > size)
+            break;
+
+        const uchar *p   = data + pos + kSeekIndexBlockHeaderSize;
+        const uchar *end = p + len;
+        pos += kSeekIndexBlockHeaderSize + len;
+
+        if (qChecksum((const char *)p, len) != crc)
+        {
+            LOG(VB_GENERAL, LOG_WARNING, LOC + "Ignoring file with bad "
+                "checksum");
+            return false;
+        }
+
+        MarkTypes blocktype = (MarkTypes)(int8_t)*p++;
+
+        if (type != MARK_ALL && blocktype != type)
+            continue;
+
+        uint64_t count;
+        if (!get_varint(p, end, count))
+        {
+            LOG(VB_GENERAL, LOG_WARNING, LOC + "Ignoring corrupt file");
+            return false;
+        }
+
+        frm_pos_map_t &posMap = maps[blocktype];
+        uint64_t frame = 0, offset = 0;
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            uint64_t dframe, doffset;
+            if (!get_varint(p, end, dframe) || !get_varint(p, end, doffset))
+            {
+                LOG(VB_GENERAL, LOG_WARNING, LOC + "Ignoring corrupt file");
+                return false;
+            }
+            frame  += dframe;
+            offset += (uint64_t)((int64_t)(doffset >> 1) ^
+                                 -(int64_t)(doffset & 1));
+            posMap[frame] = offset;
+        }
+
+        if (p != end)
+        {
+            LOG(VB_GENERAL, LOG_WARNING, LOC + "Ignoring corrupt file");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/** \brief Appends entries to a recording's existing seek index.
+ *  \return false if there is no usable seek index to append to, the
+ *          caller then needs to Write() a complete one
+ */
+bool SeekIndexFile::Append(const QString &recording, MarkTypes type,
+                           const frm_pos_map_t &posMap)
+{
+    QString path = PathFor(recording);
+    if (path.isEmpty() || posMap.isEmpty())
+        return false;
+
+    // Opening in Append mode seeks to the end, so check the header first
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || is_stale(recording, path))
+        return false;
+
+    QByteArray header = file.read(kSeekIndexHeaderSize);
+    file.close();
+    if (!good_header((const uchar *)header.constData(), header.size()) ||
+        !file.open(QIODevice::WriteOnly | QIODevice::Append))
+    {
+        return false;
+    }
+
+    // Written with a single write so a reader never sees a partial block
+    QByteArray buf = make_block(type, posMap);
+
+    if (file.write(buf) != buf.size())
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC + QString("Short write to %1")
+                .arg(path));
+        return false;
+    }
+    return true;
+}
+
+/** \brief Replaces a recording's seek index with the given entries, or
+ *         removes it if there are none.
+ */
+bool SeekIndexFile::Write(const QString &recording,
+                          const pos_map_by_type_t &maps)
+{
+    QString path = PathFor(recording);
+    if (path.isEmpty())
+        return false;
+
+    QByteArray buf = make_header();
+    pos_map_by_type_t::const_iterator it = maps.begin();
+    for (; it != maps.end(); ++it)
+    {
+        if (!it->isEmpty())
+            buf.append(make_block(it.key(), *it));
+    }
+
+    if (buf.size() == kSeekIndexHeaderSize)
+        return Remove(recording);
+
+    QString tmppath = path + ".tmp";
+    QFile file(tmppath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+        file.write(buf) != buf.size())
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC + QString("Could not write %1")
+                .arg(tmppath));
+        file.remove();
+        return false;
+    }
+    file.close();
+
+    QByteArray oldname = tmppath.toLocal8Bit();
+    QByteArray newname = path.toLocal8Bit();
+    if (rename(oldname.constData(), newname.constData()) != 0)
+    {
+        QFile::remove(path);
+        if (!QFile::rename(tmppath, path))
+        {
+            LOG(VB_GENERAL, LOG_ERR, LOC + QString("Could not rename %1")
+                    .arg(tmppath));
+            QFile::remove(tmppath);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SeekIndexFile::Remove(const QString &recording)
+{
+    QString path = PathFor(recording);
+    if (path.isEmpty() || !QFile::exists(path))
+        return true;
+    return QFile::remove(path);
+}
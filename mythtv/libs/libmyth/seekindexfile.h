@@ -0,0 +1,57 @@
+#ifndef _SEEK_INDEX_FILE_H_
+#define _SEEK_INDEX_FILE_H_
+
+// Qt headers
+#include <QString>
+#include <QMap>
+
+// MythTV headers
+#include "programtypes.h"
+#include "mythexp.h"
+
+typedef QMap<MarkTypes, frm_pos_map_t> pos_map_by_type_t;
+
+/** \brief Sidecar file holding the seek table of a recording.
+ *
+ *  The file is stored next to the recording as "<recording>.seek" and
+ *  is only used when the recording is on a local filesystem, the
+ *  recordedseek table remains the fallback for everything else.
+ *
+ *  After a 16 byte header the file is a sequence of blocks, each holding
+ *  the entries of one MarkTypes written together:
+ *
+ *    uint32  payload length, little endian
+ *    uint16  qChecksum() of the payload, little endian
+ *    int8    MarkTypes
+ *    varint  number of entries
+ *    varints frame delta and zigzag offset delta for each entry, the
+ *            first entry of a block is relative to (0, 0)
+ *
+ *  Appending a block is how RecorderBase's periodic position map saves
+ *  are written, and a truncated final block is ignored when reading, so
+ *  the file can be read while it is still being recorded. A file with a
+ *  bad block, or one last written well before the recording was, is not
+ *  used at all, so the caller falls back to the database.
+ */
+class MPUBLIC SeekIndexFile
+{
+  public:
+    static QString PathFor(const QString &recording);
+    static bool Exists(const QString &recording);
+
+    static bool Read(const QString &recording, MarkTypes type,
+                     frm_pos_map_t &posMap);
+    static bool ReadAll(const QString &recording, pos_map_by_type_t &maps);
+
+    static bool Append(const QString &recording, MarkTypes type,
+                       const frm_pos_map_t &posMap);
+    static bool Write(const QString &recording,
+                      const pos_map_by_type_t &maps);
+    static bool Remove(const QString &recording);
+
+  private:
+    static bool Parse(const uchar *data, qint64 size, MarkTypes type,
+                      pos_map_by_type_t &maps);
+};
+
+#endif // _SEEK_INDEX_FILE_H_
@@ -1,6 +1,7 @@
 #include <QAtomicInt>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QThreadStorage>
 #include <QWaitCondition>
 #include <QList>
 #include <QQueue>
@@ -12,6 +13,7 @@
 #include <QRegExp>
 #include <QVariantMap>
 #include <iostream>
+#include <algorithm>
 
 using namespace std;
 
@@ -66,7 +68,6 @@ extern "C" {
 
 static QMutex                  logQueueMutex;
 static QQueue<LoggingItem *>   logQueue;
-static QRegExp                 logRegExp = QRegExp("[%]{1,2}");
 
 static LoggerThread           *logThread = NULL;
 static QMutex                  logThreadMutex;
@@ -78,6 +79,91 @@ static QHash<uint64_t, int64_t> logThreadTidHash;
 static bool                    logThreadFinished = false;
 static bool                    debugRegistration = false;
 
+/// Records per thread in each LogRing, must be a power of two
+#define LOGRING_SIZE 64
+
+/// \brief A log message as written by LOG() into the calling thread's
+///        LogRing.  Plain data so it can be filled in without allocating.
+typedef struct {
+    qlonglong   epoch;
+    uint        usec;
+    int         line;
+    int         type;
+    LogLevel_t  level;
+    const char *file;       ///< __FILE__ of the LOG() call, not copied
+    const char *function;   ///< __FUNCTION__ of the LOG() call, not copied
+    char        message[LOGLINE_MAX+1];
+} LogRecord;
+
+/// \brief Single producer, single consumer ring of LogRecords.  The owning
+///        thread writes to it from LogPrintLine() and LoggerThread reads
+///        from it, neither of them takes a lock to do so.
+class LogRing
+{
+  public:
+    LogRing() :
+        m_threadId((uint64_t)(QThread::currentThreadId())), m_tid(0),
+        m_head(0), m_tail(0), m_busy(0), m_orphaned(0) { }
+
+    /// \brief Producer: the slot for the next record, NULL if the ring is full
+    LogRecord *Reserve(void)
+    {
+        uint head = (int)m_head;
+        if (head - (uint)m_tail.fetchAndAddAcquire(0) >= LOGRING_SIZE)
+            return NULL;
+        return &m_records[head & (LOGRING_SIZE - 1)];
+    }
+
+    /// \brief Producer: publishes the record returned by Reserve()
+    /// \return the number of records now waiting in the ring
+    uint Commit(void)
+    {
+        return (uint)m_head.fetchAndAddRelease(1) + 1 -
+               (uint)m_tail.fetchAndAddAcquire(0);
+    }
+
+    /// \brief Consumer: the oldest waiting record, NULL if the ring is empty
+    LogRecord *Peek(void)
+    {
+        uint tail = (int)m_tail;
+        if ((uint)m_head.fetchAndAddAcquire(0) == tail)
+            return NULL;
+        return &m_records[tail & (LOGRING_SIZE - 1)];
+    }
+
+    /// \brief Consumer: hands the record returned by Peek() back
+    void Release(void) { m_tail.fetchAndAddRelease(1); }
+
+  public:
+    uint64_t   m_threadId;
+    int64_t    m_tid;
+    QAtomicInt m_head;      ///< Only written by the owning thread
+    char       m_pad1[64];
+    QAtomicInt m_tail;      ///< Only written by LoggerThread
+    char       m_pad2[64];
+    QAtomicInt m_busy;      ///< Owning thread is inside LogPrintLine()
+    QAtomicInt m_orphaned;  ///< Owning thread has exited
+    LogRecord  m_records[LOGRING_SIZE];
+};
+
+/// \brief Per-thread handle on a LogRing.  It is deleted by QThreadStorage
+///        when the thread exits, the ring itself is freed by LoggerThread
+///        once it has been emptied.
+class LogRingHandle
+{
+  public:
+    LogRingHandle(LogRing *ring) : m_ring(ring) { }
+    ~LogRingHandle() { m_ring->m_orphaned.fetchAndStoreRelease(1); }
+    LogRing *m_ring;
+};
+
+static QThreadStorage<LogRingHandle *> logRingStorage;
+static QMutex                  logRingsMutex;
+static QList<LogRing *>        logRings;    // protected by logRingsMutex
+static QAtomicInt              logRingsActive(0);
+
+static int64_t loggingCurrentTid(void);
+
 typedef struct {
     bool    propagate;
     int     quiet;
@@ -229,20 +315,28 @@ void LoggingItem::setThreadTid(void)
     m_tid = logThreadTidHash.value(m_threadId, -1);
     if (m_tid == -1)
     {
-        m_tid = 0;
+        m_tid = loggingCurrentTid();
+        logThreadTidHash[m_threadId] = m_tid;
+    }
+}
+
+/// \brief Get the OS thread ID of the calling thread
+static int64_t loggingCurrentTid(void)
+{
+    int64_t tid = 0;
 
 #if defined(linux)
-        m_tid = (int64_t)syscall(SYS_gettid);
+    tid = (int64_t)syscall(SYS_gettid);
 #elif defined(__FreeBSD__)
-        long lwpid;
-        int dummy = thr_self( &lwpid );
-        (void)dummy;
-        m_tid = (int64_t)lwpid;
+    long lwpid;
+    int dummy = thr_self( &lwpid );
+    (void)dummy;
+    tid = (int64_t)lwpid;
 #elif CONFIG_DARWIN
-        m_tid = (int64_t)mach_thread_self();
+    tid = (int64_t)mach_thread_self();
 #endif
-        logThreadTidHash[m_threadId] = m_tid;
-    }
+
+    return tid;
 }
 
 /// \brief LoggerThread constructor.  Enables debugging of thread registration
@@ -253,7 +347,7 @@ LoggerThread::LoggerThread(QString filename, bool progress, bool quiet,
     MThread("Logger"),
     m_waitNotEmpty(new QWaitCondition()),
     m_waitEmpty(new QWaitCondition()),
-    m_aborted(false), m_initialWaiting(true),
+    m_aborted(false), m_ringsPending(false), m_initialWaiting(true),
     m_filename(filename), m_progress(progress),
     m_quiet(quiet), m_appname(QCoreApplication::applicationName()),
     m_tablename(table), m_facility(facility), m_pid(getpid()),
@@ -294,6 +388,80 @@ LoggerThread::~LoggerThread()
     delete m_waitEmpty;
 }
 
+/// \brief Orders LoggingItems by time, with a thread's registration before
+///        and its deregistration after any messages in the same microsecond
+static bool logItemLessThan(const LoggingItem *a, const LoggingItem *b)
+{
+    if (a->epoch() != b->epoch())
+        return a->epoch() < b->epoch();
+    if (a->usec() != b->usec())
+        return a->usec() < b->usec();
+
+    int ranka = (a->type() & kRegistering) ? 0 :
+                (a->type() & kDeregistering) ? 2 : 1;
+    int rankb = (b->type() & kRegistering) ? 0 :
+                (b->type() & kDeregistering) ? 2 : 1;
+    return ranka < rankb;
+}
+
+/// \brief Moves the records waiting in the per-thread LogRings into batch
+///        as LoggingItems, and frees the rings of threads that have exited.
+void LoggerThread::drainRings(QList<LoggingItem *> &batch)
+{
+    QMutexLocker locker(&logRingsMutex);
+
+    QList<LogRing *>::iterator it = logRings.begin();
+    while (it != logRings.end())
+    {
+        LogRing *ring = *it;
+        bool orphaned = ring->m_orphaned.fetchAndAddAcquire(0);
+
+        LogRecord *rec;
+        while ((rec = ring->Peek()) != NULL)
+        {
+            LoggingItem *item = new LoggingItem();
+            item->m_threadId = ring->m_threadId;
+            item->m_tid      = ring->m_tid;
+            item->m_epoch    = rec->epoch;
+            item->m_usec     = rec->usec;
+            item->m_line     = rec->line;
+            item->m_type     = (LoggingType)rec->type;
+            item->m_level    = rec->level;
+            item->m_file     = strdup(rec->file);
+            item->m_function = strdup(rec->function);
+            memcpy(item->m_message, rec->message, LOGLINE_MAX+1);
+            ring->Release();
+
+            batch.push_back(item);
+        }
+
+        if (orphaned)
+        {
+            delete ring;
+            it = logRings.erase(it);
+        }
+        else
+            ++it;
+    }
+}
+
+/// \brief Stops LogPrintLine() from writing to the LogRings, and waits
+///        for any writes in progress to finish.
+void LoggerThread::stopRings(void)
+{
+    if (!logRingsActive.fetchAndStoreOrdered(0))
+        return;
+
+    QMutexLocker locker(&logRingsMutex);
+
+    QList<LogRing *>::iterator it = logRings.begin();
+    for (; it != logRings.end(); ++it)
+    {
+        while ((*it)->m_busy.fetchAndAddOrdered(0))
+            usleep(100);
+    }
+}
+
 /// \brief Run the logging thread.  This thread reads from the logging queue,
 ///        and handles distributing the LoggingItems to each logger instance.
 ///        The thread will not exit until the logging queue is emptied
@@ -370,29 +538,55 @@ void LoggerThread::run(void)
         m_heartbeatTimer->start(1000);
     }
 
+    logRingsActive.fetchAndStoreOrdered(1);
+
     QMutexLocker qLock(&logQueueMutex);
 
-    while (!m_aborted || !logQueue.isEmpty())
+    while (true)
     {
+        bool aborted = m_aborted;
+
         qLock.unlock();
         qApp->processEvents(QEventLoop::AllEvents, 10);
         qApp->sendPostedEvents(NULL, QEvent::DeferredDelete);
 
+        // Once stopping, send new messages to logQueue so that the rings
+        // can be emptied for good.
+        if (aborted)
+            stopRings();
+
+        // Take the queue before the rings, so every ring record written
+        // before a queued (de)registration is in the same batch as it.
         qLock.relock();
-        if (logQueue.isEmpty())
+        QList<LoggingItem *> batch = logQueue;
+        logQueue.clear();
+        m_ringsPending = false;
+        qLock.unlock();
+
+        drainRings(batch);
+
+        if (batch.isEmpty())
         {
+            qLock.relock();
+            if (aborted && logQueue.isEmpty())
+                break;
             m_waitEmpty->wakeAll();
-            m_waitNotEmpty->wait(qLock.mutex(), 100);
+            // A record committed during the drain may have missed it
+            if (!m_ringsPending)
+                m_waitNotEmpty->wait(qLock.mutex(), 100);
             continue;
         }
 
-        LoggingItem *item = logQueue.dequeue();
-        qLock.unlock();
+        stable_sort(batch.begin(), batch.end(), logItemLessThan);
 
-        fillItem(item);
-        handleItem(item);
-        logConsole(item);
-        item->DecrRef();
+        QList<LoggingItem *>::iterator it = batch.begin();
+        for (; it != batch.end(); ++it)
+        {
+            fillItem(*it);
+            handleItem(*it);
+            logConsole(*it);
+            (*it)->DecrRef();
+        }
 
         qLock.relock();
     }
@@ -647,6 +841,14 @@ void LoggerThread::stop(void)
     m_waitNotEmpty->wakeAll();
 }
 
+/// \brief Wakes the thread up after a ring has become non-empty
+void LoggerThread::wakeUp(void)
+{
+    QMutexLocker qLock(&logQueueMutex);
+    m_ringsPending = true;
+    m_waitNotEmpty->wakeAll();
+}
+
 /// \brief  Wait for the queue to be flushed (up to a timeout)
 /// \param  timeoutMS   The number of ms to wait for the queue to flush
 /// \return true if the queue is empty, false otherwise
@@ -708,6 +910,79 @@ LoggingItem *LoggingItem::create(QByteArray &buf)
 }
 
 
+/// \brief  Get the calling thread's LogRing, creating it on first use
+static LogRing *logGetRing(void)
+{
+    LogRingHandle *handle = logRingStorage.localData();
+    if (handle)
+        return handle->m_ring;
+
+    LogRing *ring = new LogRing();
+    ring->m_tid = loggingCurrentTid();
+
+    {
+        QMutexLocker locker(&logThreadTidMutex);
+        logThreadTidHash[ring->m_threadId] = ring->m_tid;
+    }
+
+    {
+        QMutexLocker locker(&logRingsMutex);
+        logRings.push_back(ring);
+    }
+
+    logRingStorage.setLocalData(new LogRingHandle(ring));
+    return ring;
+}
+
+/// \brief  Format a log message straight into the calling thread's LogRing.
+///         Apart from creating the ring the first time a thread logs this
+///         neither locks nor allocates.
+/// \return false if the message was not queued because the ring is full
+///         or LoggerThread is stopping, the caller must then use logQueue
+static bool logRingPrint(LogLevel_t level, const char *file, int line,
+                         const char *function, int type, int fromQString,
+                         const char *format, va_list arguments)
+{
+    LogRing *ring = logGetRing();
+
+    // Paired with LoggerThread::stopRings(), which clears logRingsActive
+    // and then waits for m_busy to drop.
+    ring->m_busy.fetchAndStoreOrdered(1);
+
+    LogRecord *rec = NULL;
+    if (logRingsActive.fetchAndAddOrdered(0))
+        rec = ring->Reserve();
+
+    if (!rec)
+    {
+        ring->m_busy.fetchAndStoreRelease(0);
+        return false;
+    }
+
+    loggingGetTimeStamp(&rec->epoch, &rec->usec);
+    rec->line     = line;
+    rec->type     = type;
+    rec->level    = level;
+    rec->file     = file;
+    rec->function = function;
+
+    if (fromQString)
+    {
+        strncpy(rec->message, format, LOGLINE_MAX - 1);
+        rec->message[LOGLINE_MAX - 1] = '\0';
+    }
+    else
+        vsnprintf(rec->message, LOGLINE_MAX, format, arguments);
+
+    // LoggerThread drains every ring once woken, so only the first record
+    // of a burst has to wake it.
+    if (ring->Commit() == 1)
+        logThread->wakeUp();
+
+    ring->m_busy.fetchAndStoreRelease(0);
+    return true;
+}
+
 /// \brief  Format and send a log message into the queue.  This is called from
 ///         the LOG() macro.  The intention is minimal blocking of the caller.
 /// \param  mask    Verbosity mask of the message (VB_*)
@@ -728,26 +1003,35 @@ void LogPrintLine( uint64_t mask, LogLevel_t level, const char *file, int line,
     int type = kMessage;
     type |= (mask & VB_FLUSH) ? kFlush : 0;
     type |= (mask & VB_STDIO) ? kStandardIO : 0;
+
+    // Flushes have to wait for LoggerThread, so they stay on the slow path
+    if (!(type & kFlush) && logRingsActive.fetchAndAddRelaxed(0))
+    {
+        va_start(arguments, format);
+        bool queued = logRingPrint(level, file, line, function, type,
+                                   fromQString, format, arguments);
+        va_end(arguments);
+        if (queued)
+            return;
+    }
+
     LoggingItem *item = LoggingItem::create(file, function, line, level,
                                             (LoggingType)type);
     if (!item)
         return;
 
-    char *formatcopy = NULL;
-    if( fromQString && strchr(format, '%') )
+    // A QString message is already formatted, use it as is
+    if (fromQString)
     {
-        QString string(format);
-        format = strdup(string.replace(logRegExp, "%%").toLocal8Bit()
-                              .constData());
-        formatcopy = (char *)format;
+        strncpy(item->m_message, format, LOGLINE_MAX - 1);
+        item->m_message[LOGLINE_MAX - 1] = '\0';
+    }
+    else
+    {
+        va_start(arguments, format);
+        vsnprintf(item->m_message, LOGLINE_MAX, format, arguments);
+        va_end(arguments);
     }
-
-    va_start(arguments, format);
-    vsnprintf(item->m_message, LOGLINE_MAX, format, arguments);
-    va_end(arguments);
-
-    if (formatcopy)
-        free(formatcopy);
 
     QMutexLocker qLock(&logQueueMutex);
 
@@ -173,7 +173,11 @@ class LoggerThread : public QObject, public MThread
     bool flush(int timeoutMS = 200000);
     void handleItem(LoggingItem *item);
     void fillItem(LoggingItem *item);
+    void wakeUp(void);
   private:
+    void drainRings(QList<LoggingItem *> &batch);
+    void stopRings(void);
+
     QWaitCondition *m_waitNotEmpty; ///< Condition variable for waiting
                                     ///  for the queue to not be empty
                                     ///  Protected by logQueueMutex
@@ -182,6 +186,9 @@ class LoggerThread : public QObject, public MThread
                                     ///  Protected by logQueueMutex
     bool m_aborted;                 ///< Flag to abort the thread.
                                     ///  Protected by logQueueMutex
+    bool m_ringsPending;            ///< A ring became non-empty since the
+                                    ///  last drain.
+                                    ///  Protected by logQueueMutex
     volatile bool m_initialWaiting; ///< Waiting for the initial response from
                                     ///  mythlogserver
     QString m_filename; ///< Filename of debug logfile
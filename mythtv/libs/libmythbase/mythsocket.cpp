@@ -9,6 +9,15 @@
 #ifndef USING_MINGW
 #include <sys/select.h> // for select
 #endif
+#ifdef __linux__
+#include <sys/sendfile.h> // for sendfile
+#endif
+#include <unistd.h>
+
+// C++
+#include <algorithm>
+#include <vector>
+using namespace std;
 
 // Qt
 #include <QByteArray>
@@ -496,6 +505,90 @@ bool MythSocket::writeData(const char *data, quint64 len)
     return true;
 }
 
+/** \brief Writes len bytes of an open file to the socket.
+ *
+ *   On Linux the data is handed from the page cache straight to the
+ *   socket with sendfile(), elsewhere it is read into a bounce buffer
+ *   and passed to writeData().
+ *
+ *  \param filefd descriptor of a regular file open for reading
+ *  \param offset position in the file, advanced by the bytes sent
+ *  \param len    number of bytes to send
+ *  \return true if all len bytes were sent
+ */
+bool MythSocket::writeFile(int filefd, qint64 &offset, quint64 len)
+{
+    if (state() != Connected)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            "writeFile: Error, called with unconnected socket.");
+        return false;
+    }
+
+#ifdef __linux__
+    quint64 written = 0;
+    uint zerocnt = 0;
+
+    while (written < len)
+    {
+        off_t off = offset;
+        ssize_t sret = sendfile(socket(), filefd, &off, len - written);
+        if (sret > 0)
+        {
+            zerocnt = 0;
+            written += sret;
+            offset  += sret;
+        }
+        else if (sret == 0)
+        {
+            LOG(VB_GENERAL, LOG_ERR, LOC +
+                QString("writeFile: Error, file ended %1 bytes early")
+                    .arg(len - written));
+            return false;
+        }
+        else if (errno != EAGAIN && errno != EINTR)
+        {
+            LOG(VB_GENERAL, LOG_ERR, LOC + "writeFile: Error, sendfile" + ENO);
+            close();
+            return false;
+        }
+        else
+        {
+            zerocnt++;
+            if (zerocnt > 5000)
+            {
+                LOG(VB_GENERAL, LOG_ERR, LOC +
+                    "writeFile: Error, zerocnt timeout");
+                return false;
+            }
+            usleep(1000);
+        }
+    }
+    return true;
+#else
+    vector<char> buf(kSocketBufferSize);
+    quint64 written = 0;
+
+    while (written < len)
+    {
+        quint64 btr = min(len - written, (quint64) kSocketBufferSize);
+        if (lseek(filefd, offset, SEEK_SET) != offset)
+            return false;
+        ssize_t rret = read(filefd, &buf[0], btr);
+        if (rret <= 0)
+        {
+            LOG(VB_GENERAL, LOG_ERR, LOC + "writeFile: Error, read" + ENO);
+            return false;
+        }
+        if (!writeData(&buf[0], rret))
+            return false;
+        written += rret;
+        offset  += rret;
+    }
+    return true;
+#endif
+}
+
 bool MythSocket::readStringList(QStringList &list, uint timeoutMS)
 {
     list.clear();
@@ -76,6 +76,7 @@ class MBASE_PUBLIC MythSocket :
     bool SendReceiveStringList(QStringList &list, uint min_reply_length = 0);
     bool readData(char *data, quint64 len);
     bool writeData(const char *data, quint64 len);
+    bool writeFile(int filefd, qint64 &offset, quint64 len);
 
     bool connect(const QHostAddress &hadr, quint16 port);
     bool connect(const QString &host, quint16 port);
@@ -99,7 +99,9 @@ namespace
 
                     // Since we are dealing with a subdirectory failure is fine,
                     // so we'll just ignore the failue and continue
-                    (void) scan_dir(p->absoluteFilePath(), dh, ext_settings);
+                    if (dh)
+                        (void) scan_dir(p->absoluteFilePath(), dh,
+                                        ext_settings);
                 }
             }
 
@@ -185,8 +187,9 @@ namespace
                 // subdirectories so ignore the results and continue. As long
                 // as we reached it once to make it this far than we know the 
                 // SG/Path exists
-                (void) scan_sg_dir(start_path + "/" + fileName, host, base_path,
-                             dh, ext_settings, isMaster);
+                if (dh)
+                    (void) scan_sg_dir(start_path + "/" + fileName, host,
+                                       base_path, dh, ext_settings, isMaster);
             }
             else
             {
@@ -7,6 +7,7 @@ class META_PUBLIC DirectoryHandler
 {
   public:
     virtual ~DirectoryHandler();
+    // Returns the handler for the subdirectory, or NULL to skip it
     virtual DirectoryHandler *newDir(const QString &dir_name,
                                      const QString &fq_dir_name) = 0;
     virtual void handleFile(const QString &file_name,
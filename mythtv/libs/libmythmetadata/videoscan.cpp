@@ -1,8 +1,12 @@
 #include <QImageReader>
 #include <QApplication>
+#include <QRunnable>
+#include <QFileInfo>
+#include <QDir>
 #include <QUrl>
 
 #include "mythcontext.h"
+#include "mythdbcon.h"
 #include "mythscreenstack.h"
 #include "mythprogressdialog.h"
 #include "mythdialogbox.h"
@@ -16,6 +20,8 @@
 #include "remoteutil.h"
 #include "mythlogging.h"
 #include "mythdate.h"
+#include "mthreadpool.h"
+#include "storagegroup.h"
 
 QEvent::Type VideoScanChanges::kEventType =
     (QEvent::Type) QEvent::registerEventType();
@@ -27,8 +33,9 @@ namespace
     {
       public:
         dirhandler(DirListType &video_files,
-                   const QStringList &image_extensions) :
-            m_video_files(video_files)
+                   const QStringList &image_extensions,
+                   bool recursive = true) :
+            m_video_files(video_files), m_recursive(recursive)
         {
             for (QStringList::const_iterator p = image_extensions.begin();
                  p != image_extensions.end(); ++p)
@@ -42,7 +49,7 @@ namespace
         {
             (void) dir_name;
             (void) fq_dir_name;
-            return this;
+            return m_recursive ? this : NULL;
         }
 
         void handleFile(const QString &file_name,
@@ -67,16 +74,59 @@ namespace
         typedef std::set<QString> image_ext;
         image_ext m_image_ext;
         DirListType &m_video_files;
+        bool m_recursive;
     };
+
+    /// Path of \a path relative to the storage group directory \a base,
+    /// which is how storage group videos are stored in the database.
+    QString relative_path(const QString &path, const QString &base)
+    {
+        if (base.isEmpty())
+            return path;
+
+        QString rel = path.mid(base.length());
+        while (rel.startsWith("/"))
+            rel.remove(0, 1);
+        return rel;
+    }
 }
 
+/// Lists one of the directories of a full scan in a pool thread
+class VideoScanDirTask : public QRunnable
+{
+  public:
+    VideoScanDirTask(VideoScannerThread *scanner,
+                     VideoScannerThread::DirScan &scan,
+                     const QStringList &imageExtensions,
+                     const FileAssociations::ext_ignore_list &ext_list) :
+        m_scanner(scanner), m_scan(scan),
+        m_imageExtensions(imageExtensions), m_extList(ext_list)
+    {
+    }
+
+    void run(void)
+    {
+        m_scan.ok = m_scanner->buildFileList(m_scan.directory,
+                                             m_imageExtensions, m_extList,
+                                             m_scan.files);
+        m_scanner->directoryScanned();
+    }
+
+  private:
+    VideoScannerThread                      *m_scanner;
+    VideoScannerThread::DirScan             &m_scan;
+    const QStringList                       &m_imageExtensions;
+    const FileAssociations::ext_ignore_list &m_extList;
+};
+
 class VideoMetadataListManager;
 class MythUIProgressDialog;
 
 VideoScannerThread::VideoScannerThread(QObject *parent) :
     MThread("VideoScanner"),
     m_RemoveAll(false), m_KeepAll(false),
-    m_DBDataChanged(false)
+    m_dialog(NULL), m_DBDataChanged(false),
+    m_scanned(false), m_cancel(false), m_progress(0)
 {
     m_parent = parent;
     m_dbmetadata = new VideoMetadataListManager;
@@ -145,10 +195,40 @@ void VideoScannerThread::SetDirs(QStringList dirs)
     m_directories = dirs;
 }
 
+/** \brief Limits the next scan to directories on this host which changed.
+ *
+ *  Only the given directories are listed, and only database entries
+ *  for \a host in them are checked, instead of every video directory
+ *  and the whole videometadata table. \a host should be empty if the
+ *  directories aren't in a storage group.
+ */
+void VideoScannerThread::SetChangedDirs(const QString &host,
+                                        const ChangedDirList &dirs)
+{
+    m_changedHost = host.toLower();
+    m_changedDirs = dirs;
+    m_liveSGHosts.clear();
+    if (!m_changedHost.isEmpty())
+        m_liveSGHosts << m_changedHost;
+}
+
 void VideoScannerThread::run()
 {
     RunProlog();
 
+    bool incremental = !m_changedDirs.isEmpty();
+    m_scanned = false;
+    m_busyDirs.clear();
+
+    // A full scan and a watcher's incremental scan must not run at the
+    // same time, they would both add the same new files.
+    MSqlQuery lock(MSqlQuery::InitCon(MSqlQuery::kDedicatedConnection));
+    if (!lockScan(lock, !incremental))
+    {
+        RunEpilog();
+        return;
+    }
+
     VideoMetadataListManager::metadata_list ml;
     VideoMetadataListManager::loadAllFromDatabase(ml);
     m_dbmetadata->setList(ml);
@@ -161,44 +241,45 @@ void VideoScannerThread::run()
         imageExtensions.push_back(QString(*p));
     }
 
-    LOG(VB_GENERAL, LOG_INFO, QString("Beginning Video Scan."));
+    FileAssociations::ext_ignore_list ext_list;
+    FileAssociations::getFileAssociation().getExtensionIgnoreList(ext_list);
 
-    uint counter = 0;
     FileCheckList fs_files;
 
-    if (m_HasGUI)
-        SendProgressEvent(counter, (uint)m_directories.size(),
-                          QObject::tr("Searching for video files"));
-    for (QStringList::const_iterator iter = m_directories.begin();
-         iter != m_directories.end(); ++iter)
+    if (incremental)
     {
-        if (!buildFileList(*iter, imageExtensions, fs_files))
-        {
-            if (iter->startsWith("myth://"))
-            {
-                QUrl sgurl = *iter;
-                QString host = sgurl.host().toLower();
-                QString path = sgurl.path();
-
-                m_liveSGHosts.removeAll(host);
+        LOG(VB_GENERAL, LOG_INFO,
+            QString("Beginning Video Scan of %1 changed directories.")
+                .arg(m_changedDirs.size()));
+        scanChangedDirs(imageExtensions, ext_list, fs_files);
+    }
+    else
+    {
+        LOG(VB_GENERAL, LOG_INFO, QString("Beginning Video Scan."));
+        scanDirectories(imageExtensions, ext_list, fs_files);
+    }
 
-                LOG(VB_GENERAL, LOG_ERR,
-                    QString("Failed to scan :%1:").arg(*iter));
-            }
-        }
-        if (m_HasGUI)
-            SendProgressEvent(++counter);
+    if (m_cancel)
+    {
+        unlockScan(lock);
+        RunEpilog();
+        return;
     }
 
     PurgeList db_remove;
     verifyFiles(fs_files, db_remove);
+    if (incremental)
+        dropBusyFiles(fs_files);
     m_DBDataChanged = updateDB(fs_files, db_remove);
+    m_scanned = !m_cancel;
+    unlockScan(lock);
 
     if (m_DBDataChanged)
     {
-        QCoreApplication::postEvent(m_parent,
-            new VideoScanChanges(m_addList, m_movList,
-                                 m_delList));
+        if (m_parent)
+            QCoreApplication::postEvent(m_parent,
+                new VideoScanChanges(m_addList, m_movList,
+                                     m_delList));
 
         QStringList slist;
 
@@ -214,12 +295,257 @@ void VideoScannerThread::run()
 
         gCoreContext->SendEvent(me);
     }
-    else
+    else if (!incremental)
         gCoreContext->SendMessage("VIDEO_LIST_NO_CHANGE");
 
     RunEpilog();
 }
 
+/** \brief Lists every video directory for a full scan.
+ *
+ *  The directories are listed in parallel, each into its own file list,
+ *  and the lists are merged in directory order afterwards, so a file
+ *  found in more than one directory gets the same host as it did when
+ *  they were listed one after the other.
+ */
+void VideoScannerThread::scanDirectories(
+    const QStringList &imageExtensions,
+    const FileAssociations::ext_ignore_list &ext_list,
+    FileCheckList &filelist)
+{
+    m_progress = 0;
+    if (m_HasGUI)
+        SendProgressEvent(m_progress, (uint)m_directories.size(),
+                          QObject::tr("Searching for video files"));
+
+    std::vector<DirScan> scans(m_directories.size());
+    for (int i = 0; i < m_directories.size(); ++i)
+    {
+        scans[i].directory = m_directories[i];
+        scans[i].ok = false;
+    }
+
+    int threads = gCoreContext->GetNumSetting("VideoScanThreads", 4);
+    threads = (threads < 1) ? 1 : threads;
+    threads = (threads > (int)scans.size()) ? (int)scans.size() : threads;
+
+    if (threads <= 1)
+    {
+        for (uint i = 0; i < scans.size(); ++i)
+        {
+            scans[i].ok = buildFileList(scans[i].directory, imageExtensions,
+                                        ext_list, scans[i].files);
+            directoryScanned();
+        }
+    }
+    else
+    {
+        MThreadPool pool("VideoScanner");
+        pool.setMaxThreadCount(threads);
+        for (uint i = 0; i < scans.size(); ++i)
+        {
+            pool.start(new VideoScanDirTask(this, scans[i], imageExtensions,
+                                            ext_list), "VideoScanDir");
+        }
+        pool.waitForDone();
+    }
+
+    for (uint i = 0; i < scans.size(); ++i)
+    {
+        if (!scans[i].ok && scans[i].directory.startsWith("myth://"))
+        {
+            QUrl sgurl = scans[i].directory;
+            QString host = sgurl.host().toLower();
+
+            m_liveSGHosts.removeAll(host);
+
+            LOG(VB_GENERAL, LOG_ERR,
+                QString("Failed to scan :%1:").arg(scans[i].directory));
+        }
+
+        FileCheckList::const_iterator p = scans[i].files.begin();
+        for (; p != scans[i].files.end(); ++p)
+            filelist[p->first] = p->second;
+    }
+}
+
+/** \brief Lists the directories given to SetChangedDirs().
+ *
+ *  A directory which no longer exists is scanned as empty, so its videos
+ *  are removed, unless the storage group directory containing it is gone
+ *  as well, which usually means a file system isn't mounted. Those are
+ *  left out of the scan entirely.
+ */
+void VideoScannerThread::scanChangedDirs(
+    const QStringList &imageExtensions,
+    const FileAssociations::ext_ignore_list &ext_list,
+    FileCheckList &filelist)
+{
+    ChangedDirList scanned;
+    m_changedPaths.clear();
+    m_busyDirs.clear();
+
+    m_groupDirs.clear();
+    if (!m_changedHost.isEmpty())
+        m_groupDirs = StorageGroup("Videos", m_changedHost, false)
+                          .GetDirList();
+
+    ChangedDirList::const_iterator it = m_changedDirs.begin();
+    for (; (it != m_changedDirs.end()) && !m_cancel; ++it)
+    {
+        QString top = it->base.isEmpty() ? it->path : it->base;
+        if (!QDir(top).exists())
+        {
+            LOG(VB_GENERAL, LOG_WARNING,
+                QString("%1 is not available, not scanning %2")
+                    .arg(top).arg(it->path));
+            continue;
+        }
+
+        scanned.push_back(*it);
+
+        if (!QDir(it->path).exists())
+            continue;
+
+        FileCheckList local;
+        buildFileList(it->path, imageExtensions, ext_list, local,
+                      it->recursive);
+
+        FileCheckList::const_iterator p = local.begin();
+        for (; p != local.end(); ++p)
+        {
+            QString filename = relative_path(p->first, it->base);
+            filelist[filename].check = false;
+            filelist[filename].host = m_changedHost;
+            m_changedPaths[filename] = p->first;
+        }
+    }
+
+    m_changedDirs = scanned;
+}
+
+/// Whether \a filename is in one of the directories of an incremental scan
+bool VideoScannerThread::inChangedDirs(const QString &filename) const
+{
+    ChangedDirList::const_iterator it = m_changedDirs.begin();
+    for (; it != m_changedDirs.end(); ++it)
+    {
+        QString dir = relative_path(it->path, it->base);
+        QString prefix = dir.isEmpty() ? dir : dir + "/";
+
+        if (!filename.startsWith(prefix))
+            continue;
+
+        if (it->recursive || (filename.indexOf('/', prefix.length()) < 0))
+            return true;
+    }
+
+    return false;
+}
+
+/// Whether \a filename exists in any of the storage group directories
+bool VideoScannerThread::inGroupDirs(const QString &filename) const
+{
+    QStringList::const_iterator it = m_groupDirs.begin();
+    for (; it != m_groupDirs.end(); ++it)
+    {
+        if (QFileInfo(*it + "/" + filename).exists())
+            return true;
+    }
+
+    return false;
+}
+
+/** \brief Leaves out new files which are still being written.
+ *
+ *  A directory is reported as changed as soon as a file is created in
+ *  it, adding the file then would store a hash of whatever was copied so
+ *  far. Their directories are returned by GetBusyDirs() to be scanned
+ *  again later.
+ */
+void VideoScannerThread::dropBusyFiles(FileCheckList &files)
+{
+    QDateTime settled = MythDate::current().addSecs(-60);
+
+    FileCheckList::iterator p = files.begin();
+    while (p != files.end())
+    {
+        QString path = m_changedPaths[p->first];
+        QFileInfo fi(path);
+
+        if (p->second.check || (fi.lastModified().toUTC() < settled))
+        {
+            ++p;
+            continue;
+        }
+
+        LOG(VB_GENERAL, LOG_INFO,
+            QString("%1 is still changing, not adding it yet").arg(path));
+
+        if (!m_busyDirs.contains(fi.absolutePath()))
+            m_busyDirs << fi.absolutePath();
+        files.erase(p++);
+    }
+}
+
+void VideoScannerThread::directoryScanned(void)
+{
+    if (!m_HasGUI)
+        return;
+
+    QMutexLocker locker(&m_progressLock);
+    SendProgressEvent(++m_progress);
+}
+
+
+/** \brief Takes the database lock which keeps video scans on every host
+ *         from running at the same time.
+ *
+ *  The lock belongs to the connection of \a query. If \a wait is false
+ *  this gives up at once when another scan holds the lock, otherwise it
+ *  waits until the lock is free or the scan is cancelled.
+ */
+bool VideoScannerThread::lockScan(MSqlQuery &query, bool wait)
+{
+    bool waiting = false;
+
+    while (!m_cancel)
+    {
+        query.prepare("SELECT GET_LOCK('videoScanLock', :TIMEOUT)");
+        query.bindValue(":TIMEOUT", wait ? 5 : 0);
+        if (!query.exec() || !query.next())
+        {
+            MythDB::DBError("VideoScannerThread::lockScan", query);
+            return false;
+        }
+
+        if (query.value(0).toBool())
+            return true;
+
+        if (!wait)
+        {
+            LOG(VB_GENERAL, LOG_INFO,
+                "Another video scan is running, not scanning now");
+            return false;
+        }
+
+        if (!waiting)
+        {
+            LOG(VB_GENERAL, LOG_INFO,
+                "Waiting for another video scan to finish");
+            waiting = true;
+        }
+    }
+
+    return false;
+}
+
+void VideoScannerThread::unlockScan(MSqlQuery &query)
+{
+    query.prepare("SELECT RELEASE_LOCK('videoScanLock')");
+    if (!query.exec())
+        MythDB::DBError("VideoScannerThread::unlockScan", query);
+}
 
 void VideoScannerThread::removeOrphans(unsigned int id,
                                        const QString &filename)
@@ -254,6 +580,16 @@ void VideoScannerThread::verifyFiles(FileCheckList &files,
     {
         QString lname = (*p)->GetFilename();
         QString lhost = (*p)->GetHost().toLower();
+
+        // An incremental scan only knows about the changed directories
+        if (!m_changedDirs.isEmpty() &&
+            ((lhost != m_changedHost) || !inChangedDirs(lname)))
+        {
+            if (m_HasGUI)
+                SendProgressEvent(++counter);
+            continue;
+        }
+
         if (lname != QString::null)
         {
             iter = files.find(lname);
@@ -274,6 +610,14 @@ void VideoScannerThread::verifyFiles(FileCheckList &files,
                 // cannot reach, mark it as for removal later.
                 remove.push_back(std::make_pair((*p)->GetID(), lname));
             }
+            else if (!m_changedDirs.isEmpty() && inGroupDirs(lname))
+            {
+                // Moved to another directory of the storage group, which
+                // is found under the same name.
+                LOG(VB_GENERAL, LOG_DEBUG,
+                    QString("Keeping :%1:, it is in another directory")
+                        .arg(lname));
+            }
             else if (m_liveSGHosts.contains(lhost))
             {
                 LOG(VB_GENERAL, LOG_INFO,
@@ -303,7 +647,8 @@ bool VideoScannerThread::updateDB(const FileCheckList &add, const PurgeList &rem
         SendProgressEvent(counter, (uint)(add.size() + remove.size()),
                           QObject::tr("Updating video database"));
 
-    for (FileCheckList::const_iterator p = add.begin(); p != add.end(); ++p)
+    for (FileCheckList::const_iterator p = add.begin();
+         (p != add.end()) && !m_cancel; ++p)
     {
         // add files not already in the DB
         if (!p->second.check)
@@ -362,6 +707,10 @@ bool VideoScannerThread::updateDB(const FileCheckList &add, const PurgeList &rem
             SendProgressEvent(++counter);
     }
 
+    // A cancelled scan leaves the rest for the next one
+    if (m_cancel)
+        return ret;
+
     // When prompting is restored, account for the answer here.
     ret += remove.size();
     for (PurgeList::const_iterator p = remove.begin(); p != remove.end();
@@ -379,9 +728,10 @@ bool VideoScannerThread::updateDB(const FileCheckList &add, const PurgeList &rem
     return ret;
 }
 
-bool VideoScannerThread::buildFileList(const QString &directory,
-                                       const QStringList &imageExtensions,
-                                       FileCheckList &filelist)
+bool VideoScannerThread::buildFileList(
+    const QString &directory, const QStringList &imageExtensions,
+    const FileAssociations::ext_ignore_list &ext_list,
+    FileCheckList &filelist, bool recursive)
 {
     // TODO: FileCheckList is a std::map, keyed off the filename. In the event
     // multiple backends have access to shared storage, the potential exists
@@ -391,10 +741,8 @@ bool VideoScannerThread::buildFileList(const QString &directory,
 
     LOG(VB_GENERAL,LOG_INFO, QString("buildFileList directory = %1")
                                  .arg(directory));
-    FileAssociations::ext_ignore_list ext_list;
-    FileAssociations::getFileAssociation().getExtensionIgnoreList(ext_list);
 
-    dirhandler<FileCheckList> dh(filelist, imageExtensions);
+    dirhandler<FileCheckList> dh(filelist, imageExtensions, recursive);
     return ScanVideoDirectory(directory, &dh, ext_list, m_ListUnknown);
 }
 
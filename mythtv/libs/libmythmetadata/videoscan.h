@@ -7,12 +7,15 @@
 
 #include <QObject> // for moc
 #include <QStringList>
+#include <QMutex>
 #include <QEvent>
 
 #include "mythmetaexp.h"
 #include "mthread.h"
+#include "dbaccess.h"
 
 class QStringList;
+class MSqlQuery;
 
 class MythUIProgressDialog;
 
@@ -58,15 +61,30 @@ class META_PUBLIC VideoScanChanges : public QEvent
 
 class META_PUBLIC VideoScannerThread : public MThread
 {
+    friend class VideoScanDirTask;
+
   public:
     VideoScannerThread(QObject *parent);
     ~VideoScannerThread();
 
+    // A directory on this host whose contents changed
+    struct ChangedDir
+    {
+        QString path;      // local path of the directory
+        QString base;      // storage group directory containing it, if any
+        bool    recursive; // whether its subdirectories changed too
+    };
+    typedef QList<ChangedDir> ChangedDirList;
+
     void run();
     void SetDirs(QStringList dirs);
     void SetHosts(const QStringList &hosts);
+    void SetChangedDirs(const QString &host, const ChangedDirList &dirs);
     void SetProgressDialog(MythUIProgressDialog *dialog) { m_dialog = dialog; };
     QStringList GetOfflineSGHosts(void) { return m_offlineSGHosts; };
+    QStringList GetBusyDirs(void) { return m_busyDirs; };
+    bool GetScanned(void) { return m_scanned; };
+    void Cancel(void) { m_cancel = true; };
     bool getDataChanged() { return m_DBDataChanged; };
 
     void ResetCounts() { m_addList.clear(); m_movList.clear(); m_delList.clear(); };
@@ -82,13 +100,35 @@ class META_PUBLIC VideoScannerThread : public MThread
     typedef std::vector<std::pair<unsigned int, QString> > PurgeList;
     typedef std::map<QString, CheckStruct> FileCheckList;
 
+    struct DirScan
+    {
+        QString       directory;
+        FileCheckList files;
+        bool          ok;
+    };
+
     void removeOrphans(unsigned int id, const QString &filename);
 
+    bool lockScan(MSqlQuery &query, bool wait);
+    void unlockScan(MSqlQuery &query);
+
+    void scanDirectories(const QStringList &imageExtensions,
+                         const FileAssociations::ext_ignore_list &ext_list,
+                         FileCheckList &filelist);
+    void scanChangedDirs(const QStringList &imageExtensions,
+                         const FileAssociations::ext_ignore_list &ext_list,
+                         FileCheckList &filelist);
+    bool inChangedDirs(const QString &filename) const;
+    bool inGroupDirs(const QString &filename) const;
+    void dropBusyFiles(FileCheckList &files);
+    void directoryScanned(void);
+
     void verifyFiles(FileCheckList &files, PurgeList &remove);
     bool updateDB(const FileCheckList &add, const PurgeList &remove);
     bool buildFileList(const QString &directory,
-                                        const QStringList &imageExtensions,
-                                        FileCheckList &filelist);
+                       const QStringList &imageExtensions,
+                       const FileAssociations::ext_ignore_list &ext_list,
+                       FileCheckList &filelist, bool recursive = true);
 
     void SendProgressEvent(uint progress, uint total = 0,
             QString messsage = QString());
@@ -110,6 +150,19 @@ class META_PUBLIC VideoScannerThread : public MThread
     QList<int> m_movList; // intids moved to new filename
     QList<int> m_delList; // orphaned/deleted intids
     bool m_DBDataChanged;
+
+    // Incremental scans only look at these directories on m_changedHost
+    QString        m_changedHost;
+    ChangedDirList m_changedDirs;
+    std::map<QString, QString> m_changedPaths; // filename -> local path
+    QStringList    m_groupDirs;
+    QStringList    m_busyDirs;
+
+    bool          m_scanned; // false if cancelled or another scan ran
+    volatile bool m_cancel;
+
+    QMutex m_progressLock;
+    uint   m_progress;
 };
 
 #endif
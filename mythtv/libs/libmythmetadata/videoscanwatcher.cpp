@@ -0,0 +1,424 @@
+#include <QFileSystemWatcher>
+#include <QFileInfo>
+#include <QTimer>
+#include <QFile>
+#include <QDir>
+
+#include "videoscanwatcher.h"
+#include "videoscan.h"
+#include "mythcorecontext.h"
+#include "storagegroup.h"
+#include "mythlogging.h"
+#include "mythdate.h"
+
+#define LOC QString("VideoScanWatcher: ")
+
+/// Seconds without changes before the queued directories are scanned
+const int VideoScanWatcher::kSettleTime = 30;
+/// Seconds after the first queued change when they are scanned anyway
+const int VideoScanWatcher::kMaxDelay   = 5 * 60;
+
+namespace
+{
+    /// DVD and Blu-ray folders are videos, not directories of videos
+    bool is_disc_dir(const QString &path)
+    {
+        QDir dir(path);
+        return dir.exists("VIDEO_TS") || dir.exists("BDMV");
+    }
+
+    /// The watches are shared with every other process of this user, so
+    /// don't take more than half of them.
+    int max_watches(void)
+    {
+        QFile file("/proc/sys/fs/inotify/max_user_watches");
+        if (file.open(QIODevice::ReadOnly))
+        {
+            bool ok;
+            int max = QString(file.readLine()).trimmed().toInt(&ok);
+            if (ok && (max > 1))
+                return max / 2;
+        }
+        return 4096;
+    }
+}
+
+VideoScanWatcher::VideoScanWatcher(const QString &host) :
+    MThread("VideoScanWatcher"),
+    m_host(host), m_walked(false),
+    m_watcher(NULL), m_settleTimer(NULL), m_reconcileTimer(NULL),
+    m_maxWatches(max_watches()), m_watchesFull(false), m_stop(false)
+{
+    moveToThread(qthread());
+    start();
+}
+
+VideoScanWatcher::~VideoScanWatcher()
+{
+    m_stop = true;
+    exit(0);
+    wait();
+}
+
+void VideoScanWatcher::run(void)
+{
+    RunProlog();
+
+    m_watcher = new QFileSystemWatcher();
+    connect(m_watcher, SIGNAL(directoryChanged(const QString&)),
+            SLOT(DirectoryChanged(const QString&)));
+
+    m_settleTimer = new QTimer();
+    m_settleTimer->setSingleShot(true);
+    connect(m_settleTimer, SIGNAL(timeout()), SLOT(ScanChanges()));
+
+    m_reconcileTimer = new QTimer();
+    connect(m_reconcileTimer, SIGNAL(timeout()), SLOT(Reconcile()));
+
+    int interval = gCoreContext->GetNumSetting(
+        "VideoScanReconcileInterval", 60);
+    if (interval > 0)
+        m_reconcileTimer->start(interval * 60 * 1000);
+
+    // The first walk happens in the event loop, so exit() can stop it.
+    QTimer::singleShot(0, this, SLOT(Reconcile()));
+
+    if (!m_stop)
+        exec();
+
+    delete m_reconcileTimer;
+    m_reconcileTimer = NULL;
+    delete m_settleTimer;
+    m_settleTimer = NULL;
+    delete m_watcher;
+    m_watcher = NULL;
+
+    RunEpilog();
+}
+
+/** \brief Walks the whole directory tree, queueing the directories which
+ *         appeared, disappeared or were modified since the last walk.
+ *
+ *  The first walk only records the tree and sets up the watches.
+ *  Directories below a storage group directory which isn't available are
+ *  left as they were, so an unmounted file system doesn't look as if all
+ *  of its videos were deleted.
+ */
+void VideoScanWatcher::Reconcile(void)
+{
+    QStringList baseDirs;
+    QStringList sgDirs = StorageGroup("Videos", m_host, false).GetDirList();
+    for (QStringList::const_iterator it = sgDirs.begin();
+         it != sgDirs.end(); ++it)
+    {
+        baseDirs << QDir::cleanPath(*it);
+    }
+
+    DirTimes dirs;
+    for (QStringList::const_iterator it = baseDirs.begin();
+         it != baseDirs.end(); ++it)
+    {
+        if (QDir(*it).exists())
+        {
+            WalkDir(*it, dirs);
+            continue;
+        }
+
+        LOG(VB_GENERAL, LOG_WARNING, LOC +
+            QString("%1 is not available, not checking it").arg(*it));
+
+        DirTimes::const_iterator old = m_dirs.lowerBound(*it);
+        for (; old != m_dirs.end(); ++old)
+        {
+            if ((old.key() != *it) && !old.key().startsWith(*it + "/"))
+                break;
+            dirs[old.key()] = *old;
+        }
+    }
+
+    if (m_stop)
+        return;
+
+    m_baseDirs = baseDirs;
+
+    QStringList added;
+    QStringList removed;
+
+    for (DirTimes::const_iterator it = dirs.begin(); it != dirs.end(); ++it)
+    {
+        DirTimes::const_iterator old = m_dirs.find(it.key());
+        if (old == m_dirs.end())
+        {
+            added << it.key();
+            if (m_walked)
+                QueueDir(it.key(), true);
+        }
+        else if (m_walked && (*old != *it))
+            QueueDir(it.key(), false);
+    }
+
+    for (DirTimes::const_iterator it = m_dirs.begin(); it != m_dirs.end(); ++it)
+    {
+        if (!dirs.contains(it.key()))
+        {
+            removed << it.key();
+            QueueDir(it.key(), true);
+        }
+    }
+
+    if (!removed.isEmpty())
+        m_watcher->removePaths(removed);
+
+    m_dirs = dirs;
+    WatchDirs(added);
+
+    LOG(VB_GENERAL, m_walked ? LOG_DEBUG : LOG_INFO, LOC +
+        QString("Found %1 directories, %2 are watched, %3 are queued")
+            .arg(m_dirs.size()).arg(m_watcher->directories().size())
+            .arg(m_queued.size()));
+
+    m_walked = true;
+}
+
+/** \brief Queues a directory reported by the watcher.
+ *
+ *  Subdirectories which were created in it are watched and queued with
+ *  their contents, those which were removed or renamed are queued so
+ *  their videos are removed. A renamed directory is found under its new
+ *  name as a new subdirectory of its new parent.
+ */
+void VideoScanWatcher::DirectoryChanged(const QString &path)
+{
+    if (!QDir(path).exists())
+    {
+        QueueDir(path, true);
+        ForgetDir(path);
+        return;
+    }
+
+    QueueDir(path, false);
+    m_dirs[path] = QFileInfo(path).lastModified().toTime_t();
+
+    QString prefix = path + "/";
+    QStringList gone;
+    DirTimes::const_iterator it = m_dirs.lowerBound(prefix);
+    for (; (it != m_dirs.end()) && it.key().startsWith(prefix); ++it)
+    {
+        if ((it.key().indexOf('/', prefix.length()) < 0) &&
+            !QDir(it.key()).exists())
+        {
+            gone << it.key();
+        }
+    }
+
+    for (QStringList::const_iterator dir = gone.begin();
+         dir != gone.end(); ++dir)
+    {
+        QueueDir(*dir, true);
+        ForgetDir(*dir);
+    }
+
+    QFileInfoList subdirs = QDir(path).entryInfoList(
+        QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+    for (QFileInfoList::const_iterator sub = subdirs.begin();
+         sub != subdirs.end(); ++sub)
+    {
+        QString subpath = sub->absoluteFilePath();
+        if (m_dirs.contains(subpath) || is_disc_dir(subpath))
+            continue;
+
+        DirTimes created;
+        WalkDir(subpath, created);
+        for (DirTimes::const_iterator dir = created.begin();
+             dir != created.end(); ++dir)
+        {
+            m_dirs[dir.key()] = *dir;
+        }
+        WatchDirs(created.keys());
+        QueueDir(subpath, true);
+    }
+}
+
+/** \brief Passes the queued directories to an incremental scan.
+ *
+ *  This thread waits for the scan, changes reported in the meantime are
+ *  handled once it is done. The scan is cancelled if the watcher is
+ *  stopped. Directories with new files which were still being written
+ *  are queued again, and so are all of them if another video scan was
+ *  running.
+ */
+void VideoScanWatcher::ScanChanges(void)
+{
+    VideoScannerThread::ChangedDirList dirs;
+    QString recursivePrefix;
+
+    QMap<QString, bool>::const_iterator it = m_queued.begin();
+    for (; it != m_queued.end(); ++it)
+    {
+        // The contents of a recursive directory are already included
+        if (!recursivePrefix.isEmpty() &&
+            it.key().startsWith(recursivePrefix))
+        {
+            continue;
+        }
+
+        VideoScannerThread::ChangedDir dir;
+        dir.path      = it.key();
+        dir.base      = BaseDir(it.key());
+        dir.recursive = *it;
+
+        if (dir.base.isEmpty())
+            continue;
+
+        dirs.push_back(dir);
+
+        if (dir.recursive)
+            recursivePrefix = dir.path + "/";
+    }
+
+    m_queued.clear();
+    m_firstQueued = QDateTime();
+
+    if (dirs.isEmpty() || m_stop)
+        return;
+
+    LOG(VB_GENERAL, LOG_INFO, LOC +
+        QString("Scanning %1 changed directories").arg(dirs.size()));
+
+    VideoScannerThread scanner(NULL);
+    scanner.SetChangedDirs(m_host, dirs);
+    scanner.start();
+    while (!scanner.wait(250))
+    {
+        if (m_stop)
+            scanner.Cancel();
+    }
+
+    if (m_stop)
+        return;
+
+    if (!scanner.GetScanned())
+    {
+        VideoScannerThread::ChangedDirList::const_iterator dir = dirs.begin();
+        for (; dir != dirs.end(); ++dir)
+            QueueDir(dir->path, dir->recursive);
+        return;
+    }
+
+    QStringList busy = scanner.GetBusyDirs();
+    for (QStringList::const_iterator dir = busy.begin();
+         dir != busy.end(); ++dir)
+    {
+        if (!m_queued.contains(*dir))
+            m_queued[*dir] = false;
+    }
+
+    if (!busy.isEmpty() && !m_settleTimer->isActive())
+        m_settleTimer->start(kSettleTime * 1000);
+}
+
+/// Records the modification times of \a path and the directories below it
+void VideoScanWatcher::WalkDir(const QString &path, DirTimes &dirs) const
+{
+    if (m_stop)
+        return;
+
+    dirs[path] = QFileInfo(path).lastModified().toTime_t();
+
+    QFileInfoList subdirs = QDir(path).entryInfoList(
+        QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+    for (QFileInfoList::const_iterator it = subdirs.begin();
+         it != subdirs.end(); ++it)
+    {
+        if (!is_disc_dir(it->absoluteFilePath()))
+            WalkDir(it->absoluteFilePath(), dirs);
+    }
+}
+
+/// Adds watches for \a paths, as long as there are any left
+void VideoScanWatcher::WatchDirs(const QStringList &paths)
+{
+    if (paths.isEmpty())
+        return;
+
+    int room = m_maxWatches - m_watcher->directories().size();
+    if (room >= paths.size())
+    {
+        m_watcher->addPaths(paths);
+        return;
+    }
+
+    if (room > 0)
+        m_watcher->addPaths(paths.mid(0, room));
+
+    if (!m_watchesFull)
+    {
+        LOG(VB_GENERAL, LOG_WARNING, LOC +
+            QString("Out of directory watches, changes to unwatched "
+                    "directories are found every %1 minutes. Raise "
+                    "fs.inotify.max_user_watches to watch more of them.")
+                .arg(gCoreContext->GetNumSetting(
+                         "VideoScanReconcileInterval", 60)));
+        m_watchesFull = true;
+    }
+}
+
+/// Stops watching \a path and the directories below it
+void VideoScanWatcher::ForgetDir(const QString &path)
+{
+    QStringList forget;
+    DirTimes::iterator it = m_dirs.lowerBound(path);
+    while ((it != m_dirs.end()) &&
+           ((it.key() == path) || it.key().startsWith(path + "/")))
+    {
+        forget << it.key();
+        it = m_dirs.erase(it);
+    }
+
+    QStringList watched = m_watcher->directories();
+    QStringList unwatch;
+    for (QStringList::const_iterator dir = forget.begin();
+         dir != forget.end(); ++dir)
+    {
+        if (watched.contains(*dir))
+            unwatch << *dir;
+    }
+
+    if (!unwatch.isEmpty())
+        m_watcher->removePaths(unwatch);
+}
+
+/** \brief Queues \a path for the next scan, which starts once no change
+ *         came in for kSettleTime seconds, or kMaxDelay seconds after the
+ *         first queued change if they keep coming in.
+ */
+void VideoScanWatcher::QueueDir(const QString &path, bool recursive)
+{
+    QMap<QString, bool>::iterator it = m_queued.find(path);
+    if (it == m_queued.end())
+        m_queued[path] = recursive;
+    else if (recursive)
+        *it = true;
+
+    QDateTime now = MythDate::current();
+    if (!m_firstQueued.isValid())
+        m_firstQueued = now;
+
+    if (m_firstQueued.secsTo(now) < kMaxDelay)
+        m_settleTimer->start(kSettleTime * 1000);
+    else if (!m_settleTimer->isActive())
+        m_settleTimer->start(0);
+}
+
+/// The storage group directory containing \a path, if any
+QString VideoScanWatcher::BaseDir(const QString &path) const
+{
+    QStringList::const_iterator it = m_baseDirs.begin();
+    for (; it != m_baseDirs.end(); ++it)
+    {
+        if ((path == *it) || path.startsWith(*it + "/"))
+            return *it;
+    }
+
+    return QString();
+}
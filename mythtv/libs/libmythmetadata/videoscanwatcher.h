@@ -0,0 +1,70 @@
+#ifndef VIDEO_SCAN_WATCHER_H
+#define VIDEO_SCAN_WATCHER_H
+
+#include <QObject> // for moc
+#include <QStringList>
+#include <QDateTime>
+#include <QMap>
+
+#include "mythmetaexp.h"
+#include "mthread.h"
+
+class QFileSystemWatcher;
+class QTimer;
+
+/** \brief Keeps the video database up to date with the "Videos" storage
+ *         group directories on this host.
+ *
+ *  Every directory below the storage group directories is watched with
+ *  QFileSystemWatcher, which uses inotify on Linux. A changed directory
+ *  is queued, and the queued directories are passed to an incremental
+ *  VideoScannerThread once no more changes came in for a while.
+ *
+ *  inotify doesn't see changes made by other machines to a network file
+ *  system, and the number of watches is limited, so the directory tree
+ *  is also walked every VideoScanReconcileInterval minutes. Directories
+ *  whose modification time changed since the last walk are queued too.
+ */
+class META_PUBLIC VideoScanWatcher : public QObject, public MThread
+{
+    Q_OBJECT
+
+  public:
+    VideoScanWatcher(const QString &host);
+    ~VideoScanWatcher();
+
+  protected:
+    virtual void run(void); // MThread
+
+  private slots:
+    void DirectoryChanged(const QString &path);
+    void Reconcile(void);
+    void ScanChanges(void);
+
+  private:
+    typedef QMap<QString, uint> DirTimes; // path -> modification time
+
+    void    WalkDir(const QString &path, DirTimes &dirs) const;
+    void    WatchDirs(const QStringList &paths);
+    void    ForgetDir(const QString &path);
+    void    QueueDir(const QString &path, bool recursive);
+    QString BaseDir(const QString &path) const;
+
+    QString             m_host;
+    QStringList         m_baseDirs;
+    DirTimes            m_dirs;
+    bool                m_walked;
+    QMap<QString, bool> m_queued;       // path -> recursive
+    QDateTime           m_firstQueued;
+    QFileSystemWatcher *m_watcher;
+    QTimer             *m_settleTimer;
+    QTimer             *m_reconcileTimer;
+    int                 m_maxWatches;
+    bool                m_watchesFull;
+    volatile bool       m_stop;
+
+    static const int kSettleTime;
+    static const int kMaxDelay;
+};
+
+#endif
@@ -0,0 +1,96 @@
+//////////////////////////////////////////////////////////////////////////////
+// Program Name: recordedListCacheStatus.h
+//
+// Licensed under the GPL v2 or later, see COPYING for details
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef RECORDEDLISTCACHESTATUS_H_
+#define RECORDEDLISTCACHESTATUS_H_
+
+#include <QString>
+
+#include "serviceexp.h"
+#include "datacontracthelper.h"
+
+namespace DTC
+{
+
+class SERVICE_PUBLIC RecordedListCacheStatus : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO( "version"    , "1.0" );
+
+    Q_PROPERTY( int        Size              READ Size
+                                             WRITE setSize              )
+    Q_PROPERTY( bool       Valid             READ Valid
+                                             WRITE setValid             )
+    Q_PROPERTY( int        Hits              READ Hits
+                                             WRITE setHits              )
+    Q_PROPERTY( int        Misses            READ Misses
+                                             WRITE setMisses            )
+    Q_PROPERTY( double     HitRate           READ HitRate
+                                             WRITE setHitRate           )
+    Q_PROPERTY( int        Invalidations     READ Invalidations
+                                             WRITE setInvalidations     )
+    Q_PROPERTY( int        LastRebuildTime   READ LastRebuildTime
+                                             WRITE setLastRebuildTime   )
+    Q_PROPERTY( int        AvgRebuildTime    READ AvgRebuildTime
+                                             WRITE setAvgRebuildTime    )
+
+    PROPERTYIMP( int     , Size              )
+    PROPERTYIMP( bool    , Valid             )
+    PROPERTYIMP( int     , Hits              )
+    PROPERTYIMP( int     , Misses            )
+    PROPERTYIMP( double  , HitRate           )
+    PROPERTYIMP( int     , Invalidations     )
+    PROPERTYIMP( int     , LastRebuildTime   )
+    PROPERTYIMP( int     , AvgRebuildTime    )
+
+    public:
+
+        static void InitializeCustomTypes()
+        {
+            qRegisterMetaType< RecordedListCacheStatus  >();
+            qRegisterMetaType< RecordedListCacheStatus* >();
+        }
+
+    public:
+
+        RecordedListCacheStatus(QObject *parent = 0)
+            : QObject             ( parent ),
+              m_Size              ( 0      ),
+              m_Valid             ( false  ),
+              m_Hits              ( 0      ),
+              m_Misses            ( 0      ),
+              m_HitRate           ( 0.0    ),
+              m_Invalidations     ( 0      ),
+              m_LastRebuildTime   ( 0      ),
+              m_AvgRebuildTime    ( 0      )
+        {
+        }
+
+        RecordedListCacheStatus( const RecordedListCacheStatus &src )
+        {
+            Copy( src );
+        }
+
+        void Copy( const RecordedListCacheStatus &src )
+        {
+            m_Size              = src.m_Size             ;
+            m_Valid             = src.m_Valid            ;
+            m_Hits              = src.m_Hits             ;
+            m_Misses            = src.m_Misses           ;
+            m_HitRate           = src.m_HitRate          ;
+            m_Invalidations     = src.m_Invalidations    ;
+            m_LastRebuildTime   = src.m_LastRebuildTime  ;
+            m_AvgRebuildTime    = src.m_AvgRebuildTime   ;
+        }
+};
+
+} // namespace DTC
+
+Q_DECLARE_METATYPE( DTC::RecordedListCacheStatus )
+Q_DECLARE_METATYPE( DTC::RecordedListCacheStatus* )
+
+#endif
@@ -0,0 +1,91 @@
+//////////////////////////////////////////////////////////////////////////////
+// Program Name: schedulerStatus.h
+//
+// Licensed under the GPL v2 or later, see COPYING for details
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef SCHEDULERSTATUS_H_
+#define SCHEDULERSTATUS_H_
+
+#include <QString>
+
+#include "serviceexp.h"
+#include "datacontracthelper.h"
+
+namespace DTC
+{
+
+class SERVICE_PUBLIC SchedulerStatus : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO( "version"    , "1.0" );
+
+    Q_PROPERTY( int        InteractiveQueued READ InteractiveQueued
+                                             WRITE setInteractiveQueued )
+    Q_PROPERTY( int        BulkQueued        READ BulkQueued
+                                             WRITE setBulkQueued        )
+    Q_PROPERTY( int        Received          READ Received
+                                             WRITE setReceived          )
+    Q_PROPERTY( int        Merged            READ Merged
+                                             WRITE setMerged            )
+    Q_PROPERTY( double     MergeRatio        READ MergeRatio
+                                             WRITE setMergeRatio        )
+    Q_PROPERTY( int        Passes            READ Passes
+                                             WRITE setPasses            )
+    Q_PROPERTY( int        BulkDelay         READ BulkDelay
+                                             WRITE setBulkDelay         )
+
+    PROPERTYIMP( int     , InteractiveQueued )
+    PROPERTYIMP( int     , BulkQueued        )
+    PROPERTYIMP( int     , Received          )
+    PROPERTYIMP( int     , Merged            )
+    PROPERTYIMP( double  , MergeRatio        )
+    PROPERTYIMP( int     , Passes            )
+    PROPERTYIMP( int     , BulkDelay         )
+
+    public:
+
+        static void InitializeCustomTypes()
+        {
+            qRegisterMetaType< SchedulerStatus  >();
+            qRegisterMetaType< SchedulerStatus* >();
+        }
+
+    public:
+
+        SchedulerStatus(QObject *parent = 0)
+            : QObject             ( parent ),
+              m_InteractiveQueued ( 0      ),
+              m_BulkQueued        ( 0      ),
+              m_Received          ( 0      ),
+              m_Merged            ( 0      ),
+              m_MergeRatio        ( 0.0    ),
+              m_Passes            ( 0      ),
+              m_BulkDelay         ( 0      )
+        {
+        }
+
+        SchedulerStatus( const SchedulerStatus &src )
+        {
+            Copy( src );
+        }
+
+        void Copy( const SchedulerStatus &src )
+        {
+            m_InteractiveQueued = src.m_InteractiveQueued;
+            m_BulkQueued        = src.m_BulkQueued       ;
+            m_Received          = src.m_Received         ;
+            m_Merged            = src.m_Merged           ;
+            m_MergeRatio        = src.m_MergeRatio       ;
+            m_Passes            = src.m_Passes           ;
+            m_BulkDelay         = src.m_BulkDelay        ;
+        }
+};
+
+} // namespace DTC
+
+Q_DECLARE_METATYPE( DTC::SchedulerStatus )
+Q_DECLARE_METATYPE( DTC::SchedulerStatus* )
+
+#endif
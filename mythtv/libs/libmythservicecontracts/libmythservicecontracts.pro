@@ -40,6 +40,7 @@ HEADERS += datacontracts/frontendActionList.h
 HEADERS += datacontracts/liveStreamInfo.h        datacontracts/liveStreamInfoList.h
 HEADERS += datacontracts/labelValue.h
 HEADERS += datacontracts/logMessage.h            datacontracts/logMessageList.h
+HEADERS += datacontracts/schedulerStatus.h       datacontracts/recordedListCacheStatus.h
 
 SOURCES += service.cpp
 
@@ -80,6 +81,7 @@ incDatacontracts.files += datacontracts/frontendStatus.h      datacontracts/fron
 incDatacontracts.files += datacontracts/liveStreamInfo.h      datacontracts/liveStreamInfoList.h
 incDatacontracts.files += datacontracts/labelValue.h
 incDatacontracts.files += datacontracts/logMessage.h          datacontracts/logMessageList.h
+incDatacontracts.files += datacontracts/schedulerStatus.h     datacontracts/recordedListCacheStatus.h
 
 INSTALLS += inc incServices incDatacontracts
 
@@ -38,7 +38,7 @@
 class SERVICE_PUBLIC DvrServices : public Service  //, public QScriptable ???
 {
     Q_OBJECT
-    Q_CLASSINFO( "version"    , "1.6" );
+    Q_CLASSINFO( "version"    , "1.7" );
     Q_CLASSINFO( "RemoveRecordedItem_Method",                   "POST" )
     Q_CLASSINFO( "AddRecordSchedule_Method",                    "POST" )
     Q_CLASSINFO( "RemoveRecordSchedule_Method",                 "POST" )
@@ -71,7 +71,9 @@ class SERVICE_PUBLIC DvrServices : public Service  //, public QScriptable ???
                                                              int              Count,
                                                              const QString   &TitleRegEx,
                                                              const QString   &RecGroup,
-                                                             const QString   &StorageGroup ) = 0;
+                                                             const QString   &StorageGroup,
+                                                             int              AfterChanId,
+                                                             const QDateTime &AfterStartTime ) = 0;
 
         virtual DTC::Program*      GetRecorded           ( int              ChanId,
                                                             const QDateTime &StartTime  ) = 0;
@@ -22,6 +22,8 @@
 #include "datacontracts/timeZoneInfo.h"
 #include "datacontracts/logMessage.h"
 #include "datacontracts/logMessageList.h"
+#include "datacontracts/schedulerStatus.h"
+#include "datacontracts/recordedListCacheStatus.h"
 
 /////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
@@ -42,7 +44,7 @@
 class SERVICE_PUBLIC MythServices : public Service  //, public QScriptable ???
 {
     Q_OBJECT
-    Q_CLASSINFO( "version"    , "2.0" );
+    Q_CLASSINFO( "version"    , "2.2" );
     Q_CLASSINFO( "PutSetting_Method",            "POST" )
     Q_CLASSINFO( "AddStorageGroupDir_Method",    "POST" )
     Q_CLASSINFO( "RemoveStorageGroupDir_Method", "POST" )
@@ -66,6 +68,8 @@ class SERVICE_PUBLIC MythServices : public Service  //, public QScriptable ???
             DTC::TimeZoneInfo       ::InitializeCustomTypes();
             DTC::LogMessage         ::InitializeCustomTypes();
             DTC::LogMessageList     ::InitializeCustomTypes();
+            DTC::SchedulerStatus    ::InitializeCustomTypes();
+            DTC::RecordedListCacheStatus::InitializeCustomTypes();
         }
 
     public slots:
@@ -89,6 +93,10 @@ class SERVICE_PUBLIC MythServices : public Service  //, public QScriptable ???
 
         virtual DTC::TimeZoneInfo*  GetTimeZone         ( ) = 0;
 
+        virtual DTC::SchedulerStatus* GetSchedulerStatus ( ) = 0;
+
+        virtual DTC::RecordedListCacheStatus* GetRecordedListCacheStatus ( ) = 0;
+
         virtual DTC::LogMessageList*  GetLogs ( const QString   &HostName,
                                                 const QString   &Application,
                                                 int             PID,
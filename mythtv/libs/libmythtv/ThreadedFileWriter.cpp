@@ -1,4 +1,5 @@
 // ANSI C headers
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cerrno>
@@ -6,6 +7,7 @@
 // Unix C headers
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <unistd.h>
 #include <signal.h>
 #include <fcntl.h>
@@ -22,6 +24,10 @@
 #include "compat.h"
 #include "mythdate.h"
 
+#ifndef O_DIRECT
+#define O_DIRECT 0
+#endif
+
 #define LOC QString("TFW(%1:%2): ").arg(filename).arg(fd)
 
 /// \brief Runs ThreadedFileWriter::DiskLoop(void)
@@ -42,6 +48,84 @@ void TFWSyncThread::run(void)
 
 const uint ThreadedFileWriter::kMaxBufferSize = 128 * 1024 * 1024;
 const uint ThreadedFileWriter::kMinWriteSize = 64 * 1024;
+const uint ThreadedFileWriter::kRingSize = 64 * 1024 * 1024;
+const uint ThreadedFileWriter::kDirectAlignment = 4096;
+
+/** \class TFWRing
+ *  \brief Lock-free single-producer/single-consumer ring used by
+ *         ThreadedFileWriter in kWriteDirectRing mode.
+ *
+ *   The backing store is allocated once, aligned to the O_DIRECT block
+ *   size, so that the consumer can hand slices of it straight to the
+ *   kernel without an intermediate copy.
+ */
+TFWRing::TFWRing(uint size, uint alignment) :
+    m_data(NULL), m_size(size), m_mask(size - 1), m_head(0), m_tail(0)
+{
+#ifdef USING_MINGW
+    (void) alignment;
+    m_data = (char*) malloc(m_size);
+#else
+    void *mem = NULL;
+    if (posix_memalign(&mem, alignment, m_size) == 0)
+        m_data = (char*) mem;
+#endif
+}
+
+TFWRing::~TFWRing()
+{
+    free(m_data);
+    m_data = NULL;
+}
+
+/// \brief Returns number of bytes queued; safe to call from either side.
+uint TFWRing::Used(void) const
+{
+    uint tail = (uint) m_tail.fetchAndAddAcquire(0);
+    uint head = (uint) m_head.fetchAndAddAcquire(0);
+    return head - tail;
+}
+
+/** \brief Appends count bytes, producer side only.
+ *  \return false if there was not enough room, nothing is copied then.
+ */
+bool TFWRing::Put(const void *data, uint count)
+{
+    uint head = (uint) m_head.fetchAndAddRelaxed(0);
+    uint tail = (uint) m_tail.fetchAndAddAcquire(0);
+    if (count > m_size - (head - tail))
+        return false;
+
+    const char *cdata = (const char*) data;
+    uint off   = head & m_mask;
+    uint first = min(count, m_size - off);
+    memcpy(m_data + off, cdata, first);
+    if (first < count)
+        memcpy(m_data, cdata + first, count - first);
+
+    m_head.fetchAndStoreRelease((int) (head + count));
+    return true;
+}
+
+/** \brief Returns the oldest queued bytes, consumer side only.
+ *  \param contiguous set to the number of bytes readable at the pointer
+ *                    without wrapping around the end of the ring.
+ */
+const char *TFWRing::Peek(uint &contiguous) const
+{
+    uint tail = (uint) m_tail.fetchAndAddRelaxed(0);
+    uint head = (uint) m_head.fetchAndAddAcquire(0);
+    uint off  = tail & m_mask;
+    contiguous = min(head - tail, m_size - off);
+    return m_data + off;
+}
+
+/// \brief Releases count bytes returned by Peek(), consumer side only.
+void TFWRing::Consume(uint count)
+{
+    uint tail = (uint) m_tail.fetchAndAddRelaxed(0);
+    m_tail.fetchAndStoreRelease((int) (tail + count));
+}
 
 /** \class ThreadedFileWriter
  *  \brief This class supports the writing of recordings to disk.
@@ -54,22 +138,52 @@ const uint ThreadedFileWriter::kMinWriteSize = 64 * 1024;
  *   to the stream.
  */
 
-/** \fn ThreadedFileWriter::ThreadedFileWriter(const QString&,int,mode_t)
+/** \fn ThreadedFileWriter::ThreadedFileWriter(const QString&,int,mode_t,WriteMode)
  *  \brief Creates a threaded file writer.
+ *
+ *   In kWriteDirectRing mode Write() copies into a preallocated lock-free
+ *   ring instead of a mutex protected buffer list, and the write thread
+ *   flushes block aligned runs of the ring with O_DIRECT so that the
+ *   recording does not push playback data out of the page cache. If the
+ *   ring can not be allocated the writer silently uses kWriteBuffered.
  */
 ThreadedFileWriter::ThreadedFileWriter(const QString &fname,
-                                       int pflags, mode_t pmode) :
+                                       int pflags, mode_t pmode,
+                                       WriteMode wmode) :
     // file stuff
     filename(fname),                     flags(pflags),
     mode(pmode),                         fd(-1),
+    directfd(-1),                        writemode(wmode),
+    fileoffset(0),
     // state
     flush(false),                        in_dtor(false),
     ignore_writes(false),                tfw_min_write_size(kMinWriteSize),
     totalBufferUse(0),
+    // buffers
+    ring(NULL),                          ring_ignore_writes(0),
+    // statistics
+    stat_max_depth(0),                   stat_writes(0),
+    stat_direct_writes(0),               stat_bytes(0),
+    stat_depth_sum(0),                   stat_latency_sum(0),
+    stat_latency_max(0),
     // threads
     writeThread(NULL),                   syncThread(NULL)
 {
     filename.detach();
+
+    if (writemode == kWriteDirectRing && filename != "-")
+    {
+        ring = new TFWRing(kRingSize, kDirectAlignment);
+        if (!ring->IsValid())
+        {
+            LOG(VB_GENERAL, LOG_WARNING, LOC +
+                "Failed to allocate write ring, using buffered writes.");
+            delete ring;
+            ring = NULL;
+        }
+    }
+    if (!ring)
+        writemode = kWriteBuffered;
 }
 
 /** \fn ThreadedFileWriter::ReOpen(QString)
@@ -90,6 +204,18 @@ bool ThreadedFileWriter::ReOpen(QString newFilename)
         fd = -1;
     }
 
+    if (directfd >= 0)
+    {
+        close(directfd);
+        directfd = -1;
+    }
+
+    if (ring)
+    {
+        LogStatistics();
+        ResetStatistics();
+    }
+
     if (!newFilename.isEmpty())
         filename = newFilename;
 
@@ -105,6 +231,7 @@ bool ThreadedFileWriter::ReOpen(QString newFilename)
 bool ThreadedFileWriter::Open(void)
 {
     ignore_writes = false;
+    ring_ignore_writes.fetchAndStoreRelease(0);
 
     if (filename == "-")
         fd = fileno(stdout);
@@ -112,6 +239,20 @@ bool ThreadedFileWriter::Open(void)
     {
         QByteArray fname = filename.toLocal8Bit();
         fd = open(fname.constData(), flags, mode);
+
+        // The O_DIRECT descriptor is opened after the regular one so that
+        // any O_CREAT/O_TRUNC has already been applied to the file.
+        if (fd >= 0 && ring && O_DIRECT)
+        {
+            int dflags = (flags & ~(O_CREAT | O_TRUNC | O_APPEND)) | O_DIRECT;
+            directfd = open(fname.constData(), dflags, mode);
+            if (directfd < 0)
+            {
+                LOG(VB_FILE, LOG_INFO, LOC +
+                    "O_DIRECT not supported here, using buffered writes." +
+                    ENO);
+            }
+        }
     }
 
     if (fd < 0)
@@ -124,6 +265,16 @@ bool ThreadedFileWriter::Open(void)
     {
         LOG(VB_FILE, LOG_INFO, LOC + "Open() successful");
 
+        if (ring)
+        {
+            // Write() and Seek() are paused by our caller, so DiskLoopRing()
+            // has nothing in flight and is not looking at fileoffset.
+            QMutexLocker locker(&buflock);
+            fileoffset = lseek(fd, 0, (flags & O_APPEND) ? SEEK_END : SEEK_CUR);
+            if (fileoffset < 0)
+                fileoffset = 0;
+        }
+
 #ifdef USING_MINGW
         _setmode(fd, _O_BINARY);
 #endif
@@ -188,6 +339,19 @@ ThreadedFileWriter::~ThreadedFileWriter()
         close(fd);
         fd = -1;
     }
+
+    if (directfd >= 0)
+    {
+        close(directfd);
+        directfd = -1;
+    }
+
+    if (ring)
+    {
+        LogStatistics();
+        delete ring;
+        ring = NULL;
+    }
 }
 
 /** \fn ThreadedFileWriter::Write(const void*, uint)
@@ -201,6 +365,9 @@ uint ThreadedFileWriter::Write(const void *data, uint count)
     if (count == 0)
         return 0;
 
+    if (ring)
+        return WriteRing(data, count);
+
     QMutexLocker locker(&buflock);
 
     if (ignore_writes)
@@ -256,6 +423,42 @@ uint ThreadedFileWriter::Write(const void *data, uint count)
     return count;
 }
 
+/** \brief Lock-free Write() used in kWriteDirectRing mode.
+ *
+ *   Only the recorder thread may call this. The write thread is only
+ *   woken when we cross the minimum write size, otherwise it notices
+ *   new data on its own timeout.
+ */
+uint ThreadedFileWriter::WriteRing(const void *data, uint count)
+{
+    if (ring_ignore_writes.fetchAndAddAcquire(0))
+        return count;
+
+    uint before = ring->Used();
+    if (!ring->Put(data, count))
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+                "Maximum buffer size exceeded."
+                "\n\t\t\tfile will be truncated, no further writing "
+                "will be done."
+                "\n\t\t\tThis generally indicates your disk performance "
+                "\n\t\t\tis insufficient to deal with the number of on-going "
+                "\n\t\t\trecordings, or you have a disk failure.");
+        ring_ignore_writes.fetchAndStoreRelease(1);
+        bufferHasData.wakeAll();
+        return count;
+    }
+
+    uint after = before + count;
+    if (after > stat_max_depth)
+        stat_max_depth = after;
+
+    if (before < kMinWriteSize && after >= kMinWriteSize)
+        bufferHasData.wakeAll();
+
+    return count;
+}
+
 /** \fn ThreadedFileWriter::Seek(long long pos, int whence)
  *  \brief Seek to a position within stream; May be unsafe.
  *
@@ -270,6 +473,19 @@ uint ThreadedFileWriter::Write(const void *data, uint count)
 long long ThreadedFileWriter::Seek(long long pos, int whence)
 {
     QMutexLocker locker(&buflock);
+
+    if (ring)
+    {
+        FlushRing(locker);
+        // DiskLoopRing() uses positioned writes, so bring the descriptor's
+        // own offset up to date before honoring SEEK_CUR.
+        lseek(fd, fileoffset, SEEK_SET);
+        long long ret = lseek(fd, pos, whence);
+        if (ret >= 0)
+            fileoffset = ret;
+        return ret;
+    }
+
     flush = true;
     while (!writeBuffers.empty())
     {
@@ -291,6 +507,13 @@ long long ThreadedFileWriter::Seek(long long pos, int whence)
 void ThreadedFileWriter::Flush(void)
 {
     QMutexLocker locker(&buflock);
+
+    if (ring)
+    {
+        FlushRing(locker);
+        return;
+    }
+
     flush = true;
     while (!writeBuffers.empty())
     {
@@ -305,6 +528,23 @@ void ThreadedFileWriter::Flush(void)
     flush = false;
 }
 
+/// \brief Waits for DiskLoopRing() to drain the ring; buflock must be held.
+void ThreadedFileWriter::FlushRing(QMutexLocker &locker)
+{
+    flush = true;
+    while (ring->Used() && !ring_ignore_writes.fetchAndAddAcquire(0))
+    {
+        bufferHasData.wakeAll();
+        if (!bufferEmpty.wait(locker.mutex(), 2000))
+        {
+            LOG(VB_GENERAL, LOG_WARNING, LOC +
+                QString("Taking a long time to flush.. buffer size %1")
+                    .arg(ring->Used()));
+        }
+    }
+    flush = false;
+}
+
 /** \brief Flush data written to the file descriptor to disk.
  *
  *  This prevents freezing up Linux disk access on a running
@@ -379,6 +619,12 @@ void ThreadedFileWriter::DiskLoop(void)
     signal(SIGXFSZ, SIG_IGN);
 #endif
 
+    if (ring)
+    {
+        DiskLoopRing();
+        return;
+    }
+
     QMutexLocker locker(&buflock);
 
     // Even if the bytes buffered is less than the minimum write
@@ -552,3 +798,199 @@ void ThreadedFileWriter::TrimEmptyBuffers(void)
         ++it;
     }
 }
+
+/** \brief Writes one run of the ring to disk at fileoffset.
+ *
+ *   When the ring position and the file offset are both block aligned the
+ *   largest aligned prefix is written through the O_DIRECT descriptor,
+ *   otherwise just enough is written through the regular descriptor to
+ *   bring them back into alignment. Since both advance by the same amount
+ *   they only ever drift apart after a Seek() to an unaligned offset.
+ *
+ *  \return bytes written, or -1 on error with errno set.
+ */
+int ThreadedFileWriter::WriteRingChunk(const char *data, uint count)
+{
+    uint misalign = ring->Tail() & (kDirectAlignment - 1);
+    bool aligned  = !misalign && !(fileoffset & (kDirectAlignment - 1));
+
+    if (directfd >= 0 && aligned && count >= kDirectAlignment)
+    {
+        uint sz = count & ~(kDirectAlignment - 1);
+        int ret = pwrite(directfd, data, sz, fileoffset);
+        if (ret >= 0)
+        {
+            stat_direct_writes++;
+            return ret;
+        }
+        if (errno != EINVAL)
+            return ret;
+
+        // Some filesystems accept O_DIRECT at open() and refuse it later
+        LOG(VB_FILE, LOG_INFO, LOC +
+            "O_DIRECT write refused, using buffered writes." + ENO);
+        close(directfd);
+        directfd = -1;
+    }
+
+    uint sz = count;
+    if (directfd >= 0 && misalign &&
+        ((fileoffset & (kDirectAlignment - 1)) == misalign))
+    {
+        sz = min(count, kDirectAlignment - misalign);
+    }
+
+    return pwrite(fd, data, sz, fileoffset);
+}
+
+/** \brief The write thread run method used in kWriteDirectRing mode.
+ *
+ *   buflock is only held here while waiting, the ring itself is read
+ *   without any locking.
+ */
+void ThreadedFileWriter::DiskLoopRing(void)
+{
+    QMutexLocker locker(&buflock);
+
+    MythTimer minWriteTimer;
+    minWriteTimer.start();
+
+    uint errcnt = 0;
+
+    while (!in_dtor)
+    {
+        uint used = ring->Used();
+
+        if (ring_ignore_writes.fetchAndAddAcquire(0))
+        {
+            uint contiguous;
+            while (ring->Used())
+            {
+                ring->Peek(contiguous);
+                ring->Consume(contiguous);
+            }
+            bufferEmpty.wakeAll();
+            bufferHasData.wait(locker.mutex(), 1000);
+            continue;
+        }
+
+        if (!used)
+        {
+            bufferEmpty.wakeAll();
+            bufferHasData.wait(locker.mutex(), flush ? 10 : 100);
+            continue;
+        }
+
+        int mwte = minWriteTimer.elapsed();
+        if (!flush && (mwte < 250) && (used < tfw_min_write_size))
+        {
+            bufferHasData.wait(locker.mutex(), 250 - mwte);
+            continue;
+        }
+
+        if (fd == -1)
+        {
+            bufferHasData.wait(locker.mutex(), 200);
+            continue;
+        }
+
+        minWriteTimer.start();
+        locker.unlock();
+
+        uint contiguous;
+        const char *data = ring->Peek(contiguous);
+
+        struct timeval start, end;
+        gettimeofday(&start, NULL);
+
+        int ret = WriteRingChunk(data, contiguous);
+        int err = errno;
+
+        gettimeofday(&end, NULL);
+        uint usec = (end.tv_sec  - start.tv_sec) * 1000000 +
+                    (end.tv_usec - start.tv_usec);
+        stat_writes++;
+        stat_depth_sum   += used;
+        stat_latency_sum += usec;
+        stat_latency_max  = max(stat_latency_max, usec);
+
+        if (usec > 1000000)
+        {
+            LOG(VB_GENERAL, LOG_WARNING, LOC +
+                QString("write(%1) total %2 -- took a long time, %3 ms")
+                    .arg(contiguous).arg(used).arg(usec / 1000));
+        }
+
+        locker.relock();
+
+        // Seek() and Open() read fileoffset under buflock, so it has to be
+        // advanced before the data leaves the ring.
+        if (ret > 0)
+        {
+            fileoffset += ret;
+            ring->Consume(ret);
+            stat_bytes += ret;
+            errcnt = 0;
+        }
+
+        if (ret >= 0)
+            continue;
+
+        if (err == EAGAIN || err == EINTR)
+        {
+            LOG(VB_GENERAL, LOG_WARNING, LOC + "Got EAGAIN.");
+            bufferHasData.wait(locker.mutex(), 50);
+            continue;
+        }
+
+        errcnt++;
+        errno = err;
+        LOG(VB_GENERAL, LOG_ERR, LOC + "File I/O " +
+            QString(" errcnt: %1").arg(errcnt) + ENO);
+
+        if ((errcnt >= 3) || (ENOSPC == err) || (EFBIG == err))
+        {
+            LOG(VB_GENERAL, LOG_ERR, LOC +
+                QString("Giving up on '%1', file will be truncated, "
+                        "no further writing will be done.").arg(filename));
+            ring_ignore_writes.fetchAndStoreRelease(1);
+        }
+        else
+        {
+            bufferHasData.wait(locker.mutex(), 50);
+        }
+    }
+}
+
+/// \brief Clears the statistics, so each file is reported on its own.
+void ThreadedFileWriter::ResetStatistics(void)
+{
+    stat_max_depth     = 0;
+    stat_writes        = 0;
+    stat_direct_writes = 0;
+    stat_bytes         = 0;
+    stat_depth_sum     = 0;
+    stat_latency_sum   = 0;
+    stat_latency_max   = 0;
+}
+
+/** \brief Logs the queue depth and write latency seen by this writer.
+ *
+ *   Only collected in kWriteDirectRing mode.
+ */
+void ThreadedFileWriter::LogStatistics(void) const
+{
+    if (!stat_writes)
+        return;
+
+    LOG(VB_RECORD, LOG_INFO, LOC +
+        QString("Wrote %1 MB in %2 writes (%3 direct). "
+                "Queue depth avg %4 KB max %5 KB of %6 KB. "
+                "Write latency avg %7 ms max %8 ms.")
+            .arg(stat_bytes / (1024 * 1024))
+            .arg(stat_writes).arg(stat_direct_writes)
+            .arg(stat_depth_sum / stat_writes / 1024)
+            .arg(stat_max_depth / 1024).arg(ring->Size() / 1024)
+            .arg(stat_latency_sum / stat_writes / 1000.0, 0, 'f', 2)
+            .arg(stat_latency_max / 1000.0, 0, 'f', 2));
+}
@@ -9,6 +9,7 @@ using namespace std;
 #include <QDateTime>
 #include <QString>
 #include <QMutex>
+#include <QAtomicInt>
 
 #include <fcntl.h>
 #include <stdint.h>
@@ -37,12 +38,51 @@ class TFWSyncThread : public MThread
     ThreadedFileWriter *m_parent;
 };
 
+/** \brief Preallocated single-producer/single-consumer byte ring.
+ *
+ *  Put() may only be called from the producer thread and Peek()/Consume()
+ *  only from the consumer thread; neither side takes a lock. The head and
+ *  tail are free running byte counters, so the size must be a power of two.
+ */
+class TFWRing
+{
+  public:
+    TFWRing(uint size, uint alignment);
+    ~TFWRing();
+
+    bool IsValid(void) const { return m_data; }
+    uint Size(void) const { return m_size; }
+    uint Used(void) const;
+
+    bool Put(const void *data, uint count);
+    const char *Peek(uint &contiguous) const;
+    void Consume(uint count);
+    /// Number of bytes consumed so far, modulo 2^32.
+    uint Tail(void) const { return (uint) m_tail.fetchAndAddAcquire(0); }
+
+  private:
+    char              *m_data;
+    uint               m_size;
+    uint               m_mask;
+    mutable QAtomicInt m_head; ///< written only by the producer
+    mutable QAtomicInt m_tail; ///< written only by the consumer
+};
+
 class ThreadedFileWriter
 {
     friend class TFWWriteThread;
     friend class TFWSyncThread;
   public:
-    ThreadedFileWriter(const QString &fname, int flags, mode_t mode);
+    typedef enum WriteMode
+    {
+        /// List of heap buffers protected by a mutex, written with write()
+        kWriteBuffered = 0,
+        /// Lock-free preallocated ring, flushed with O_DIRECT where possible
+        kWriteDirectRing
+    } WriteMode;
+
+    ThreadedFileWriter(const QString &fname, int flags, mode_t mode,
+                       WriteMode wmode = kWriteBuffered);
     ~ThreadedFileWriter();
 
     bool Open(void);
@@ -56,17 +96,28 @@ class ThreadedFileWriter
     void Sync(void);
     void Flush(void);
 
+    void LogStatistics(void) const;
+    void ResetStatistics(void);
+
   protected:
     void DiskLoop(void);
+    void DiskLoopRing(void);
     void SyncLoop(void);
     void TrimEmptyBuffers(void);
 
+    uint WriteRing(const void *data, uint count);
+    void FlushRing(QMutexLocker &locker);
+    int  WriteRingChunk(const char *data, uint count);
+
   private:
     // file info
     QString         filename;
     int             flags;
     mode_t          mode;
     int             fd;
+    int             directfd;  ///< O_DIRECT descriptor, ring mode only
+    WriteMode       writemode;
+    long long       fileoffset; ///< next write offset, owned by DiskLoopRing
 
     // state
     bool            flush;              // protected by buflock
@@ -85,6 +136,17 @@ class ThreadedFileWriter
     mutable QMutex    buflock;
     QList<TFWBuffer*> writeBuffers;     // protected by buflock
     QList<TFWBuffer*> emptyBuffers;     // protected by buflock
+    TFWRing          *ring;
+    QAtomicInt        ring_ignore_writes;
+
+    // statistics, ring mode only
+    uint            stat_max_depth;     // written by Write() only
+    uint            stat_writes;        // written by DiskLoopRing() only
+    uint            stat_direct_writes; // written by DiskLoopRing() only
+    long long       stat_bytes;         // written by DiskLoopRing() only
+    long long       stat_depth_sum;     // written by DiskLoopRing() only
+    long long       stat_latency_sum;   // in usec, DiskLoopRing() only
+    uint            stat_latency_max;   // in usec, DiskLoopRing() only
 
     // threads
     TFWWriteThread *writeThread;
@@ -99,6 +161,10 @@ class ThreadedFileWriter
     static const uint kMaxBufferSize;
     /// Minimum to write to disk in a single write, when not flushing buffer.
     static const uint kMinWriteSize;
+    /// Size of the preallocated ring used by kWriteDirectRing.
+    static const uint kRingSize;
+    /// Block alignment required for O_DIRECT writes.
+    static const uint kDirectAlignment;
 };
 
 #endif
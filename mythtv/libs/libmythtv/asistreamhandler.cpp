@@ -232,9 +232,7 @@ void ASIStreamHandler::run(void)
             continue;
         }
 
-        StreamDataList::const_iterator sit = _stream_data_list.begin();
-        for (; sit != _stream_data_list.end(); ++sit)
-            remainder = sit.key()->ProcessData(buffer, len);
+        remainder = ProcessData(buffer, len);
 
         if (_mpts != NULL)
             _mpts->Write(buffer, len - remainder);
@@ -323,6 +323,7 @@ AvFormatDecoder::AvFormatDecoder(MythPlayer *parent,
       playerFlags(flags),
       video_codec_id(kCodec_NONE),
       maxkeyframedist(-1),
+      bitstream_keyframes(0),       bitstream_dialnorm(-1),
       // Closed Caption & Teletext decoders
       ignore_scte(false),
       invert_scte_field(0),
@@ -4376,6 +4377,48 @@ int AvFormatDecoder::DecodeAudio(AVCodecContext *ctx,
 }
 
 // documented in decoderbase.h
+/** \brief Returns the dialogue normalization of an AC-3 or E-AC-3 packet
+ *         in -dB, or -1 if the packet has none.
+ */
+static int ac3_dialnorm(const AVCodecContext *ctx, const AVPacket *pkt)
+{
+    if ((ctx->codec_id != CODEC_ID_AC3 && ctx->codec_id != CODEC_ID_EAC3) ||
+        pkt->size < 8 || pkt->data[0] != 0x0b || pkt->data[1] != 0x77)
+    {
+        return -1;
+    }
+
+    const uint8_t *buf = pkt->data;
+    uint bsid = buf[5] >> 3;
+    uint dialnorm;
+    if (bsid <= 10)
+    {
+        // acmod, then the mix levels it implies, lfeon and dialnorm
+        uint bits = (buf[6] << 8) | buf[7];
+        uint acmod = bits >> 13;
+        uint used = 3 + 1;
+        if ((acmod & 1) && acmod != 1)
+            used += 2;
+        if (acmod & 4)
+            used += 2;
+        if (acmod == 2)
+            used += 2;
+        dialnorm = (bits >> (16 - used - 5)) & 0x1f;
+    }
+    else if (bsid <= 16)
+    {
+        // E-AC-3 puts dialnorm right after bsid
+        dialnorm = ((buf[5] & 0x7) << 2) | (buf[6] >> 6);
+    }
+    else
+    {
+        return -1;
+    }
+
+    // 0 is reserved and means the same as 31
+    return dialnorm ? dialnorm : 31;
+}
+
 bool AvFormatDecoder::GetFrame(DecodeType decodetype)
 {
     AVPacket *pkt = NULL;
@@ -4590,6 +4633,14 @@ bool AvFormatDecoder::GetFrame(DecodeType decodetype)
 
         have_err = false;
 
+        if (bitstreamStats && codec_type == AVMEDIA_TYPE_AUDIO &&
+            pkt->stream_index == selectedTrack[kTrackTypeAudio].av_stream_index)
+        {
+            int dialnorm = ac3_dialnorm(curstream->codec, pkt);
+            if (dialnorm >= 0)
+                bitstream_dialnorm = dialnorm;
+        }
+
         switch (codec_type)
         {
             case AVMEDIA_TYPE_AUDIO:
@@ -4616,6 +4667,8 @@ bool AvFormatDecoder::GetFrame(DecodeType decodetype)
 
                 if (!(decodetype & kDecodeVideo))
                 {
+                    if (bitstreamStats)
+                        GatherBitstreamStats(curstream, pkt);
                     framesPlayed++;
                     gotVideoFrame = 1;
                     break;
@@ -4657,6 +4710,94 @@ bool AvFormatDecoder::GetFrame(DecodeType decodetype)
     return true;
 }
 
+/** \brief Records the size of a demuxed video packet in bitstreamStats,
+ *         decoding it too if it is a keyframe that should be sampled.
+ */
+void AvFormatDecoder::GatherBitstreamStats(AVStream *stream, AVPacket *pkt)
+{
+    if (framesRead <= 0)
+        return;
+
+    // The second field of a field coded frame adds to the same entry
+    if (bitstreamStats->size() < (size_t)framesRead)
+        bitstreamStats->resize(framesRead);
+    BitstreamFrameStats &stats = (*bitstreamStats)[framesRead - 1];
+
+    stats.size += pkt->size;
+    stats.dialnorm = bitstream_dialnorm;
+
+    if (!(pkt->flags & AV_PKT_FLAG_KEY) || stats.keyframe)
+        return;
+    stats.keyframe = true;
+
+    if (bitstreamKeyframeStep &&
+        (bitstream_keyframes++ % bitstreamKeyframeStep) == 0)
+    {
+        stats.decoded = DecodeKeyframeLuma(stream, pkt, stats);
+    }
+}
+
+/** \brief Decodes a keyframe on its own for its average and peak luma.
+ *
+ *  The codec is flushed before the keyframe so nothing else is referenced,
+ *  and drained after it so the picture is not held back for reordering.
+ *  With kDecodeLowRes MPEG-2 only decodes a scaled down picture, which is
+ *  all the brightness check needs.
+ */
+bool AvFormatDecoder::DecodeKeyframeLuma(AVStream *stream, AVPacket *pkt,
+                                         BitstreamFrameStats &stats)
+{
+    AVCodecContext *context = stream->codec;
+    if (private_dec || !context->codec)
+        return false;
+
+    AVFrame mpa_pic;
+    avcodec_get_frame_defaults(&mpa_pic);
+    int gotpicture = 0;
+
+    QMutexLocker locker(avcodeclock);
+
+    avcodec_flush_buffers(context);
+    if (avcodec_decode_video2(context, &mpa_pic, &gotpicture, pkt) < 0)
+        return false;
+
+    if (!gotpicture)
+    {
+        AVPacket drain;
+        av_init_packet(&drain);
+        drain.data = NULL;
+        drain.size = 0;
+        avcodec_decode_video2(context, &mpa_pic, &gotpicture, &drain);
+    }
+
+    if (!gotpicture || !mpa_pic.data[0])
+        return false;
+
+    // Every other pixel of every other line is plenty for a brightness
+    int width  = min(current_width, mpa_pic.linesize[0]);
+    int height = current_height;
+    uint64_t total = 0;
+    uint count = 0;
+    uint peak = 0;
+    for (int y = 0; y < height; y += 2)
+    {
+        const uint8_t *line = mpa_pic.data[0] + y * mpa_pic.linesize[0];
+        for (int x = 0; x < width; x += 2)
+        {
+            total += line[x];
+            peak = max(peak, (uint)line[x]);
+            count++;
+        }
+    }
+
+    if (!count)
+        return false;
+
+    stats.luma_avg = total / count;
+    stats.luma_max = peak;
+    return true;
+}
+
 bool AvFormatDecoder::HasVideo(const AVFormatContext *ic)
 {
     if (ic && ic->cur_pmt_sect)
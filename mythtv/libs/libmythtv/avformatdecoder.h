@@ -246,6 +246,9 @@ class AvFormatDecoder : public DecoderBase
     void HandleGopStart(AVPacket *pkt, bool can_reliably_parse_keyframes);
 
     bool GenerateDummyVideoFrames(void);
+    void GatherBitstreamStats(AVStream *stream, AVPacket *pkt);
+    bool DecodeKeyframeLuma(AVStream *stream, AVPacket *pkt,
+                            BitstreamFrameStats &stats);
     bool HasVideo(const AVFormatContext *ic);
     float normalized_fps(AVStream *stream, AVCodecContext *enc);
     void av_update_stream_timings_video(AVFormatContext *ic);
@@ -318,6 +321,10 @@ class AvFormatDecoder : public DecoderBase
 
     int maxkeyframedist;
 
+    // Bitstream statistics
+    uint bitstream_keyframes;
+    int  bitstream_dialnorm;
+
     // Caption/Subtitle/Teletext decoders
     bool             ignore_scte;
     uint             invert_scte_field;
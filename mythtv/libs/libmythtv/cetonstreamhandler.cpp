@@ -269,10 +269,8 @@ void CetonStreamHandler::run(void)
             continue;
         }
 
-        StreamDataList::const_iterator sit = _stream_data_list.begin();
-        for (; sit != _stream_data_list.end(); ++sit)
-            remainder = sit.key()->ProcessData(
-                reinterpret_cast<unsigned char*>(buffer), bytes_read);
+        remainder = ProcessData(
+            reinterpret_cast<unsigned char*>(buffer), bytes_read);
 
         _listener_lock.unlock();
         if (remainder != 0)
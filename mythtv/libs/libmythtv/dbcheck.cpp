@@ -2288,6 +2288,16 @@ NULL
         if (!performActualUpdate(&updates[0], "1308", dbver))
             return false;
     }
+
+    if (dbver == "1308")
+    {
+        const char *updates[] = {
+"ALTER TABLE recorded ADD INDEX starttime (starttime, chanid);",
+NULL
+};
+        if (!performActualUpdate(&updates[0], "1309", dbver))
+            return false;
+    }
     
     return true;
 }
@@ -98,6 +98,26 @@ class StreamInfo
 };
 typedef vector<StreamInfo> sinfo_vec_t;
 
+/** \brief What the bitstream says about one video frame, gathered while
+ *         demuxing without decoding it.  See DecoderBase::SetBitstreamStats().
+ */
+class BitstreamFrameStats
+{
+  public:
+    BitstreamFrameStats() :
+        size(0), keyframe(false), decoded(false),
+        luma_avg(0), luma_max(0), dialnorm(-1) {}
+
+  public:
+    uint size;          ///< Bytes of coded video for the frame
+    bool keyframe;
+    bool decoded;       ///< luma_avg and luma_max are valid
+    uint8_t luma_avg;
+    uint8_t luma_max;
+    int8_t dialnorm;    ///< AC-3 dialogue level in -dB, -1 if unknown
+};
+typedef vector<BitstreamFrameStats> bitstream_stats_t;
+
 class DecoderBase
 {
   public:
@@ -121,6 +141,10 @@ class DecoderBase
     void SetProgramInfo(const ProgramInfo &pginfo);
 
     void SetLowBuffers(bool low) { lowbuffers = low; }
+    /// Fills stats while GetFrame(kDecodeNothing) is demuxing, decoding
+    /// every keyframe_step'th keyframe for its brightness (none if 0).
+    void SetBitstreamStats(bitstream_stats_t *stats, uint keyframe_step)
+        { bitstreamStats = stats; bitstreamKeyframeStep = keyframe_step; }
     /// Disables AC3/DTS pass through
     virtual void SetDisablePassThrough(bool disable) { (void)disable; }
 
@@ -279,6 +303,9 @@ class DecoderBase
 
     bool lowbuffers;
 
+    bitstream_stats_t *bitstreamStats;
+    uint bitstreamKeyframeStep;
+
     bool getrawframes;
     bool getrawvideo;
 
@@ -262,9 +262,7 @@ void DVBStreamHandler::RunTS(void)
             continue;
         }
 
-        StreamDataList::const_iterator sit = _stream_data_list.begin();
-        for (; sit != _stream_data_list.end(); ++sit)
-            remainder = sit.key()->ProcessData(buffer, len);
+        remainder = ProcessData(buffer, len);
 
         _listener_lock.unlock();
 
@@ -6,6 +6,7 @@
  */
 
 #include <QDateTime>
+#include <QStringList>
 
 #include "eitcache.h"
 #include "mythcontext.h"
@@ -84,27 +85,31 @@ static inline bool modified(uint64_t sig)
     return sig >> 63;
 }
 
-static void replace_in_db(int chanid, uint eventid, uint64_t sig)
-{
+/// Maximum number of rows in one replace_in_db() statement
+static const int kMaxReplaceRows = 500;
 
+/** \brief Writes cache entries with multi-row REPLACE statements.
+ *
+ *   \param values "(chanid,eventid,tableid,version,endtime)" tuples,
+ *                 the list is cleared afterwards.
+ */
+static void replace_in_db(QStringList &values)
+{
     MSqlQuery query(MSqlQuery::InitCon());
 
-    QString qstr =
-        "REPLACE INTO eit_cache "
-        "       ( chanid,  eventid,  tableid,  version,  endtime) "
-        "VALUES (:CHANID, :EVENTID, :TABLEID, :VERSION, :ENDTIME)";
-
-    query.prepare(qstr);
-    query.bindValue(":CHANID",   chanid);
-    query.bindValue(":EVENTID",  eventid);
-    query.bindValue(":TABLEID",  extract_table_id(sig));
-    query.bindValue(":VERSION",  extract_version(sig));
-    query.bindValue(":ENDTIME",  extract_endtime(sig));
-
-    if (!query.exec())
-        MythDB::DBError("Error updating eitcache", query);
+    for (int i = 0; i < values.size(); i += kMaxReplaceRows)
+    {
+        QString qstr =
+            "REPLACE INTO eit_cache "
+            "       ( chanid,  eventid,  tableid,  version,  endtime) "
+            "VALUES " +
+            QStringList(values.mid(i, kMaxReplaceRows)).join(",");
+
+        if (!query.exec(qstr))
+            MythDB::DBError("Error updating eitcache", query);
+    }
 
-    return;
+    values.clear();
 }
 
 static void delete_in_db(uint endtime)
@@ -274,18 +279,22 @@ void EITCache::WriteChannelToDB(uint chanid)
 
     uint size    = eventMap->size();
     uint updated = 0;
+    QStringList values;
 
     event_map_t::iterator it = eventMap->begin();
     while (it != eventMap->end())
     {
         if (modified(*it) && extract_endtime(*it) > lastPruneTime)
         {
-            replace_in_db(chanid, it.key(), *it);
+            values << QString("(%1,%2,%3,%4,%5)").arg(chanid).arg(it.key())
+                .arg(extract_table_id(*it)).arg(extract_version(*it))
+                .arg(extract_endtime(*it));
             updated++;
             *it &= ~(uint64_t)0 >> 1; // mark as synced
         }
         ++it;
     }
+    replace_in_db(values);
     unlock_channel(chanid, updated);
 
     if (updated)
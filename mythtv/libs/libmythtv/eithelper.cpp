@@ -18,11 +18,12 @@ using namespace std;
 #include "dishdescriptors.h"
 #include "premieredescriptors.h"
 #include "mythdate.h"
+#include "mythtimer.h"
 #include "programdata.h"
 #include "programinfo.h" // for subtitle types and audio and video properties
 #include "compat.h" // for gmtime_r on windows.
 
-const uint EITHelper::kChunkSize = 20;
+const uint EITHelper::kChunkSize = 200;
 EITCache *EITHelper::eitcache = new EITCache();
 
 static uint get_chan_id_from_db(uint sourceid,
@@ -59,6 +60,10 @@ uint EITHelper::GetListSize(void) const
 /** \fn EITHelper::ProcessEvents(void)
  *  \brief Inserts events in EIT list.
  *
+ *   The events are grouped by channel and each group is written with
+ *   DBEvent::UpdateDB(MSqlQuery&,uint,const vector<DBEvent*>&,int),
+ *   which loads the overlapping programs once per group.
+ *
  *  \return Returns number of events inserted into DB.
  */
 uint EITHelper::ProcessEvents(void)
@@ -69,19 +74,35 @@ uint EITHelper::ProcessEvents(void)
     if (!db_events.size())
         return 0;
 
-    MSqlQuery query(MSqlQuery::InitCon());
+    QMap<uint, vector<DBEvent*> > chan_events;
     for (uint i = 0; (i < kChunkSize) && (db_events.size() > 0); i++)
     {
         DBEventEIT *event = db_events.dequeue();
         eitList_lock.unlock();
 
         eitfixup->Fix(*event);
+        chan_events[event->chanid].push_back(event);
 
-        insertCount += event->UpdateDB(query, 1000);
-
-        delete event;
         eitList_lock.lock();
     }
+    eitList_lock.unlock();
+
+    MythTimer t;
+    t.start();
+
+    MSqlQuery query(MSqlQuery::InitCon());
+    QMap<uint, vector<DBEvent*> >::iterator it = chan_events.begin();
+    for (; it != chan_events.end(); ++it)
+    {
+        insertCount += DBEvent::UpdateDB(query, it.key(), *it, 1000);
+
+        for (uint i = 0; i < (*it).size(); i++)
+            delete (*it)[i];
+    }
+
+    uint rate = insertCount * 1000 / max(t.elapsed(), 1);
+
+    eitList_lock.lock();
 
     if (!insertCount)
         return 0;
@@ -89,15 +110,16 @@ uint EITHelper::ProcessEvents(void)
     if (incomplete_events.size() || unmatched_etts.size())
     {
         LOG(VB_EIT, LOG_INFO,
-            LOC + QString("Added %1 events -- complete(%2) "
-                          "incomplete(%3) unmatched(%4)")
-                .arg(insertCount).arg(db_events.size())
+            LOC + QString("Added %1 events (%2/s) -- complete(%3) "
+                          "incomplete(%4) unmatched(%5)")
+                .arg(insertCount).arg(rate).arg(db_events.size())
                 .arg(incomplete_events.size()).arg(unmatched_etts.size()));
     }
     else
     {
         LOG(VB_EIT, LOG_INFO,
-            LOC + QString("Added %1 events").arg(insertCount));
+            LOC + QString("Added %1 events (%2/s)")
+                .arg(insertCount).arg(rate));
     }
 
     return insertCount;
@@ -133,6 +155,12 @@ void EITHelper::SetSourceID(uint _sourceid)
     sourceid = _sourceid;
 }
 
+uint EITHelper::GetSourceID(void)
+{
+    QMutexLocker locker(&eitList_lock);
+    return sourceid;
+}
+
 void EITHelper::AddEIT(uint atsc_major, uint atsc_minor,
                        const EventInformationTable *eit)
 {
@@ -16,6 +16,7 @@
 #include "mthread.h"
 #include "iso639.h"
 #include "mythdb.h"
+#include "mythcorecontext.h"
 #include "tv_rec.h"
 
 #define LOC QString("EITScanner: ")
@@ -30,6 +31,7 @@
 
 QMutex     EITScanner::resched_lock;
 QDateTime  EITScanner::resched_next_time      = MythDate::current();
+QSet<uint> EITScanner::resched_sources;
 const uint EITScanner::kMinRescheduleInterval = 150;
 
 EITScanner::EITScanner(uint _cardnum)
@@ -113,7 +115,7 @@ void EITScanner::run(void)
             LOG(VB_EIT, LOG_INFO,
                 LOC_ID + QString("Added %1 EIT Events").arg(eitCount));
             eitCount = 0;
-            RescheduleRecordings();
+            RescheduleRecordings(eitHelper->GetSourceID());
         }
 
         if (activeScan && (MythDate::current() > activeScanNextTrig))
@@ -124,7 +126,7 @@ void EITScanner::run(void)
                 LOG(VB_EIT, LOG_INFO,
                     LOC_ID + QString("Added %1 EIT Events").arg(eitCount));
                 eitCount = 0;
-                RescheduleRecordings();
+                RescheduleRecordings(eitHelper->GetSourceID());
             }
 
             if (activeScanNextChan == activeScanChannels.end())
@@ -165,29 +167,48 @@ void EITScanner::run(void)
     lock.unlock();
 }
 
-/** \fn EITScanner::RescheduleRecordings(void)
- *  \brief Tells scheduler about programming changes.
+/** \fn EITScanner::RescheduleRecordings(uint)
+ *  \brief Tells scheduler about programming changes on a video source.
  *
  *  This implements some very basic rate limiting. If a call is made
- *  to this within kMinRescheduleInterval of the last call it is ignored.
+ *  to this within kMinRescheduleInterval of the last call, its source
+ *  is only remembered and rescheduled with the next call that isn't.
+ *  The sources are only passed on when the scheduler runs incrementally.
  */
-void EITScanner::RescheduleRecordings(void)
+void EITScanner::RescheduleRecordings(uint sourceid)
 {
-    if (!resched_lock.tryLock())
-        return;
+    QMutexLocker locker(&resched_lock);
+
+    resched_sources.insert(sourceid);
 
     if (resched_next_time > MythDate::current())
     {
         LOG(VB_EIT, LOG_INFO, LOC + "Rate limiting reschedules..");
-        resched_lock.unlock();
         return;
     }
 
     resched_next_time =
         MythDate::current().addSecs(kMinRescheduleInterval);
-    resched_lock.unlock();
 
-    ScheduledRecording::RescheduleMatch(0, 0, 0, QDateTime(), "EITScanner");
+    QSet<uint> sources = resched_sources;
+    resched_sources.clear();
+    locker.unlock();
+
+    // Without incremental scheduling a per source request saves nothing,
+    // so keep asking for a single complete match.
+    if (!gCoreContext->GetNumSetting("SchedIncremental", 0))
+    {
+        ScheduledRecording::RescheduleMatch(0, 0, 0, QDateTime(),
+                                            "EITScanner");
+        return;
+    }
+
+    QSet<uint>::const_iterator it = sources.begin();
+    for (; it != sources.end(); ++it)
+    {
+        ScheduledRecording::RescheduleMatch(0, *it, 0, QDateTime(),
+                                            "EITScanner");
+    }
 }
 
 /** \fn EITScanner::StartPassiveScan(ChannelBase*, EITSource*, bool)
@@ -6,6 +6,7 @@
 #include <QWaitCondition>
 #include <QStringList>
 #include <QDateTime>
+#include <QSet>
 #include <QRunnable>
 #include <QMutex>
 
@@ -46,7 +47,7 @@ class EITScanner : public QRunnable
   private:
     void TeardownAll(void);
     static void *SpawnEventLoop(void*);
-    static void RescheduleRecordings(void);
+    static void RescheduleRecordings(uint sourceid);
 
     QMutex           lock;
     ChannelBase     *channel;
@@ -70,6 +71,7 @@ class EITScanner : public QRunnable
 
     static QMutex    resched_lock;
     static QDateTime resched_next_time;
+    static QSet<uint> resched_sources;
 
     /// Minumum number of seconds between reschedules.
     static const uint kMinRescheduleInterval;
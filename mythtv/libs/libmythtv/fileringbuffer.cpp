@@ -40,9 +40,17 @@ static int posix_fadvise(int, off_t, off_t, int) { return 0; }
 
 #define LOC      QString("FileRingBuf(%1): ").arg(filename)
 
+/// Smallest window we ask the kernel to prefetch ahead of local reads
+static const long long kAdviseMinWindow  = 1024 * 1024;
+/// Largest window we ask the kernel to prefetch ahead of local reads
+static const long long kAdviseMaxWindow  = 16 * 1024 * 1024;
+/// Amount of recently read data left in the page cache behind the reader
+static const long long kAdviseKeepBehind = 32 * 1024 * 1024;
+
 FileRingBuffer::FileRingBuffer(const QString &lfilename,
                                bool write, bool readahead, int timeout_ms)
-  : RingBuffer(kRingBuffer_File)
+  : RingBuffer(kRingBuffer_File),
+    adviseAhead(0), adviseBehind(0)
 {
     startreadahead = readahead;
     safefilename = lfilename;
@@ -66,8 +74,12 @@ FileRingBuffer::FileRingBuffer(const QString &lfilename,
         }
         else
         {
+            ThreadedFileWriter::WriteMode wmode =
+                gCoreContext->GetNumSetting("RecordWithDirectIO", 0) ?
+                ThreadedFileWriter::kWriteDirectRing :
+                ThreadedFileWriter::kWriteBuffered;
             tfw = new ThreadedFileWriter(
-                filename, O_WRONLY|O_TRUNC|O_CREAT|O_LARGEFILE, 0644);
+                filename, O_WRONLY|O_TRUNC|O_CREAT|O_LARGEFILE, 0644, wmode);
 
             if (!tfw->Open())
             {
@@ -257,6 +269,8 @@ bool FileRingBuffer::OpenFile(const QString &lfilename, uint retry_ms)
                     {
                         posix_fadvise(fd2, 0, 0,        POSIX_FADV_SEQUENTIAL);
                         posix_fadvise(fd2, 0, 128*1024, POSIX_FADV_WILLNEED);
+                        adviseAhead = 128*1024;
+                        adviseBehind = 0;
                         lasterror = 0;
                         break;
                     }
@@ -476,9 +490,58 @@ int FileRingBuffer::safe_read(int fd, void *data, uint sz)
         if (tot < sz)
             usleep(60000);
     }
+
+    if (tot > 0)
+        AdviseReadWindow(lseek64(fd2, 0, SEEK_CUR), tot);
+
     return tot;
 }
 
+/** \fn FileRingBuffer::AdviseReadWindow(long long, uint)
+ *  \brief Keeps the kernel's page cache hints in step with local reads.
+ *
+ *   We ask the kernel to prefetch a window ahead of the read position
+ *   which grows with the size of the reads being made, so the read
+ *   ahead thread rarely has to wait on the disk when it enlarges its
+ *   block size. Data well behind the read position is released from
+ *   the page cache so that fast-forward, or several streams read off
+ *   the same disk, do not push each other's data out of memory.
+ *
+ *  \param pos       Current file offset of the file descriptor
+ *  \param last_read Number of bytes returned by the last read
+ */
+void FileRingBuffer::AdviseReadWindow(long long pos, uint last_read)
+{
+    if (pos < 0)
+        return;
+
+    long long window = max(kAdviseMinWindow, (long long)last_read * 16);
+    window = min(window, kAdviseMaxWindow);
+
+    // After a seek we are outside the advised range, start over here.
+    if (pos < adviseBehind || pos > adviseAhead)
+    {
+        adviseAhead  = pos;
+        adviseBehind = pos;
+    }
+
+    if (pos + window / 2 > adviseAhead)
+    {
+        long long end = pos + window;
+        posix_fadvise(fd2, adviseAhead, end - adviseAhead,
+                      POSIX_FADV_WILLNEED);
+        adviseAhead = end;
+    }
+
+    if (pos - adviseBehind > kAdviseKeepBehind + window)
+    {
+        long long end = pos - kAdviseKeepBehind;
+        posix_fadvise(fd2, adviseBehind, end - adviseBehind,
+                      POSIX_FADV_DONTNEED);
+        adviseBehind = end;
+    }
+}
+
 /** \fn FileRingBuffer::safe_read(RemoteFile*, void*, uint)
  *  \brief Reads data from the RemoteFile.
  *
@@ -33,4 +33,11 @@ class MTV_PUBLIC FileRingBuffer : public RingBuffer
     }
     int safe_read(int fd, void *data, uint sz);
     int safe_read(RemoteFile *rf, void *data, uint sz);
+
+    void AdviseReadWindow(long long pos, uint last_read);
+
+    /// End of the range we have asked the kernel to prefetch
+    long long adviseAhead;
+    /// Start of the range we have not yet released from the page cache
+    long long adviseBehind;
 };
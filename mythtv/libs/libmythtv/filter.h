@@ -32,6 +32,21 @@ typedef struct FilterInfo_
     char *libname;
 } FilterInfo;
 
+typedef struct FilterSlicePool_ FilterSlicePool;
+
+/* Does one horizontal slice of a filter's work, the slices of a frame may
+ * run concurrently on different threads */
+typedef void (*filter_slice_func)(void *arg, int this_slice, int total_slices);
+
+/* Worker threads owned by a FilterChain and shared by its filters */
+struct FilterSlicePool_
+{
+    /* Runs func for slices 0 to total_slices - 1, returns when all are done */
+    void (*run)(FilterSlicePool *pool, filter_slice_func func, void *arg,
+                int total_slices);
+    int threads;
+};
+
 struct VideoFilter_
 {
     int (*filter)(struct VideoFilter_ *, VideoFrame *, int);
@@ -42,10 +57,31 @@ struct VideoFilter_
     VideoFrameType outpixfmt;
     char *opts;
     FilterInfo *info;
+    FilterSlicePool *slices; /* Set by FilterChain, NULL if single threaded */
 };
 
 #define FILT_NULL {NULL,NULL,NULL,NULL,NULL}
 
+/* Number of slices worth splitting a frame into for this filter */
+static inline int filter_slice_count(const VideoFilter *vf)
+{
+    return (vf->slices && vf->slices->threads > 1) ? vf->slices->threads : 1;
+}
+
+/* Runs func once for each slice, on the chain's threads if there are any */
+static inline void filter_run_slices(VideoFilter *vf, filter_slice_func func,
+                                     void *arg, int total_slices)
+{
+    int i;
+    if (vf->slices && total_slices > 1)
+    {
+        vf->slices->run(vf->slices, func, arg, total_slices);
+        return;
+    }
+    for (i = 0; i < total_slices; i++)
+        func(arg, i, total_slices);
+}
+
 #ifdef TIME_FILTER
 
 #ifndef TF_INTERVAL
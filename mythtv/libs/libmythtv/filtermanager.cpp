@@ -10,11 +10,14 @@
 // Qt headers
 #include <QDir>
 #include <QStringList>
+#include <QMutex>
+#include <QWaitCondition>
 
 // MythTV headers
 #include "mythcontext.h"
 #include "filtermanager.h"
 #include "mythdirs.h"
+#include "mthread.h"
 
 #define LOC QString("FilterManager: ")
 
@@ -37,6 +40,140 @@ static const char *FmtToString(VideoFrameType ft)
     }
 }
 
+class FilterSliceThread : public MThread
+{
+  public:
+    FilterSliceThread(FilterThreadPool *pool) :
+        MThread("FilterSlice"), m_pool(pool) { }
+
+  protected:
+    void run(void);
+
+  private:
+    FilterThreadPool *m_pool;
+};
+
+/** \class FilterThreadPool
+ *  \brief Runs the slices of a filter on the threads of a FilterChain.
+ *
+ *  The thread calling FilterChain::ProcessFrame() takes slices too, so
+ *  only max_threads - 1 threads are started, and they are started on the
+ *  first frame so that chains which never slice anything cost nothing.
+ */
+class FilterThreadPool : public FilterSlicePool
+{
+  public:
+    FilterThreadPool(int max_threads) :
+        m_func(NULL), m_arg(NULL), m_total(0), m_next(0), m_pending(0),
+        m_stop(false)
+    {
+        run = &FilterThreadPool::RunSlices;
+        threads = max_threads;
+    }
+
+    ~FilterThreadPool()
+    {
+        m_lock.lock();
+        m_stop = true;
+        m_wake.wakeAll();
+        m_lock.unlock();
+
+        vector<FilterSliceThread*>::iterator it = m_threads.begin();
+        for (; it != m_threads.end(); ++it)
+        {
+            (*it)->wait();
+            delete *it;
+        }
+    }
+
+    /// Does slices until there are none left, returns false when stopping
+    bool DoSlices(bool wait)
+    {
+        QMutexLocker locker(&m_lock);
+
+        while (wait && !m_stop && m_next >= m_total)
+            m_wake.wait(&m_lock);
+
+        while (m_next < m_total)
+        {
+            int slice = m_next++;
+            filter_slice_func func = m_func;
+            void *arg = m_arg;
+            int total = m_total;
+
+            m_lock.unlock();
+            func(arg, slice, total);
+            m_lock.lock();
+
+            if (--m_pending == 0)
+                m_done.wakeAll();
+        }
+
+        return !m_stop;
+    }
+
+  private:
+    static void RunSlices(FilterSlicePool *pool, filter_slice_func func,
+                          void *arg, int total_slices)
+    {
+        FilterThreadPool *tp = static_cast<FilterThreadPool*>(pool);
+
+        if (tp->m_threads.empty())
+        {
+            for (int i = 1; i < tp->threads; i++)
+            {
+                tp->m_threads.push_back(new FilterSliceThread(tp));
+                tp->m_threads.back()->start();
+            }
+            LOG(VB_PLAYBACK, LOG_INFO, LOC +
+                QString("Started %1 filter threads").arg(tp->threads - 1));
+        }
+
+        tp->m_lock.lock();
+        tp->m_func    = func;
+        tp->m_arg     = arg;
+        tp->m_total   = total_slices;
+        tp->m_next    = 0;
+        tp->m_pending = total_slices;
+        tp->m_wake.wakeAll();
+        tp->m_lock.unlock();
+
+        tp->DoSlices(false);
+
+        tp->m_lock.lock();
+        while (tp->m_pending > 0)
+            tp->m_done.wait(&tp->m_lock);
+        tp->m_total = 0;
+        tp->m_next  = 0;
+        tp->m_lock.unlock();
+    }
+
+    QMutex             m_lock;
+    QWaitCondition     m_wake;
+    QWaitCondition     m_done;
+    filter_slice_func  m_func;
+    void              *m_arg;
+    int                m_total;
+    int                m_next;
+    int                m_pending;
+    bool               m_stop;
+    vector<FilterSliceThread*> m_threads;
+};
+
+void FilterSliceThread::run(void)
+{
+    RunProlog();
+    while (m_pool->DoSlices(true))
+        ;
+    RunEpilog();
+}
+
+FilterChain::FilterChain(int max_threads) : threadPool(NULL)
+{
+    if (max_threads > 1)
+        threadPool = new FilterThreadPool(max_threads);
+}
+
 FilterChain::~FilterChain()
 {
     vector<VideoFilter*>::iterator it = filters.begin();
@@ -51,6 +188,14 @@ FilterChain::~FilterChain()
         free(filter);
     }
     filters.clear();
+
+    delete threadPool;
+}
+
+void FilterChain::Append(VideoFilter *f)
+{
+    f->slices = threadPool;
+    filters.push_back(f);
 }
 
 void FilterChain::ProcessFrame(VideoFrame *frame, FrameScanType scan)
@@ -202,7 +347,7 @@ FilterChain *FilterManager::LoadFilters(QString Filters,
         return NULL;
 
     vector<const FilterInfo*> FiltInfoChain;
-    FilterChain *FiltChain = new FilterChain;
+    FilterChain *FiltChain = new FilterChain(max_threads);
     vector<FmtConv*> FmtList;
     const FilterInfo *FI;
     const FilterInfo *FI2;
@@ -554,5 +699,6 @@ VideoFilter * FilterManager::LoadFilter(const FilterInfo *FiltInfo,
     else
         Filter->opts = NULL;
     Filter->info = const_cast<FilterInfo*>(FiltInfo);
+    Filter->slices = NULL;
     return Filter;
 }
@@ -19,18 +19,21 @@ typedef map<QString,FilterInfo*> filter_map_t;
 
 #include "videoouttypes.h"
 
+class FilterThreadPool;
+
 class FilterChain
 {
   public:
-    FilterChain() { }
+    FilterChain(int max_threads = 1);
     virtual ~FilterChain();
 
     void ProcessFrame(VideoFrame *Frame, FrameScanType scan = kScan_Ignore);
 
-    void Append(VideoFilter *f) { filters.push_back(f); }
+    void Append(VideoFilter *f);
 
   private:
     vector<VideoFilter*> filters;
+    FilterThreadPool    *threadPool;
 };
 
 class FilterManager
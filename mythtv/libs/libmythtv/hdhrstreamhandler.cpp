@@ -166,9 +166,7 @@ void HDHRStreamHandler::run(void)
             continue;
         }
 
-        StreamDataList::const_iterator sit = _stream_data_list.begin();
-        for (; sit != _stream_data_list.end(); ++sit)
-            remainder = sit.key()->ProcessData(data_buffer, data_length);
+        remainder = ProcessData(data_buffer, data_length);
 
         _listener_lock.unlock();
         if (remainder != 0)
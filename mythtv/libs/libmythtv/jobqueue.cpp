@@ -13,6 +13,7 @@ using namespace std;
 #include <QRegExp>
 #include <QEvent>
 #include <QCoreApplication>
+#include <QThread>
 
 #include "mythconfig.h"
 
@@ -43,6 +44,9 @@ using namespace std;
 
 #define LOC     QString("JobQueue: ")
 
+/// How often the queue is scanned when it is woken up by events
+static const int kJobQueueEventPollTime = 5 * 60;
+
 JobQueue::JobQueue(bool master) :
     m_hostname(gCoreContext->GetHostName()),
     jobsRunning(0),
@@ -51,7 +55,8 @@ JobQueue::JobQueue(bool master) :
     runningJobsLock(new QMutex(QMutex::Recursive)),
     isMaster(master),
     queueThread(new MThread("JobQueue", this)),
-    processQueue(false)
+    processQueue(false),
+    m_wakeup(false)
 {
     jobQueueCPU = gCoreContext->GetNumSetting("JobQueueCPU", 0);
 
@@ -91,6 +96,14 @@ void JobQueue::customEvent(QEvent *e)
         MythEvent *me = (MythEvent *)e;
         QString message = me->Message();
 
+        if (message == "JOB_QUEUE_CHANGED")
+        {
+            QMutexLocker locker(&queueThreadCondLock);
+            m_wakeup = true;
+            queueThreadCond.wakeAll();
+            return;
+        }
+
         if (message.left(9) == "LOCAL_JOB")
         {
             // LOCAL_JOB action ID jobID
@@ -174,6 +187,8 @@ void JobQueue::ProcessQueue(void)
     int status;
     QString hostname;
     int sleepTime;
+    bool wakeOnEvents;
+    QDateTime nextScheduled;
 
     QMap<int, int> jobStatus;
     int maxJobs;
@@ -191,6 +206,10 @@ void JobQueue::ProcessQueue(void)
 
         startedJobAlready = false;
         sleepTime = gCoreContext->GetNumSetting("JobQueueCheckFrequency", 30);
+        wakeOnEvents = gCoreContext->GetNumSetting("JobQueueWakeOnEvents", 1);
+        if (wakeOnEvents)
+            sleepTime = max(sleepTime, kJobQueueEventPollTime);
+        nextScheduled = QDateTime();
         maxJobs = gCoreContext->GetNumSetting("JobQueueMaxSimultaneousJobs", 3);
         LOG(VB_JOBQUEUE, LOG_INFO, LOC +
             QString("Currently set to run up to %1 job(s) max.")
@@ -319,6 +338,12 @@ void JobQueue::ProcessQueue(void)
                 // Is this job scheduled for the future
                 if (jobs[x].schedruntime > MythDate::current())
                 {
+                    if (!nextScheduled.isValid() ||
+                        jobs[x].schedruntime < nextScheduled)
+                    {
+                        nextScheduled = jobs[x].schedruntime;
+                    }
+
                     message = QString("Skipping '%1' job for %2, this job is "
                                       "not scheduled to run until %3.")
                                       .arg(JobText(jobs[x].type)).arg(logInfo)
@@ -435,6 +460,15 @@ void JobQueue::ProcessQueue(void)
                 if (startedJobAlready)
                     continue;
 
+                if ((inTimeWindow) && (!HaveCPUForJob()))
+                {
+                    message = QString("Skipping '%1' job for %2, "
+                                      "this backend is too busy.")
+                                      .arg(JobText(jobs[x].type)).arg(logInfo);
+                    LOG(VB_JOBQUEUE, LOG_INFO, LOC + message);
+                    continue;
+                }
+
                 if ((inTimeWindow) &&
                     (hostname.isEmpty()) &&
                     (!ChangeJobHost(jobID, m_hostname)))
@@ -462,6 +496,7 @@ void JobQueue::ProcessQueue(void)
                 LOG(VB_JOBQUEUE, LOG_INFO, LOC + message);
 
                 ProcessJob(jobs[x]);
+                m_recentStarts.push_back(MythDate::current());
 
                 startedJobAlready = true;
             }
@@ -494,10 +529,78 @@ void JobQueue::ProcessQueue(void)
         if (processQueue)
         {
             int st = (startedJobAlready) ? (5 * 1000) : (sleepTime * 1000);
-            if (st > 0)
+
+            // Wake up in time for jobs scheduled to run later
+            if (wakeOnEvents && nextScheduled.isValid())
+            {
+                // Clamped first, a job years ahead would overflow st
+                int secs = MythDate::current().secsTo(nextScheduled) + 1;
+                secs = max(1, min(secs, sleepTime));
+                st = min(st, secs * 1000);
+            }
+
+            // A job queued or finished while we were scanning means another
+            // pass is needed straight away
+            if (st > 0 && !(m_wakeup && !startedJobAlready))
                 queueThreadCond.wait(locker.mutex(), st);
         }
+        m_wakeup = false;
+    }
+}
+
+/** \brief Returns true if this host has the CPU to start another job.
+ *
+ *  With JobQueueMaxCPULoad set, a job is only started while the load
+ *  average stays below that percentage of the CPUs. Jobs started in the
+ *  last minute count as one each, as the load average has not caught up
+ *  with them yet. A host that is not running any jobs can always start one.
+ */
+bool JobQueue::HaveCPUForJob(void)
+{
+    QDateTime cutoff = MythDate::current().addSecs(-60);
+    while (!m_recentStarts.isEmpty() && m_recentStarts.front() < cutoff)
+        m_recentStarts.pop_front();
+
+    int maxLoad = gCoreContext->GetNumSetting("JobQueueMaxCPULoad", 0);
+    if (maxLoad <= 0 || jobsRunning == 0)
+        return true;
+
+    double loads[3];
+    if (getloadavg(loads, 3) == -1)
+        return true;
+
+    int cpus = max(QThread::idealThreadCount(), 1);
+    double load = 100.0 * (loads[0] + m_recentStarts.size()) / cpus;
+
+    LOG(VB_JOBQUEUE, LOG_INFO, LOC +
+        QString("Load is %1% of %2 CPUs, jobs start below %3%")
+            .arg(load, 0, 'f', 0).arg(cpus).arg(maxLoad));
+
+    return load < maxLoad;
+}
+
+/** \brief Tells the job queue on every host that the queue has changed.
+ *
+ *  The JOB_QUEUE_CHANGED event goes to the master backend, which passes it
+ *  on to its own JobQueue and to every connected slave and mythjobqueue.
+ */
+void JobQueue::NotifyJobQueues(void)
+{
+    if (!gCoreContext->GetNumSetting("JobQueueWakeOnEvents", 1))
+        return;
+
+    QString message("JOB_QUEUE_CHANGED");
+
+    if (gCoreContext->IsBackend() && !gCoreContext->IsMasterBackend())
+    {
+        // A slave only dispatches SendMessage() locally
+        gCoreContext->dispatch(MythEvent(message));
+        QStringList strlist("MESSAGE");
+        strlist << message;
+        gCoreContext->SendReceiveStringList(strlist);
     }
+    else
+        gCoreContext->SendMessage(message);
 }
 
 bool JobQueue::QueueRecordingJobs(const RecordingInfo &recinfo, int jobTypes)
@@ -609,6 +712,8 @@ bool JobQueue::QueueJob(int jobType, uint chanid, const QDateTime &recstartts,
         return false;
     }
 
+    NotifyJobQueues();
+
     return true;
 }
 
@@ -1833,6 +1938,9 @@ void JobQueue::RemoveRunningJob(int id)
     }
 
     runningJobsLock->unlock();
+
+    // Other jobs for the same recording may have been waiting for this one
+    NotifyJobQueues();
 }
 
 QString JobQueue::PrettyPrint(off_t bytes)
@@ -2341,8 +2449,6 @@ void JobQueue::DoFlagCommercialsThread(int jobID)
         comment = tr("%n commercial break(s)", "", breaksFound);
         ChangeJobStatus(jobID, JOB_FINISHED, comment);
 
-        program_info->SendUpdateEvent();
-
         if (!program_info->IsLocal())
             program_info->SetPathname(program_info->GetPlaybackURL(false,true));
         if (program_info->IsLocal())
@@ -2354,6 +2460,9 @@ void JobQueue::DoFlagCommercialsThread(int jobID)
         }
     }
 
+    // The recording is no longer being flagged, however the job ended
+    program_info->SendUpdateEvent();
+
     msg = tr("Commercial Detection %1", "Job ID")
         .arg(StatusText(GetJobStatus(jobID)));
 
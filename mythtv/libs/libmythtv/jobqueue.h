@@ -9,6 +9,7 @@
 #include <QObject>
 #include <QEvent>
 #include <QMutex>
+#include <QList>
 #include <QMap>
 
 #include "mythtvexp.h"
@@ -210,6 +211,8 @@ class MTV_PUBLIC JobQueue : public QObject, public QRunnable
     void ProcessJob(JobQueueEntry job);
 
     bool AllowedToRun(JobQueueEntry job);
+    bool HaveCPUForJob(void);
+    static void NotifyJobQueues(void);
 
     static bool InJobRunWindow(int orStartingWithinMins = 0);
 
@@ -252,6 +255,9 @@ class MTV_PUBLIC JobQueue : public QObject, public QRunnable
     QWaitCondition queueThreadCond;
     QMutex queueThreadCondLock;
     bool processQueue;
+    bool m_wakeup;                      ///< protected by queueThreadCondLock
+
+    QList<QDateTime> m_recentStarts;    ///< jobs started in the last minute
 };
 
 #endif
@@ -4,6 +4,9 @@
 #include <algorithm> // for find & max
 using namespace std;
 
+// C headers
+#include <cstring> // for memchr & memset
+
 // POSIX headers
 #include <sys/time.h> // for gettimeofday
 
@@ -84,6 +87,7 @@ MPEGStreamData::MPEGStreamData(int desiredProgram, bool cacheTables)
       _invalid_pat_seen(false), _invalid_pat_warning(false)
 {
     memset(_si_time_offsets, 0, sizeof(_si_time_offsets));
+    memset(_pid_flags, 0, sizeof(_pid_flags));
 
     AddListeningPID(MPEG_PAT_PID);
     AddListeningPID(MPEG_CAT_PID);
@@ -189,6 +193,7 @@ void MPEGStreamData::Reset(int desiredProgram)
     _pids_notlistening.clear();
     _pids_writing.clear();
     _pids_audio.clear();
+    ClearPIDFlags(kPIDListening | kPIDNotListening | kPIDWriting | kPIDAudio);
 
     _pid_video_single_program = _pid_pmt_single_program = 0xffffffff;
 
@@ -638,6 +643,7 @@ bool MPEGStreamData::CreatePMTSingleProgram(const ProgramMapTable &pmt)
     }
 
     _pids_audio.clear();
+    ClearPIDFlags(kPIDAudio);
     for (uint i = 0; i < audioPIDs.size(); i++)
         AddAudioPID(audioPIDs[i]);
 
@@ -906,98 +912,108 @@ void MPEGStreamData::UpdateTimeOffset(uint64_t _si_utc_time)
 
 }
 
-#define DONE_WITH_PSIP_PACKET() { if (psip) delete psip; \
-    if (morePSIPTables) goto HAS_ANOTHER_PSIP; else return; }
-
 /** \fn MPEGStreamData::HandleTSTables(const TSPacket*)
  *  \brief Assembles PSIP packets and processes them.
  */
 void MPEGStreamData::HandleTSTables(const TSPacket* tspacket)
 {
-    bool morePSIPTables;
-  HAS_ANOTHER_PSIP:
-    // Assemble PSIP
-    PSIPTable *psip = AssemblePSIP(tspacket, morePSIPTables);
-    if (!psip)
-       return;
+    bool morePSIPTables = true;
+    while (morePSIPTables)
+    {
+        // Assemble PSIP
+        PSIPTable *psip = AssemblePSIP(tspacket, morePSIPTables);
+        if (!psip)
+           return;
+
+        if (tspacket->Scrambled() && psip->HasCRC())
+        { // scrambled! ATSC, DVB require tables not to be scrambled
+            LOG(VB_RECORD, LOG_ERR,
+                "PSIP packet is scrambled, not ATSC/DVB compiant");
+        }
+        else
+        {
+            HandleAssembledTable(tspacket->PID(), *psip);
+        }
+
+        delete psip;
+    }
+}
 
+/** \fn MPEGStreamData::HandleAssembledTable(uint, const PSIPTable&)
+ *  \brief Validates an assembled PSIP table and processes it.
+ *
+ *   StreamHandler calls this directly with the sections of the SI PIDs
+ *   all its listeners receive, which it assembles only once for them.
+ */
+void MPEGStreamData::HandleAssembledTable(uint pid, const PSIPTable &psip)
+{
     // drop stuffing packets
-    if ((TableID::ST       == psip->TableID()) ||
-        (TableID::STUFFING == psip->TableID()))
+    if ((TableID::ST       == psip.TableID()) ||
+        (TableID::STUFFING == psip.TableID()))
     {
         LOG(VB_RECORD, LOG_DEBUG, "Dropping Stuffing table");
-        DONE_WITH_PSIP_PACKET();
+        return;
     }
 
     // Don't do validation on tables withotu CRC
-    if (!psip->HasCRC())
+    if (!psip.HasCRC())
     {
-        HandleTables(tspacket->PID(), *psip);
-        DONE_WITH_PSIP_PACKET();
+        HandleTables(pid, psip);
+        return;
     }
 
     // Validate PSIP
     // but don't validate PMT/PAT if our driver has the PMT/PAT CRC bug.
     bool buggy = _have_CRC_bug &&
-        ((TableID::PMT == psip->TableID()) ||
-         (TableID::PAT == psip->TableID()));
-    if (!buggy && !psip->IsGood())
+        ((TableID::PMT == psip.TableID()) ||
+         (TableID::PAT == psip.TableID()));
+    if (!buggy && !psip.IsGood())
     {
         LOG(VB_RECORD, LOG_ERR,
             QString("PSIP packet failed CRC check. pid(0x%1) type(0x%2)")
-                .arg(tspacket->PID(),0,16).arg(psip->TableID(),0,16));
-        DONE_WITH_PSIP_PACKET();
+                .arg(pid,0,16).arg(psip.TableID(),0,16));
+        return;
     }
 
-    if (TableID::MGT <= psip->TableID() && psip->TableID() <= TableID::STT &&
-        !psip->IsCurrent())
+    if (TableID::MGT <= psip.TableID() && psip.TableID() <= TableID::STT &&
+        !psip.IsCurrent())
     { // we don't cache the next table, for now
         LOG(VB_RECORD, LOG_DEBUG, QString("Table not current 0x%1")
-            .arg(psip->TableID(),2,16,QChar('0')));
-        DONE_WITH_PSIP_PACKET();
-    }
-
-    if (tspacket->Scrambled())
-    { // scrambled! ATSC, DVB require tables not to be scrambled
-        LOG(VB_RECORD, LOG_ERR,
-            "PSIP packet is scrambled, not ATSC/DVB compiant");
-        DONE_WITH_PSIP_PACKET();
+            .arg(psip.TableID(),2,16,QChar('0')));
+        return;
     }
 
-    if (!psip->VerifyPSIP(!_have_CRC_bug))
+    if (!psip.VerifyPSIP(!_have_CRC_bug))
     {
         LOG(VB_RECORD, LOG_ERR, QString("PSIP table 0x%1 is invalid")
-            .arg(psip->TableID(),2,16,QChar('0')));
-        DONE_WITH_PSIP_PACKET();
+            .arg(psip.TableID(),2,16,QChar('0')));
+        return;
     }
 
     // Don't decode redundant packets,
     // but if it is a desired PAT or PMT emit a "heartbeat" signal.
-    if (IsRedundant(tspacket->PID(), *psip))
+    if (IsRedundant(pid, psip))
     {
-        if (TableID::PAT == psip->TableID())
+        if (TableID::PAT == psip.TableID())
         {
             QMutexLocker locker(&_listener_lock);
             ProgramAssociationTable *pat_sp = PATSingleProgram();
             for (uint i = 0; i < _mpeg_sp_listeners.size(); i++)
                 _mpeg_sp_listeners[i]->HandleSingleProgramPAT(pat_sp);
         }
-        if (TableID::PMT == psip->TableID() &&
-            tspacket->PID() == _pid_pmt_single_program)
+        if (TableID::PMT == psip.TableID() &&
+            pid == _pid_pmt_single_program)
         {
             QMutexLocker locker(&_listener_lock);
             ProgramMapTable *pmt_sp = PMTSingleProgram();
             for (uint i = 0; i < _mpeg_sp_listeners.size(); i++)
                 _mpeg_sp_listeners[i]->HandleSingleProgramPMT(pmt_sp);
         }
-        DONE_WITH_PSIP_PACKET(); // already parsed this table, toss it.
+        return; // already parsed this table, toss it.
     }
 
-    HandleTables(tspacket->PID(), *psip);
-
-    DONE_WITH_PSIP_PACKET();
+    HandleTables(pid, psip);
 }
-#undef DONE_WITH_PSIP_PACKET
 
 int MPEGStreamData::ProcessData(const unsigned char *buffer, int len)
 {
@@ -1042,8 +1058,10 @@ int MPEGStreamData::ProcessData(const unsigned char *buffer, int len)
 bool MPEGStreamData::ProcessTSPacket(const TSPacket& tspacket)
 {
     bool ok = !tspacket.TransportError();
+    const uint pid = tspacket.PID();
+    const uint flags = _pid_flags[pid];
 
-    if (IsEncryptionTestPID(tspacket.PID()))
+    if ((flags & kPIDEncryptionTest) && IsEncryptionTestPID(pid))
     {
         ProcessEncryptedPacket(tspacket);
     }
@@ -1054,7 +1072,7 @@ bool MPEGStreamData::ProcessTSPacket(const TSPacket& tspacket)
     if (tspacket.Scrambled())
         return true;
 
-    if (IsVideoPID(tspacket.PID()))
+    if (IsVideoPID(pid))
     {
         for (uint j = 0; j < _ts_av_listeners.size(); j++)
             _ts_av_listeners[j]->ProcessVideoTSPacket(tspacket);
@@ -1062,7 +1080,7 @@ bool MPEGStreamData::ProcessTSPacket(const TSPacket& tspacket)
         return true;
     }
 
-    if (IsAudioPID(tspacket.PID()))
+    if (flags & kPIDAudio)
     {
         for (uint j = 0; j < _ts_av_listeners.size(); j++)
             _ts_av_listeners[j]->ProcessAudioTSPacket(tspacket);
@@ -1070,13 +1088,14 @@ bool MPEGStreamData::ProcessTSPacket(const TSPacket& tspacket)
         return true;
     }
 
-    if (IsWritingPID(tspacket.PID()))
+    if (flags & kPIDWriting)
     {
         for (uint j = 0; j < _ts_writing_listeners.size(); j++)
             _ts_writing_listeners[j]->ProcessTSPacket(tspacket);
     }
 
-    if (IsListeningPID(tspacket.PID()) && tspacket.HasPayload())
+    if (((flags & (kPIDListening | kPIDNotListening)) == kPIDListening) &&
+        !_listening_disabled && tspacket.HasPayload())
     {
         HandleTSTables(&tspacket);
     }
@@ -1093,41 +1112,52 @@ int MPEGStreamData::ResyncStream(const unsigned char *buffer, int curr_pos,
     if (nextpos >= len)
         return -1; // not enough bytes; caller should try again
 
-    while (buffer[pos] != SYNC_BYTE || buffer[nextpos] != SYNC_BYTE)
+    // Let memchr() find the sync byte candidates, it scans a word or
+    // vector register at a time rather than a byte at a time.
+    const int last = len - TSPacket::kSize;
+    while (pos < last)
     {
+        const unsigned char *sync = (const unsigned char*)
+            memchr(buffer + pos, SYNC_BYTE, last - pos);
+        if (!sync)
+            break;
+
+        pos = sync - buffer;
+        if (buffer[pos + TSPacket::kSize] == SYNC_BYTE)
+            return pos;
         pos++;
-        nextpos++;
-        if (nextpos == len)
-            return -2; // not found
     }
 
-    return pos;
+    return -2; // not found
 }
 
 bool MPEGStreamData::IsListeningPID(uint pid) const
 {
-    if (_listening_disabled || IsNotListeningPID(pid))
+    if (_listening_disabled)
         return false;
-    pid_map_t::const_iterator it = _pids_listening.find(pid);
-    return it != _pids_listening.end();
+    return (GetPIDFlags(pid) & (kPIDListening | kPIDNotListening)) ==
+        kPIDListening;
 }
 
 bool MPEGStreamData::IsNotListeningPID(uint pid) const
 {
-    pid_map_t::const_iterator it = _pids_notlistening.find(pid);
-    return it != _pids_notlistening.end();
+    return GetPIDFlags(pid) & kPIDNotListening;
 }
 
 bool MPEGStreamData::IsWritingPID(uint pid) const
 {
-    pid_map_t::const_iterator it = _pids_writing.find(pid);
-    return it != _pids_writing.end();
+    return GetPIDFlags(pid) & kPIDWriting;
 }
 
 bool MPEGStreamData::IsAudioPID(uint pid) const
 {
-    pid_map_t::const_iterator it = _pids_audio.find(pid);
-    return it != _pids_audio.end();
+    return GetPIDFlags(pid) & kPIDAudio;
+}
+
+void MPEGStreamData::ClearPIDFlags(uint flag)
+{
+    for (uint pid = 0; pid < kPIDTableSize; pid++)
+        _pid_flags[pid] &= ~flag;
 }
 
 uint MPEGStreamData::GetPIDs(pid_map_t &pids) const
@@ -1822,6 +1852,7 @@ void MPEGStreamData::AddEncryptionTestPID(uint pnum, uint pid, bool isvideo)
     AddListeningPID(pid);
 
     _encryption_pid_to_info[pid] = CryptInfo((isvideo) ? 10000 : 500, 8);
+    SetPIDFlag(pid, kPIDEncryptionTest);
 
     _encryption_pid_to_pnums[pid].push_back(pnum);
     _encryption_pnum_to_pids[pnum].push_back(pid);
@@ -1865,6 +1896,7 @@ void MPEGStreamData::RemoveEncryptionTestPIDs(uint pnum)
             {
                 _encryption_pid_to_pnums.remove(pid);
                 _encryption_pid_to_info.remove(pid);
+                ClearPIDFlag(pid, kPIDEncryptionTest);
             }
         }
     }
@@ -1913,6 +1945,7 @@ void MPEGStreamData::ResetDecryptionMonitoringState(void)
     QMutexLocker locker(&_encryption_lock);
 
     _encryption_pid_to_info.clear();
+    ClearPIDFlags(kPIDEncryptionTest);
     _encryption_pid_to_pnums.clear();
     _encryption_pnum_to_pids.clear();
 }
@@ -118,9 +118,11 @@ class MTV_PUBLIC MPEGStreamData : public EITSource
 
     // Table processing
     void SetIgnoreCRC(bool haveCRCbug) { _have_CRC_bug = haveCRCbug; }
+    bool HasCRCBug(void) const { return _have_CRC_bug; }
     virtual bool IsRedundant(uint pid, const PSIPTable&) const;
     virtual bool HandleTables(uint pid, const PSIPTable &psip);
     virtual void HandleTSTables(const TSPacket* tspacket);
+    void HandleAssembledTable(uint pid, const PSIPTable &psip);
     virtual bool ProcessTSPacket(const TSPacket& tspacket);
     virtual int  ProcessData(const unsigned char *buffer, int len);
     inline  void HandleAdaptationFieldControl(const TSPacket* tspacket);
@@ -128,21 +130,25 @@ class MTV_PUBLIC MPEGStreamData : public EITSource
     // Listening
     virtual void AddListeningPID(
         uint pid, PIDPriority priority = kPIDPriorityNormal)
-        { _pids_listening[pid] = priority; }
+        { _pids_listening[pid] = priority; SetPIDFlag(pid, kPIDListening); }
     virtual void AddNotListeningPID(uint pid)
-        { _pids_notlistening[pid] = kPIDPriorityNormal; }
+        { _pids_notlistening[pid] = kPIDPriorityNormal;
+          SetPIDFlag(pid, kPIDNotListening); }
     virtual void AddWritingPID(
         uint pid, PIDPriority priority = kPIDPriorityHigh)
-        { _pids_writing[pid] = priority; }
+        { _pids_writing[pid] = priority; SetPIDFlag(pid, kPIDWriting); }
     virtual void AddAudioPID(
         uint pid, PIDPriority priority = kPIDPriorityHigh)
-        { _pids_audio[pid] = priority; }
+        { _pids_audio[pid] = priority; SetPIDFlag(pid, kPIDAudio); }
 
-    virtual void RemoveListeningPID(uint pid) { _pids_listening.remove(pid);  }
+    virtual void RemoveListeningPID(uint pid)
+        { _pids_listening.remove(pid); ClearPIDFlag(pid, kPIDListening); }
     virtual void RemoveNotListeningPID(uint pid)
-        { _pids_notlistening.remove(pid); }
-    virtual void RemoveWritingPID(uint pid) { _pids_writing.remove(pid);    }
-    virtual void RemoveAudioPID(uint pid)   { _pids_audio.remove(pid);      }
+        { _pids_notlistening.remove(pid); ClearPIDFlag(pid, kPIDNotListening); }
+    virtual void RemoveWritingPID(uint pid)
+        { _pids_writing.remove(pid); ClearPIDFlag(pid, kPIDWriting); }
+    virtual void RemoveAudioPID(uint pid)
+        { _pids_audio.remove(pid); ClearPIDFlag(pid, kPIDAudio); }
 
     virtual bool IsListeningPID(uint pid) const;
     virtual bool IsNotListeningPID(uint pid) const;
@@ -150,6 +156,14 @@ class MTV_PUBLIC MPEGStreamData : public EITSource
     bool IsVideoPID(uint pid) const
         { return _pid_video_single_program == pid; }
     virtual bool IsAudioPID(uint pid) const;
+    /// \brief Returns true if ProcessTSPacket() has any use for this PID
+    bool IsWantedPID(uint pid) const
+        { return GetPIDFlags(pid) || IsVideoPID(pid); }
+    /// \brief Returns true if ProcessTSPacket() only assembles the tables
+    ///        of this PID, so they may be handed in by HandleAssembledTable()
+    bool IsTablesOnlyPID(uint pid) const
+        { return GetPIDFlags(pid) == kPIDListening && !IsVideoPID(pid) &&
+                 !_listening_disabled; }
 
     const pid_map_t& ListeningPIDs(void) const
         { return _pids_listening; }
@@ -341,8 +355,28 @@ class MTV_PUBLIC MPEGStreamData : public EITSource
     void ProcessPMT(const ProgramMapTable *pmt);
     void ProcessEncryptedPacket(const TSPacket&);
 
+  public:
     static int ResyncStream(const unsigned char *buffer, int curr_pos, int len);
 
+  protected:
+
+    /// Bits of _pid_flags, one per PID set a packet may be dispatched to
+    enum
+    {
+        kPIDListening      = 0x01,
+        kPIDNotListening   = 0x02,
+        kPIDWriting        = 0x04,
+        kPIDAudio          = 0x08,
+        kPIDEncryptionTest = 0x10,
+    };
+    void SetPIDFlag(uint pid, uint flag)
+        { if (pid < kPIDTableSize) _pid_flags[pid] |= flag; }
+    void ClearPIDFlag(uint pid, uint flag)
+        { if (pid < kPIDTableSize) _pid_flags[pid] &= ~flag; }
+    void ClearPIDFlags(uint flag);
+    uint GetPIDFlags(uint pid) const
+        { return (pid < kPIDTableSize) ? _pid_flags[pid] : 0; }
+
     void UpdateTimeOffset(uint64_t si_utc_time);
 
     // Caching
@@ -372,6 +406,10 @@ class MTV_PUBLIC MPEGStreamData : public EITSource
     pid_map_t                 _pids_writing;
     pid_map_t                 _pids_audio;
     bool                      _listening_disabled;
+    /// Flat copy of the PID sets above, indexed by PID, so that
+    /// ProcessTSPacket() can dispatch with a single table lookup.
+    static const uint         kPIDTableSize = 0x2000;
+    unsigned char             _pid_flags[kPIDTableSize];
 
     // Encryption monitoring
     mutable QMutex            _encryption_lock;
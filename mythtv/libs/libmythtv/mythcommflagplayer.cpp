@@ -197,3 +197,74 @@ bool MythCommFlagPlayer::RebuildSeekTable(
 
     return true;
 }
+
+/** \brief Demuxes the whole recording, filling \p stats with what the
+ *         bitstream says about each frame, see BitstreamFrameStats.
+ *
+ *  Only every \p keyframeStep'th keyframe is decoded, and nothing at all
+ *  if it is 0, so this is many times faster than decoding every frame.
+ *
+ *  \param stop if set, the scan is abandoned once it becomes true
+ *  \param cb   called now and then with the percentage scanned
+ *  \return false if the file could not be read or the scan was stopped
+ */
+bool MythCommFlagPlayer::ScanBitstream(
+    bitstream_stats_t &stats, uint keyframeStep, const bool *stop,
+    StatusCallback cb, void* cbData)
+{
+    killdecoder = false;
+    framesPlayed = 0;
+
+    stats.clear();
+    if (totalFrames)
+        stats.reserve(totalFrames);
+
+    if (OpenFile() < 0)
+        return false;
+
+    SetPlaying(true);
+
+    if (!InitVideo())
+    {
+        LOG(VB_GENERAL, LOG_ERR,
+            "ScanBitstream unable to initialize video");
+        SetPlaying(false);
+        return false;
+    }
+
+    ClearAfterSeek();
+    decoder->SetBitstreamStats(&stats, keyframeStep);
+
+    MythTimer ui_timer, inuse_timer;
+    ui_timer.start();
+    inuse_timer.start();
+
+    while (!GetEof() && !(stop && *stop))
+    {
+        if (inuse_timer.elapsed() > 2534)
+        {
+            inuse_timer.restart();
+            player_ctx->LockPlayingInfo(__FILE__, __LINE__);
+            if (player_ctx->playingInfo)
+                player_ctx->playingInfo->UpdateInUseMark();
+            player_ctx->UnlockPlayingInfo(__FILE__, __LINE__);
+        }
+
+        if (cb && ui_timer.elapsed() > 98)
+        {
+            ui_timer.restart();
+            int percentage = 0;
+            if (totalFrames)
+                percentage = (int)(stats.size() * 100 / totalFrames);
+            (*cb)((percentage > 100) ? 100 : percentage, cbData);
+        }
+
+        DecoderGetFrame(kDecodeNothing, true);
+    }
+
+    decoder->SetBitstreamStats(NULL, 0);
+    SetPlaying(false);
+    killdecoder = true;
+
+    return !(stop && *stop);
+}
@@ -9,6 +9,9 @@ class MTV_PUBLIC MythCommFlagPlayer : public MythPlayer
     MythCommFlagPlayer(PlayerFlags flags = kNoFlags) : MythPlayer(flags) { }
     bool RebuildSeekTable(bool showPercentage = true, StatusCallback cb = NULL,
                           void* cbData = NULL);
+    bool ScanBitstream(bitstream_stats_t &stats, uint keyframeStep,
+                       const bool *stop = NULL, StatusCallback cb = NULL,
+                       void* cbData = NULL);
 };
 
 #endif // MYTHCOMMFLAGPLAYER_H
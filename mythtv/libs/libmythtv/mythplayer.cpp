@@ -1075,8 +1075,10 @@ void MythPlayer::InitFilters(void)
         postfilt_width = video_dim.width();
         postfilt_height = video_dim.height();
 
+        int threads = videoOutput ? videoOutput->GetFilterThreads() : 1;
         videoFilters = FiltMan->LoadFilters(
-            filters, itmp, otmp, postfilt_width, postfilt_height, btmp);
+            filters, itmp, otmp, postfilt_width, postfilt_height, btmp,
+            threads);
     }
 
     videofiltersLock.unlock();
@@ -1918,9 +1920,13 @@ void MythPlayer::AVSync(VideoFrame *buffer, bool limit_delay)
 
     if (output_jmeter && output_jmeter->RecordCycleTime())
     {
+        uint lock_usecs = 0;
+        uint lock_waits = videoOutput->TakeFrameLockWaits(lock_usecs);
         LOG(VB_PLAYBACK | VB_TIMESTAMP, LOG_INFO, LOC +
-            QString("A/V avsync_delay: %1, avsync_avg: %2")
-                .arg(avsync_delay / 1000).arg(avsync_avg / 1000));
+            QString("A/V avsync_delay: %1, avsync_avg: %2, "
+                    "frame lock waits: %3 (%4 ms)")
+                .arg(avsync_delay / 1000).arg(avsync_avg / 1000)
+                .arg(lock_waits).arg(lock_usecs / 1000));
     }
 
     avsync_adjustment = 0;
@@ -6,8 +6,15 @@
 #include <algorithm>
 using namespace std;
 
+// Qt headers
+#include <QStringList>
+#include <QRunnable>
+
 // MythTV headers
 #include "channelutil.h"
+#include "mythcorecontext.h"
+#include "mthreadpool.h"
+#include "mythtimer.h"
 #include "mythdb.h"
 #include "mythlogging.h"
 #include "programinfo.h"
@@ -29,6 +36,19 @@ static QString denullify(const QString &str)
     return str.isNull() ? "" : str;
 }
 
+/// Adds a copy of an event, without the credits, to an overlap index
+static void add_program(vector<DBEvent> &programs, const DBEvent &event)
+{
+    programs.push_back(DBEvent(event.listingsource));
+    DBEvent &prog = programs.back();
+    prog = event;
+    delete prog.credits;
+    prog.credits = NULL;
+}
+
+/// Maximum number of rows in one InsertBatchDB() statement
+static const uint kMaxInsertRows = 50;
+
 DBPerson::DBPerson(const DBPerson &other) :
     role(other.role), name(other.name)
 {
@@ -240,8 +260,173 @@ uint DBEvent::UpdateDB(
     }
 }
 
+/** \brief Writes a batch of events for one channel to the program table.
+ *
+ *   This has the same effect as calling UpdateDB() for each event in
+ *   turn. But the programs overlapping the whole batch are loaded with a
+ *   single query and then kept up to date in memory, and events that
+ *   don't overlap any program are inserted with multi-row statements.
+ *
+ *  \return number of events written to the database
+ */
+uint DBEvent::UpdateDB(MSqlQuery &query, uint chanid,
+                       const vector<DBEvent*> &events, int match_threshold)
+{
+    if (events.empty())
+        return 0;
+
+    QDateTime start = events[0]->starttime;
+    QDateTime end   = events[0]->endtime;
+    for (uint i = 1; i < events.size(); i++)
+    {
+        start = min(start, events[i]->starttime);
+        end   = max(end,   events[i]->endtime);
+    }
+
+    vector<DBEvent> all;
+    GetOverlappingPrograms(query, chanid, start, end, all);
+
+    vector<const DBEvent*> pending;
+    uint count = 0;
+
+    for (uint i = 0; i < events.size(); i++)
+    {
+        const DBEvent &event = *events[i];
+
+        vector<DBEvent> programs;
+        vector<uint>    indexes;
+        event.GetOverlapping(all, programs, indexes);
+
+        if (programs.empty() && !event.credits)
+        {
+            pending.push_back(&event);
+            add_program(all, event);
+            continue;
+        }
+
+        // Anything below may touch the programs waiting to be inserted
+        uint npending = pending.size();
+        uint inserted = InsertBatchDB(query, chanid, pending, all);
+        count += inserted;
+
+        if (inserted < npending)
+        {
+            // The programs that failed are gone from the index again
+            programs.clear();
+            indexes.clear();
+            event.GetOverlapping(all, programs, indexes);
+        }
+
+        if (programs.empty())
+        {
+            if (event.InsertDB(query, chanid))
+            {
+                count++;
+                add_program(all, event);
+            }
+            continue;
+        }
+
+        int  match = INT_MIN;
+        int  j     = -1;
+        match = event.GetMatch(programs, j);
+
+        if (match >= match_threshold)
+        {
+            LOG(VB_EIT, LOG_DEBUG,
+                QString("EIT: accept match[%1]: %2 '%3' vs. '%4'")
+                    .arg(j).arg(match).arg(event.title)
+                    .arg(programs[j].title));
+        }
+        else
+        {
+            if (j >= 0)
+            {
+                LOG(VB_EIT, LOG_DEBUG,
+                    QString("EIT: reject match[%1]: %2 '%3' vs. '%4'")
+                        .arg(j).arg(match).arg(event.title)
+                        .arg(programs[j].title));
+            }
+            j = -1;
+        }
+
+        uint written = event.UpdateDB(query, chanid, programs, j);
+        count += written;
+
+        if (!written)
+        {
+            // Don't guess what made it to the database before the error
+            all.clear();
+            GetOverlappingPrograms(query, chanid, start, end, all);
+            continue;
+        }
+
+        // Apply the same changes MoveOutOfTheWayDB() and UpdateDB()
+        // made in the database to the programs in memory.
+        vector<uint> deleted;
+        for (uint k = 0; k < programs.size(); k++)
+        {
+            DBEvent &prog = all[indexes[k]];
+            if ((int)k == j)
+            {
+                event.MergeInto(prog);
+            }
+            else if (prog.starttime >= event.starttime &&
+                     prog.endtime   <= event.endtime)
+            {
+                deleted.push_back(indexes[k]);
+            }
+            else if (prog.starttime < event.starttime &&
+                     prog.endtime   > event.starttime)
+            {
+                prog.endtime = event.starttime;
+            }
+            else if (prog.starttime < event.endtime &&
+                     prog.endtime   > event.endtime)
+            {
+                prog.starttime = event.endtime;
+            }
+        }
+
+        sort(deleted.begin(), deleted.end());
+        for (int k = deleted.size() - 1; k >= 0; k--)
+            all.erase(all.begin() + deleted[k]);
+
+        if (j < 0)
+            add_program(all, event);
+    }
+
+    count += InsertBatchDB(query, chanid, pending, all);
+
+    return count;
+}
+
 uint DBEvent::GetOverlappingPrograms(
     MSqlQuery &query, uint chanid, vector<DBEvent> &programs) const
+{
+    return GetOverlappingPrograms(query, chanid, starttime, endtime, programs);
+}
+
+void DBEvent::GetOverlapping(const vector<DBEvent> &all,
+                             vector<DBEvent> &programs,
+                             vector<uint> &indexes) const
+{
+    // Same condition as the query in GetOverlappingPrograms()
+    for (uint i = 0; i < all.size(); i++)
+    {
+        const DBEvent &prog = all[i];
+        if ((prog.starttime >= starttime && prog.starttime <  endtime) ||
+            (prog.endtime   >  starttime && prog.endtime   <= endtime))
+        {
+            programs.push_back(prog);
+            indexes.push_back(i);
+        }
+    }
+}
+
+uint DBEvent::GetOverlappingPrograms(
+    MSqlQuery &query, uint chanid, const QDateTime &starttime,
+    const QDateTime &endtime, vector<DBEvent> &programs)
 {
     uint count = 0;
     query.prepare(
@@ -466,8 +651,11 @@ uint DBEvent::UpdateDB(
     return UpdateDB(q, chanid, p[match]);
 }
 
-uint DBEvent::UpdateDB(
-    MSqlQuery &query, uint chanid, const DBEvent &match) const
+/** \brief Merges this event into \a prog, the program it matched.
+ *
+ *  Afterwards \a prog holds what UpdateDB() writes over the matched row.
+ */
+void DBEvent::MergeInto(DBEvent &prog) const
 {
     QString  ltitle     = title;
     QString  lsubtitle  = subtitle;
@@ -478,53 +666,71 @@ uint DBEvent::UpdateDB(
     QString  lseriesId  = seriesId;
     QDate loriginalairdate = originalairdate;
 
-    if (match.title.length() >= ltitle.length())
-        ltitle = match.title;
+    if (prog.title.length() >= ltitle.length())
+        ltitle = prog.title;
 
-    if (match.subtitle.length() >= lsubtitle.length())
-        lsubtitle = match.subtitle;
+    if (prog.subtitle.length() >= lsubtitle.length())
+        lsubtitle = prog.subtitle;
 
-    if (match.description.length() >= ldesc.length())
-        ldesc = match.description;
+    if (prog.description.length() >= ldesc.length())
+        ldesc = prog.description;
 
-    if (lcategory.isEmpty() && !match.category.isEmpty())
-        lcategory = match.category;
+    if (lcategory.isEmpty() && !prog.category.isEmpty())
+        lcategory = prog.category;
 
-    if (!lairdate && !match.airdate)
-        lairdate = match.airdate;
+    if (!lairdate && !prog.airdate)
+        lairdate = prog.airdate;
 
-    if (!loriginalairdate.isValid() && match.originalairdate.isValid())
-        loriginalairdate = match.originalairdate;
+    if (!loriginalairdate.isValid() && prog.originalairdate.isValid())
+        loriginalairdate = prog.originalairdate;
 
-    if (lprogramId.isEmpty() && !match.programId.isEmpty())
-        lprogramId = match.programId;
+    if (lprogramId.isEmpty() && !prog.programId.isEmpty())
+        lprogramId = prog.programId;
 
-    if (lseriesId.isEmpty() && !match.seriesId.isEmpty())
-        lseriesId = match.seriesId;
+    if (lseriesId.isEmpty() && !prog.seriesId.isEmpty())
+        lseriesId = prog.seriesId;
 
-    uint tmp = categoryType;
-    if (!categoryType && match.categoryType)
-        tmp = match.categoryType;
-
-    QString lcattype = myth_category_type_to_string(tmp);
-
-    unsigned char lsubtype = subtitleType | match.subtitleType;
-    unsigned char laudio   = audioProps   | match.audioProps;
-    unsigned char lvideo   = videoProps   | match.videoProps;
+    unsigned char lcattype = categoryType;
+    if (!categoryType && prog.categoryType)
+        lcattype = prog.categoryType;
 
     uint lpartnumber =
-        (!partnumber && match.partnumber) ? match.partnumber : partnumber;
+        (!partnumber && prog.partnumber) ? prog.partnumber : partnumber;
     uint lparttotal =
-        (!parttotal  && match.parttotal ) ? match.parttotal  : parttotal;
-
-    bool lpreviouslyshown = previouslyshown | match.previouslyshown;
-
-    uint32_t llistingsource = listingsource | match.listingsource;
+        (!parttotal  && prog.parttotal ) ? prog.parttotal  : parttotal;
 
     QString lsyndicatedepisodenumber = syndicatedepisodenumber;
     if (lsyndicatedepisodenumber.isEmpty() &&
-        !match.syndicatedepisodenumber.isEmpty())
-        lsyndicatedepisodenumber = match.syndicatedepisodenumber;
+        !prog.syndicatedepisodenumber.isEmpty())
+        lsyndicatedepisodenumber = prog.syndicatedepisodenumber;
+
+    prog.title           = ltitle;
+    prog.subtitle        = lsubtitle;
+    prog.description     = ldesc;
+    prog.category        = lcategory;
+    prog.categoryType    = lcattype;
+    prog.starttime       = starttime;
+    prog.endtime         = endtime;
+    prog.airdate         = lairdate;
+    prog.originalairdate = loriginalairdate;
+    prog.programId       = lprogramId;
+    prog.seriesId        = lseriesId;
+    prog.subtitleType   |= subtitleType;
+    prog.audioProps     |= audioProps;
+    prog.videoProps     |= videoProps;
+    prog.partnumber      = lpartnumber;
+    prog.parttotal       = lparttotal;
+    prog.syndicatedepisodenumber = lsyndicatedepisodenumber;
+    prog.previouslyshown = prog.previouslyshown || previouslyshown;
+    prog.listingsource  |= listingsource;
+}
+
+uint DBEvent::UpdateDB(
+    MSqlQuery &query, uint chanid, const DBEvent &match) const
+{
+    DBEvent merged(match.listingsource);
+    merged = match;
+    MergeInto(merged);
 
     query.prepare(
         "UPDATE program "
@@ -547,29 +753,36 @@ uint DBEvent::UpdateDB(
 
     query.bindValue(":CHANID",      chanid);
     query.bindValue(":OLDSTART",    match.starttime);
-    query.bindValue(":TITLE",       denullify(ltitle));
-    query.bindValue(":SUBTITLE",    denullify(lsubtitle));
-    query.bindValue(":DESC",        denullify(ldesc));
-    query.bindValue(":CATEGORY",    denullify(lcategory));
-    query.bindValue(":CATTYPE",     lcattype);
-    query.bindValue(":STARTTIME",   starttime);
-    query.bindValue(":ENDTIME",     endtime);
-    query.bindValue(":CC",          lsubtype & SUB_HARDHEAR ? true : false);
-    query.bindValue(":HASSUBTITLES",lsubtype & SUB_NORMAL   ? true : false);
-    query.bindValue(":STEREO",      laudio   & AUD_STEREO   ? true : false);
-    query.bindValue(":HDTV",        lvideo   & VID_HDTV     ? true : false);
-    query.bindValue(":SUBTYPE",     lsubtype);
-    query.bindValue(":AUDIOPROP",   laudio);
-    query.bindValue(":VIDEOPROP",   lvideo);
-    query.bindValue(":PARTNO",      lpartnumber);
-    query.bindValue(":PARTTOTAL",   lparttotal);
-    query.bindValue(":SYNDICATENO", denullify(lsyndicatedepisodenumber));
-    query.bindValue(":AIRDATE",     lairdate?QString::number(lairdate):"0000");
-    query.bindValue(":ORIGAIRDATE", loriginalairdate);
-    query.bindValue(":LSOURCE",     llistingsource);
-    query.bindValue(":SERIESID",    denullify(lseriesId));
-    query.bindValue(":PROGRAMID",   denullify(lprogramId));
-    query.bindValue(":PREVSHOWN",   lpreviouslyshown);
+    query.bindValue(":TITLE",       denullify(merged.title));
+    query.bindValue(":SUBTITLE",    denullify(merged.subtitle));
+    query.bindValue(":DESC",        denullify(merged.description));
+    query.bindValue(":CATEGORY",    denullify(merged.category));
+    query.bindValue(":CATTYPE",
+                    myth_category_type_to_string(merged.categoryType));
+    query.bindValue(":STARTTIME",   merged.starttime);
+    query.bindValue(":ENDTIME",     merged.endtime);
+    query.bindValue(":CC",
+                    merged.subtitleType & SUB_HARDHEAR ? true : false);
+    query.bindValue(":HASSUBTITLES",
+                    merged.subtitleType & SUB_NORMAL   ? true : false);
+    query.bindValue(":STEREO",
+                    merged.audioProps   & AUD_STEREO   ? true : false);
+    query.bindValue(":HDTV",
+                    merged.videoProps   & VID_HDTV     ? true : false);
+    query.bindValue(":SUBTYPE",     merged.subtitleType);
+    query.bindValue(":AUDIOPROP",   merged.audioProps);
+    query.bindValue(":VIDEOPROP",   merged.videoProps);
+    query.bindValue(":PARTNO",      merged.partnumber);
+    query.bindValue(":PARTTOTAL",   merged.parttotal);
+    query.bindValue(":SYNDICATENO",
+                    denullify(merged.syndicatedepisodenumber));
+    query.bindValue(":AIRDATE",     merged.airdate ?
+                    QString::number(merged.airdate) : "0000");
+    query.bindValue(":ORIGAIRDATE", merged.originalairdate);
+    query.bindValue(":LSOURCE",     merged.listingsource);
+    query.bindValue(":SERIESID",    denullify(merged.seriesId));
+    query.bindValue(":PROGRAMID",   denullify(merged.programId));
+    query.bindValue(":PREVSHOWN",   merged.previouslyshown);
 
     if (!query.exec())
     {
@@ -683,9 +896,7 @@ bool DBEvent::MoveOutOfTheWayDB(
     return true;
 }
 
-uint DBEvent::InsertDB(MSqlQuery &query, uint chanid) const
-{
-    query.prepare(
+static const char *kInsertColumns =
         "REPLACE INTO program ("
         "  chanid,         title,          subtitle,        description, "
         "  category,       category_type, "
@@ -696,44 +907,114 @@ uint DBEvent::InsertDB(MSqlQuery &query, uint chanid) const
         "  syndicatedepisodenumber, "
         "  airdate,        originalairdate,listingsource, "
         "  seriesid,       programid,      previouslyshown ) "
-        "VALUES ("
-        " :CHANID,        :TITLE,         :SUBTITLE,       :DESCRIPTION, "
-        " :CATEGORY,      :CATTYPE, "
-        " :STARTTIME,     :ENDTIME, "
-        " :CC,            :STEREO,        :HDTV,           :HASSUBTITLES, "
-        " :SUBTYPES,      :AUDIOPROP,     :VIDEOPROP, "
-        " :STARS,         :PARTNUMBER,    :PARTTOTAL, "
-        " :SYNDICATENO, "
-        " :AIRDATE,       :ORIGAIRDATE,   :LSOURCE, "
-        " :SERIESID,      :PROGRAMID,     :PREVSHOWN) ");
-
+        "VALUES ";
+
+/// One row of kInsertColumns, %1 is replaced by the row's suffix
+static const char *kInsertValues =
+        "("
+        " :CHANID%1,      :TITLE%1,       :SUBTITLE%1,     :DESCRIPTION%1, "
+        " :CATEGORY%1,    :CATTYPE%1, "
+        " :STARTTIME%1,   :ENDTIME%1, "
+        " :CC%1,          :STEREO%1,      :HDTV%1,         :HASSUBTITLES%1, "
+        " :SUBTYPES%1,    :AUDIOPROP%1,   :VIDEOPROP%1, "
+        " :STARS%1,       :PARTNUMBER%1,  :PARTTOTAL%1, "
+        " :SYNDICATENO%1, "
+        " :AIRDATE%1,     :ORIGAIRDATE%1, :LSOURCE%1, "
+        " :SERIESID%1,    :PROGRAMID%1,   :PREVSHOWN%1) ";
+
+void DBEvent::BindInsertValues(
+    MSqlQuery &query, uint chanid, const QString &sfx) const
+{
     QString cattype = myth_category_type_to_string(categoryType);
-    QString empty("");
-    query.bindValue(":CHANID",      chanid);
-    query.bindValue(":TITLE",       denullify(title));
-    query.bindValue(":SUBTITLE",    denullify(subtitle));
-    query.bindValue(":DESCRIPTION", denullify(description));
-    query.bindValue(":CATEGORY",    denullify(category));
-    query.bindValue(":CATTYPE",     cattype);
-    query.bindValue(":STARTTIME",   starttime);
-    query.bindValue(":ENDTIME",     endtime);
-    query.bindValue(":CC",          subtitleType & SUB_HARDHEAR ? true : false);
-    query.bindValue(":STEREO",      audioProps   & AUD_STEREO   ? true : false);
-    query.bindValue(":HDTV",        videoProps   & VID_HDTV     ? true : false);
-    query.bindValue(":HASSUBTITLES",subtitleType & SUB_NORMAL   ? true : false);
-    query.bindValue(":SUBTYPES",    subtitleType);
-    query.bindValue(":AUDIOPROP",   audioProps);
-    query.bindValue(":VIDEOPROP",   videoProps);
-    query.bindValue(":STARS",       stars);
-    query.bindValue(":PARTNUMBER",  partnumber);
-    query.bindValue(":PARTTOTAL",   parttotal);
-    query.bindValue(":SYNDICATENO", denullify(syndicatedepisodenumber));
-    query.bindValue(":AIRDATE",     airdate ? QString::number(airdate):"0000");
-    query.bindValue(":ORIGAIRDATE", originalairdate);
-    query.bindValue(":LSOURCE",     listingsource);
-    query.bindValue(":SERIESID",    denullify(seriesId));
-    query.bindValue(":PROGRAMID",   denullify(programId));
-    query.bindValue(":PREVSHOWN",   previouslyshown);
+    query.bindValue(":CHANID"+sfx,      chanid);
+    query.bindValue(":TITLE"+sfx,       denullify(title));
+    query.bindValue(":SUBTITLE"+sfx,    denullify(subtitle));
+    query.bindValue(":DESCRIPTION"+sfx, denullify(description));
+    query.bindValue(":CATEGORY"+sfx,    denullify(category));
+    query.bindValue(":CATTYPE"+sfx,     cattype);
+    query.bindValue(":STARTTIME"+sfx,   starttime);
+    query.bindValue(":ENDTIME"+sfx,     endtime);
+    query.bindValue(":CC"+sfx,
+                    subtitleType & SUB_HARDHEAR ? true : false);
+    query.bindValue(":STEREO"+sfx,
+                    audioProps   & AUD_STEREO   ? true : false);
+    query.bindValue(":HDTV"+sfx,
+                    videoProps   & VID_HDTV     ? true : false);
+    query.bindValue(":HASSUBTITLES"+sfx,
+                    subtitleType & SUB_NORMAL   ? true : false);
+    query.bindValue(":SUBTYPES"+sfx,    subtitleType);
+    query.bindValue(":AUDIOPROP"+sfx,   audioProps);
+    query.bindValue(":VIDEOPROP"+sfx,   videoProps);
+    query.bindValue(":STARS"+sfx,       stars);
+    query.bindValue(":PARTNUMBER"+sfx,  partnumber);
+    query.bindValue(":PARTTOTAL"+sfx,   parttotal);
+    query.bindValue(":SYNDICATENO"+sfx, denullify(syndicatedepisodenumber));
+    query.bindValue(":AIRDATE"+sfx,
+                    airdate ? QString::number(airdate) : "0000");
+    query.bindValue(":ORIGAIRDATE"+sfx, originalairdate);
+    query.bindValue(":LSOURCE"+sfx,     listingsource);
+    query.bindValue(":SERIESID"+sfx,    denullify(seriesId));
+    query.bindValue(":PROGRAMID"+sfx,   denullify(programId));
+    query.bindValue(":PREVSHOWN"+sfx,   previouslyshown);
+}
+
+/** \brief Inserts events that have no credits with multi-row statements.
+ *
+ *   Copies of the events are the last programs of the overlap index all,
+ *   the ones that could not be inserted are removed from it again. The
+ *   list of events is cleared afterwards.
+ *  \return number of events inserted
+ */
+uint DBEvent::InsertBatchDB(
+    MSqlQuery &query, uint chanid, vector<const DBEvent*> &events,
+    vector<DBEvent> &all)
+{
+    uint count = 0;
+    uint base  = all.size() - events.size();
+    vector<uint> failed;
+
+    for (uint first = 0; first < events.size(); first += kMaxInsertRows)
+    {
+        uint last = min(first + kMaxInsertRows, (uint)events.size());
+
+        QString sql = kInsertColumns;
+        for (uint i = first; i < last; i++)
+        {
+            if (i > first)
+                sql += ",";
+            sql += QString(kInsertValues).arg(i - first);
+        }
+
+        query.prepare(sql);
+        for (uint i = first; i < last; i++)
+            events[i]->BindInsertValues(
+                query, chanid, QString::number(i - first));
+
+        if (!query.exec())
+        {
+            MythDB::DBError("InsertBatchDB", query);
+            failed.push_back(first);
+            continue;
+        }
+
+        count += last - first;
+    }
+
+    for (int k = failed.size() - 1; k >= 0; k--)
+    {
+        uint last = min(failed[k] + kMaxInsertRows, (uint)events.size());
+        all.erase(all.begin() + base + failed[k], all.begin() + base + last);
+    }
+
+    events.clear();
+
+    return count;
+}
+
+uint DBEvent::InsertDB(MSqlQuery &query, uint chanid) const
+{
+    query.prepare(QString(kInsertColumns) + QString(kInsertValues).arg(""));
+    BindInsertValues(query, chanid, "");
 
     if (!query.exec())
     {
@@ -1051,26 +1332,61 @@ void ProgramData::FixProgramList(QList<ProgInfo*> &fixlist)
     }
 }
 
-void ProgramData::HandlePrograms(
-    uint sourceid, QMap<QString, QList<ProgInfo> > &proglist)
+/** \brief Imports the listings of a share of the channels passed to
+ *         ProgramData::HandlePrograms() over its own DB connection.
+ *
+ *  The time spent in each phase is accumulated so the caller can report
+ *  where a listings refresh spends its time.
+ */
+class ProgramImportTask : public QRunnable
 {
-    uint unchanged = 0, updated = 0;
+  public:
+    explicit ProgramImportTask(uint sourceid) :
+        unchanged(0), updated(0), channels(0),
+        lookupTime(0), fixupTime(0), updateTime(0),
+        m_sourceid(sourceid)
+    {
+        setAutoDelete(false);
+    }
 
+    void AddChannel(const QString &xmltvid, QList<ProgInfo> *list)
+    {
+        m_xmltvids.push_back(xmltvid);
+        m_lists.push_back(list);
+    }
+
+    void run(void);
+
+  public:
+    uint     unchanged;
+    uint     updated;
+    uint     channels;
+    uint64_t lookupTime; ///< ms spent looking up chanids
+    uint64_t fixupTime;  ///< ms spent in ProgramData::FixProgramList()
+    uint64_t updateTime; ///< ms spent comparing and writing programs
+
+  private:
+    uint                     m_sourceid;
+    QStringList              m_xmltvids;
+    QList<QList<ProgInfo>*>  m_lists;
+};
+
+void ProgramImportTask::run(void)
+{
     MSqlQuery query(MSqlQuery::InitCon());
+    MythTimer t;
 
-    QMap<QString, QList<ProgInfo> >::const_iterator mapiter;
-    for (mapiter = proglist.begin(); mapiter != proglist.end(); ++mapiter)
+    for (int i = 0; i < m_xmltvids.size(); ++i)
     {
-        if (mapiter.key().isEmpty())
-            continue;
+        t.start();
 
         query.prepare(
             "SELECT chanid "
             "FROM channel "
             "WHERE sourceid = :ID AND "
             "      xmltvid  = :XMLTVID");
-        query.bindValue(":ID",      sourceid);
-        query.bindValue(":XMLTVID", mapiter.key());
+        query.bindValue(":ID",      m_sourceid);
+        query.bindValue(":XMLTVID", m_xmltvids[i]);
 
         if (!query.exec())
         {
@@ -1082,31 +1398,104 @@ void ProgramData::HandlePrograms(
         while (query.next())
             chanids.push_back(query.value(0).toUInt());
 
+        lookupTime += t.restart();
+
         if (chanids.empty())
         {
             LOG(VB_GENERAL, LOG_NOTICE,
                 QString("Unknown xmltv channel identifier: %1"
-                        " - Skipping channel.").arg(mapiter.key()));
+                        " - Skipping channel.").arg(m_xmltvids[i]));
             continue;
         }
 
-        QList<ProgInfo> &list = proglist[mapiter.key()];
+        QList<ProgInfo> &list = *m_lists[i];
         QList<ProgInfo*> sortlist;
         QList<ProgInfo>::iterator it = list.begin();
         for (; it != list.end(); ++it)
             sortlist.push_back(&(*it));
 
-        FixProgramList(sortlist);
+        ProgramData::FixProgramList(sortlist);
+
+        fixupTime += t.restart();
 
-        for (uint i = 0; i < chanids.size(); ++i)
+        for (uint j = 0; j < chanids.size(); ++j)
         {
-            HandlePrograms(query, chanids[i], sortlist, unchanged, updated);
+            ProgramData::HandlePrograms(
+                query, chanids[j], sortlist, unchanged, updated);
         }
+
+        updateTime += t.elapsed();
+        channels++;
+    }
+}
+
+/** \brief Inserts the listings in proglist into the program table.
+ *
+ *  When the "MythFillImportThreads" setting is greater than one the
+ *  channels are shared out between that many threads, each with its own
+ *  DB connection. Otherwise they are handled one after the other in the
+ *  calling thread.
+ */
+void ProgramData::HandlePrograms(
+    uint sourceid, QMap<QString, QList<ProgInfo> > &proglist)
+{
+    MythTimer totalTimer;
+    totalTimer.start();
+
+    int threads = gCoreContext->GetNumSetting("MythFillImportThreads", 1);
+    threads = min(threads, proglist.size());
+    threads = max(threads, 1);
+
+    vector<ProgramImportTask*> tasks;
+    for (int i = 0; i < threads; ++i)
+        tasks.push_back(new ProgramImportTask(sourceid));
+
+    // The lists are handed out from this thread so that any copy on
+    // write detach of the map happens before the workers start.
+    uint next = 0;
+    QMap<QString, QList<ProgInfo> >::iterator mapiter;
+    for (mapiter = proglist.begin(); mapiter != proglist.end(); ++mapiter)
+    {
+        if (mapiter.key().isEmpty())
+            continue;
+        tasks[next++ % threads]->AddChannel(mapiter.key(), &(*mapiter));
+    }
+
+    if (threads == 1)
+    {
+        tasks[0]->run();
+    }
+    else
+    {
+        MThreadPool pool("ProgramData");
+        pool.setMaxThreadCount(threads);
+        for (int i = 0; i < threads; ++i)
+            pool.start(tasks[i], QString("ProgramImport%1").arg(i));
+        pool.waitForDone();
+    }
+
+    uint unchanged = 0, updated = 0, channels = 0;
+    uint64_t lookupTime = 0, fixupTime = 0, updateTime = 0;
+    for (int i = 0; i < threads; ++i)
+    {
+        unchanged  += tasks[i]->unchanged;
+        updated    += tasks[i]->updated;
+        channels   += tasks[i]->channels;
+        lookupTime += tasks[i]->lookupTime;
+        fixupTime  += tasks[i]->fixupTime;
+        updateTime += tasks[i]->updateTime;
+        delete tasks[i];
     }
 
     LOG(VB_GENERAL, LOG_INFO,
         QString("Updated programs: %1 Unchanged programs: %2")
                 .arg(updated) .arg(unchanged));
+    LOG(VB_GENERAL, LOG_INFO,
+        QString("Imported %1 channels with %2 thread(s) in %3 ms "
+                "(summed over threads: channel lookup %4 ms, "
+                "fixup %5 ms, program update %6 ms)")
+            .arg(channels).arg(threads).arg(totalTimer.elapsed())
+            .arg(lookupTime).arg(fixupTime).arg(updateTime));
 }
 
 void ProgramData::HandlePrograms(MSqlQuery             &query,
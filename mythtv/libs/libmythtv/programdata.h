@@ -126,6 +126,8 @@ class MTV_PUBLIC DBEvent
     void AddPerson(const QString &role, const QString &name);
 
     uint UpdateDB(MSqlQuery &query, uint chanid, int match_threshold) const;
+    static uint UpdateDB(MSqlQuery &query, uint chanid,
+                         const vector<DBEvent*> &events, int match_threshold);
 
     bool HasCredits(void) const { return credits; }
     bool HasTimeConflict(const DBEvent &other) const;
@@ -135,15 +137,27 @@ class MTV_PUBLIC DBEvent
   protected:
     uint GetOverlappingPrograms(
         MSqlQuery&, uint chanid, vector<DBEvent> &programs) const;
+    static uint GetOverlappingPrograms(
+        MSqlQuery&, uint chanid, const QDateTime &start,
+        const QDateTime &end, vector<DBEvent> &programs);
+    void GetOverlapping(
+        const vector<DBEvent> &all, vector<DBEvent> &programs,
+        vector<uint> &indexes) const;
     int  GetMatch(
         const vector<DBEvent> &programs, int &bestmatch) const;
     uint UpdateDB(
         MSqlQuery&, uint chanid, const vector<DBEvent> &p, int match) const;
     uint UpdateDB(
         MSqlQuery&, uint chanid, const DBEvent &match) const;
+    void MergeInto(DBEvent &prog) const;
     bool MoveOutOfTheWayDB(
         MSqlQuery&, uint chanid, const DBEvent &nonmatch) const;
     virtual uint InsertDB(MSqlQuery&, uint chanid) const;
+    static uint InsertBatchDB(
+        MSqlQuery&, uint chanid, vector<const DBEvent*> &events,
+        vector<DBEvent> &all);
+    void BindInsertValues(
+        MSqlQuery&, uint chanid, const QString &suffix) const;
     virtual void Squeeze(void);
 
   public:
@@ -255,6 +269,8 @@ class MTV_PUBLIC ProgInfo : public DBEvent
 
 class MTV_PUBLIC ProgramData
 {
+    friend class ProgramImportTask;
+
   public:
     static void HandlePrograms(uint sourceid,
                                QMap<QString, QList<ProgInfo> > &proglist);
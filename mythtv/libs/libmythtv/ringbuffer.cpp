@@ -1566,6 +1566,17 @@ void RingBuffer::SetOldFile(bool is_old)
     rwlock.unlock();
 }
 
+/** \brief Returns true if this file is not expected to grow any further.
+ *  \sa SetOldFile(bool)
+ */
+bool RingBuffer::IsOldFile(void) const
+{
+    rwlock.lockForRead();
+    bool tmp = oldfile;
+    rwlock.unlock();
+    return tmp;
+}
+
 /// Returns name of file used by this RingBuffer
 QString RingBuffer::GetFilename(void) const
 {
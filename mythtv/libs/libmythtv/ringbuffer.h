@@ -66,6 +66,7 @@ class MTV_PUBLIC RingBuffer : protected MThread
     QString   GetSafeFilename(void) { return safefilename; }
     QString   GetFilename(void)      const;
     QString   GetSubtitleFilename(void) const;
+    bool      IsOldFile(void)        const;
     /// Returns value of stopreads
     /// \sa StartReads(void), StopReads(void)
     bool      GetStopReads(void)     const { return stopreads; }
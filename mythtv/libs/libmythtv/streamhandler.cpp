@@ -20,7 +20,9 @@ StreamHandler::StreamHandler(const QString &device) :
     _pid_lock(QMutex::Recursive),
     _open_pid_filters(0),
 
-    _listener_lock(QMutex::Recursive)
+    _listener_lock(QMutex::Recursive),
+
+    _shared_sections_used(false)
 {
 }
 
@@ -367,3 +369,126 @@ PIDPriority StreamHandler::GetPIDPriority(uint pid) const
 
     return tmp;
 }
+
+/// \brief Returns true for the SI PIDs every listener receives
+static bool is_shared_section_pid(uint pid)
+{
+    return pid == MPEG_PAT_PID || pid == DVB_NIT_PID ||
+           pid == DVB_SDT_PID  || pid == DVB_EIT_PID;
+}
+
+/** \brief Delivers a buffer of TS data to all listeners.
+ *
+ *   With a single listener the buffer is simply handed to its
+ *   MPEGStreamData::ProcessData(). When several recorders share the
+ *   multiplex the buffer is synced and split into packets only once,
+ *   and each listener is then handed just the packets of the PIDs it
+ *   actually uses, instead of every listener resyncing and looking up
+ *   every packet of the whole multiplex.
+ *
+ *   The PAT, NIT, SDT and EIT sections are also assembled and CRC checked
+ *   only once, and the complete tables are handed to every listener that
+ *   does nothing but parse tables from that PID. The version tracking
+ *   and caching of the tables stays with each listener. PMTs and PES
+ *   data are on PIDs of the individual programs and are still handled by
+ *   the listeners themselves.
+ *
+ *  \note Must be called with _listener_lock held.
+ *  \return number of bytes at the end of the buffer that were not
+ *          processed and should be passed in again with the next read.
+ */
+int StreamHandler::ProcessData(const unsigned char *buffer, int len)
+{
+    if (_stream_data_list.size() == 1)
+    {
+        _shared_sections_used = false;
+        return _stream_data_list.begin().key()->ProcessData(buffer, len);
+    }
+
+    // Sections in progress are stale after the single listener period
+    if (!_shared_sections_used)
+    {
+        _shared_sections.Reset(-1);
+        _shared_sections_used = true;
+    }
+
+    _demux_offsets.clear();
+    _demux_pids.clear();
+
+    int pos = 0;
+    int remainder = 0;
+    while (true)
+    {
+        if (pos + int(TSPacket::kSize) > len)
+        {
+            remainder = len - pos;
+            break;
+        }
+
+        if (buffer[pos] != SYNC_BYTE)
+        {
+            int newpos = MPEGStreamData::ResyncStream(buffer, pos+1, len);
+            if (newpos == -1)
+            {
+                remainder = len - pos;
+                break;
+            }
+            if (newpos == -2)
+            {
+                remainder = TSPacket::kSize;
+                break;
+            }
+            pos = newpos;
+        }
+
+        const TSPacket *pkt = reinterpret_cast<const TSPacket*>(&buffer[pos]);
+        _demux_offsets.push_back(pos);
+        _demux_pids.push_back(pkt->PID());
+        pos += TSPacket::kSize;
+    }
+
+    // Only drop PAT/PMT sections with a bad CRC if no listener's driver
+    // has the CRC bug, each listener still checks for itself.
+    bool crc_bug = false;
+    StreamDataList::const_iterator it = _stream_data_list.begin();
+    for (; it != _stream_data_list.end(); ++it)
+        crc_bug |= it.key()->HasCRCBug();
+    _shared_sections.SetIgnoreCRC(crc_bug);
+
+    const uint count = _demux_offsets.size();
+    for (uint i = 0; i < count; i++)
+    {
+        const TSPacket &pkt =
+            *reinterpret_cast<const TSPacket*>(&buffer[_demux_offsets[i]]);
+        const uint pid = _demux_pids[i];
+        const bool shared = is_shared_section_pid(pid) &&
+            !pkt.TransportError() && !pkt.Scrambled() && pkt.HasPayload();
+
+        _shared_listeners.clear();
+        for (it = _stream_data_list.begin();
+             it != _stream_data_list.end(); ++it)
+        {
+            MPEGStreamData *sd = it.key();
+            if (shared && sd->IsTablesOnlyPID(pid))
+                _shared_listeners.push_back(sd);
+            else if (sd->IsWantedPID(pid))
+                sd->ProcessTSPacket(pkt);
+        }
+
+        if (_shared_listeners.empty())
+            continue;
+
+        bool more = true;
+        while (more)
+        {
+            PSIPTable *psip = _shared_sections.Assemble(&pkt, more);
+            if (!psip)
+                break;
+            for (uint j = 0; j < _shared_listeners.size(); j++)
+                _shared_listeners[j]->HandleAssembledTable(pid, *psip);
+            delete psip;
+        }
+    }
+
+    return remainder;
+}
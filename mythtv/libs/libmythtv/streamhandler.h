@@ -44,6 +44,18 @@ class PIDInfo
 // iterator returning these in order of ascending pid number.
 typedef QMap<uint,PIDInfo*> PIDInfoMap;
 
+/** \brief Assembles the sections of the SI PIDs every listener of a
+ *         StreamHandler receives, once for all of them.
+ */
+class SharedSectionAssembler : public MPEGStreamData
+{
+  public:
+    SharedSectionAssembler() : MPEGStreamData(-1, false) { }
+
+    PSIPTable *Assemble(const TSPacket *tspacket, bool &moreTablePackets)
+        { return AssemblePSIP(tspacket, moreTablePackets); }
+};
+
 // locking order
 // _pid_lock -> _listener_lock
 // _add_rm_lock -> _listener_lock
@@ -81,6 +93,8 @@ class StreamHandler : protected MThread, public DeviceReaderCB
 
     PIDPriority GetPIDPriority(uint pid) const;
 
+    int ProcessData(const unsigned char *buffer, int len);
+
     // DeviceReaderCB
     virtual void ReaderPaused(int fd) { (void) fd; }
     virtual void PriorityEvent(int fd) { (void) fd; }
@@ -122,6 +136,13 @@ class StreamHandler : protected MThread, public DeviceReaderCB
     typedef QMap<MPEGStreamData*,QString> StreamDataList;
     mutable QMutex    _listener_lock;
     StreamDataList    _stream_data_list;
+
+    // Shared demux state, see ProcessData()
+    vector<uint>      _demux_offsets;
+    vector<uint>      _demux_pids;
+    SharedSectionAssembler   _shared_sections;
+    bool                     _shared_sections_used;
+    vector<MPEGStreamData*>  _shared_listeners;
 };
 
 #endif // _STREAM_HANDLER_H_
@@ -2,6 +2,7 @@
 // based on earlier work in MythTV's videout_xvmc.cpp
 
 #include <unistd.h>
+#include <sys/time.h>
 
 #include "mythconfig.h"
 
@@ -20,6 +21,22 @@ extern "C" {
 
 int next_dbg_str = 0;
 
+/// Index of a single queue in VideoBuffers::queue_count, -1 for a mix
+static int queue_index(BufferType type)
+{
+    switch (type)
+    {
+        case kVideoBuffer_avail:     return 0;
+        case kVideoBuffer_limbo:     return 1;
+        case kVideoBuffer_used:      return 2;
+        case kVideoBuffer_pause:     return 3;
+        case kVideoBuffer_displayed: return 4;
+        case kVideoBuffer_finished:  return 5;
+        case kVideoBuffer_decode:    return 6;
+        default:                     return -1;
+    }
+}
+
 YUVInfo::YUVInfo(uint w, uint h, uint sz, const int *p, const int *o)
     : width(w), height(h), size(sz)
 {
@@ -115,6 +132,13 @@ YUVInfo::YUVInfo(uint w, uint h, uint sz, const int *p, const int *o)
  *        decoder (in the decode queue) then it is placed in the finished queue
  *        until the decoder is no longer using it (not in the decode queue).
  *
+ *  Every change to the queues is made with global_lock held. Once the
+ *  outermost public call making changes is done they are published to
+ *  atomic per frame and per queue state. size() and contains() read that
+ *  state without taking the lock, so the display and decoder threads
+ *  polling for free or decoded frames do not contend with each other's
+ *  queue changes.
+ *
  * \see VideoOutput
  */
 
@@ -122,7 +146,7 @@ VideoBuffers::VideoBuffers()
     : needfreeframes(0), needprebufferframes(0),
       needprebufferframes_normal(0), needprebufferframes_small(0),
       keepprebufferframes(0), createdpauseframe(false), rpos(0), vpos(0),
-      global_lock(QMutex::Recursive)
+      global_lock(QMutex::Recursive), change_depth(0), state_changed(false)
 {
 }
 
@@ -156,7 +180,7 @@ void VideoBuffers::Init(uint numdecode, bool extra_for_pause,
                         uint need_free, uint needprebuffer_normal,
                         uint needprebuffer_small, uint keepprebuffer)
 {
-    QMutexLocker locker(&global_lock);
+    BeginChange();
 
     Reset();
 
@@ -188,6 +212,8 @@ void VideoBuffers::Init(uint numdecode, bool extra_for_pause,
 
     for (uint i = 0; i < numdecode; i++)
         enqueue(kVideoBuffer_avail, at(i));
+
+    EndChange();
 }
 
 /**
@@ -196,7 +222,7 @@ void VideoBuffers::Init(uint numdecode, bool extra_for_pause,
  */
 void VideoBuffers::Reset()
 {
-    QMutexLocker locker(&global_lock);
+    BeginChange();
 
     // Delete ffmpeg VideoFrames so we can create
     // a different number of buffers below
@@ -218,6 +244,9 @@ void VideoBuffers::Reset()
     pause.clear();
     displayed.clear();
     vbufferMap.clear();
+    state_changed = true;
+
+    EndChange();
 }
 
 /**
@@ -233,7 +262,7 @@ void VideoBuffers::SetPrebuffering(bool normal)
 
 VideoFrame *VideoBuffers::GetNextFreeFrameInternal(BufferType enqueue_to)
 {
-    QMutexLocker locker(&global_lock);
+    BeginChange(true);
     VideoFrame *frame = NULL;
 
     // Try to get a frame not being used by the decoder
@@ -257,6 +286,9 @@ VideoFrame *VideoBuffers::GetNextFreeFrameInternal(BufferType enqueue_to)
     if (frame)
         safeEnqueue(enqueue_to, frame);
 
+    state_changed = true;
+    EndChange();
+
     return frame;
 }
 
@@ -305,12 +337,15 @@ VideoFrame *VideoBuffers::GetNextFreeFrame(BufferType enqueue_to)
  */
 void VideoBuffers::ReleaseFrame(VideoFrame *frame)
 {
-    QMutexLocker locker(&global_lock);
+    BeginChange(true);
 
     vpos = vbufferMap[frame];
     limbo.remove(frame);
     decode.enqueue(frame);
     used.enqueue(frame);
+    state_changed = true;
+
+    EndChange();
 }
 
 /**
@@ -320,7 +355,7 @@ void VideoBuffers::ReleaseFrame(VideoFrame *frame)
  */
 void VideoBuffers::DeLimboFrame(VideoFrame *frame)
 {
-    QMutexLocker locker(&global_lock);
+    BeginChange(true);
     if (limbo.contains(frame))
         limbo.remove(frame);
 
@@ -332,6 +367,9 @@ void VideoBuffers::DeLimboFrame(VideoFrame *frame)
     // remove from decode queue since the decoder is finished
     while (decode.contains(frame))
         decode.remove(frame);
+    state_changed = true;
+
+    EndChange();
 }
 
 /**
@@ -340,8 +378,9 @@ void VideoBuffers::DeLimboFrame(VideoFrame *frame)
  */
 void VideoBuffers::StartDisplayingFrame(void)
 {
-    QMutexLocker locker(&global_lock);
+    LockCounted();
     rpos = vbufferMap[used.head()];
+    global_lock.unlock();
 }
 
 /**
@@ -350,7 +389,7 @@ void VideoBuffers::StartDisplayingFrame(void)
  */
 void VideoBuffers::DoneDisplayingFrame(VideoFrame *frame)
 {
-    QMutexLocker locker(&global_lock);
+    BeginChange(true);
 
     if(used.contains(frame))
         remove(kVideoBuffer_used, frame);
@@ -368,6 +407,8 @@ void VideoBuffers::DoneDisplayingFrame(VideoFrame *frame)
             enqueue(kVideoBuffer_avail, *it);
         }
     }
+
+    EndChange();
 }
 
 /**
@@ -377,8 +418,9 @@ void VideoBuffers::DoneDisplayingFrame(VideoFrame *frame)
  */
 void VideoBuffers::DiscardFrame(VideoFrame *frame)
 {
-    QMutexLocker locker(&global_lock);
+    BeginChange(true);
     safeEnqueue(kVideoBuffer_avail, frame);
+    EndChange();
 }
 
 frame_queue_t *VideoBuffers::queue(BufferType type)
@@ -431,14 +473,18 @@ const frame_queue_t *VideoBuffers::queue(BufferType type) const
 
 VideoFrame *VideoBuffers::dequeue(BufferType type)
 {
-    QMutexLocker locker(&global_lock);
+    BeginChange();
 
+    VideoFrame *frame = NULL;
     frame_queue_t *q = queue(type);
+    if (q && !q->empty())
+    {
+        frame = q->dequeue();
+        state_changed = true;
+    }
 
-    if (!q)
-        return NULL;
-
-    return q->dequeue();
+    EndChange();
+    return frame;
 }
 
 VideoFrame *VideoBuffers::head(BufferType type)
@@ -480,10 +526,11 @@ void VideoBuffers::enqueue(BufferType type, VideoFrame *frame)
     if (!q)
         return;
 
-    global_lock.lock();
+    BeginChange();
     q->remove(frame);
     q->enqueue(frame);
-    global_lock.unlock();
+    state_changed = true;
+    EndChange();
 
     return;
 }
@@ -493,7 +540,7 @@ void VideoBuffers::remove(BufferType type, VideoFrame *frame)
     if (!frame)
         return;
 
-    QMutexLocker locker(&global_lock);
+    BeginChange();
 
     if ((type & kVideoBuffer_avail) == kVideoBuffer_avail)
         available.remove(frame);
@@ -509,11 +556,14 @@ void VideoBuffers::remove(BufferType type, VideoFrame *frame)
         decode.remove(frame);
     if ((type & kVideoBuffer_finished) == kVideoBuffer_finished)
         finished.remove(frame);
+    state_changed = true;
+
+    EndChange();
 }
 
 void VideoBuffers::requeue(BufferType dst, BufferType src, int num)
 {
-    QMutexLocker locker(&global_lock);
+    BeginChange();
 
     num = (num <= 0) ? size(src) : num;
     for (uint i=0; i<(uint)num; i++)
@@ -522,6 +572,8 @@ void VideoBuffers::requeue(BufferType dst, BufferType src, int num)
         if (frame)
             enqueue(dst, frame);
     }
+
+    EndChange();
 }
 
 void VideoBuffers::safeEnqueue(BufferType dst, VideoFrame* frame)
@@ -529,15 +581,15 @@ void VideoBuffers::safeEnqueue(BufferType dst, VideoFrame* frame)
     if (!frame)
         return;
 
-    QMutexLocker locker(&global_lock);
-
+    BeginChange();
     remove(kVideoBuffer_all, frame);
     enqueue(dst, frame);
+    EndChange();
 }
 
 frame_queue_t::iterator VideoBuffers::begin_lock(BufferType type)
 {
-    global_lock.lock();
+    LockCounted();
     frame_queue_t *q = queue(type);
     if (q)
         return q->begin();
@@ -559,19 +611,33 @@ frame_queue_t::iterator VideoBuffers::end(BufferType type)
     return it;
 }
 
+/**
+ * \fn VideoBuffers::size(BufferType) const
+ *  Returns the number of frames in a queue, without taking global_lock.
+ */
 uint VideoBuffers::size(BufferType type) const
 {
-    QMutexLocker locker(&global_lock);
-
-    const frame_queue_t *q = queue(type);
-    if (q)
-        return q->size();
+    int q = queue_index(type);
+    if (q < 0)
+        return 0;
 
-    return 0;
+    return (uint) (int) queue_count[q];
 }
 
+/**
+ * \fn VideoBuffers::contains(BufferType, VideoFrame*) const
+ *  Returns true if frame is in the queue. This does not take global_lock
+ *  unless the frame is beyond the first kMaxTrackedFrames buffers.
+ */
 bool VideoBuffers::contains(BufferType type, VideoFrame *frame) const
 {
+    if (!frame || queue_index(type) < 0)
+        return false;
+
+    uint tracked = (int) tracked_frames;
+    if (tracked && frame >= &buffers[0] && frame < &buffers[0] + tracked)
+        return (int) frame_state[frame - &buffers[0]] & type;
+
     QMutexLocker locker(&global_lock);
 
     const frame_queue_t *q = queue(type);
@@ -581,6 +647,104 @@ bool VideoBuffers::contains(BufferType type, VideoFrame *frame) const
     return false;
 }
 
+/**
+ * \fn VideoBuffers::BeginChange(bool)
+ *  Locks global_lock for a change to the queues. If counted is true,
+ *  waits for the lock are counted as in LockCounted().
+ */
+void VideoBuffers::BeginChange(bool counted)
+{
+    if (counted)
+        LockCounted();
+    else
+        global_lock.lock();
+    change_depth++;
+}
+
+/**
+ * \fn VideoBuffers::EndChange(void)
+ *  Unlocks global_lock after BeginChange(). When the outermost change is
+ *  done and any queue was changed, the new state is published.
+ */
+void VideoBuffers::EndChange(void)
+{
+    if (!--change_depth && state_changed)
+    {
+        PublishState();
+        state_changed = false;
+    }
+    global_lock.unlock();
+}
+
+/**
+ * \fn VideoBuffers::PublishState(void)
+ *  Copies the queue sizes and each frame's queues to the atomic state
+ *  read by size() and contains(). Called by EndChange() with global_lock
+ *  held, once per public call that changed any queue.
+ */
+void VideoBuffers::PublishState(void)
+{
+    const frame_queue_t *queues[7] =
+        { &available, &limbo, &used, &pause, &displayed, &finished, &decode };
+    int state[kMaxTrackedFrames];
+    uint tracked = (Size() < kMaxTrackedFrames) ? Size() : kMaxTrackedFrames;
+
+    memset(state, 0, sizeof(state));
+
+    for (uint q = 0; q < 7; q++)
+    {
+        queue_count[q].fetchAndStoreRelease(queues[q]->size());
+
+        frame_queue_t::const_iterator it = queues[q]->begin();
+        for (; it != queues[q]->end(); ++it)
+        {
+            uint i = *it - &buffers[0];
+            if (i < tracked)
+                state[i] |= 1 << q;
+        }
+    }
+
+    for (uint i = 0; i < tracked; i++)
+    {
+        if ((int) frame_state[i] != state[i])
+            frame_state[i].fetchAndStoreRelease(state[i]);
+    }
+
+    tracked_frames.fetchAndStoreRelease(tracked);
+}
+
+/**
+ * \fn VideoBuffers::LockCounted(void)
+ *  Locks global_lock, counting the times and how long another thread
+ *  already held it.
+ */
+void VideoBuffers::LockCounted(void)
+{
+    if (global_lock.tryLock())
+        return;
+
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    global_lock.lock();
+    gettimeofday(&end, NULL);
+
+    lock_waits.ref();
+    lock_wait_usecs.fetchAndAddOrdered(
+        (end.tv_sec - start.tv_sec) * 1000000 +
+        (end.tv_usec - start.tv_usec));
+}
+
+/**
+ * \fn VideoBuffers::TakeLockWaits(uint&)
+ *  Returns the number of waits for global_lock since the last call, and
+ *  the total time spent waiting in wait_usecs.
+ */
+uint VideoBuffers::TakeLockWaits(uint &wait_usecs)
+{
+    wait_usecs = lock_wait_usecs.fetchAndStoreOrdered(0);
+    return lock_waits.fetchAndStoreOrdered(0);
+}
+
 VideoFrame *VideoBuffers::GetScratchFrame(void)
 {
     if (!createdpauseframe || !head(kVideoBuffer_pause))
@@ -611,7 +775,7 @@ void VideoBuffers::SetLastShownFrameToScratch(void)
  */
 void VideoBuffers::DiscardFrames(bool next_frame_keyframe)
 {
-    QMutexLocker locker(&global_lock);
+    BeginChange();
     LOG(VB_PLAYBACK, LOG_INFO, QString("VideoBuffers::DiscardFrames(%1): %2")
             .arg(next_frame_keyframe).arg(GetStatus()));
 
@@ -624,6 +788,7 @@ void VideoBuffers::DiscardFrames(bool next_frame_keyframe)
         LOG(VB_PLAYBACK, LOG_INFO,
             QString("VideoBuffers::DiscardFrames(%1): %2 -- done")
                 .arg(next_frame_keyframe).arg(GetStatus()));
+        EndChange();
         return;
     }
 
@@ -667,16 +832,19 @@ void VideoBuffers::DiscardFrames(bool next_frame_keyframe)
     for (it = decode.begin(); it != decode.end(); ++it)
         available.enqueue(*it);
     decode.clear();
+    state_changed = true;
 
     LOG(VB_PLAYBACK, LOG_INFO,
         QString("VideoBuffers::DiscardFrames(%1): %2 -- done")
             .arg(next_frame_keyframe).arg(GetStatus()));
+
+    EndChange();
 }
 
 void VideoBuffers::ClearAfterSeek(void)
 {
     {
-        QMutexLocker locker(&global_lock);
+        BeginChange();
 
         for (uint i = 0; i < Size(); i++)
             at(i)->timecode = 0;
@@ -698,6 +866,9 @@ void VideoBuffers::ClearAfterSeek(void)
         {
             vpos = rpos = 0;
         }
+        state_changed = true;
+
+        EndChange();
     }
 }
 
@@ -765,7 +936,7 @@ bool VideoBuffers::CreateBuffer(int width, int height, uint num, void* data,
 uint VideoBuffers::AddBuffer(int width, int height, void* data,
                              VideoFrameType fmt)
 {
-    QMutexLocker lock(&global_lock);
+    BeginChange();
 
     uint num = Size();
     buffers.resize(num + 1);
@@ -778,7 +949,9 @@ uint VideoBuffers::AddBuffer(int width, int height, void* data,
     buffers[num].priv[1] = ffmpeg_hack;
     enqueue(kVideoBuffer_avail, at(num));
 
-    return Size();
+    uint size = Size();
+    EndChange();
+    return size;
 }
 
 void VideoBuffers::DeleteBuffers()
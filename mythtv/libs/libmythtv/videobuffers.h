@@ -10,6 +10,7 @@ extern "C" {
 #include <map>
 using namespace std;
 
+#include <QAtomicInt>
 #include <QMutex>
 #include <QString>
 #include <QWaitCondition>
@@ -129,10 +130,16 @@ class VideoBuffers
                    VideoFrameType fmt);
 
     QString GetStatus(int n=-1) const; // debugging method
+    uint TakeLockWaits(uint &wait_usecs);
+
   private:
     frame_queue_t         *queue(BufferType type);
     const frame_queue_t   *queue(BufferType type) const;
     VideoFrame            *GetNextFreeFrameInternal(BufferType enqueue_to);
+    void                   LockCounted(void);
+    void                   BeginChange(bool counted = false);
+    void                   EndChange(void);
+    void                   PublishState(void);
 
     frame_queue_t          available, used, limbo, pause, displayed, decode, finished;
     vbuffer_map_t          vbufferMap; // videobuffers to buffer's index
@@ -150,6 +157,18 @@ class VideoBuffers
     uint                   vpos;
 
     mutable QMutex         global_lock;
+    uint                   change_depth;  // nested BeginChange() calls
+    bool                   state_changed; // queues changed, not published
+
+    // Queue membership published after each change for lock free readers
+    static const uint      kMaxTrackedFrames = 128;
+    QAtomicInt             frame_state[kMaxTrackedFrames];
+    QAtomicInt             queue_count[7];
+    QAtomicInt             tracked_frames;
+
+    // Contention on global_lock by the per frame calls
+    QAtomicInt             lock_waits;
+    QAtomicInt             lock_wait_usecs;
 };
 
 #endif // __VIDEOBUFFERS_H__
@@ -606,8 +606,7 @@ bool VideoOutput::SetupDeinterlace(bool interlaced,
             }
             else
             {
-                int threads = db_vdisp_profile ?
-                                db_vdisp_profile->GetMaxCPUs() : 1;
+                int threads = GetFilterThreads();
                 const QSize video_dim = window.GetVideoDim();
                 int width  = video_dim.width();
                 int height = video_dim.height();
@@ -72,6 +72,9 @@ class VideoOutput
     virtual bool ApproveDeintFilter(const QString& filtername) const;
     void         GetDeinterlacers(QStringList &deinterlacers);
     QString      GetDeinterlacer(void);
+    /// Number of threads software video filters may use
+    int          GetFilterThreads(void) const
+        { return db_vdisp_profile ? db_vdisp_profile->GetMaxCPUs() : 1; }
     virtual void PrepareFrame(VideoFrame *buffer, FrameScanType,
                               OSD *osd) = 0;
     virtual void Show(FrameScanType) = 0;
@@ -218,6 +221,10 @@ class VideoOutput
 
     /// \brief Returns string with status of each frame for debugging.
     QString GetFrameStatus(void) const { return vbuffers.GetStatus(); }
+    /// \brief Returns number of waits for the frame queue lock since the
+    ///        last call, and the time spent waiting in wait_usecs.
+    uint TakeFrameLockWaits(uint &wait_usecs)
+        { return vbuffers.TakeLockWaits(wait_usecs); }
 
     /// \brief Updates frame displayed when video is paused.
     virtual void UpdatePauseFrame(int64_t &disp_timecode) = 0;
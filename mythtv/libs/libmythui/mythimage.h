@@ -81,6 +81,7 @@ class MUI_PUBLIC MythImage : public QImage, public ReferenceCounter
     void setIsReflected(bool reflected) { m_isReflected = reflected; }
 
     void SetIsInCache(bool bCached);
+    bool IsInCache(void) const { return m_cached; }
 
     uint GetCacheSize(void) const
     {
@@ -16,6 +16,9 @@
 #include <QSize>
 #include <QFile>
 #include <QAtomicInt>
+#include <QHash>
+#include <QSet>
+#include <QRunnable>
 
 #include "mythdirs.h"
 #include "mythlogging.h"
@@ -108,8 +111,15 @@ public:
     int m_baseWidth, m_baseHeight;
     bool m_isWide;
 
-    QMap<QString, MythImage *> imageCache;
-    QMap<QString, uint> CacheTrack;
+    void TouchCacheEntry(const QString &url);
+    void RemoveCacheEntry(const QString &url);
+
+    QHash<QString, MythImage *> imageCache;
+    QHash<QString, uint> CacheTrack;     ///< last time the source was checked
+    QHash<QString, quint64> m_cacheUse;  ///< url -> key in m_cacheLRU
+    QMap<quint64, QString> m_cacheLRU;   ///< least recently used first
+    quint64 m_cacheUseCount;
+    QSet<QString> m_cacheWrites;         ///< disk cache files being written
     QMutex *m_cacheLock;
 
     QAtomicInt m_cacheSize;
@@ -155,7 +165,7 @@ MythUIHelperPrivate::MythUIHelperPrivate(MythUIHelper *p)
       m_wmult(1.0), m_hmult(1.0), m_pixelAspectRatio(-1.0),
       m_xbase(0), m_ybase(0), m_height(0), m_width(0),
       m_baseWidth(800), m_baseHeight(600), m_isWide(false),
-      m_cacheLock(new QMutex(QMutex::Recursive)),
+      m_cacheUseCount(0), m_cacheLock(new QMutex(QMutex::Recursive)),
       m_cacheSize(0), m_maxCacheSize(20 * 1024 * 1024),
       m_screenxbase(0), m_screenybase(0), m_screenwidth(0), m_screenheight(0),
       screensaver(NULL), screensaverEnabled(false), display_res(NULL),
@@ -166,7 +176,10 @@ MythUIHelperPrivate::MythUIHelperPrivate(MythUIHelper *p)
 
 MythUIHelperPrivate::~MythUIHelperPrivate()
 {
-    QMutableMapIterator<QString, MythImage *> i(imageCache);
+    // Pending disk cache writes lock m_cacheLock
+    m_imageThreadPool->waitForDone();
+
+    QMutableHashIterator<QString, MythImage *> i(imageCache);
 
     while (i.hasNext())
     {
@@ -177,6 +190,8 @@ MythUIHelperPrivate::~MythUIHelperPrivate()
     }
 
     CacheTrack.clear();
+    m_cacheUse.clear();
+    m_cacheLRU.clear();
 
     delete m_cacheLock;
     delete m_imageThreadPool;
@@ -187,6 +202,76 @@ MythUIHelperPrivate::~MythUIHelperPrivate()
         DisplayRes::SwitchToDesktop();
 }
 
+/// Marks an image as the most recently used one.  Call with m_cacheLock held.
+void MythUIHelperPrivate::TouchCacheEntry(const QString &url)
+{
+    QHash<QString, quint64>::iterator it = m_cacheUse.find(url);
+    if (it != m_cacheUse.end())
+        m_cacheLRU.remove(*it);
+
+    m_cacheUse[url] = ++m_cacheUseCount;
+    m_cacheLRU[m_cacheUseCount] = url;
+}
+
+/// Drops an image from the memory cache.  Call with m_cacheLock held.
+void MythUIHelperPrivate::RemoveCacheEntry(const QString &url)
+{
+    QHash<QString, MythImage *>::iterator it = imageCache.find(url);
+    if (it == imageCache.end())
+        return;
+
+    MythImage *im = *it;
+    imageCache.erase(it);
+    CacheTrack.remove(url);
+    m_cacheLRU.remove(m_cacheUse.take(url));
+
+    im->SetIsInCache(false);
+    im->DecrRef();
+}
+
+/** \class ImageCacheWriter
+ *  \brief Saves an image to the disk cache from the image thread pool.
+ *
+ *  PNG encoding a full size fanart image takes longer than decoding it, so
+ *  it is kept off the thread that loaded the image.  The file is written
+ *  under a temporary name so LoadCacheImage() never sees a partial file.
+ */
+class ImageCacheWriter : public QRunnable
+{
+  public:
+    ImageCacheWriter(MythUIHelperPrivate *parent, const QString &url,
+                     const QString &dstfile, const QImage &image) :
+        m_parent(parent), m_url(url), m_dstfile(dstfile), m_image(image) {}
+
+    void run()
+    {
+        QString tmpfile = m_dstfile + ".tmp";
+        bool ok = m_image.save(tmpfile, "PNG");
+
+        QMutexLocker locker(m_parent->m_cacheLock);
+
+        // RemoveFromCacheByURL() was called while we were encoding
+        if (!m_parent->m_cacheWrites.remove(m_url) || !ok)
+        {
+            if (!ok)
+                LOG(VB_GUI | VB_FILE, LOG_WARNING, LOC +
+                    QString("Failed to save %1 to cache").arg(m_dstfile));
+            QFile::remove(tmpfile);
+            return;
+        }
+
+        QFile::remove(m_dstfile);
+        if (!QFile::rename(tmpfile, m_dstfile))
+            QFile::remove(tmpfile);
+    }
+
+  private:
+    MythUIHelperPrivate *m_parent;
+    QString m_url;
+    QString m_dstfile;
+    QImage  m_image;
+};
+
 void MythUIHelperPrivate::Init(void)
 {
     screensaver = ScreenSaverControl::get();
@@ -492,7 +577,7 @@ void MythUIHelper::UpdateImageCache(void)
 {
     QMutexLocker locker(d->m_cacheLock);
 
-    QMutableMapIterator<QString, MythImage *> i(d->imageCache);
+    QMutableHashIterator<QString, MythImage *> i(d->imageCache);
 
     while (i.hasNext())
     {
@@ -503,6 +588,9 @@ void MythUIHelper::UpdateImageCache(void)
     }
 
     d->CacheTrack.clear();
+    d->m_cacheUse.clear();
+    d->m_cacheLRU.clear();
+    d->m_cacheWrites.clear();
 
     d->m_cacheSize.fetchAndStoreOrdered(0);
 
@@ -513,11 +601,13 @@ MythImage *MythUIHelper::GetImageFromCache(const QString &url)
 {
     QMutexLocker locker(d->m_cacheLock);
 
-    if (d->imageCache.contains(url))
+    QHash<QString, MythImage *>::iterator it = d->imageCache.find(url);
+    if (it != d->imageCache.end())
     {
         d->CacheTrack[url] = MythDate::current().toTime_t();
-        d->imageCache[url]->IncrRef();
-        return d->imageCache[url];
+        d->TouchCacheEntry(url);
+        (*it)->IncrRef();
+        return *it;
     }
 
     /*
@@ -564,64 +654,60 @@ MythImage *MythUIHelper::CacheImage(const QString &url, MythImage *im,
         if (!themedir.exists())
             themedir.mkdir(GetMythUI()->GetThemeCacheDir());
 
-        // Save to disk cache
-        im->save(dstfile, "PNG");
+        // Save to disk cache, the QImage copy is shared until im changes
+        QMutexLocker locker(d->m_cacheLock);
+        if (!d->m_cacheWrites.contains(url))
+        {
+            d->m_cacheWrites.insert(url);
+            d->m_imageThreadPool->start(
+                new ImageCacheWriter(d, url, dstfile, *im), "ImageCacheWrite");
+        }
     }
 
-    // delete the oldest cached images until we fall below threshold.
     QMutexLocker locker(d->m_cacheLock);
 
-    while (d->m_cacheSize.fetchAndAddOrdered(0) + im->numBytes() >=
+    // Delete the least recently used images until we fall below threshold.
+    // Images that are still in use elsewhere are not counted in the cache
+    // size, and removing them would not free anything, so they are skipped.
+    int needed = im->IsInCache() ? 0 : im->numBytes();
+    int count = 0;
+    QMap<quint64, QString>::iterator lru = d->m_cacheLRU.begin();
+
+    while (d->m_cacheSize.fetchAndAddOrdered(0) + needed >=
            d->m_maxCacheSize.fetchAndAddOrdered(0) &&
-           d->imageCache.size())
+           lru != d->m_cacheLRU.end())
     {
-        QMap<QString, MythImage *>::iterator it = d->imageCache.begin();
-        uint oldestTime = MythDate::current().toTime_t();
-        QString oldestKey = it.key();
+        QString key = *lru;
+        MythImage *old = d->imageCache.value(key);
+        ++lru;
 
-        int count = 0;
+        if (old == im)
+            continue;
 
-        for (; it != d->imageCache.end(); ++it)
-        {
-            if (d->CacheTrack[it.key()] < oldestTime)
-            {
-                if ((2 == it.value()->IncrRef()) && (it.value() != im))
-                {
-                    oldestTime = d->CacheTrack[it.key()];
-                    oldestKey = it.key();
-                    count++;
-                }
-                it.value()->DecrRef();
-            }
-        }
+        bool unused = (2 == old->IncrRef());
+        old->DecrRef();
+        if (!unused)
+            continue;
 
-        LOG(VB_GUI | VB_FILE, LOG_INFO, LOC +
-            QString("%1 images are eligible for expiry").arg(count));
+        LOG(VB_GUI | VB_FILE, LOG_DEBUG, LOC +
+            QString("Cache too big (%1), removing :%2:")
+            .arg(d->m_cacheSize.fetchAndAddOrdered(0) + needed)
+            .arg(key));
 
-        if (count > 0)
-        {
-            LOG(VB_GUI | VB_FILE, LOG_INFO, LOC +
-                QString("Cache too big (%1), removing :%2:")
-                .arg(d->m_cacheSize.fetchAndAddOrdered(0) + im->numBytes())
-                .arg(oldestKey));
-
-            d->imageCache[oldestKey]->SetIsInCache(false);
-            d->imageCache[oldestKey]->DecrRef();
-            d->imageCache.remove(oldestKey);
-            d->CacheTrack.remove(oldestKey);
-        }
-        else
-        {
-            break;
-        }
+        d->RemoveCacheEntry(key);
+        count++;
     }
 
-    QMap<QString, MythImage *>::iterator it = d->imageCache.find(url);
+    if (count)
+        LOG(VB_GUI | VB_FILE, LOG_INFO, LOC +
+            QString("Expired %1 images from the cache").arg(count));
+
+    QHash<QString, MythImage *>::iterator it = d->imageCache.find(url);
 
     if (it == d->imageCache.end())
     {
         im->IncrRef();
-        d->imageCache[url] = im;
+        it = d->imageCache.insert(url, im);
         d->CacheTrack[url] = MythDate::current().toTime_t();
 
         im->SetIsInCache(true);
@@ -629,26 +715,20 @@ MythImage *MythUIHelper::CacheImage(const QString &url, MythImage *im,
             QString("NOT IN RAM CACHE, Adding, and adding to size :%1: :%2:")
             .arg(url).arg(im->numBytes()));
     }
+    d->TouchCacheEntry(url);
 
     LOG(VB_GUI | VB_FILE, LOG_INFO, LOC +
         QString("MythUIHelper::CacheImage : Cache Count = :%1: size :%2:")
         .arg(d->imageCache.count()).arg(d->m_cacheSize));
 
-    return d->imageCache[url];
+    return *it;
 }
 
 void MythUIHelper::RemoveFromCacheByURL(const QString &url)
 {
     QMutexLocker locker(d->m_cacheLock);
-    QMap<QString, MythImage *>::iterator it = d->imageCache.find(url);
-
-    if (it != d->imageCache.end())
-    {
-        d->imageCache[url]->SetIsInCache(false);
-        d->imageCache[url]->DecrRef();
-        d->imageCache.remove(url);
-        d->CacheTrack.remove(url);
-    }
+    d->RemoveCacheEntry(url);
+    d->m_cacheWrites.remove(url);
 
     QString dstfile;
 
@@ -1498,14 +1578,25 @@ MythImage *MythUIHelper::LoadCacheImage(QString srcfile, QString label,
 
         QMutexLocker locker(d->m_cacheLock);
 
-        if (d->imageCache.contains(label) &&
+        QHash<QString, MythImage *>::iterator it = d->imageCache.find(label);
+        if (it != d->imageCache.end() &&
             d->CacheTrack[label] + kImageCacheTimeout > now)
         {
-            d->imageCache[label]->IncrRef();
-            return d->imageCache[label];
+            d->TouchCacheEntry(label);
+            (*it)->IncrRef();
+            return *it;
         }
     }
 
+    // Nothing below can find an image that is not already in memory, and
+    // the stat calls are best left to the image loading threads.
+    if (cacheMode & kCacheCheckMemoryOnly)
+    {
+        QMutexLocker locker(d->m_cacheLock);
+        if (!d->imageCache.contains(label))
+            return NULL;
+    }
+
     QString cachefilepath = GetThemeCacheDir() + '/' + label;
     QFileInfo fi(cachefilepath);
 
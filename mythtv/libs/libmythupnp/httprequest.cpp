@@ -11,6 +11,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include "httprequest.h"
+#include "httpresponsestream.h"
 
 #include <QFile>
 #include <QFileInfo>
@@ -136,7 +137,8 @@ HTTPRequest::HTTPRequest() : m_procReqLineExp ( "[ \r\n][ \r\n]*"  ),
                              m_bSOAPRequest   ( false ),
                              m_eResponseType  ( ResponseTypeUnknown),
                              m_nResponseStatus( 200 ),
-                             m_pPostProcess   ( NULL )
+                             m_pPostProcess   ( NULL ),
+                             m_pResponseStream( NULL )
 {
     m_response.open( QIODevice::ReadWrite );
 }
@@ -145,6 +147,15 @@ HTTPRequest::HTTPRequest() : m_procReqLineExp ( "[ \r\n][ \r\n]*"  ),
 //
 /////////////////////////////////////////////////////////////////////////////
 
+HTTPRequest::~HTTPRequest()
+{
+    delete m_pResponseStream;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
 RequestType HTTPRequest::SetRequestType( const QString &sType )
 {
     if (sType == "GET"        ) return( m_eType = RequestTypeGet         );
@@ -185,11 +196,14 @@ QString HTTPRequest::BuildHeader( long long nSize )
     sHeader += GetAdditionalHeaders();
 
     sHeader += QString( "Connection: %1\r\n"
-                        "Content-Type: %2\r\n"
-                        "Content-Length: %3\r\n" )
+                        "Content-Type: %2\r\n" )
                         .arg( GetKeepAlive() ? "Keep-Alive" : "Close" )
-                        .arg( sContentType )
-                        .arg( nSize );
+                        .arg( sContentType );
+
+    // A negative size means the body is sent with chunked encoding.
+
+    if (nSize >= 0)
+        sHeader += QString( "Content-Length: %1\r\n" ).arg( nSize );
 
     // ----------------------------------------------------------------------
     // Temp Hack to process DLNA header
@@ -237,6 +251,18 @@ long HTTPRequest::SendResponse( void )
             break;
     }
 
+    // ----------------------------------------------------------------------
+    // A streamed response has already been sent while it was serialized.
+    // ----------------------------------------------------------------------
+
+    if (( m_pResponseStream != NULL ) && m_pResponseStream->IsStreaming())
+    {
+        if (m_pResponseStream->IsFailed())
+            return( -1 );
+
+        return( m_pResponseStream->BytesSent() );
+    }
+
     LOG(VB_UPNP, LOG_INFO,
         QString("HTTPRequest::SendResponse(xml/html) (%1) :%2 -> %3: %4")
              .arg(m_sFileName) .arg(GetResponseStatus())
@@ -633,6 +659,12 @@ void HTTPRequest::FormatActionResponse( Serializer *pSer )
     m_sResponseTypeText = pSer->GetContentType();
     m_nResponseStatus   = 200;
 
+    if (( m_pResponseStream != NULL ) && m_pResponseStream->IsStreaming())
+    {
+        m_pResponseStream->Finish();
+        return;
+    }
+
     pSer->AddHeaders( m_mapRespHeaders );
 
     //m_response << pFormatter->ToString();
@@ -1452,28 +1484,56 @@ bool HTTPRequest::ProcessSOAPPayload( const QString &sSOAPAction )
 Serializer *HTTPRequest::GetSerializer()
 {
     Serializer *pSerializer = NULL;
+    QIODevice  *pDevice     = &m_response;
+
+    // ----------------------------------------------------------------------
+    // Let large responses to HTTP/1.1 clients be streamed as they are
+    // serialized, unless the client wants to check its cached copy against
+    // an ETag, which can only be computed from the complete response.
+    // ----------------------------------------------------------------------
+
+    int nThreshold =
+        UPnp::GetConfiguration()->GetValue( "HTTP/StreamThreshold", 262144 );
+
+    if (( nThreshold > 0 ) && ( m_eType != RequestTypeHead ) &&
+        (( m_nMajor > 1 ) || (( m_nMajor == 1 ) && ( m_nMinor >= 1 ))) &&
+        GetHeaderValue( "If-None-Match", "" ).isEmpty())
+    {
+        delete m_pResponseStream;
+
+        m_pResponseStream = new HTTPResponseStream( this, nThreshold );
+        pDevice           = m_pResponseStream;
+    }
 
     if (m_bSOAPRequest) 
-        pSerializer = (Serializer *)new SoapSerializer(&m_response,
+        pSerializer = (Serializer *)new SoapSerializer(pDevice,
                                                        m_sNameSpace, m_sMethod);
     else
     {
         QString sAccept = GetHeaderValue( "Accept", "*/*" );
         
         if (sAccept.contains( "application/json", Qt::CaseInsensitive ))    
-            pSerializer = (Serializer *)new JSONSerializer(&m_response,
+            pSerializer = (Serializer *)new JSONSerializer(pDevice,
                                                            m_sMethod);
         else if (sAccept.contains( "text/javascript", Qt::CaseInsensitive ))    
-            pSerializer = (Serializer *)new JSONSerializer(&m_response,
+            pSerializer = (Serializer *)new JSONSerializer(pDevice,
                                                            m_sMethod);
         else if (sAccept.contains( "text/x-apple-plist+xml", Qt::CaseInsensitive ))
-            pSerializer = (Serializer *)new XmlPListSerializer(&m_response);
+            pSerializer = (Serializer *)new XmlPListSerializer(pDevice);
     }
 
     // Default to XML
 
     if (pSerializer == NULL)
-        pSerializer = (Serializer *)new XmlSerializer(&m_response, m_sMethod);
+        pSerializer = (Serializer *)new XmlSerializer(pDevice, m_sMethod);
+
+    // The headers go out as soon as the response starts streaming.
+
+    m_eResponseType     = ResponseTypeOther;
+    m_sResponseTypeText = pSerializer->GetContentType();
+
+    if (pDevice == m_pResponseStream)
+        m_pResponseStream->SetSerializer( pSerializer );
 
     return pSerializer;
 }
@@ -78,6 +78,8 @@ typedef struct
 
 /////////////////////////////////////////////////////////////////////////////
 
+class HTTPResponseStream;
+
 class IPostProcess
 {
     public:
@@ -91,6 +93,8 @@ class IPostProcess
 
 class UPNP_PUBLIC HTTPRequest
 {
+    friend class HTTPResponseStream;
+
     protected:
 
         static const char  *m_szServerHeaders;
@@ -139,6 +143,8 @@ class UPNP_PUBLIC HTTPRequest
 
     protected:
 
+        HTTPResponseStream *m_pResponseStream;
+
         RequestType     SetRequestType      ( const QString &sType  );
         void            SetRequestProtocol  ( const QString &sLine  );
         ContentType     SetContentType      ( const QString &sType  );
@@ -169,7 +175,7 @@ class UPNP_PUBLIC HTTPRequest
     public:
         
                         HTTPRequest     ();
-        virtual        ~HTTPRequest     () {};
+        virtual        ~HTTPRequest     ();
 
         bool            ParseRequest    ();
 
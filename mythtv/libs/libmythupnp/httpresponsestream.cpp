@@ -0,0 +1,265 @@
+//////////////////////////////////////////////////////////////////////////////
+// Program Name: httpresponsestream.cpp
+//
+// Purpose     : Output device which streams large responses to the client
+//               using chunked transfer encoding
+//
+// Licensed under the GPL v2 or later, see COPYING for details
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "httpresponsestream.h"
+#include "httprequest.h"
+#include "serializer.h"
+#include "mythlogging.h"
+
+#include "zlib.h"
+
+// Size of the chunks sent once streaming has started.
+
+const int HTTPResponseStream::kChunkSize = 32768;
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//////////////////////////////////////////////////////////////////////////////
+
+HTTPResponseStream::HTTPResponseStream( HTTPRequest *pRequest,
+                                        qint64       nThreshold )
+                  : m_pRequest   ( pRequest   ),
+                    m_pSerializer( NULL       ),
+                    m_nThreshold ( nThreshold ),
+                    m_bStreaming ( false      ),
+                    m_bFinished  ( false      ),
+                    m_bFailed    ( false      ),
+                    m_pZStream   ( NULL       ),
+                    m_nBytesSent ( 0          )
+{
+    open( QIODevice::WriteOnly );
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//////////////////////////////////////////////////////////////////////////////
+
+HTTPResponseStream::~HTTPResponseStream()
+{
+    if (m_pZStream != NULL)
+    {
+        deflateEnd( m_pZStream );
+        delete m_pZStream;
+        m_pZStream = NULL;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//////////////////////////////////////////////////////////////////////////////
+
+qint64 HTTPResponseStream::readData( char *pData, qint64 nMaxLen )
+{
+    return -1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//////////////////////////////////////////////////////////////////////////////
+
+qint64 HTTPResponseStream::writeData( const char *pData, qint64 nLen )
+{
+    if (m_bFailed || m_bFinished)
+        return -1;
+
+    if (!m_bStreaming)
+    {
+        qint64 nWritten = m_pRequest->m_response.write( pData, nLen );
+
+        if ((m_nThreshold > 0) && (m_pRequest->m_response.size() > m_nThreshold))
+        {
+            if (!BeginStreaming())
+                return -1;
+        }
+
+        return nWritten;
+    }
+
+    if (!Append( pData, nLen, Z_NO_FLUSH ))
+        return -1;
+
+    return nLen;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Sends the response headers and whatever was buffered so far.  These are
+// the serializer's headers, as for a buffered response, except the ETag
+// which can't be sent, it's a hash of the whole response.
+//////////////////////////////////////////////////////////////////////////////
+
+bool HTTPResponseStream::BeginStreaming()
+{
+    m_bStreaming = true;
+
+    if (m_pSerializer != NULL)
+        m_pSerializer->AddHeaders( m_pRequest->m_mapRespHeaders );
+
+    if (m_pRequest->m_mapHeaders[ "accept-encoding" ].contains( "gzip" ))
+    {
+        m_pZStream = new z_stream;
+
+        m_pZStream->zalloc = Z_NULL;
+        m_pZStream->zfree  = Z_NULL;
+        m_pZStream->opaque = Z_NULL;
+
+        int ret = deflateInit2( m_pZStream,
+                                Z_DEFAULT_COMPRESSION,
+                                Z_DEFLATED,
+                                15 + 16,
+                                8,
+                                Z_DEFAULT_STRATEGY ); // gzip encoding
+        if (ret == Z_OK)
+            m_pRequest->m_mapRespHeaders[ "Content-Encoding" ] = "gzip";
+        else
+        {
+            delete m_pZStream;
+            m_pZStream = NULL;
+        }
+    }
+
+    m_pRequest->m_mapRespHeaders[ "Transfer-Encoding" ] = "chunked";
+    m_pRequest->m_mapRespHeaders.remove( "ETag" );
+
+    LOG(VB_UPNP, LOG_INFO,
+        QString("HTTPResponseStream: streaming response to %1%2")
+            .arg(m_pRequest->GetPeerAddress())
+            .arg(m_pZStream ? " (gzip)" : ""));
+
+    QByteArray sHeader = m_pRequest->BuildHeader( -1 ).toUtf8();
+
+    if (m_pRequest->WriteBlockDirect( sHeader.constData(),
+                                      sHeader.length() ) != sHeader.length())
+    {
+        m_bFailed = true;
+        return false;
+    }
+
+    m_nBytesSent += sHeader.length();
+
+    // Move the buffered output into the first chunks.
+
+    QByteArray buffered = m_pRequest->m_response.buffer();
+
+    m_pRequest->m_response.buffer().clear();
+    m_pRequest->m_response.seek( 0 );
+
+    return Append( buffered.constData(), buffered.size(), Z_NO_FLUSH );
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//////////////////////////////////////////////////////////////////////////////
+
+bool HTTPResponseStream::Append( const char *pData, qint64 nLen, int nFlush )
+{
+    if (m_pZStream == NULL)
+        m_pending.append( pData, nLen );
+    else
+    {
+        char out[ kChunkSize ];
+
+        m_pZStream->next_in  = (Bytef*)pData;
+        m_pZStream->avail_in = nLen;
+
+        do
+        {
+            m_pZStream->avail_out = kChunkSize;
+            m_pZStream->next_out  = (Bytef*)out;
+
+            if (deflate( m_pZStream, nFlush ) == Z_STREAM_ERROR)
+            {
+                m_bFailed = true;
+                return false;
+            }
+
+            m_pending.append( out, kChunkSize - m_pZStream->avail_out );
+        }
+        while (m_pZStream->avail_out == 0);
+    }
+
+    if (m_pending.size() >= kChunkSize)
+        return SendChunk();
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//////////////////////////////////////////////////////////////////////////////
+
+bool HTTPResponseStream::SendChunk()
+{
+    if (m_pending.isEmpty())
+        return true;
+
+    QByteArray sSize = QByteArray::number( m_pending.size(), 16 ) + "\r\n";
+
+    m_pending.append( "\r\n" );
+
+    if ((m_pRequest->WriteBlockDirect( sSize.constData(),
+                                       sSize.length() ) != sSize.length()) ||
+        (m_pRequest->WriteBlockDirect( m_pending.constData(),
+                                       m_pending.length() ) != m_pending.length()))
+    {
+        m_bFailed = true;
+        return false;
+    }
+
+    m_nBytesSent += sSize.length() + m_pending.length();
+
+    m_pending.clear();
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Called once the serializer is done.  Sends the rest of the response and
+// the terminating chunk if the response was streamed, otherwise the output
+// is still in the request's response buffer.
+//////////////////////////////////////////////////////////////////////////////
+
+bool HTTPResponseStream::Finish()
+{
+    if (m_bFinished || !m_bStreaming || m_bFailed)
+    {
+        m_bFinished = true;
+        return !m_bFailed;
+    }
+
+    if (m_pZStream != NULL)
+    {
+        Append( NULL, 0, Z_FINISH );
+
+        deflateEnd( m_pZStream );
+        delete m_pZStream;
+        m_pZStream = NULL;
+    }
+
+    m_bFinished = true;
+
+    if (m_bFailed || !SendChunk())
+        return false;
+
+    static const char *pszLastChunk = "0\r\n\r\n";
+
+    if (m_pRequest->WriteBlockDirect( pszLastChunk, 5 ) != 5)
+    {
+        m_bFailed = true;
+        return false;
+    }
+
+    m_nBytesSent += 5;
+
+    LOG(VB_UPNP, LOG_INFO,
+        QString("HTTPResponseStream: streamed %1 bytes to %2")
+            .arg(m_nBytesSent).arg(m_pRequest->GetPeerAddress()));
+
+    return true;
+}
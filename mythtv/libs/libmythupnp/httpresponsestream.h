@@ -0,0 +1,73 @@
+//////////////////////////////////////////////////////////////////////////////
+// Program Name: httpresponsestream.h
+//
+// Purpose     : Output device which streams large responses to the client
+//               using chunked transfer encoding
+//
+// Licensed under the GPL v2 or later, see COPYING for details
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __HTTPRESPONSESTREAM_H__
+#define __HTTPRESPONSESTREAM_H__
+
+#include <QIODevice>
+#include <QByteArray>
+
+#include "upnpexp.h"
+
+class HTTPRequest;
+class Serializer;
+struct z_stream_s;
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Serializers write into this device instead of the request's response
+// buffer.  Output is collected in the response buffer as usual until it
+// grows past the threshold, then the headers are sent and everything
+// after that is written to the socket in chunks as it is produced, so
+// large responses are sent with bounded memory.  Small responses are
+// left in the buffer and are sent by HTTPRequest::SendResponse() with
+// their ETag and Content-Length, exactly as before.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+class UPNP_PUBLIC HTTPResponseStream : public QIODevice
+{
+    protected:
+
+        static const int     kChunkSize;
+
+        HTTPRequest         *m_pRequest;
+        Serializer          *m_pSerializer;
+        qint64               m_nThreshold;
+        bool                 m_bStreaming;
+        bool                 m_bFinished;
+        bool                 m_bFailed;
+        struct z_stream_s   *m_pZStream;
+        QByteArray           m_pending;
+        qint64               m_nBytesSent;
+
+        virtual qint64 readData ( char *pData, qint64 nMaxLen );
+        virtual qint64 writeData( const char *pData, qint64 nLen );
+
+        bool    BeginStreaming  ();
+        bool    Append          ( const char *pData, qint64 nLen, int nFlush );
+        bool    SendChunk       ();
+
+    public:
+
+                 HTTPResponseStream( HTTPRequest *pRequest, qint64 nThreshold );
+        virtual ~HTTPResponseStream();
+
+        void     SetSerializer  ( Serializer *pSer ) { m_pSerializer = pSer; }
+        bool     Finish         ();
+
+        bool     IsStreaming    () const { return m_bStreaming; }
+        bool     IsFailed       () const { return m_bFailed;    }
+        qint64   BytesSent      () const { return m_nBytesSent; }
+
+        virtual bool isSequential() const { return true; }
+};
+
+#endif
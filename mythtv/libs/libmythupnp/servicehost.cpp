@@ -437,6 +437,7 @@ bool ServiceHost::FormatResponse( HTTPRequest *pRequest, QObject *pResults )
 
         pRequest->FormatActionResponse( pSer );
 
+        delete pSer;
         delete pResults;
 
         return true;
@@ -502,5 +503,7 @@ bool ServiceHost::FormatResponse( HTTPRequest *pRequest, QVariant vValue )
 
     pRequest->FormatActionResponse( pSer );
 
+    delete pSer;
+
     return true;
 }
@@ -5,5 +5,8 @@ AutoExpire  *expirer      = NULL;
 JobQueue    *jobqueue     = NULL;
 HouseKeeper *housekeeping = NULL;
 MediaServer *g_pUPnp      = NULL;
+RecordedListCache *recordedListCache = NULL;
+GuideTileCache    *guideTileCache    = NULL;
+VideoScanWatcher  *videoScanWatcher  = NULL;
 QString      pidfile;
 QString      logfile;
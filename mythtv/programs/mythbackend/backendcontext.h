@@ -10,12 +10,18 @@ class Scheduler;
 class JobQueue;
 class HouseKeeper;
 class MediaServer;
+class RecordedListCache;
+class GuideTileCache;
+class VideoScanWatcher;
 
 extern QMap<int, EncoderLink *> tvList;
 extern AutoExpire  *expirer;
 extern JobQueue    *jobqueue;
 extern HouseKeeper *housekeeping;
 extern MediaServer *g_pUPnp;
+extern RecordedListCache *recordedListCache;
+extern GuideTileCache    *guideTileCache;
+extern VideoScanWatcher  *videoScanWatcher;
 extern QString      pidfile;
 extern QString      logfile;
 
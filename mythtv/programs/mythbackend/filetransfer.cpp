@@ -1,3 +1,9 @@
+// POSIX headers
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+
 #include <QCoreApplication>
 #include <QDateTime>
 #include <QFileInfo>
@@ -14,20 +20,21 @@ FileTransfer::FileTransfer(QString &filename, MythSocket *remote,
     ReferenceCounter(QString("FileTransfer:%1").arg(filename)),
     readthreadlive(true), readsLocked(false),
     rbuffer(RingBuffer::Create(filename, false, usereadahead, timeout_ms, true)),
-    sock(remote), ateof(false), lock(QMutex::NonRecursive),
-    writemode(false)
+    sock(remote), ateof(false), zerocopyfd(-1), zerocopypos(0),
+    lock(QMutex::NonRecursive), writemode(false)
 {
     pginfo = new ProgramInfo(filename);
     pginfo->MarkAsInUse(true, kFileTransferInUseID);
-    rbuffer->Start();
+    if (!OpenZeroCopy())
+        rbuffer->Start();
 }
 
 FileTransfer::FileTransfer(QString &filename, MythSocket *remote, bool write) :
     ReferenceCounter(QString("FileTransfer:%1").arg(filename)),
     readthreadlive(true), readsLocked(false),
     rbuffer(RingBuffer::Create(filename, write)),
-    sock(remote), ateof(false), lock(QMutex::NonRecursive),
-    writemode(write)
+    sock(remote), ateof(false), zerocopyfd(-1), zerocopypos(0),
+    lock(QMutex::NonRecursive), writemode(write)
 {
     pginfo = new ProgramInfo(filename);
     pginfo->MarkAsInUse(true, kFileTransferInUseID);
@@ -41,6 +48,12 @@ FileTransfer::~FileTransfer()
 {
     Stop();
 
+    if (zerocopyfd >= 0)
+    {
+        close(zerocopyfd);
+        zerocopyfd = -1;
+    }
+
     if (rbuffer)
     {
         delete rbuffer;
@@ -54,6 +67,53 @@ FileTransfer::~FileTransfer()
     }
 }
 
+/** \brief Switches to sending the file with MythSocket::writeFile().
+ *
+ *   This is only done for local files the RingBuffer considers old,
+ *   i.e. which are not expected to grow; recordings in progress keep
+ *   using the RingBuffer so reads at the end wait for more data.
+ *   The RingBuffer's read-ahead thread is not started in this mode.
+ */
+bool FileTransfer::OpenZeroCopy(void)
+{
+    if (!rbuffer || !rbuffer->IsOpen() ||
+        rbuffer->GetType() != kRingBuffer_File || !rbuffer->IsOldFile())
+    {
+        return false;
+    }
+
+    QString fname = rbuffer->GetFilename();
+    if (!fname.startsWith("/") || !QFileInfo(fname).isFile())
+        return false;
+
+    zerocopyfd = open(fname.toLocal8Bit().constData(), O_RDONLY);
+    if (zerocopyfd < 0)
+        return false;
+
+    zerocopypos = 0;
+    LOG(VB_FILE, LOG_INFO, QString("FileTransfer: sending '%1' zero-copy")
+        .arg(fname));
+    return true;
+}
+
+/** \brief Hands reading back to the RingBuffer at the current position.
+ *
+ *   Used when the client tells us the file may still be growing.
+ */
+void FileTransfer::CloseZeroCopy(void)
+{
+    QMutexLocker locker(&lock);
+
+    if (zerocopyfd < 0)
+        return;
+
+    close(zerocopyfd);
+    zerocopyfd = -1;
+
+    rbuffer->Seek(zerocopypos, SEEK_SET);
+    rbuffer->Start();
+}
+
 bool FileTransfer::isOpen(void)
 {
     if (rbuffer && rbuffer->IsOpen())
@@ -127,6 +187,24 @@ int FileTransfer::RequestBlock(int size)
     while (readsLocked)
         readsUnlockedCond.wait(&lock, 100 /*ms*/);
 
+    if (zerocopyfd >= 0)
+    {
+        struct stat st;
+        if (fstat(zerocopyfd, &st) < 0)
+            return -1;
+
+        qint64 avail = max((qint64)st.st_size - zerocopypos, (qint64)0);
+        tot = (int) min((qint64)max(size,0), avail);
+
+        if (tot > 0 && !sock->writeFile(zerocopyfd, zerocopypos, tot))
+            tot = -1;
+
+        if (pginfo)
+            pginfo->UpdateInUseMark();
+
+        return tot;
+    }
+
     requestBuffer.resize(max((size_t)max(size,0) + 128, requestBuffer.size()));
     char *buf = &requestBuffer[0];
     while (tot < size && !rbuffer->GetStopReads() && readthreadlive)
@@ -200,6 +278,24 @@ long long FileTransfer::Seek(long long curpos, long long pos, int whence)
 
     ateof = false;
 
+    {
+        QMutexLocker locker(&lock);
+        if (zerocopyfd >= 0)
+        {
+            long long desired = pos;
+            if (whence == SEEK_CUR)
+                desired = curpos + pos;
+            else if (whence == SEEK_END)
+                desired = QFileInfo(rbuffer->GetFilename()).size() + pos;
+
+            if (desired < 0)
+                return -1;
+
+            zerocopypos = desired;
+            return desired;
+        }
+    }
+
     Pause();
 
     if (whence == SEEK_CUR)
@@ -233,6 +329,9 @@ void FileTransfer::SetTimeout(bool fast)
     if (pginfo)
         pginfo->UpdateInUseMark();
 
+    if (!fast)
+        CloseZeroCopy();
+
     rbuffer->SetOldFile(fast);
 }
 
@@ -50,6 +50,9 @@ class FileTransfer : public ReferenceCounter
   private:
    ~FileTransfer();
 
+    bool OpenZeroCopy(void);
+    void CloseZeroCopy(void);
+
     volatile bool  readthreadlive;
     bool           readsLocked;
     QWaitCondition readsUnlockedCond;
@@ -61,6 +64,11 @@ class FileTransfer : public ReferenceCounter
 
     vector<char> requestBuffer;
 
+    /// Descriptor used to sendfile() finished local files, or -1
+    int          zerocopyfd;
+    /// Read position of zerocopyfd, protected by lock
+    qint64       zerocopypos;
+
     QMutex lock;
 
     bool writemode;
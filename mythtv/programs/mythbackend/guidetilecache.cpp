@@ -0,0 +1,309 @@
+// C++ headers
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+// Qt headers
+#include <QSet>
+
+// MythTV headers
+#include "guidetilecache.h"
+#include "mythcorecontext.h"
+#include "mythlogging.h"
+#include "mythevent.h"
+#include "mythdbcon.h"
+#include "mythdate.h"
+
+#define LOC QString("GuideTileCache: ")
+
+/// Channel ids covered by one tile
+const uint GuideTileCache::kChanBlock = 32;
+/// Seconds of listings covered by one tile
+const uint GuideTileCache::kSlotSecs  = 3 * 60 * 60;
+/// Tiles kept before the least recently used one is dropped
+const int  GuideTileCache::kMaxTiles  = 512;
+/// Seconds after which a tile or the channel list is reloaded anyway
+const int  GuideTileCache::kMaxAge    = 30 * 60;
+
+static bool program_order(const ProgramInfo *a, const ProgramInfo *b)
+{
+    if (a->GetChanID() != b->GetChanID())
+        return a->GetChanID() < b->GetChanID();
+    return a->GetScheduledStartTime() < b->GetScheduledStartTime();
+}
+
+/// Copies the programs in the requested range which we haven't seen yet.
+static void add_matches(
+    vector<ProgramInfo*> &found, QSet<QString> &seen,
+    const ProgramList &programs, uint firstChanId, uint lastChanId,
+    const QDateTime &start, const QDateTime &end)
+{
+    ProgramList::const_iterator it = programs.begin();
+    for (; it != programs.end(); ++it)
+    {
+        const ProgramInfo *pginfo = *it;
+
+        if ((pginfo->GetChanID() < firstChanId)       ||
+            (pginfo->GetChanID() > lastChanId)        ||
+            (pginfo->GetScheduledEndTime() < start)   ||
+            (pginfo->GetScheduledStartTime() > end))
+        {
+            continue;
+        }
+
+        // Programs appear in every tile they overlap, and the guide query
+        // only lists a program once per channel number and callsign.
+        QString key = QString("%1 %2 %3 %4")
+            .arg(pginfo->GetScheduledStartTime().toString(Qt::ISODate))
+            .arg(pginfo->GetChanNum())
+            .arg(pginfo->GetChannelSchedulingID())
+            .arg(pginfo->GetTitle());
+
+        if (seen.contains(key))
+            continue;
+
+        seen.insert(key);
+        found.push_back(new ProgramInfo(*pginfo));
+    }
+}
+
+GuideTileCache::GuideTileCache(void) :
+    m_generation(0), m_useCount(0), m_hits(0), m_misses(0)
+{
+    gCoreContext->addListener(this);
+}
+
+GuideTileCache::~GuideTileCache()
+{
+    gCoreContext->removeListener(this);
+
+    QMutexLocker locker(&m_lock);
+    Clear();
+}
+
+/** \brief Returns the first of \e numChannels channel ids starting at
+ *         \e startChanId and the last one, or 0 if there are none.
+ */
+void GuideTileCache::GetChannelRange(
+    uint startChanId, uint numChannels, uint &firstChanId, uint &lastChanId)
+{
+    QMutexLocker locker(&m_lock);
+
+    if (!m_chanLoaded.isValid() ||
+        (m_chanLoaded.secsTo(MythDate::current()) > kMaxAge))
+    {
+        uint generation = m_generation;
+        locker.unlock();
+
+        QVector<uint> chanids;
+        MSqlQuery query(MSqlQuery::InitCon());
+        query.prepare("SELECT chanid FROM channel ORDER BY chanid");
+        if (!query.exec())
+            MythDB::DBError("GuideTileCache::GetChannelRange", query);
+        while (query.next())
+            chanids.push_back(query.value(0).toUInt());
+
+        locker.relock();
+        m_chanids = chanids;
+        if (generation == m_generation)
+            m_chanLoaded = MythDate::current();
+    }
+
+    firstChanId = lastChanId = 0;
+
+    QVector<uint>::const_iterator it =
+        lower_bound(m_chanids.begin(), m_chanids.end(), startChanId);
+    uint avail = m_chanids.end() - it;
+    uint count = min(numChannels, avail);
+    if (count)
+    {
+        firstChanId = *it;
+        lastChanId  = *(it + count - 1);
+    }
+}
+
+/** \brief Fills \e destination with copies of the listings for the channel
+ *         ids from \e firstChanId to \e lastChanId between \e start and
+ *         \e end, sorted by channel id and start time.
+ */
+void GuideTileCache::GetPrograms(
+    ProgramList &destination, uint firstChanId, uint lastChanId,
+    const QDateTime &start, const QDateTime &end)
+{
+    destination.clear();
+
+    uint firstBlock = firstChanId / kChanBlock;
+    uint lastBlock  = lastChanId  / kChanBlock;
+    uint firstSlot  = start.toTime_t() / kSlotSecs;
+    uint lastSlot   = end.toTime_t()   / kSlotSecs;
+
+    vector<ProgramInfo*> found;
+    QSet<QString>        seen;
+    ProgramList          schedList;
+    bool                 schedLoaded = false;
+    uint                 hits   = 0;
+    uint                 misses = 0;
+
+    uint numTiles = (lastBlock - firstBlock + 1) * (lastSlot - firstSlot + 1);
+    if ((int)numTiles > kMaxTiles / 4)
+    {
+        // Too large to be worth caching, load it the way it always was.
+        bool hasConflicts;
+        LoadFromScheduler(schedList, hasConflicts);
+        Tile *tile = LoadTile(firstChanId, lastChanId, start, end, schedList);
+        add_matches(found, seen, tile->programs,
+                    firstChanId, lastChanId, start, end);
+        delete tile;
+    }
+    else
+    {
+        for (uint block = firstBlock; block <= lastBlock; block++)
+        {
+            for (uint slot = firstSlot; slot <= lastSlot; slot++)
+            {
+                quint64 key = ((quint64)block << 32) | slot;
+
+                QMutexLocker locker(&m_lock);
+
+                Tile *tile = m_tiles.value(key, NULL);
+                if (tile &&
+                    (tile->loaded.secsTo(MythDate::current()) > kMaxAge))
+                {
+                    m_tiles.remove(key);
+                    delete tile;
+                    tile = NULL;
+                }
+
+                if (tile)
+                {
+                    hits++;
+                    tile->lastUsed = ++m_useCount;
+                    add_matches(found, seen, tile->programs,
+                                firstChanId, lastChanId, start, end);
+                    continue;
+                }
+
+                misses++;
+                uint generation = m_generation;
+                locker.unlock();
+
+                if (!schedLoaded)
+                {
+                    bool hasConflicts;
+                    LoadFromScheduler(schedList, hasConflicts);
+                    schedLoaded = true;
+                }
+
+                QDateTime slotStart = MythDate::fromTime_t(slot * kSlotSecs);
+                tile = LoadTile(block * kChanBlock,
+                                block * kChanBlock + kChanBlock - 1,
+                                slotStart, slotStart.addSecs(kSlotSecs - 1),
+                                schedList);
+
+                add_matches(found, seen, tile->programs,
+                            firstChanId, lastChanId, start, end);
+
+                locker.relock();
+                // Don't keep a tile loaded before the schedule changed.
+                if (generation == m_generation)
+                    AddTile(key, tile);
+                else
+                    delete tile;
+            }
+        }
+    }
+
+    sort(found.begin(), found.end(), program_order);
+
+    vector<ProgramInfo*>::iterator it = found.begin();
+    for (; it != found.end(); ++it)
+        destination.push_back(*it);
+
+    QMutexLocker locker(&m_lock);
+    m_hits   += hits;
+    m_misses += misses;
+
+    LOG(VB_GENERAL, LOG_DEBUG, LOC +
+        QString("%1 tiles from cache, %2 loaded, %3 of %4 tiles total hit")
+            .arg(hits).arg(misses).arg(m_hits).arg(m_hits + m_misses));
+}
+
+/// Drops every tile and the channel list, the next request reloads them.
+void GuideTileCache::Invalidate(void)
+{
+    QMutexLocker locker(&m_lock);
+    Clear();
+    m_chanLoaded = QDateTime();
+    m_generation++;
+}
+
+/// Loads the listings for one tile, or an uncached range.
+GuideTileCache::Tile *GuideTileCache::LoadTile(
+    uint firstChanId, uint lastChanId,
+    const QDateTime &start, const QDateTime &end,
+    const ProgramList &schedList) const
+{
+    MSqlBindings bindings;
+    QString      sSQL = "WHERE program.chanid >= :StartChanId "
+                         "AND program.chanid <= :EndChanId "
+                         "AND program.endtime >= :StartDate "
+                         "AND program.starttime <= :EndDate "
+                        "GROUP BY program.starttime, channel.channum, "
+                         "channel.callsign, program.title "
+                        "ORDER BY program.chanid ";
+
+    bindings[":StartChanId"] = firstChanId;
+    bindings[":EndChanId"  ] = lastChanId;
+    bindings[":StartDate"  ] = start;
+    bindings[":EndDate"    ] = end;
+
+    Tile *tile = new Tile();
+    LoadFromProgram(tile->programs, sSQL, bindings, schedList);
+    tile->loaded   = MythDate::current();
+    tile->lastUsed = 0;
+
+    return tile;
+}
+
+/// Adds a tile, dropping the least recently used one if there are too
+/// many, m_lock must be held when this is called.
+void GuideTileCache::AddTile(quint64 key, Tile *tile)
+{
+    delete m_tiles.value(key, NULL);
+    m_tiles[key] = tile;
+    tile->lastUsed = ++m_useCount;
+
+    while (m_tiles.size() > kMaxTiles)
+    {
+        QHash<quint64,Tile*>::iterator oldest = m_tiles.begin();
+        QHash<quint64,Tile*>::iterator it = m_tiles.begin();
+        for (; it != m_tiles.end(); ++it)
+        {
+            if ((*it)->lastUsed < (*oldest)->lastUsed)
+                oldest = it;
+        }
+        delete *oldest;
+        m_tiles.erase(oldest);
+    }
+}
+
+/// Deletes every tile, m_lock must be held when this is called.
+void GuideTileCache::Clear(void)
+{
+    QHash<quint64,Tile*>::iterator it = m_tiles.begin();
+    for (; it != m_tiles.end(); ++it)
+        delete *it;
+    m_tiles.clear();
+}
+
+void GuideTileCache::customEvent(QEvent *event)
+{
+    if ((MythEvent::Type)(event->type()) != MythEvent::MythEventMessage)
+        return;
+
+    MythEvent *me = (MythEvent *)event;
+    if (me->Message().left(15) == "SCHEDULE_CHANGE")
+        Invalidate();
+}
+
+/* vim: set expandtab tabstop=4 shiftwidth=4: */
@@ -0,0 +1,72 @@
+#ifndef GUIDETILECACHE_H_
+#define GUIDETILECACHE_H_
+
+#include <QDateTime>
+#include <QVector>
+#include <QObject>
+#include <QMutex>
+#include <QHash>
+
+#include "programinfo.h"
+
+/** \brief Cache of program guide listings for Guide::GetProgramGuide().
+ *
+ *  The guide is split into tiles of kChanBlock channel ids by kSlotSecs
+ *  seconds. Each tile is loaded from the program table with the pending
+ *  recordings applied, the first time a request covers it. Later requests
+ *  covering the tile are answered from memory. The tiles and the channel
+ *  list are dropped when the scheduler reports a schedule change. That
+ *  follows guide data updates, because new guide data always queues a
+ *  reschedule.
+ */
+class GuideTileCache : public QObject
+{
+    Q_OBJECT
+
+  public:
+    GuideTileCache(void);
+   ~GuideTileCache();
+
+    void GetChannelRange(uint startChanId, uint numChannels,
+                         uint &firstChanId, uint &lastChanId);
+    void GetPrograms(ProgramList &destination,
+                     uint firstChanId, uint lastChanId,
+                     const QDateTime &start, const QDateTime &end);
+    void Invalidate(void);
+
+  protected:
+    virtual void customEvent(QEvent *event);
+
+  private:
+    class Tile
+    {
+      public:
+        ProgramList programs;
+        QDateTime   loaded;
+        uint        lastUsed;
+    };
+
+    Tile *LoadTile(uint firstChanId, uint lastChanId,
+                   const QDateTime &start, const QDateTime &end,
+                   const ProgramList &schedList) const;
+    void  AddTile(quint64 key, Tile *tile);
+    void  Clear(void);
+
+    mutable QMutex       m_lock;
+    QHash<quint64,Tile*> m_tiles;       // protected by m_lock
+    QVector<uint>        m_chanids;     // protected by m_lock
+    QDateTime            m_chanLoaded;  // protected by m_lock
+    uint                 m_generation;  // protected by m_lock
+    uint                 m_useCount;    // protected by m_lock
+    uint                 m_hits;        // protected by m_lock
+    uint                 m_misses;      // protected by m_lock
+
+    static const uint kChanBlock;
+    static const uint kSlotSecs;
+    static const int  kMaxTiles;
+    static const int  kMaxAge;
+};
+
+#endif
+
+/* vim: set expandtab tabstop=4 shiftwidth=4: */
@@ -32,6 +32,9 @@
 #include "encoderlink.h"
 #include "remoteutil.h"
 #include "housekeeper.h"
+#include "recordedlistcache.h"
+#include "guidetilecache.h"
+#include "videoscanwatcher.h"
 
 #include "mythcontext.h"
 #include "mythversion.h"
@@ -240,6 +243,15 @@ void cleanup(void)
     delete g_pUPnp;
     g_pUPnp = NULL;
 
+    delete recordedListCache;
+    recordedListCache = NULL;
+
+    delete guideTileCache;
+    guideTileCache = NULL;
+
+    delete videoScanWatcher;
+    videoScanWatcher = NULL;
+
     if (SSDP::Instance())
     {
         SSDP::Instance()->RequestTerminate();
@@ -622,6 +634,12 @@ int run_backend(MythBackendCommandLineParser &cmdline)
     if (!cmdline.toBool("nojobqueue"))
         jobqueue = new JobQueue(ismaster);
 
+    recordedListCache = new RecordedListCache();
+    guideTileCache    = new GuideTileCache();
+
+    if (gCoreContext->GetNumSetting("VideoScanWatch", 0))
+        videoScanWatcher = new VideoScanWatcher(gCoreContext->GetHostName());
+
     // ----------------------------------------------------------------------
     //
     // ----------------------------------------------------------------------
@@ -51,6 +51,7 @@ using namespace std;
 #include "scheduler.h"
 #include "backendutil.h"
 #include "programinfo.h"
+#include "seekindexfile.h"
 #include "mythtimezone.h"
 #include "recordinginfo.h"
 #include "recordingrule.h"
@@ -71,6 +72,9 @@ using namespace std;
 #include "videoutils.h"
 #include "mythlogging.h"
 #include "filesysteminfo.h"
+#include "recordedlistcache.h"
+
+extern RecordedListCache *recordedListCache;
 
 /** Milliseconds to wait for an existing thread from
  *  process request thread pool.
@@ -123,6 +127,10 @@ int delete_file_immediately(const QString &filename,
 
 QMutex MainServer::truncate_and_close_lock;
 const uint MainServer::kMasterServerReconnectTimeout = 1000; //ms
+/// Changed/removed recordings remembered before the log is reset
+const int  MainServer::kMaxRecListChanges = 2000;
+/// Largest number of changed recordings sent as a delta
+const int  MainServer::kMaxRecListDelta = 250;
 
 class ProcessRequestRunnable : public QRunnable
 {
@@ -232,7 +240,10 @@ MainServer::MainServer(bool master, int port,
     masterServer(NULL), ismaster(master), threadPool("ProcessRequestPool"),
     masterBackendOverride(false),
     m_sched(sched), m_expirer(expirer), deferredDeleteTimer(NULL),
-    autoexpireUpdateTimer(NULL), m_exitCode(GENERIC_EXIT_OK),
+    autoexpireUpdateTimer(NULL),
+    m_recListEpoch(MythDate::current().toTime_t()),
+    m_recListGeneration(1), m_recListResetGeneration(1),
+    m_exitCode(GENERIC_EXIT_OK),
     m_stopped(false)
 {
     PreviewGeneratorQueue::CreatePreviewGeneratorQueue(
@@ -481,6 +492,13 @@ void MainServer::ProcessRequestWork(MythSocket *sock)
         else
             HandleQueryRecordings(tokens[1], pbs);
     }
+    else if (command == "QUERY_RECORDINGS_SINCE")
+    {
+        if (tokens.size() != 3)
+            LOG(VB_GENERAL, LOG_ERR, "Bad QUERY_RECORDINGS_SINCE query");
+        else
+            HandleQueryRecordingsSince(tokens, pbs);
+    }
     else if (command == "QUERY_RECORDING")
     {
         HandleQueryRecording(tokens, pbs);
@@ -1167,6 +1185,13 @@ void MainServer::customEvent(QEvent *e)
             me = &mod_me;
         }
 
+        if (me->Message().left(21) == "RECORDING_LIST_CHANGE" ||
+            me->Message().left(16) == "UPDATE_FILE_SIZE"      ||
+            me->Message().left(14) == "COMMFLAG_START")
+        {
+            NoteRecordingListChange(*me);
+        }
+
         if (broadcast.empty())
         {
             broadcast.push_back("BACKEND_MESSAGE");
@@ -1703,14 +1728,6 @@ void MainServer::HandleQueryRecordings(QString type, PlaybackSock *pbs)
     MythSocket *pbssock = pbs->getSocket();
     QString playbackhost = pbs->getHostname();
 
-    QMap<QString,ProgramInfo*> recMap;
-    if (m_sched)
-        recMap = m_sched->GetRecording();
-
-    QMap<QString,uint32_t> inUseMap = ProgramInfo::QueryInUseMap();
-    QMap<QString,bool> isJobRunning =
-        ProgramInfo::QueryJobsRunning(JOB_COMMFLAG);
-
     int sort = 0;
     // Allow "Play" and "Delete" for backwards compatibility with protocol
     // version 56 and below.
@@ -1720,22 +1737,32 @@ void MainServer::HandleQueryRecordings(QString type, PlaybackSock *pbs)
         sort = -1;
 
     ProgramList destination;
-    LoadFromRecorded(
-        destination, (type == "Recording"),
-        inUseMap, isJobRunning, recMap, sort);
+    recordedListCache->GetList(destination, (type == "Recording"), sort);
 
-    QMap<QString,ProgramInfo*>::iterator mit = recMap.begin();
-    for (; mit != recMap.end(); mit = recMap.erase(mit))
-        delete *mit;
+    FillRecordingPathnames(destination, playbackhost);
 
     QStringList outputlist(QString::number(destination.size()));
+    ProgramList::iterator it = destination.begin();
+    for (; it != destination.end(); ++it)
+        (*it)->ToStringList(outputlist);
+
+    SendResponse(pbssock, outputlist);
+}
+
+/** \brief Points each recording in the list at a URL the frontend on
+ *         \e playbackhost can play it from, filling in file sizes
+ *         which are not yet known.
+ */
+void MainServer::FillRecordingPathnames(
+    ProgramList &list, const QString &playbackhost)
+{
     QMap<QString, QString> backendIpMap;
     QMap<QString, QString> backendPortMap;
     QString ip   = gCoreContext->GetBackendServerIP();
     QString port = gCoreContext->GetSetting("BackendServerPort");
 
-    ProgramList::iterator it = destination.begin();
-    for (it = destination.begin(); it != destination.end(); ++it)
+    ProgramList::iterator it = list.begin();
+    for (; it != list.end(); ++it)
     {
         ProgramInfo *proginfo = *it;
         PlaybackSock *slave = NULL;
@@ -1771,7 +1798,7 @@ void MainServer::HandleQueryRecordings(QString type, PlaybackSock *pbs)
             if (proginfo->GetPathname().isEmpty())
             {
                 LOG(VB_GENERAL, LOG_ERR, LOC +
-                    QString("HandleQueryRecordings() "
+                    QString("FillRecordingPathnames() "
                             "Couldn't find backend for:\n\t\t\t%1")
                         .arg(proginfo->toString(ProgramInfo::kTitleSubtitle)));
 
@@ -1786,7 +1813,7 @@ void MainServer::HandleQueryRecordings(QString type, PlaybackSock *pbs)
                 if (!slave->FillProgramInfo(*proginfo, playbackhost))
                 {
                     LOG(VB_GENERAL, LOG_ERR,
-                        "MainServer::HandleQueryRecordings()"
+                        "MainServer::FillRecordingPathnames()"
                         "\n\t\t\tCould not fill program info "
                         "from backend");
                 }
@@ -1818,13 +1845,162 @@ void MainServer::HandleQueryRecordings(QString type, PlaybackSock *pbs)
 
         if (slave)
             slave->DecrRef();
+    }
+}
 
-        proginfo->ToStringList(outputlist);
+/**
+ * \addtogroup myth_network_protocol
+ * \par        QUERY_RECORDINGS_SINCE \e epoch \e generation
+ * Returns the changes to the unsorted recording list since the client
+ * last received list \e generation from backend instance \e epoch.
+ * If the backend still knows what changed since then it returns
+ * "DELTA", the current epoch and generation, the number of added or
+ * changed recordings followed by their programinfos, then the number of
+ * removed recordings followed by their unique keys. Otherwise it returns
+ * "FULL", the current epoch and generation, the number of recordings
+ * followed by their programinfos. Send "0 0" to request the full list.
+ */
+void MainServer::HandleQueryRecordingsSince(
+    QStringList &slist, PlaybackSock *pbs)
+{
+    MythSocket *pbssock = pbs->getSocket();
+    QString playbackhost = pbs->getHostname();
+
+    uint epoch      = slist[1].toUInt();
+    uint generation = slist[2].toUInt();
+
+    QStringList changed;
+    QStringList removed;
+    bool full = true;
+
+    QMutexLocker locker(&m_recListLock);
+    uint cur_epoch      = m_recListEpoch;
+    uint cur_generation = m_recListGeneration;
+    if ((epoch == m_recListEpoch) &&
+        (generation >= m_recListResetGeneration) &&
+        (generation <= m_recListGeneration))
+    {
+        QMap<QString,uint>::const_iterator it = m_recListChanged.begin();
+        for (; it != m_recListChanged.end(); ++it)
+        {
+            if (*it > generation)
+                changed.push_back(it.key());
+        }
+        for (it = m_recListRemoved.begin(); it != m_recListRemoved.end(); ++it)
+        {
+            if (*it > generation)
+                removed.push_back(it.key());
+        }
+        full = changed.size() > kMaxRecListDelta;
+    }
+    locker.unlock();
+
+    ProgramList destination;
+    if (full)
+    {
+        recordedListCache->GetList(destination, false, 0);
+    }
+    else
+    {
+        // Recordings deleted since they were last changed are missing
+        recordedListCache->GetRecordings(destination, changed, removed);
+    }
+
+    FillRecordingPathnames(destination, playbackhost);
+
+    QStringList outputlist(full ? "FULL" : "DELTA");
+    outputlist << QString::number(cur_epoch)
+               << QString::number(cur_generation)
+               << QString::number(destination.size());
+
+    ProgramList::iterator it = destination.begin();
+    for (; it != destination.end(); ++it)
+        (*it)->ToStringList(outputlist);
+
+    if (!full)
+    {
+        outputlist << QString::number(removed.size());
+        outputlist += removed;
     }
 
     SendResponse(pbssock, outputlist);
 }
 
+/** \brief Remembers which recording a recording list event was about so
+ *         QUERY_RECORDINGS_SINCE can send frontends just the changes.
+ *
+ *  Events which do not name a recording, or a log which has grown too
+ *  long, start a new list generation which every client must fetch in
+ *  full.
+ */
+void MainServer::NoteRecordingListChange(const MythEvent &me)
+{
+    QStringList tokens = me.Message().simplified().split(" ");
+    uint        chanid = 0;
+    QDateTime   recstartts;
+    bool        is_delete = false;
+
+    if (tokens[0] == "UPDATE_FILE_SIZE")
+    {
+        if (tokens.size() >= 3)
+        {
+            chanid     = tokens[1].toUInt();
+            recstartts = MythDate::fromString(tokens[2]);
+        }
+    }
+    else if (tokens[0] == "COMMFLAG_START")
+    {
+        // The recording's commercial flagging job is now running
+        if (tokens.size() >= 2)
+            ProgramInfo::ExtractKey(tokens[1], chanid, recstartts);
+    }
+    else if ((tokens.size() >= 2) && (tokens[1] == "UPDATE"))
+    {
+        ProgramInfo evinfo(me.ExtraDataList());
+        chanid     = evinfo.GetChanID();
+        recstartts = evinfo.GetRecordingStartTime();
+    }
+    else if ((tokens.size() >= 4) &&
+             ((tokens[1] == "ADD") || (tokens[1] == "DELETE")))
+    {
+        chanid     = tokens[2].toUInt();
+        recstartts = MythDate::fromString(tokens[3]);
+        is_delete  = (tokens[1] == "DELETE");
+    }
+
+    // The delta is served from recordedListCache, which may not have seen
+    // this event yet. Don't let a client get the new generation together
+    // with the old list.
+    if (tokens[0] != "UPDATE_FILE_SIZE")
+        recordedListCache->Invalidate();
+
+    QMutexLocker locker(&m_recListLock);
+
+    uint generation = ++m_recListGeneration;
+
+    if (!chanid || !recstartts.isValid() ||
+        (m_recListChanged.size() + m_recListRemoved.size() >=
+         kMaxRecListChanges))
+    {
+        m_recListChanged.clear();
+        m_recListRemoved.clear();
+        m_recListResetGeneration = generation;
+        return;
+    }
+
+    QString key = ProgramInfo::MakeUniqueKey(chanid, recstartts);
+    if (is_delete)
+    {
+        m_recListChanged.remove(key);
+        m_recListRemoved[key] = generation;
+    }
+    else
+    {
+        m_recListRemoved.remove(key);
+        m_recListChanged[key] = generation;
+    }
+}
+
 /**
  * \addtogroup myth_network_protocol
  * \par        QUERY_RECORDING BASENAME \e basename
@@ -2036,6 +2212,13 @@ void MainServer::DoDeleteThread(DeleteStruct *ds)
         delete_file_immediately( sFileName, followLinks, true);
     }
 
+    /* Delete the seek index, if there is one. */
+    if (SeekIndexFile::Exists(ds->m_filename))
+    {
+        delete_file_immediately(SeekIndexFile::PathFor(ds->m_filename),
+                                followLinks, true);
+    }
+
     DeleteRecordedFiles(ds);
 
     DoDeleteInDB(ds);
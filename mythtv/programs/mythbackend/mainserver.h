@@ -149,6 +149,10 @@ class MainServer : public QObject, public MythSocketCBs
     bool HandleDeleteFile(QString filename, QString storagegroup,
                           PlaybackSock *pbs = NULL);
     void HandleQueryRecordings(QString type, PlaybackSock *pbs);
+    void HandleQueryRecordingsSince(QStringList &slist, PlaybackSock *pbs);
+    void FillRecordingPathnames(ProgramList &list,
+                                const QString &playbackhost);
+    void NoteRecordingListChange(const MythEvent &me);
     void HandleQueryRecording(QStringList &slist, PlaybackSock *pbs);
     void HandleStopRecording(QStringList &slist, PlaybackSock *pbs);
     void DoHandleStopRecording(RecordingInfo &recinfo, PlaybackSock *pbs);
@@ -312,6 +316,14 @@ class MainServer : public QObject, public MythSocketCBs
     QMutex                     m_downloadURLsLock;
     QMap<QString, QString>     m_downloadURLs;
 
+    // Recording list change log, used by QUERY_RECORDINGS_SINCE
+    QMutex                     m_recListLock;
+    uint                       m_recListEpoch;
+    uint                       m_recListGeneration;
+    uint                       m_recListResetGeneration;
+    QMap<QString, uint>        m_recListChanged;
+    QMap<QString, uint>        m_recListRemoved;
+
     int m_exitCode;
 
     typedef QHash<QString,QString> RequestedBy;
@@ -320,6 +332,8 @@ class MainServer : public QObject, public MythSocketCBs
     bool m_stopped;
 
     static const uint kMasterServerReconnectTimeout;
+    static const int  kMaxRecListChanges;
+    static const int  kMaxRecListDelta;
 };
 
 #endif
@@ -0,0 +1,238 @@
+// Qt headers
+#include <QStringList>
+
+// MythTV headers
+#include "recordedlistcache.h"
+#include "mythcorecontext.h"
+#include "mythscheduler.h"
+#include "mythlogging.h"
+#include "mythevent.h"
+#include "mythtimer.h"
+#include "mythdate.h"
+#include "jobqueue.h"
+
+#define LOC QString("RecListCache: ")
+
+/// Seconds after which the list is rebuilt even if no event invalidated it,
+/// so in-use entries which timed out in the database are dropped.
+const int RecordedListCache::kMaxAge = 5 * 60;
+
+static void add_copy(ProgramList &destination, const ProgramInfo &pginfo,
+                     bool possiblyInProgressRecordingsOnly,
+                     const QDateTime &now)
+{
+    if (possiblyInProgressRecordingsOnly &&
+        ((pginfo.GetRecordingEndTime() < now) ||
+         (pginfo.GetRecordingStartTime() > now)))
+    {
+        return;
+    }
+
+    destination.push_back(new ProgramInfo(pginfo));
+}
+
+RecordedListCache::RecordedListCache(void) :
+    m_valid(false), m_generation(0),
+    m_hits(0), m_misses(0), m_invalidations(0),
+    m_lastRebuild(0), m_totalRebuild(0)
+{
+    gCoreContext->addListener(this);
+}
+
+RecordedListCache::~RecordedListCache()
+{
+    gCoreContext->removeListener(this);
+}
+
+/** \brief Fills \e destination with copies of the cached recordings,
+ *         rebuilding the cached list first if it has been invalidated.
+ *
+ *  The arguments have the same meaning as for LoadFromRecorded(), except
+ *  that an unsorted list is returned in ascending order.
+ */
+void RecordedListCache::GetList(
+    ProgramList &destination, bool possiblyInProgressRecordingsOnly, int sort)
+{
+    destination.clear();
+
+    QMutexLocker locker(&m_lock);
+    CheckValid(locker);
+
+    QDateTime now = MythDate::current();
+    if (sort < 0)
+    {
+        ProgramList::const_reverse_iterator it = m_list.rbegin();
+        for (; it != m_list.rend(); ++it)
+            add_copy(destination, **it, possiblyInProgressRecordingsOnly, now);
+    }
+    else
+    {
+        ProgramList::const_iterator it = m_list.begin();
+        for (; it != m_list.end(); ++it)
+            add_copy(destination, **it, possiblyInProgressRecordingsOnly, now);
+    }
+}
+
+/** \brief Fills \e destination with copies of the cached recordings
+ *         with the unique keys in \e keys.
+ *
+ *  Keys of recordings which are not in the list are added to \e missing.
+ */
+void RecordedListCache::GetRecordings(
+    ProgramList &destination, const QStringList &keys, QStringList &missing)
+{
+    destination.clear();
+
+    QMutexLocker locker(&m_lock);
+    CheckValid(locker);
+
+    QStringList::const_iterator it = keys.begin();
+    for (; it != keys.end(); ++it)
+    {
+        QHash<QString,ProgramInfo*>::const_iterator pit = m_index.find(*it);
+        if (pit != m_index.end())
+            destination.push_back(new ProgramInfo(**pit));
+        else
+            missing.push_back(*it);
+    }
+}
+
+/// Marks the cached list out of date, the next request rebuilds it.
+void RecordedListCache::Invalidate(void)
+{
+    QMutexLocker locker(&m_lock);
+    m_valid = false;
+    m_generation++;
+    m_invalidations++;
+}
+
+RecordedListCacheStats RecordedListCache::GetStats(void) const
+{
+    QMutexLocker locker(&m_lock);
+
+    RecordedListCacheStats stats;
+    stats.size          = m_list.size();
+    stats.valid         = m_valid;
+    stats.hits          = m_hits;
+    stats.misses        = m_misses;
+    stats.invalidations = m_invalidations;
+    stats.lastRebuild   = m_lastRebuild;
+    stats.totalRebuild  = m_totalRebuild;
+    return stats;
+}
+
+/// Rebuilds the list if it is out of date, \e locker must hold m_lock.
+void RecordedListCache::CheckValid(QMutexLocker &locker)
+{
+    if (!m_valid || (m_builtAt.secsTo(MythDate::current()) > kMaxAge))
+    {
+        locker.unlock();
+        Rebuild();
+        locker.relock();
+    }
+    else
+    {
+        m_hits++;
+    }
+}
+
+/** \brief Reloads the list from the database.
+ *
+ *  Only one rebuild runs at a time; requests which missed while it ran
+ *  use its result instead of loading the list again.
+ */
+void RecordedListCache::Rebuild(void)
+{
+    QMutexLocker rebuild_locker(&m_rebuildLock);
+
+    m_lock.lock();
+    if (m_valid && (m_builtAt.secsTo(MythDate::current()) <= kMaxAge))
+    {
+        m_hits++;
+        m_lock.unlock();
+        return;
+    }
+    m_misses++;
+    uint generation = m_generation;
+    m_lock.unlock();
+
+    MythTimer timer;
+    timer.start();
+
+    QMap<QString,ProgramInfo*> recMap;
+    if (gCoreContext->GetScheduler())
+        recMap = gCoreContext->GetScheduler()->GetRecording();
+
+    QMap<QString,uint32_t> inUseMap = ProgramInfo::QueryInUseMap();
+    QMap<QString,bool> isJobRunning =
+        ProgramInfo::QueryJobsRunning(JOB_COMMFLAG);
+
+    ProgramList list;
+    LoadFromRecorded(list, false, inUseMap, isJobRunning, recMap, 1);
+
+    QMap<QString,ProgramInfo*>::iterator mit = recMap.begin();
+    for (; mit != recMap.end(); mit = recMap.erase(mit))
+        delete *mit;
+
+    uint elapsed = timer.elapsed();
+
+    QMutexLocker locker(&m_lock);
+
+    m_list.clear();
+    m_index.clear();
+
+    list.setAutoDelete(false);
+    ProgramList::iterator it = list.begin();
+    for (; it != list.end(); ++it)
+    {
+        m_list.push_back(*it);
+        m_index[(*it)->MakeUniqueKey()] = *it;
+    }
+
+    // An event which arrived while we were loading may not be reflected
+    // in the list, so only call it valid if there wasn't one.
+    m_valid        = (generation == m_generation);
+    m_builtAt      = MythDate::current();
+    m_lastRebuild  = elapsed;
+    m_totalRebuild += elapsed;
+
+    LOG(VB_GENERAL, LOG_DEBUG, LOC +
+        QString("Loaded %1 recordings in %2 ms")
+            .arg(m_list.size()).arg(elapsed));
+}
+
+void RecordedListCache::customEvent(QEvent *event)
+{
+    if ((MythEvent::Type)(event->type()) != MythEvent::MythEventMessage)
+        return;
+
+    MythEvent *me = (MythEvent *)event;
+    QString message = me->Message();
+
+    if (message.left(16) == "UPDATE_FILE_SIZE")
+    {
+        QStringList tokens = message.simplified().split(" ");
+        if (tokens.size() < 4)
+            return;
+
+        QString key = ProgramInfo::MakeUniqueKey(
+            tokens[1].toUInt(), MythDate::fromString(tokens[2]));
+
+        QMutexLocker locker(&m_lock);
+        QHash<QString,ProgramInfo*>::iterator it = m_index.find(key);
+        if (it != m_index.end())
+            (*it)->SetFilesize(tokens[3].toLongLong());
+        return;
+    }
+
+    if (message.left(21) == "RECORDING_LIST_CHANGE"   ||
+        message.left(23) == "MASTER_UPDATE_PROG_INFO" ||
+        message.left(17) == "JOB_QUEUE_CHANGED"       ||
+        message.left(14) == "COMMFLAG_START"          ||
+        message.left(15) == "SCHEDULE_CHANGE")
+    {
+        Invalidate();
+    }
+}
+
+/* vim: set expandtab tabstop=4 shiftwidth=4: */
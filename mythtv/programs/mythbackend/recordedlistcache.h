@@ -0,0 +1,76 @@
+#ifndef RECORDEDLISTCACHE_H_
+#define RECORDEDLISTCACHE_H_
+
+#include <QObject>
+#include <QString>
+#include <QMutex>
+#include <QHash>
+#include <QStringList>
+
+#include "programinfo.h"
+
+/// Snapshot of the recorded list cache counters,
+/// see RecordedListCache::GetStats()
+struct RecordedListCacheStats
+{
+    uint size;          ///< recordings in the cached list
+    bool valid;         ///< false if the next request rebuilds the list
+    uint hits;          ///< requests answered from the cached list
+    uint misses;        ///< requests which had to rebuild the list
+    uint invalidations; ///< events which invalidated the cached list
+    uint lastRebuild;   ///< milliseconds taken by the last rebuild
+    uint totalRebuild;  ///< milliseconds taken by all rebuilds
+};
+
+/** \brief In-memory copy of the recorded table as LoadFromRecorded()
+ *         returns it, shared by the protocol and services code.
+ *
+ *  The list is built on the first request after it has been invalidated
+ *  and every other request is answered with copies of the cached
+ *  ProgramInfos. Events which change a recording, its in-use status or
+ *  its jobs invalidate the list, file size updates are applied in place.
+ */
+class RecordedListCache : public QObject
+{
+    Q_OBJECT
+
+  public:
+    RecordedListCache(void);
+   ~RecordedListCache();
+
+    void GetList(ProgramList &destination,
+                 bool possiblyInProgressRecordingsOnly, int sort);
+    void GetRecordings(ProgramList &destination, const QStringList &keys,
+                       QStringList &missing);
+    void Invalidate(void);
+
+    RecordedListCacheStats GetStats(void) const;
+
+  protected:
+    virtual void customEvent(QEvent *event);
+
+  private:
+    void Rebuild(void);
+    void CheckValid(QMutexLocker &locker);
+
+    mutable QMutex              m_lock;
+    /// serialises rebuilds so concurrent misses share one database load
+    QMutex                      m_rebuildLock;
+    ProgramList                 m_list;       // protected by m_lock
+    QHash<QString,ProgramInfo*> m_index;      // protected by m_lock
+    bool                        m_valid;      // protected by m_lock
+    uint                        m_generation; // protected by m_lock
+    QDateTime                   m_builtAt;    // protected by m_lock
+
+    uint                        m_hits;          // protected by m_lock
+    uint                        m_misses;        // protected by m_lock
+    uint                        m_invalidations; // protected by m_lock
+    uint                        m_lastRebuild;   // protected by m_lock
+    uint                        m_totalRebuild;  // protected by m_lock
+
+    static const int kMaxAge;
+};
+
+#endif
+
+/* vim: set expandtab tabstop=4 shiftwidth=4: */
@@ -25,6 +25,8 @@ using namespace std;
 #include <QMutex>
 #include <QFile>
 #include <QMap>
+#include <QHash>
+#include <QSqlRecord>
 
 #include "mythmiscutil.h"
 #include "mythsystem.h"
@@ -60,6 +62,10 @@ Scheduler::Scheduler(bool runthread, QMap<int, EncoderLink *> *tvList,
     priorityTable("powerpriority"),
     schedLock(),
     m_queueLock(),
+    m_bulkDelay(gCoreContext->GetNumSetting("SchedBulkDelay", 10)),
+    m_requestsReceived(0),
+    m_requestsMerged(0),
+    m_passes(0),
     reclist_changed(false),
     specsched(master_sched),
     schedMoveHigher(false),
@@ -73,7 +79,9 @@ Scheduler::Scheduler(bool runthread, QMap<int, EncoderLink *> *tvList,
     error(0),
     livetvTime(QDateTime()),
     livetvpriority(0),
-    prefinputpri(0)
+    prefinputpri(0),
+    m_incremental(false),
+    m_staleAll(true)
 {
     char *debug = getenv("DEBUG_CONFLICTS");
     debugConflicts = (debug != NULL);
@@ -1565,6 +1573,56 @@ bool Scheduler::GetAllPending(RecList &retList) const
     return hasconflicts;
 }
 
+/** \brief Copies at most \e count (all if 0) of the pending entries
+ *         selected by \e filter, skipping the first \e startIndex of them.
+ *  \return the number of entries selected by \e filter
+ */
+uint Scheduler::GetPendingPage(RecList &retList, PendingFilter filter,
+                               uint startIndex, uint count) const
+{
+    QDateTime now = MythDate::current();
+
+    QMutexLocker lockit(&schedLock);
+
+    uint total  = 0;
+    uint copied = 0;
+
+    RecConstIter it = reclist.begin();
+    for (; it != reclist.end(); ++it)
+    {
+        if (!IsPendingSelected(**it, filter, now))
+            continue;
+
+        if ((total >= startIndex) && (!count || (copied < count)))
+        {
+            retList.push_back(new RecordingInfo(**it));
+            copied++;
+        }
+        total++;
+    }
+
+    return total;
+}
+
+/// Returns true if \e filter selects the pending entry \e pginfo.
+bool Scheduler::IsPendingSelected(const RecordingInfo &pginfo,
+                                  PendingFilter filter, const QDateTime &now)
+{
+    if (pginfo.GetRecordingStartTime() < now)
+        return false;
+
+    switch (filter)
+    {
+        case kPendingWillRecord:
+            return pginfo.GetRecordingStatus() <= rsWillRecord;
+        case kPendingConflicts:
+            return pginfo.GetRecordingStatus() == rsConflict;
+        case kPendingAll:
+        default:
+            return true;
+    }
+}
+
 QMap<QString,ProgramInfo*> Scheduler::GetRecording(void) const
 {
     QMutexLocker lockit(&schedLock);
@@ -1635,11 +1693,201 @@ void Scheduler::GetAllScheduled(QStringList &strList)
 
 void Scheduler::Reschedule(const QStringList &request)
 {
-    QMutexLocker locker(&m_queueLock);
-    reschedQueue.enqueue(request);
+    EnqueueRequest(request);
     reschedWait.wakeOne();
 }
 
+/** \brief Returns the part of a request that identifies what it affects.
+ *
+ *   Two requests with the same key have the same effect, apart from
+ *   the maximum start time of MATCH requests which is merged separately.
+ */
+static QString request_key(const QStringList &request, QStringList &tokens)
+{
+    tokens = request.value(0).split(' ', QString::SkipEmptyParts);
+    QString type = tokens.value(0);
+
+    if (type == "MATCH" && tokens.size() >= 5)
+        return QStringList(tokens.mid(0, 4)).join(" ");
+
+    if (type == "CHECK" && tokens.size() >= 4 && request.size() >= 5)
+        return QString("CHECK %1 %2\n").arg(tokens[2]).arg(tokens[3]) +
+            QStringList(request.mid(1, 4)).join("\n");
+
+    if (type == "PLACE")
+        return type;
+
+    return request.join("\n");
+}
+
+/** \brief Returns true for the MATCH requests sent after guide data
+ *         updates, which are identified by the reason they carry.
+ */
+static bool is_guide_request(const QStringList &tokens)
+{
+    if (tokens.value(0) != "MATCH")
+        return false;
+
+    QString why = tokens.value(5);
+    return why == "EITScanner" || why == "MythFillDatabase";
+}
+
+/** \brief Queues a reschedule request, merging it with queued ones.
+ *
+ *   Requests sent after guide data updates by mythfilldatabase and the
+ *   EIT scanner go to the bulk lane and are held back for SchedBulkDelay
+ *   seconds so bursts can be merged. All other requests, including full
+ *   reschedules asked for by mythutil, mythbackend or mythtv-setup, are
+ *   the result of user actions and go to the interactive lane, which is
+ *   handled on the next pass without waiting.
+ *
+ *   A request is merged if an equivalent one is already queued in its
+ *   lane, if a "MATCH 0 0 0" is already queued in the bulk lane, or if it
+ *   is a PLACE, since every pass places all recordings anyway.
+ */
+void Scheduler::EnqueueRequest(const QStringList &request)
+{
+    QMutexLocker locker(&m_queueLock);
+
+    m_requestsReceived++;
+
+    QStringList tokens;
+    QString key = request_key(request, tokens);
+    QString type = tokens.value(0);
+    // The initial pass is never delayed
+    bool bulk = is_guide_request(tokens) && m_passes > 0;
+    MythDeque<QStringList> &lane = bulk ? reschedBulkQueue : reschedQueue;
+
+    if (type == "PLACE" && !reschedQueue.empty())
+    {
+        m_requestsMerged++;
+        return;
+    }
+
+    if (bulk && key == "MATCH 0 0 0" && !lane.empty())
+    {
+        // Everything queued in the bulk lane is covered by this request,
+        // only the latest maximum start time needs to be carried over.
+        QDateTime newmax = MythDate::fromString(tokens.value(4));
+        MythDeque<QStringList>::iterator it = lane.begin();
+        for (; it != lane.end() && newmax.isValid(); ++it)
+        {
+            QStringList qtokens;
+            request_key(*it, qtokens);
+            QDateTime oldmax = MythDate::fromString(qtokens.value(4));
+            if (!oldmax.isValid() || oldmax > newmax)
+                newmax = oldmax;
+        }
+        tokens[4] = newmax.isValid() ? newmax.toString(Qt::ISODate) : "-";
+
+        m_requestsMerged += lane.size();
+        lane.clear();
+        lane.enqueue(QStringList(tokens.join(" ")));
+        return;
+    }
+
+    MythDeque<QStringList>::iterator it = lane.begin();
+    while (it != lane.end())
+    {
+        QStringList qtokens;
+        QString qkey = request_key(*it, qtokens);
+
+        if (qkey == "PLACE")
+        {
+            // Superseded by the new request, which will place as well
+            it = lane.erase(it);
+            m_requestsMerged++;
+            continue;
+        }
+
+        if (qkey != key && !(bulk && qkey == "MATCH 0 0 0"))
+        {
+            ++it;
+            continue;
+        }
+
+        if (type == "MATCH")
+        {
+            // Keep the later of the two maximum start times, where
+            // "-" means there is no limit at all.
+            QDateTime oldmax = MythDate::fromString(qtokens.value(4));
+            QDateTime newmax = MythDate::fromString(tokens.value(4));
+            if (oldmax.isValid() && (!newmax.isValid() || newmax > oldmax))
+            {
+                qtokens[4] = newmax.isValid() ?
+                    newmax.toString(Qt::ISODate) : "-";
+                (*it)[0] = qtokens.join(" ");
+            }
+        }
+
+        m_requestsMerged++;
+        return;
+    }
+
+    if (bulk && lane.empty())
+        m_bulkQueuedTime = MythDate::current();
+
+    lane.enqueue(request);
+}
+
+/** \brief Takes the next request that is ready to be handled.
+ *
+ *   The interactive lane always comes first, the bulk lane is only
+ *   drained once its oldest request has waited m_bulkDelay seconds.
+ */
+bool Scheduler::DequeueRequest(QStringList &request)
+{
+    QMutexLocker locker(&m_queueLock);
+
+    if (!reschedQueue.empty())
+    {
+        request = reschedQueue.dequeue();
+        return true;
+    }
+
+    if (!reschedBulkQueue.empty() &&
+        m_bulkQueuedTime.secsTo(MythDate::current()) >= (int)m_bulkDelay)
+    {
+        request = reschedBulkQueue.dequeue();
+        return true;
+    }
+
+    return false;
+}
+
+/** \brief Returns 0 if there are requests ready to be handled, the number
+ *         of milliseconds until the bulk lane is ready, or -1 if there
+ *         are no queued requests at all.
+ */
+int Scheduler::TimeToReadyRequests(void)
+{
+    QMutexLocker locker(&m_queueLock);
+
+    if (!reschedQueue.empty())
+        return 0;
+
+    if (reschedBulkQueue.empty())
+        return -1;
+
+    int waited = m_bulkQueuedTime.secsTo(MythDate::current());
+    return max(((int)m_bulkDelay - waited) * 1000, 0);
+}
+
+/// \brief Returns the state of the reschedule request queue.
+SchedQueueStats Scheduler::GetQueueStats(void) const
+{
+    QMutexLocker locker(&m_queueLock);
+
+    SchedQueueStats stats;
+    stats.interactive = reschedQueue.size();
+    stats.bulk        = reschedBulkQueue.size();
+    stats.received    = m_requestsReceived;
+    stats.merged      = m_requestsMerged;
+    stats.passes      = m_passes;
+    stats.bulkDelay   = m_bulkDelay;
+    return stats;
+}
+
 void Scheduler::AddRecording(const RecordingInfo &pi)
 {
     QMutexLocker lockit(&schedLock);
@@ -1824,10 +2072,13 @@ void Scheduler::run(void)
         }
         else
         {
-            if (!HaveQueuedRequests())
+            int reqwait = TimeToReadyRequests();
+            if (reqwait != 0)
             {
                 int sched_sleep = (secs_to_next - schedRunTime - 1) * 1000;
                 sched_sleep = min(sched_sleep, maxSleep);
+                if (reqwait > 0)
+                    sched_sleep = min(sched_sleep, reqwait);
                 if (secs_to_next < prerollseconds + (maxSleep/1000))
                     sched_sleep = min(sched_sleep, 5000);
                 LOG(VB_SCHEDULE, LOG_INFO,
@@ -1839,7 +2090,7 @@ void Scheduler::run(void)
             }
             
             QTime t; t.start();
-            if (HaveQueuedRequests() && HandleReschedule())
+            if (TimeToReadyRequests() == 0 && HandleReschedule())
             {
                 statuschanged = true;
                 startIter = reclist.begin();
@@ -1856,6 +2107,10 @@ void Scheduler::run(void)
                     gCoreContext->GetNumSetting("idleWaitForRecordingTime", 15);
                 tuningTimeout =
                     gCoreContext->GetNumSetting("tuningTimeout", 180);
+
+                QMutexLocker locker(&m_queueLock);
+                m_bulkDelay =
+                    gCoreContext->GetNumSetting("SchedBulkDelay", 10);
             }
             
             int e = t.elapsed();
@@ -2107,12 +2362,12 @@ bool Scheduler::HandleReschedule(void)
     QString msg;
     bool deleteFuture = false;
     bool runCheck = false;
+
+    m_incremental = doRun && gCoreContext->GetNumSetting("SchedIncremental", 0);
     
-    while (HaveQueuedRequests())
+    QStringList request;
+    while (DequeueRequest(request))
     {
-        m_queueLock.lock();
-        QStringList request = reschedQueue.dequeue();
-        m_queueLock.unlock();
         QStringList tokens;
         if (request.size() >= 1)
             tokens = request[0].split(' ', QString::SkipEmptyParts);
@@ -2146,6 +2401,7 @@ bool Scheduler::HandleReschedule(void)
             recordmatchLock.lock();
             UpdateMatches(recordid, sourceid, mplexid, maxstarttime);
             recordmatchLock.unlock();
+            InvalidateNewRecords(recordid, sourceid, mplexid, QString());
             schedLock.lock();
         }
         else if (tokens[0] == "CHECK")
@@ -2170,6 +2426,10 @@ bool Scheduler::HandleReschedule(void)
             ResetDuplicates(recordid, findid, title, subtitle, descrip, 
                             programid);
             recordmatchLock.unlock();
+            if (title.isEmpty())
+                InvalidateNewRecords(0, 0, 0, QString());
+            else
+                InvalidateNewRecords(recordid, 0, 0, title);
             schedLock.lock();
         }
         else if (tokens[0] != "PLACE")
@@ -2205,6 +2465,8 @@ bool Scheduler::HandleReschedule(void)
     gettimeofday(&fillstart, NULL);
     if (runCheck)
     {
+        if (m_incremental)
+            InvalidateResetDuplicates();
         LOG(VB_SCHEDULE, LOG_INFO, "UpdateDuplicates...");
         UpdateDuplicates();
     }
@@ -2234,9 +2496,10 @@ bool Scheduler::HandleReschedule(void)
     }
 
     msg.sprintf("Scheduled %d items in %.1f "
-                "= %.2f match + %.2f check + %.2f place",
+                "= %.2f match + %.2f check + %.2f place%s",
                 (int)reclist.size(), matchTime + checkTime + placeTime, 
-                matchTime, checkTime, placeTime);
+                matchTime, checkTime, placeTime,
+                m_incremental ? " (incremental)" : "");
     LOG(VB_GENERAL, LOG_INFO, msg);
 
     fsInfoCacheFillTime = MythDate::current().addSecs(-1000);
@@ -2267,6 +2530,9 @@ bool Scheduler::HandleReschedule(void)
 
     gCoreContext->SendSystemEvent("SCHEDULER_RAN");
 
+    QMutexLocker locker(&m_queueLock);
+    m_passes++;
+
     return true;
 }
 
@@ -4024,40 +4290,56 @@ void Scheduler::AddNewRecords(void)
         "ON ( oldrecstatus.station   = c.callsign  AND "
         "     oldrecstatus.starttime = p.starttime AND "
         "     oldrecstatus.title     = p.title ) "
-        "WHERE p.endtime > (NOW() - INTERVAL 480 MINUTE) "
+        "WHERE p.endtime > (NOW() - INTERVAL 480 MINUTE) ");
+    QString order(
         "ORDER BY RECTABLE.recordid DESC, p.starttime, p.title, c.callsign, "
         "         c.channum ");
     query.replace("RECTABLE", schedTmpRecord);
+    order.replace("RECTABLE", schedTmpRecord);
 
     LOG(VB_SCHEDULE, LOG_INFO, QString(" |-- Start DB Query..."));
 
     gettimeofday(&dbstart, NULL);
-    result.prepare(query);
-    if (!result.exec())
-    {
-        MythDB::DBError("AddNewRecords", result);
+    if (!LoadNewRecords(query, order, schedTmpRecord))
         return;
-    }
     gettimeofday(&dbend, NULL);
 
     LOG(VB_SCHEDULE, LOG_INFO,
-        QString(" |-- %1 results in %2 sec. Processing...")
-            .arg(result.size())
+        QString(" |-- %1 rules in %2 sec. Processing...")
+            .arg(m_newRecordsCache.size())
             .arg(((dbend.tv_sec  - dbstart.tv_sec) * 1000000 +
                   (dbend.tv_usec - dbstart.tv_usec)) / 1000000.0));
 
     RecordingInfo *lastp = NULL;
+    QDateTime minendts = MythDate::current().addSecs(-480 * 60);
 
-    while (result.next())
+    // Walk the rules in the same descending recordid order as the query
+    QList<const SchedRow*> rows;
+    SchedRowMap::const_iterator rit = m_newRecordsCache.constEnd();
+    while (rit != m_newRecordsCache.constBegin())
     {
+        --rit;
+        QList<SchedRow>::const_iterator row = (*rit).begin();
+        for (; row != (*rit).end(); ++row)
+            rows.push_back(&(*row));
+    }
+
+    for (int i = 0; i < rows.size(); ++i)
+    {
+        const SchedRow &result = *rows[i];
+
+        // Cached rows of earlier passes may have aged out of the query.
+        if (MythDate::as_utc(result.at(3).toDateTime()) <= minendts)
+            continue;
+
         // If this is the same program we saw in the last pass and it
         // wasn't a viable candidate, then neither is this one so
         // don't bother with it.  This is essentially an early call to
         // PruneRedundants().
-        uint recordid = result.value(17).toUInt();
-        QDateTime startts = MythDate::as_utc(result.value(2).toDateTime());
-        QString title = result.value(4).toString();
-        QString callsign = result.value(8).toString();
+        uint recordid = result.at(17).toUInt();
+        QDateTime startts = MythDate::as_utc(result.at(2).toDateTime());
+        QString title = result.at(4).toString();
+        QString callsign = result.at(8).toString();
         if (lastp && lastp->GetRecordingStatus() != rsUnknown
             && lastp->GetRecordingStatus() != rsOffLine
             && lastp->GetRecordingStatus() != rsDontRecord
@@ -4069,65 +4351,65 @@ void Scheduler::AddNewRecords(void)
 
         RecordingInfo *p = new RecordingInfo(
             title,
-            result.value(5).toString(),//subtitle
-            result.value(6).toString(),//description
+            result.at(5).toString(),//subtitle
+            result.at(6).toString(),//description
             0, // season
             0, // episode
-            result.value(11).toString(),//category
+            result.at(11).toString(),//category
 
-            result.value(0).toUInt(),//chanid
-            result.value(7).toString(),//channum
+            result.at(0).toUInt(),//chanid
+            result.at(7).toString(),//channum
             callsign,
-            result.value(9).toString(),//channame
+            result.at(9).toString(),//channame
 
-            result.value(21).toString(),//recgroup
-            result.value(36).toString(),//playgroup
+            result.at(21).toString(),//recgroup
+            result.at(36).toString(),//playgroup
 
-            result.value(43).toString(),//hostname
-            result.value(42).toString(),//storagegroup
+            result.at(43).toString(),//hostname
+            result.at(42).toString(),//storagegroup
 
-            result.value(30).toUInt(),//year
+            result.at(30).toUInt(),//year
 
-            result.value(26).toString(),//seriesid
-            result.value(27).toString(),//programid
-            result.value(28).toString(),//inetref
-            result.value(29).toString(),//catType
+            result.at(26).toString(),//seriesid
+            result.at(27).toString(),//programid
+            result.at(28).toString(),//inetref
+            result.at(29).toString(),//catType
 
-            result.value(12).toInt(),//recpriority
+            result.at(12).toInt(),//recpriority
 
             startts,
-            MythDate::as_utc(result.value(3).toDateTime()),//endts
-            MythDate::as_utc(result.value(18).toDateTime()),//recstartts
-            MythDate::as_utc(result.value(19).toDateTime()),//recendts
+            MythDate::as_utc(result.at(3).toDateTime()),//endts
+            MythDate::as_utc(result.at(18).toDateTime()),//recstartts
+            MythDate::as_utc(result.at(19).toDateTime()),//recendts
 
-            result.value(31).toDouble(),//stars
-            (result.value(32).isNull()) ? QDate() :
-            QDate::fromString(result.value(32).toString(), Qt::ISODate),
+            result.at(31).toDouble(),//stars
+            (result.at(32).isNull()) ? QDate() :
+            QDate::fromString(result.at(32).toString(), Qt::ISODate),
             //originalAirDate
 
-            result.value(20).toInt(),//repeat
+            result.at(20).toInt(),//repeat
 
-            RecStatusType(result.value(37).toInt()),//oldrecstatus
-            result.value(38).toInt(),//reactivate
+            RecStatusType(result.at(37).toInt()),//oldrecstatus
+            result.at(38).toInt(),//reactivate
 
             recordid,
-            result.value(34).toUInt(),//parentid
-            RecordingType(result.value(16).toInt()),//rectype
-            RecordingDupInType(result.value(13).toInt()),//dupin
-            RecordingDupMethodType(result.value(22).toInt()),//dupmethod
+            result.at(34).toUInt(),//parentid
+            RecordingType(result.at(16).toInt()),//rectype
+            RecordingDupInType(result.at(13).toInt()),//dupin
+            RecordingDupMethodType(result.at(22).toInt()),//dupmethod
 
-            result.value(1).toUInt(),//sourceid
-            result.value(25).toUInt(),//inputid
-            result.value(24).toUInt(),//cardid
+            result.at(1).toUInt(),//sourceid
+            result.at(25).toUInt(),//inputid
+            result.at(24).toUInt(),//cardid
 
-            result.value(35).toUInt(),//findid
+            result.at(35).toUInt(),//findid
 
-            result.value(23).toInt() == COMM_DETECT_COMMFREE,//commfree
-            result.value(40).toUInt(),//subtitleType
-            result.value(39).toUInt(),//videoproperties
-            result.value(41).toUInt(),//audioproperties
-            result.value(46).toInt());//future
-        p->SetRecordingPriority2(result.value(47).toInt()); // schedorder
+            result.at(23).toInt() == COMM_DETECT_COMMFREE,//commfree
+            result.at(40).toUInt(),//subtitleType
+            result.at(39).toUInt(),//videoproperties
+            result.at(41).toUInt(),//audioproperties
+            result.at(46).toInt());//future
+        p->SetRecordingPriority2(result.at(47).toInt()); // schedorder
 
         if (!p->future && !p->IsReactivated() &&
             p->oldrecstatus != rsAborted &&
@@ -4144,9 +4426,9 @@ void Scheduler::AddNewRecords(void)
 
         p->SetRecordingPriority(
             p->GetRecordingPriority() + recTypeRecPriorityMap[p->GetRecordingRuleType()] +
-            result.value(48).toInt() +
+            result.at(48).toInt() +
             ((autopriority) ?
-             autopriority - (result.value(45).toInt() * autostrata / 200) : 0));
+             autopriority - (result.at(45).toInt() * autostrata / 200) : 0));
 
         // Check to see if the program is currently recording and if
         // the end time was changed.  Ideally, checking for a new end
@@ -4196,7 +4478,7 @@ void Scheduler::AddNewRecords(void)
         // Check for rsCurrentRecording and rsPreviousRecording
         if (p->GetRecordingRuleType() == kDontRecord)
             newrecstatus = rsDontRecord;
-        else if (result.value(15).toInt() && !p->IsReactivated())
+        else if (result.at(15).toInt() && !p->IsReactivated())
             newrecstatus = rsPreviousRecording;
         else if (p->GetRecordingRuleType() != kSingleRecord &&
                  p->GetRecordingRuleType() != kOverrideRecord &&
@@ -4208,19 +4490,19 @@ void Scheduler::AddNewRecords(void)
             if ((dupin & kDupsNewEpi) && p->IsRepeat())
                 newrecstatus = rsRepeat;
 
-            if ((dupin & kDupsInOldRecorded) && result.value(10).toInt())
+            if ((dupin & kDupsInOldRecorded) && result.at(10).toInt())
             {
-                if (result.value(44).toInt() == rsNeverRecord)
+                if (result.at(44).toInt() == rsNeverRecord)
                     newrecstatus = rsNeverRecord;
                 else
                     newrecstatus = rsPreviousRecording;
             }
 
-            if ((dupin & kDupsInRecorded) && result.value(14).toInt())
+            if ((dupin & kDupsInRecorded) && result.at(14).toInt())
                 newrecstatus = rsCurrentRecording;
         }
 
-        bool inactive = result.value(33).toInt();
+        bool inactive = result.at(33).toInt();
         if (inactive)
             newrecstatus = rsInactive;
 
@@ -4244,6 +4526,324 @@ void Scheduler::AddNewRecords(void)
     RecIter tmp = tmpList.begin();
     for ( ; tmp != tmpList.end(); ++tmp)
         worklist.push_back(*tmp);
+
+    if (!m_incremental)
+    {
+        m_newRecordsCache.clear();
+        m_newRecordsCacheTime = QDateTime();
+    }
+}
+
+/** \brief Fills m_newRecordsCache with the rows of the AddNewRecords() query.
+ *
+ *   In incremental mode only the rules touched by the requests handled
+ *   since the last pass are queried again, the rows of all other rules are
+ *   reused and only have their oldrecorded columns refreshed. Everything is
+ *   reloaded when the query itself changed (e.g. a priority setting) and
+ *   at least once every kNewRecordsMaxAge seconds as a safety net.
+ */
+bool Scheduler::LoadNewRecords(const QString &query, const QString &order,
+                               const QString &schedTmpRecord)
+{
+    static const int kNewRecordsMaxAge = 60 * 60;
+
+    QDateTime now = MythDate::current();
+    bool full = !m_incremental || m_staleAll ||
+        query != m_newRecordsQuery || !m_newRecordsCacheTime.isValid() ||
+        m_newRecordsCacheTime.secsTo(now) > kNewRecordsMaxAge;
+
+    QSet<uint> stale;
+    if (!full && !FindStaleNewRecords(stale))
+        full = true;
+
+    m_staleAll = false;
+    m_staleRecordIds.clear();
+    m_staleSourceIds.clear();
+    m_staleMplexIds.clear();
+    m_staleTitles.clear();
+
+    QString filter;
+    if (full)
+    {
+        m_newRecordsCache.clear();
+    }
+    else
+    {
+        QStringList ids;
+        QSet<uint>::const_iterator it = stale.begin();
+        for (; it != stale.end(); ++it)
+        {
+            m_newRecordsCache.remove(*it);
+            ids << QString::number(*it);
+        }
+        filter = QString("AND %1.recordid IN (%2) ")
+            .arg(schedTmpRecord).arg(ids.join(","));
+
+        RefreshNewRecordsHistory(stale);
+    }
+
+    if (full || !stale.empty())
+    {
+        MSqlQuery result(dbConn);
+        result.prepare(query + filter + order);
+        if (!result.exec())
+        {
+            MythDB::DBError("AddNewRecords", result);
+            m_newRecordsCache.clear();
+            m_newRecordsCacheTime = QDateTime();
+            m_staleAll = true;
+            return false;
+        }
+
+        int columns = result.record().count();
+        while (result.next())
+        {
+            SchedRow row(columns);
+            for (int i = 0; i < columns; ++i)
+                row[i] = result.value(i);
+            m_newRecordsCache[row[17].toUInt()].push_back(row);
+        }
+    }
+
+    LOG(VB_SCHEDULE, LOG_INFO, QString(" |-- %1 reload, %2 rules queried")
+        .arg(full ? "Full" : "Incremental")
+        .arg(full ? m_newRecordsCache.size() : stale.size()));
+
+    m_newRecordsQuery = query;
+    if (full)
+        m_newRecordsCacheTime = now;
+
+    return true;
+}
+
+/** \brief Resolves the invalidations recorded by InvalidateNewRecords()
+ *         into the set of recording rules whose rows must be queried again.
+ *
+ *   A rule is stale if it has matches on an affected channel or title now,
+ *   or if it had cached rows for one, since it may just have lost them.
+ */
+bool Scheduler::FindStaleNewRecords(QSet<uint> &stale)
+{
+    stale = m_staleRecordIds;
+
+    MSqlQuery query(dbConn);
+    QSet<uint> chanids;
+
+    QSet<uint>::const_iterator it = m_staleSourceIds.begin();
+    for (; it != m_staleSourceIds.end(); ++it)
+    {
+        query.prepare("SELECT chanid FROM channel WHERE sourceid = :SOURCEID");
+        query.bindValue(":SOURCEID", *it);
+        if (!query.exec())
+        {
+            MythDB::DBError("FindStaleNewRecords", query);
+            return false;
+        }
+        while (query.next())
+            chanids.insert(query.value(0).toUInt());
+    }
+
+    for (it = m_staleMplexIds.begin(); it != m_staleMplexIds.end(); ++it)
+    {
+        query.prepare("SELECT chanid FROM channel WHERE mplexid = :MPLEXID");
+        query.bindValue(":MPLEXID", *it);
+        if (!query.exec())
+        {
+            MythDB::DBError("FindStaleNewRecords", query);
+            return false;
+        }
+        while (query.next())
+            chanids.insert(query.value(0).toUInt());
+    }
+
+    if (!chanids.empty())
+    {
+        QStringList ids;
+        for (it = chanids.begin(); it != chanids.end(); ++it)
+            ids << QString::number(*it);
+
+        query.prepare(QString("SELECT DISTINCT recordid FROM recordmatch "
+                              "WHERE chanid IN (%1)").arg(ids.join(",")));
+        if (!query.exec())
+        {
+            MythDB::DBError("FindStaleNewRecords", query);
+            return false;
+        }
+        while (query.next())
+            stale.insert(query.value(0).toUInt());
+    }
+
+    QSet<QString> titles;
+    QSet<QString>::const_iterator tit = m_staleTitles.begin();
+    for (; tit != m_staleTitles.end(); ++tit)
+    {
+        titles.insert((*tit).toLower());
+        query.prepare("SELECT DISTINCT rm.recordid FROM recordmatch rm "
+                      "INNER JOIN program p "
+                      "      ON rm.chanid = p.chanid "
+                      "         AND rm.starttime = p.starttime "
+                      "         AND rm.manualid = p.manualid "
+                      "WHERE p.title = :TITLE");
+        query.bindValue(":TITLE", *tit);
+        if (!query.exec())
+        {
+            MythDB::DBError("FindStaleNewRecords", query);
+            return false;
+        }
+        while (query.next())
+            stale.insert(query.value(0).toUInt());
+    }
+
+    if (chanids.empty() && titles.empty())
+        return true;
+
+    SchedRowMap::const_iterator rit = m_newRecordsCache.constBegin();
+    for (; rit != m_newRecordsCache.constEnd(); ++rit)
+    {
+        QList<SchedRow>::const_iterator row = (*rit).begin();
+        for (; row != (*rit).end(); ++row)
+        {
+            if (chanids.contains((*row).at(0).toUInt()) ||
+                titles.contains((*row).at(4).toString().toLower()))
+            {
+                stale.insert(rit.key());
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+/** \brief Marks the rules whose recordmatch rows UpdateDuplicates() is
+ *         about to recompute as stale.
+ *
+ *   The duplicate columns of the cached rows (oldrecduplicate,
+ *   recduplicate, findduplicate and recordmatch.oldrecstatus) change when
+ *   a recording finishes or is deleted and when oldrecorded is updated.
+ *   All of these reset the affected recordmatch rows through
+ *   ResetDuplicates() or UpdateMatches(), so the rules with reset rows are
+ *   exactly the ones whose cached rows went stale.
+ */
+void Scheduler::InvalidateResetDuplicates(void)
+{
+    MSqlQuery query(dbConn);
+    query.prepare("SELECT DISTINCT recordid FROM recordmatch "
+                  "WHERE oldrecduplicate = -1");
+    if (!query.exec())
+    {
+        MythDB::DBError("InvalidateResetDuplicates", query);
+        m_staleAll = true;
+        return;
+    }
+
+    while (query.next())
+        m_staleRecordIds.insert(query.value(0).toUInt());
+}
+
+/** \brief Updates the oldrecorded columns of the cached rules not in skip.
+ *
+ *   The scheduler itself writes oldrecorded via AddHistory() without
+ *   queueing a request, so these columns can not be tracked through
+ *   invalidations; re-reading them is much cheaper than the full query.
+ */
+void Scheduler::RefreshNewRecordsHistory(const QSet<uint> &skip)
+{
+    QDateTime minstartts;
+    SchedRowMap::iterator rit = m_newRecordsCache.begin();
+    for (; rit != m_newRecordsCache.end(); ++rit)
+    {
+        QList<SchedRow>::const_iterator row = (*rit).begin();
+        for (; row != (*rit).end(); ++row)
+        {
+            QDateTime startts = (*row).at(2).toDateTime();
+            if (!minstartts.isValid() || startts < minstartts)
+                minstartts = startts;
+        }
+    }
+
+    if (!minstartts.isValid())
+        return;
+
+    MSqlQuery query(dbConn);
+    query.prepare("SELECT station, starttime, title, "
+                  "       recstatus, reactivate, future "
+                  "FROM oldrecorded "
+                  "WHERE starttime >= :MINSTARTTS");
+    query.bindValue(":MINSTARTTS", minstartts);
+    if (!query.exec())
+    {
+        MythDB::DBError("RefreshNewRecordsHistory", query);
+        m_staleAll = true;
+        return;
+    }
+
+    QHash<QString, SchedRow> history;
+    while (query.next())
+    {
+        QString key = QString("%1|%2|%3")
+            .arg(query.value(0).toString().toLower())
+            .arg(query.value(1).toDateTime().toString(Qt::ISODate))
+            .arg(query.value(2).toString().toLower());
+        SchedRow cols(3);
+        cols[0] = query.value(3);
+        cols[1] = query.value(4);
+        cols[2] = query.value(5);
+        history[key] = cols;
+    }
+
+    for (rit = m_newRecordsCache.begin(); rit != m_newRecordsCache.end(); ++rit)
+    {
+        if (skip.contains(rit.key()))
+            continue;
+
+        QList<SchedRow>::iterator row = (*rit).begin();
+        for (; row != (*rit).end(); ++row)
+        {
+            QString key = QString("%1|%2|%3")
+                .arg((*row)[8].toString().toLower())
+                .arg((*row)[2].toDateTime().toString(Qt::ISODate))
+                .arg((*row)[4].toString().toLower());
+            QHash<QString, SchedRow>::const_iterator hit = history.find(key);
+            if (hit == history.end())
+            {
+                (*row)[37] = QVariant();
+                (*row)[38] = QVariant();
+                (*row)[46] = QVariant();
+            }
+            else
+            {
+                (*row)[37] = (*hit).at(0);
+                (*row)[38] = (*hit).at(1);
+                (*row)[46] = (*hit).at(2);
+            }
+        }
+    }
+}
+
+/** \brief Records which cached AddNewRecords() rows a request may affect.
+ *
+ *   Passing no recordid, sourceid, mplexid nor title invalidates
+ *   everything. The actual rules are only looked up in LoadNewRecords(),
+ *   once recordmatch has been updated for all queued requests.
+ */
+void Scheduler::InvalidateNewRecords(uint recordid, uint sourceid,
+                                     uint mplexid, const QString &title)
+{
+    if (!recordid && !sourceid && !mplexid && title.isEmpty())
+    {
+        m_staleAll = true;
+        return;
+    }
+
+    if (recordid)
+        m_staleRecordIds.insert(recordid);
+    if (sourceid)
+        m_staleSourceIds.insert(sourceid);
+    if (mplexid)
+        m_staleMplexIds.insert(mplexid);
+    if (!title.isEmpty())
+        m_staleTitles.insert(title);
 }
 
 void Scheduler::AddNotListed(void) {
@@ -13,6 +13,8 @@ using namespace std;
 #include <QMutex>
 #include <QMap>
 #include <QSet>
+#include <QVector>
+#include <QVariant>
 
 // MythTV headers
 #include "filesysteminfo.h"
@@ -30,6 +32,31 @@ class AutoExpire;
 
 class Scheduler;
 
+/// Snapshot of the reschedule request queue, see Scheduler::GetQueueStats()
+struct SchedQueueStats
+{
+    uint interactive; ///< requests waiting in the interactive lane
+    uint bulk;        ///< requests waiting in the bulk lane
+    uint received;    ///< requests received since startup
+    uint merged;      ///< requests merged into an already queued request
+    uint passes;      ///< reschedule passes run since startup
+    uint bulkDelay;   ///< seconds bulk requests are held back for merging
+};
+
+/// Selects the entries returned by Scheduler::GetPendingPage(), which
+/// only returns entries starting now or later
+typedef enum
+{
+    kPendingWillRecord = 0, ///< entries which will record
+    kPendingAll,            ///< all entries
+    kPendingConflicts,      ///< entries in conflict
+} PendingFilter;
+
+/// One row of the AddNewRecords() query
+typedef QVector<QVariant> SchedRow;
+/// AddNewRecords() rows grouped by recording rule
+typedef QMap<uint, QList<SchedRow> > SchedRowMap;
+
 class Scheduler : public MThread, public MythScheduler
 {
   public:
@@ -64,6 +91,10 @@ class Scheduler : public MThread, public MythScheduler
     // true iff there are conflicts
     bool GetAllPending(RecList &retList) const;
     virtual void GetAllPending(QStringList &strList) const;
+    uint GetPendingPage(RecList &retList, PendingFilter filter,
+                        uint startIndex, uint count) const;
+    static bool IsPendingSelected(const RecordingInfo &pginfo,
+                                  PendingFilter filter, const QDateTime &now);
     virtual QMap<QString,ProgramInfo*> GetRecording(void) const;
 
     static void GetAllScheduled(QStringList &strList);
@@ -93,6 +124,8 @@ class Scheduler : public MThread, public MythScheduler
 
     int GetError(void) const { return error; }
 
+    SchedQueueStats GetQueueStats(void) const;
+
   protected:
     virtual void run(void); // MThread
 
@@ -112,6 +145,13 @@ class Scheduler : public MThread, public MythScheduler
     void BuildWorkList(void);
     bool ClearWorkList(void);
     void AddNewRecords(void);
+    bool LoadNewRecords(const QString &query, const QString &order,
+                        const QString &schedTmpRecord);
+    bool FindStaleNewRecords(QSet<uint> &stale);
+    void InvalidateResetDuplicates(void);
+    void RefreshNewRecordsHistory(const QSet<uint> &skip);
+    void InvalidateNewRecords(uint recordid, uint sourceid, uint mplexid,
+                              const QString &title);
     void AddNotListed(void);
     void BuildNewRecordsQueries(uint recordid, QStringList &from, 
                                 QStringList &where, MSqlBindings &bindings);
@@ -185,27 +225,33 @@ class Scheduler : public MThread, public MythScheduler
 
     void EnqueueMatch(uint recordid, uint sourceid, uint mplexid,
                       const QDateTime maxstarttime, const QString &why)
-    { QMutexLocker locker(&m_queueLock);
-      reschedQueue.enqueue(ScheduledRecording::BuildMatchRequest(recordid,
+    { EnqueueRequest(ScheduledRecording::BuildMatchRequest(recordid,
                                       sourceid, mplexid, maxstarttime, why)); };
     void EnqueueCheck(const RecordingInfo &recinfo, const QString &why)
-    { QMutexLocker locker(&m_queueLock);
-        reschedQueue.enqueue(ScheduledRecording::BuildCheckRequest(recinfo,
-                                                                    why)); };
+    { EnqueueRequest(ScheduledRecording::BuildCheckRequest(recinfo, why)); };
     void EnqueuePlace(const QString &why)
-    { QMutexLocker locker(&m_queueLock);
-      reschedQueue.enqueue(ScheduledRecording::BuildPlaceRequest(why)); };
+    { EnqueueRequest(ScheduledRecording::BuildPlaceRequest(why)); };
 
-    bool HaveQueuedRequests(void)
-    {  QMutexLocker locker(&m_queueLock); return !reschedQueue.empty(); };
-    void ClearRequestQueue(void)
-    {  QMutexLocker locker(&m_queueLock); reschedQueue.clear(); };
+    void EnqueueRequest(const QStringList &request);
+    bool DequeueRequest(QStringList &request);
+    int  TimeToReadyRequests(void);
 
-    
+    void ClearRequestQueue(void)
+    {  QMutexLocker locker(&m_queueLock);
+       reschedQueue.clear(); reschedBulkQueue.clear(); };
 
+    /// Interactive lane, handled on the next scheduler pass
     MythDeque<QStringList> reschedQueue;
+    /// Bulk lane for the MATCH requests of guide data updates, these are
+    /// held back for m_bulkDelay seconds so that bursts get merged
+    MythDeque<QStringList> reschedBulkQueue;
     mutable QMutex schedLock;
     mutable QMutex m_queueLock;
+    QDateTime m_bulkQueuedTime;
+    uint      m_bulkDelay;
+    uint      m_requestsReceived;
+    uint      m_requestsMerged;
+    uint      m_passes;
     QMutex recordmatchLock;
     QWaitCondition reschedWait;
     RecList reclist;
@@ -252,6 +298,18 @@ class Scheduler : public MThread, public MythScheduler
     int prefinputpri;
     QMap<QString, bool> hasLaterList;
 
+    // Incremental scheduling, rows of the AddNewRecords() query are kept
+    // between passes and only the rules touched by a request are reloaded.
+    bool          m_incremental;
+    SchedRowMap   m_newRecordsCache;
+    QString       m_newRecordsQuery;
+    QDateTime     m_newRecordsCacheTime;
+    bool          m_staleAll;
+    QSet<uint>    m_staleRecordIds;
+    QSet<uint>    m_staleSourceIds;
+    QSet<uint>    m_staleMplexIds;
+    QSet<QString> m_staleTitles;
+
     // cache IsSameProgram()
     typedef pair<const RecordingInfo*,const RecordingInfo*> IsSameKey;
     typedef QMap<IsSameKey,bool> IsSameCacheType;
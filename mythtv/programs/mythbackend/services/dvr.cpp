@@ -23,6 +23,8 @@
 //
 //////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
+
 #include <QMap>
 #include <QRegExp>
 
@@ -38,12 +40,37 @@
 #include "encoderlink.h"
 #include "remoteutil.h"
 #include "mythdate.h"
+#include "recordedlistcache.h"
 
 #include "serviceUtil.h"
 #include <mythscheduler.h>
 
 extern QMap<int, EncoderLink *> tvList;
 extern AutoExpire  *expirer;
+extern RecordedListCache *recordedListCache;
+
+/// Orders recordings by start time and channel id, like the database pages
+static bool comp_recstart(const ProgramInfo *a, const ProgramInfo *b)
+{
+    if (a->GetRecordingStartTime() != b->GetRecordingStartTime())
+        return a->GetRecordingStartTime() < b->GetRecordingStartTime();
+    return a->GetChanID() < b->GetChanID();
+}
+
+static bool comp_recstart_rev(const ProgramInfo *a, const ProgramInfo *b)
+{
+    return comp_recstart(b, a);
+}
+
+/// True if \e pInfo comes after the recording on \e chanid at \e recstartts
+static bool is_after(const ProgramInfo *pInfo, uint chanid,
+                     const QDateTime &recstartts, bool descending)
+{
+    if (pInfo->GetRecordingStartTime() != recstartts)
+        return (pInfo->GetRecordingStartTime() < recstartts) == descending;
+    return (pInfo->GetChanID() < chanid) == descending &&
+           (pInfo->GetChanID() != chanid);
+}
 
 /////////////////////////////////////////////////////////////////////////////
 //
@@ -54,102 +81,183 @@ DTC::ProgramList* Dvr::GetRecordedList( bool bDescending,
                                         int  nCount      )
 {
     return GetFilteredRecordedList( bDescending, nStartIndex, nCount,
-                                    QString(), QString(), QString() );
+                                    QString(), QString(), QString(),
+                                    0, QDateTime() );
 }
 
-DTC::ProgramList* Dvr::GetFilteredRecordedList( bool           bDescending,
-                                                int            nStartIndex,
-                                                int            nCount,
-                                                const QString &sTitleRegEx,
-                                                const QString &sRecGroup,
-                                                const QString &sStorageGroup )
+DTC::ProgramList* Dvr::GetFilteredRecordedList( bool             bDescending,
+                                                int              nStartIndex,
+                                                int              nCount,
+                                                const QString   &sTitleRegEx,
+                                                const QString   &sRecGroup,
+                                                const QString   &sStorageGroup,
+                                                int              nAfterChanId,
+                                                const QDateTime &dtAfterStartTime )
 {
-    QMap< QString, ProgramInfo* > recMap;
-
-    if (gCoreContext->GetScheduler())
-        recMap = gCoreContext->GetScheduler()->GetRecording();
-
-    QMap< QString, uint32_t > inUseMap    = ProgramInfo::QueryInUseMap();
-    QMap< QString, bool >     isJobRunning= ProgramInfo::QueryJobsRunning(JOB_COMMFLAG);
-
-    ProgramList progList;
+    ProgramList           progList;
+    vector<ProgramInfo*>  selected;
 
-    int desc = 0;
-    if (bDescending)
-        desc = -1;
-
-    LoadFromRecorded( progList, false, inUseMap, isJobRunning, recMap, desc );
+    // ----------------------------------------------------------------------
+    // StartIndex stays one-based for filtered lists, as it was before the
+    // database paging, zero and one both start at the first recording.
+    // ----------------------------------------------------------------------
 
-    QMap< QString, ProgramInfo* >::iterator mit = recMap.begin();
+    bool bFiltered = !sTitleRegEx.isEmpty() || !sRecGroup.isEmpty() ||
+                     !sStorageGroup.isEmpty();
+    int  nSkip     = bFiltered ? nStartIndex - 1 : nStartIndex;
 
-    for (; mit != recMap.end(); mit = recMap.erase(mit))
-        delete *mit;
+    nStartIndex = max( nStartIndex, 0 );
+    nSkip       = max( nSkip, 0 );
 
     // ----------------------------------------------------------------------
-    // Build Response
+    // The whole list, and any list filtered by title, comes from the
+    // recorded list cache so TitleRegEx is always a case insensitive
+    // QRegExp. Other pages are selected, sorted and limited by the
+    // database.  Paging continues after the recording given by
+    // AfterChanId and AfterStartTime, if set, otherwise StartIndex
+    // recordings are skipped.
     // ----------------------------------------------------------------------
 
-    DTC::ProgramList *pPrograms = new DTC::ProgramList();
+    QDateTime dtAfter = dtAfterStartTime.toUTC();
     int nAvailable = 0;
 
-    if ((sTitleRegEx.isEmpty()) &&
-        (sRecGroup.isEmpty()) &&
-        (sStorageGroup.isEmpty()))
+    if (!sTitleRegEx.isEmpty() ||
+        ((nCount <= 0) && (nSkip == 0) && !dtAfter.isValid()))
     {
-        nStartIndex   = min( nStartIndex, (int)progList.size() );
-        nCount        = (nCount > 0) ? min( nCount, (int)progList.size() ) : progList.size();
-        int nEndIndex = min((nStartIndex + nCount), (int)progList.size() );
-        nCount        = nEndIndex - nStartIndex;
+        recordedListCache->GetList( progList, false, 0 );
 
-        nAvailable = progList.size();
+        QRegExp rTitleRegEx = QRegExp(sTitleRegEx, Qt::CaseInsensitive);
 
-        for( int n = nStartIndex; n < nEndIndex; n++)
+        vector<ProgramInfo*> matched;
+        ProgramList::iterator it = progList.begin();
+        for (; it != progList.end(); ++it)
         {
-            ProgramInfo *pInfo = progList[ n ];
-            if (pInfo->GetRecordingGroup() != "Deleted")
-            {
-                DTC::Program *pProgram = pPrograms->AddNewProgram();
+            ProgramInfo *pInfo = *it;
 
-                FillProgramInfo( pProgram, pInfo, true );
-            }
+            if ((!bFiltered && pInfo->GetRecordingGroup() == "Deleted") ||
+                (!sTitleRegEx.isEmpty() && !pInfo->GetTitle().contains(rTitleRegEx)) ||
+                (!sRecGroup.isEmpty() && sRecGroup != pInfo->GetRecordingGroup()) ||
+                (!sStorageGroup.isEmpty() && sStorageGroup != pInfo->GetStorageGroup()))
+                continue;
+
+            matched.push_back(pInfo);
+        }
+
+        nAvailable = matched.size();
+
+        // Same order as the database pages
+        if (bDescending)
+            stable_sort(matched.begin(), matched.end(), comp_recstart_rev);
+        else
+            stable_sort(matched.begin(), matched.end(), comp_recstart);
+
+        vector<ProgramInfo*>::iterator mit = matched.begin();
+        if (dtAfter.isValid())
+        {
+            while ((mit != matched.end()) &&
+                   !is_after( *mit, nAfterChanId, dtAfter, bDescending ))
+                ++mit;
+        }
+        else
+        {
+            mit += min( nSkip, (int)matched.size() );
+        }
+
+        for (; mit != matched.end(); ++mit)
+        {
+            if ((nCount > 0) && ((int)selected.size() >= nCount))
+                break;
+            selected.push_back(*mit);
         }
     }
     else
     {
-        int nMax      = nCount;
-
-        nAvailable = 0;
-        nCount = 0;
+        MSqlBindings bindings;
+        QStringList  clauses;
 
-        QRegExp rTitleRegEx        = QRegExp(sTitleRegEx, Qt::CaseInsensitive);
+        if (!sRecGroup.isEmpty())
+        {
+            clauses << "r.recgroup = :RECGROUP";
+            bindings[":RECGROUP"] = sRecGroup;
+        }
 
-        for( unsigned int n = 0; n < progList.size(); n++)
+        if (!sStorageGroup.isEmpty())
         {
-            ProgramInfo *pInfo = progList[ n ];
+            clauses << "r.storagegroup = :STORAGEGROUP";
+            bindings[":STORAGEGROUP"] = sStorageGroup;
+        }
 
-            if ((!sTitleRegEx.isEmpty() && !pInfo->GetTitle().contains(rTitleRegEx)) ||
-                (!sRecGroup.isEmpty() && sRecGroup != pInfo->GetRecordingGroup()) ||
-                (!sStorageGroup.isEmpty() && sStorageGroup != pInfo->GetStorageGroup()))
-                continue;
+        if (clauses.isEmpty())
+            clauses << "r.recgroup != 'Deleted'";
 
-            ++nAvailable;
+        QString sWhere = "WHERE " + clauses.join(" AND ") + " ";
 
-            if ((nAvailable < nStartIndex) ||
-                (nCount >= nMax))
-                continue;
+        MSqlQuery query(MSqlQuery::InitCon());
 
-            ++nCount;
+        query.prepare("SELECT COUNT(*) FROM recorded AS r " + sWhere);
+        query.bindValues(bindings);
 
-            DTC::Program *pProgram = pPrograms->AddNewProgram();
+        if (!query.exec())
+            MythDB::DBError("Dvr::GetFilteredRecordedList", query);
+        else if (query.next())
+            nAvailable = query.value(0).toInt();
 
-            FillProgramInfo( pProgram, pInfo, true );
+        QString sDir = bDescending ? "DESC" : "ASC";
+        QString sSQL = sWhere;
+
+        if (dtAfter.isValid())
+        {
+            sSQL += QString("AND (r.starttime %1 :AFTERSTART OR "
+                            "     (r.starttime = :AFTERSTART2 AND "
+                            "      r.chanid %1 :AFTERCHANID)) ")
+                .arg(bDescending ? "<" : ">");
+            bindings[":AFTERSTART"]  = dtAfter;
+            bindings[":AFTERSTART2"] = dtAfter;
+            bindings[":AFTERCHANID"] = nAfterChanId;
         }
+
+        sSQL += QString("ORDER BY r.starttime %1, r.chanid %1 ").arg(sDir);
+
+        // MySQL needs a row count with an offset, use the largest one.
+        sSQL += QString("LIMIT %1, %2 ").arg(dtAfter.isValid() ? 0 : nSkip)
+            .arg((nCount > 0) ? QString::number(nCount) :
+                                QString("18446744073709551615"));
+
+        QMap<QString,ProgramInfo*> recMap;
+        if (gCoreContext->GetScheduler())
+            recMap = gCoreContext->GetScheduler()->GetRecording();
+
+        QMap<QString,uint32_t> inUseMap = ProgramInfo::QueryInUseMap();
+        QMap<QString,bool> isJobRunning =
+            ProgramInfo::QueryJobsRunning(JOB_COMMFLAG);
+
+        LoadFromRecorded( progList, sSQL, bindings,
+                          inUseMap, isJobRunning, recMap );
+
+        QMap<QString,ProgramInfo*>::iterator mit = recMap.begin();
+        for (; mit != recMap.end(); mit = recMap.erase(mit))
+            delete *mit;
+
+        selected.assign( progList.begin(), progList.end() );
+    }
+
+    // ----------------------------------------------------------------------
+    // Build Response
+    // ----------------------------------------------------------------------
+
+    DTC::ProgramList *pPrograms = new DTC::ProgramList();
+
+    for( unsigned int n = 0; n < selected.size(); n++)
+    {
+        DTC::Program *pProgram = pPrograms->AddNewProgram();
+
+        FillProgramInfo( pProgram, selected[ n ], true );
     }
 
     // ----------------------------------------------------------------------
 
     pPrograms->setStartIndex    ( nStartIndex     );
-    pPrograms->setCount         ( nCount          );
+    pPrograms->setCount         ( selected.size() );
     pPrograms->setTotalAvailable( nAvailable      );
     pPrograms->setAsOf          ( MythDate::current() );
     pPrograms->setVersion       ( MYTH_BINARY_VERSION );
@@ -379,31 +487,52 @@ QStringList Dvr::GetTitleList()
 }
 
 /////////////////////////////////////////////////////////////////////////////
-//
+// Only the requested page is copied out of the scheduler, unless this
+// backend has to ask the master for its whole pending list.
 /////////////////////////////////////////////////////////////////////////////
 
-DTC::ProgramList* Dvr::GetUpcomingList( int  nStartIndex,
-                                        int  nCount,
-                                        bool bShowAll )
+static DTC::ProgramList *get_pending_list( int           nStartIndex,
+                                           int           nCount,
+                                           PendingFilter eFilter )
 {
-    RecordingList  recordingList;
-    RecordingList  tmpList;
-    bool hasConflicts;
-    LoadFromScheduler(tmpList, hasConflicts);
-
-    // Sort the upcoming into only those which will record
-    RecordingList::iterator it = tmpList.begin();
-    for(; it < tmpList.end(); ++it)
+    RecordingList recordingList;
+    uint          nAvailable = 0;
+
+    nStartIndex = max( nStartIndex, 0 );
+    nCount      = max( nCount, 0 );
+
+    Scheduler *pSched = dynamic_cast<Scheduler*>(gCoreContext->GetScheduler());
+
+    if (pSched)
     {
-        if (!bShowAll && ((*it)->GetRecordingStatus() <= rsWillRecord) &&
-            ((*it)->GetRecordingStartTime() >= MythDate::current()))
-        {
-            recordingList.push_back(new RecordingInfo(**it));
-        }
-        else if (bShowAll &&
-                 ((*it)->GetRecordingStartTime() >= MythDate::current()))
+        RecList tmpList;
+        nAvailable = pSched->GetPendingPage( tmpList, eFilter,
+                                             nStartIndex, nCount );
+
+        RecList::iterator it = tmpList.begin();
+        for (; it != tmpList.end(); ++it)
+            recordingList.push_back( *it );
+    }
+    else
+    {
+        RecordingList tmpList;
+        bool hasConflicts;
+        LoadFromScheduler(tmpList, hasConflicts);
+
+        QDateTime now = MythDate::current();
+
+        RecordingList::iterator it = tmpList.begin();
+        for(; it < tmpList.end(); ++it)
         {
-            recordingList.push_back(new RecordingInfo(**it));
+            if (!Scheduler::IsPendingSelected( **it, eFilter, now ))
+                continue;
+
+            if (((int)nAvailable >= nStartIndex) &&
+                ((nCount == 0) || ((int)recordingList.size() < nCount)))
+            {
+                recordingList.push_back(new RecordingInfo(**it));
+            }
+            nAvailable++;
         }
     }
 
@@ -413,11 +542,7 @@ DTC::ProgramList* Dvr::GetUpcomingList( int  nStartIndex,
 
     DTC::ProgramList *pPrograms = new DTC::ProgramList();
 
-    nStartIndex   = min( nStartIndex, (int)recordingList.size() );
-    nCount        = (nCount > 0) ? min( nCount, (int)recordingList.size() ) : recordingList.size();
-    int nEndIndex = min((nStartIndex + nCount), (int)recordingList.size() );
-
-    for( int n = nStartIndex; n < nEndIndex; n++)
+    for( uint n = 0; n < recordingList.size(); n++)
     {
         ProgramInfo *pInfo = recordingList[ n ];
 
@@ -428,13 +553,13 @@ DTC::ProgramList* Dvr::GetUpcomingList( int  nStartIndex,
 
     // ----------------------------------------------------------------------
 
-    pPrograms->setStartIndex    ( nStartIndex     );
-    pPrograms->setCount         ( nCount          );
-    pPrograms->setTotalAvailable( recordingList.size() );
+    pPrograms->setStartIndex    ( min( nStartIndex, (int)nAvailable ) );
+    pPrograms->setCount         ( recordingList.size() );
+    pPrograms->setTotalAvailable( nAvailable      );
     pPrograms->setAsOf          ( MythDate::current() );
     pPrograms->setVersion       ( MYTH_BINARY_VERSION );
     pPrograms->setProtoVer      ( MYTH_PROTO_VERSION  );
-    
+
     return pPrograms;
 }
 
@@ -442,54 +567,22 @@ DTC::ProgramList* Dvr::GetUpcomingList( int  nStartIndex,
 //
 /////////////////////////////////////////////////////////////////////////////
 
-DTC::ProgramList* Dvr::GetConflictList( int  nStartIndex,
-                                        int  nCount       )
+DTC::ProgramList* Dvr::GetUpcomingList( int  nStartIndex,
+                                        int  nCount,
+                                        bool bShowAll )
 {
-    RecordingList  recordingList;
-    RecordingList  tmpList;
-    bool hasConflicts;
-    LoadFromScheduler(tmpList, hasConflicts);
-
-    // Sort the upcoming into only those which are conflicts
-    RecordingList::iterator it = tmpList.begin();
-    for(; it < tmpList.end(); ++it)
-    {
-        if (((*it)->GetRecordingStatus() == rsConflict) &&
-            ((*it)->GetRecordingStartTime() >= MythDate::current()))
-        {
-            recordingList.push_back(new RecordingInfo(**it));
-        }
-    }
-
-    // ----------------------------------------------------------------------
-    // Build Response
-    // ----------------------------------------------------------------------
-
-    DTC::ProgramList *pPrograms = new DTC::ProgramList();
-
-    nStartIndex   = min( nStartIndex, (int)recordingList.size() );
-    nCount        = (nCount > 0) ? min( nCount, (int)recordingList.size() ) : recordingList.size();
-    int nEndIndex = min((nStartIndex + nCount), (int)recordingList.size() );
-
-    for( int n = nStartIndex; n < nEndIndex; n++)
-    {
-        ProgramInfo *pInfo = recordingList[ n ];
-
-        DTC::Program *pProgram = pPrograms->AddNewProgram();
-
-        FillProgramInfo( pProgram, pInfo, true );
-    }
-
-    // ----------------------------------------------------------------------
+    return get_pending_list( nStartIndex, nCount,
+                             bShowAll ? kPendingAll : kPendingWillRecord );
+}
 
-    pPrograms->setStartIndex    ( nStartIndex     );
-    pPrograms->setCount         ( nCount          );
-    pPrograms->setTotalAvailable( recordingList.size() );
-    pPrograms->setAsOf          ( MythDate::current() );
-    pPrograms->setVersion       ( MYTH_BINARY_VERSION );
-    pPrograms->setProtoVer      ( MYTH_PROTO_VERSION  );
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
 
-    return pPrograms;
+DTC::ProgramList* Dvr::GetConflictList( int  nStartIndex,
+                                        int  nCount       )
+{
+    return get_pending_list( nStartIndex, nCount, kPendingConflicts );
 }
 
 int Dvr::AddRecordSchedule   ( int       chanid,
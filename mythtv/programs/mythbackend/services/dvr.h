@@ -52,7 +52,9 @@ class Dvr : public DvrServices
                                                     int              Count,
                                                     const QString   &TitleRegEx,
                                                     const QString   &RecGroup,
-                                                    const QString   &StorageGroup );
+                                                    const QString   &StorageGroup,
+                                                    int              AfterChanId,
+                                                    const QDateTime &AfterStartTime );
 
         DTC::Program*     GetRecorded         ( int              ChanId,
                                                 const QDateTime &StartTime  );
@@ -168,11 +170,14 @@ class ScriptableDvr : public QObject
                                            int              Count,
                                            const QString   &TitleRegEx,
                                            const QString   &RecGroup,
-                                           const QString   &StorageGroup)
+                                           const QString   &StorageGroup,
+                                           int              AfterChanId,
+                                           const QDateTime &AfterStartTime )
         {
             return m_obj.GetFilteredRecordedList( Descending, StartIndex, Count,
                                                   TitleRegEx, RecGroup,
-                                                  StorageGroup);
+                                                  StorageGroup, AfterChanId,
+                                                  AfterStartTime );
         }
 
         QObject* GetRecorded         ( int              ChanId,
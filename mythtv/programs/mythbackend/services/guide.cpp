@@ -33,9 +33,11 @@
 #include "scheduler.h"
 #include "autoexpire.h"
 #include "channelutil.h"
+#include "guidetilecache.h"
 
-extern AutoExpire  *expirer;
-extern Scheduler   *sched;
+extern AutoExpire     *expirer;
+extern Scheduler      *sched;
+extern GuideTileCache *guideTileCache;
 
 /////////////////////////////////////////////////////////////////////////////
 //
@@ -66,53 +68,28 @@ DTC::ProgramGuide *Guide::GetProgramGuide( const QDateTime &rawStartTime ,
     // Find the ending channel Id
     // ----------------------------------------------------------------------
 
-    int nEndChanId = nStartChanId;
+    uint nFirstChanId = 0;
+    uint nLastChanId  = 0;
 
-    MSqlQuery query(MSqlQuery::InitCon());
+    if (nStartChanId < 0)
+        nStartChanId = 0;
 
-    query.prepare( "SELECT chanid FROM channel WHERE (chanid >= :STARTCHANID )"
-                   " ORDER BY chanid LIMIT :NUMCHAN" );
+    guideTileCache->GetChannelRange( nStartChanId, nNumChannels,
+                                     nFirstChanId, nLastChanId );
 
-    query.bindValue(":STARTCHANID", nStartChanId );
-    query.bindValue(":NUMCHAN"    , nNumChannels );
-
-    if (!query.exec())
-        MythDB::DBError("Select ChanId", query);
-
-    query.first();  nStartChanId = query.value(0).toInt();
-    query.last();   nEndChanId   = query.value(0).toInt();
+    int nEndChanId = nLastChanId;
+    nStartChanId   = nFirstChanId;
 
     // ----------------------------------------------------------------------
-    // Build SQL statement for Program Listing
+    // Get the Program Listing, served from the guide tile cache where
+    // possible.  Tiles include the status of pending recordings.
     // ----------------------------------------------------------------------
 
     ProgramList  progList;
-    ProgramList  schedList;
-    MSqlBindings bindings;
-
-    QString      sSQL = "WHERE program.chanid >= :StartChanId "
-                         "AND program.chanid <= :EndChanId "
-                         "AND program.endtime >= :StartDate "
-                         "AND program.starttime <= :EndDate "
-                        "GROUP BY program.starttime, channel.channum, "
-                         "channel.callsign, program.title "
-                        "ORDER BY program.chanid ";
-
-    bindings[":StartChanId"] = nStartChanId;
-    bindings[":EndChanId"  ] = nEndChanId;
-    bindings[":StartDate"  ] = dtStartTime;
-    bindings[":EndDate"    ] = dtEndTime;
-
-    // ----------------------------------------------------------------------
-    // Get all Pending Scheduled Programs
-    // ----------------------------------------------------------------------
-
-    bool hasConflicts;
-    LoadFromScheduler(schedList, hasConflicts);
-
-    // ----------------------------------------------------------------------
 
-    LoadFromProgram( progList, sSQL, bindings, schedList );
+    if (nLastChanId)
+        guideTileCache->GetPrograms( progList, nFirstChanId, nLastChanId,
+                                     dtStartTime, dtEndTime );
 
     // ----------------------------------------------------------------------
     // Build Response
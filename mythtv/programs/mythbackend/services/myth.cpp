@@ -40,6 +40,10 @@
 #include "hardwareprofile.h"
 #include "mythtimezone.h"
 #include "mythdate.h"
+#include "scheduler.h"
+#include "recordedlistcache.h"
+
+extern RecordedListCache *recordedListCache;
 
 /////////////////////////////////////////////////////////////////////////////
 //
@@ -381,6 +385,62 @@ DTC::TimeZoneInfo *Myth::GetTimeZone(  )
 //
 /////////////////////////////////////////////////////////////////////////////
 
+DTC::SchedulerStatus *Myth::GetSchedulerStatus(  )
+{
+    Scheduler *pSched = dynamic_cast<Scheduler*>(gCoreContext->GetScheduler());
+
+    if (!pSched)
+        throw( QString( "Scheduler is not running on this backend." ));
+
+    SchedQueueStats stats = pSched->GetQueueStats();
+
+    DTC::SchedulerStatus *pResults = new DTC::SchedulerStatus();
+
+    pResults->setInteractiveQueued( stats.interactive );
+    pResults->setBulkQueued( stats.bulk );
+    pResults->setReceived( stats.received );
+    pResults->setMerged( stats.merged );
+    pResults->setMergeRatio( stats.received ?
+                             (double)stats.merged / stats.received : 0.0 );
+    pResults->setPasses( stats.passes );
+    pResults->setBulkDelay( stats.bulkDelay );
+
+    return pResults;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+DTC::RecordedListCacheStatus *Myth::GetRecordedListCacheStatus(  )
+{
+    if (!recordedListCache)
+        throw( QString( "Recorded list cache is not running." ));
+
+    RecordedListCacheStats stats = recordedListCache->GetStats();
+
+    DTC::RecordedListCacheStatus *pResults =
+        new DTC::RecordedListCacheStatus();
+
+    uint requests = stats.hits + stats.misses;
+
+    pResults->setSize( stats.size );
+    pResults->setValid( stats.valid );
+    pResults->setHits( stats.hits );
+    pResults->setMisses( stats.misses );
+    pResults->setHitRate( requests ? (double)stats.hits / requests : 0.0 );
+    pResults->setInvalidations( stats.invalidations );
+    pResults->setLastRebuildTime( stats.lastRebuild );
+    pResults->setAvgRebuildTime( stats.misses ?
+                                 stats.totalRebuild / stats.misses : 0 );
+
+    return pResults;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
 DTC::LogMessageList *Myth::GetLogs(  const QString   &HostName,
                                      const QString   &Application,
                                      int             PID,
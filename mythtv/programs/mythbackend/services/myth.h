@@ -59,6 +59,10 @@ class Myth : public MythServices
 
         DTC::TimeZoneInfo*  GetTimeZone         ( );
 
+        DTC::SchedulerStatus* GetSchedulerStatus ( );
+
+        DTC::RecordedListCacheStatus* GetRecordedListCacheStatus ( );
+
         DTC::LogMessageList* GetLogs            ( const QString   &HostName,
                                                   const QString   &Application,
                                                   int             PID,
@@ -171,6 +175,13 @@ class ScriptableMyth : public QObject
 
         QObject* GetTimeZone() { return m_obj.GetTimeZone( ); }
 
+        QObject* GetSchedulerStatus() { return m_obj.GetSchedulerStatus( ); }
+
+        QObject* GetRecordedListCacheStatus()
+        {
+            return m_obj.GetRecordedListCacheStatus( );
+        }
+
         QObject* GetLogs( const QString   &HostName,
                           const QString   &Application,
                           int             PID,
@@ -0,0 +1,420 @@
+// POSIX headers
+#include <unistd.h>
+
+// ANSI C headers
+#include <cmath>
+#include <cstring>
+
+// C++ headers
+#include <algorithm> // for min/max, nth_element
+#include <iostream> // for cerr
+using namespace std;
+
+// Qt headers
+#include <QString>
+
+// MythTV headers
+#include "mythcorecontext.h"
+#include "mythcommflagplayer.h"
+#include "mythlogging.h"
+
+// Commercial Flagging headers
+#include "BitstreamCommDetector.h"
+
+static void scan_progress(int percentage, void *detector)
+{
+    ((BitstreamCommDetector *)detector)->ScanProgress(percentage);
+}
+
+static uint median(vector<uint> &values)
+{
+    if (values.empty())
+        return 0;
+    vector<uint>::iterator mid = values.begin() + values.size() / 2;
+    nth_element(values.begin(), mid, values.end());
+    return *mid;
+}
+
+BitstreamCommDetector::BitstreamCommDetector(
+    SkipType commDetectMethod_in, bool showProgress_in, bool fullSpeed_in,
+    MythCommFlagPlayer *player_in,
+    const QDateTime &recordingStartedAt_in,
+    const QDateTime &recordingStopsAt_in) :
+    commDetectMethod(commDetectMethod_in),
+    showProgress(showProgress_in),          fullSpeed(fullSpeed_in),
+    player(player_in),
+    recordingStartedAt(recordingStartedAt_in),
+    recordingStopsAt(recordingStopsAt_in),
+    fps(0.0),                               keyframeDist(0),
+    aggressiveDetection(true),              prevPercent(-1),
+    showDialnorm(-1)
+{
+    keyframeStep =
+        gCoreContext->GetNumSetting("CommDetectFastKeyframeStep", 1);
+    blankSizePercent =
+        gCoreContext->GetNumSetting("CommDetectFastBlankSize", 10);
+    darkBrightness =
+        gCoreContext->GetNumSetting("CommDetectDarkBrightness", 80);
+    dimBrightness =
+        gCoreContext->GetNumSetting("CommDetectDimBrightness", 120);
+    dimAverage =
+        gCoreContext->GetNumSetting("CommDetectDimAverage", 35);
+    minCommBreakLength =
+        gCoreContext->GetNumSetting("CommDetectMinCommBreakLength", 60);
+    maxCommBreakLength =
+        gCoreContext->GetNumSetting("CommDetectMaxCommBreakLength", 395);
+    minShowLength =
+        gCoreContext->GetNumSetting("CommDetectMinShowLength", 65);
+}
+
+bool BitstreamCommDetector::go()
+{
+    aggressiveDetection =
+        gCoreContext->GetNumSetting("AggressiveCommDetect", 1);
+
+    emit statusUpdate(QObject::tr("Scanning bitstream"));
+    if (showProgress)
+        cerr << "\r  0%/          \r" << flush;
+
+    flagTime.start();
+    bool ok = player->ScanBitstream(frameStats, keyframeStep, &m_bStop,
+                                    scan_progress, this);
+
+    if (showProgress)
+        cerr << "\r                         \r" << flush;
+
+    if (!ok || m_bStop)
+        return false;
+
+    fps = player->GetFrameRate();
+    if (fps <= 0.0 || frameStats.empty())
+    {
+        LOG(VB_GENERAL, LOG_ERR,
+            "BitstreamCommDetector: no video frames found");
+        return false;
+    }
+
+    LOG(VB_COMMFLAG, LOG_INFO,
+        QString("BitstreamCommDetector: scanned %1 frames in %2 s")
+            .arg(frameStats.size()).arg(flagTime.elapsed() / 1000.0));
+
+    FindBlankFrames();
+    FindAudioChanges();
+    BuildCommBreakList();
+
+    emit gotNewCommercialBreakList();
+    return true;
+}
+
+void BitstreamCommDetector::ScanProgress(int percentage)
+{
+    emit breathe();
+
+    while (m_bPaused && !m_bStop)
+    {
+        emit breathe();
+        sleep(1);
+    }
+
+    float elapsed = flagTime.elapsed() / 1000.0;
+    float flagFPS = (elapsed > 0.0f) ? frameStats.size() / elapsed : 0.0f;
+
+    if (showProgress)
+    {
+        QString tmp = QString("\r%1%/%2fps  \r")
+            .arg(percentage, 3).arg((int)flagFPS, 4);
+        cerr << qPrintable(tmp) << flush;
+    }
+
+    if (percentage == prevPercent)
+        return;
+
+    emit statusUpdate(QObject::tr("%1% Completed @ %2 fps.")
+                      .arg(percentage).arg(flagFPS));
+
+    if (percentage % 10 == 0)
+    {
+        LOG(VB_GENERAL, LOG_INFO, QString("%1%% Completed @ %2 fps.")
+            .arg(percentage).arg(flagFPS));
+    }
+    prevPercent = percentage;
+}
+
+void BitstreamCommDetector::FindBlankFrames(void)
+{
+    const uint64_t count = frameStats.size();
+    vector<uint> keySizes, otherSizes;
+    uint64_t i, lastKey = 0, keyframes = 0;
+
+    for (i = 0; i < count; i++)
+    {
+        if (frameStats[i].keyframe)
+        {
+            keySizes.push_back(frameStats[i].size);
+            lastKey = i;
+            keyframes++;
+        }
+        else if (frameStats[i].size)
+        {
+            otherSizes.push_back(frameStats[i].size);
+        }
+    }
+
+    keyframeDist = (keyframes > 1) ? lastKey / (keyframes - 1) : 0;
+
+    // A blank picture costs next to nothing to code, so a keyframe that is
+    // far smaller than usual is blank, and so are the equally tiny frames
+    // coded against it.
+    uint64_t keyLimit   = (uint64_t)median(keySizes) * blankSizePercent / 100;
+    uint64_t otherLimit = (uint64_t)median(otherSizes) * blankSizePercent / 100;
+
+    blankRuns.clear();
+    for (i = 0; i < count; i++)
+    {
+        const BitstreamFrameStats &stats = frameStats[i];
+        if (!stats.keyframe)
+            continue;
+
+        bool blank;
+        if (stats.decoded)
+        {
+            blank = (stats.luma_max < darkBrightness) ||
+                    ((stats.luma_max < dimBrightness) &&
+                     (stats.luma_avg < dimAverage));
+        }
+        else
+        {
+            blank = stats.size < keyLimit;
+        }
+
+        if (!blank)
+            continue;
+
+        uint64_t first = i, last = i;
+        while (first > 0 && (i - first) < MAX_BLANK_FRAMES &&
+               !frameStats[first - 1].keyframe &&
+               frameStats[first - 1].size < otherLimit)
+        {
+            first--;
+        }
+        while (last + 1 < count && (last - i) < MAX_BLANK_FRAMES &&
+               !frameStats[last + 1].keyframe &&
+               frameStats[last + 1].size < otherLimit)
+        {
+            last++;
+        }
+
+        // Join runs that touch, such as blank keyframes a GOP apart
+        frame_range_map_t::iterator prev = blankRuns.upperBound(first);
+        if (prev != blankRuns.begin() && (*(--prev) + 1 >= first))
+            *prev = max(*prev, last);
+        else
+            blankRuns[first] = last;
+    }
+
+    LOG(VB_COMMFLAG, LOG_INFO,
+        QString("BitstreamCommDetector: %1 blank runs, keyframe every %2 "
+                "frames").arg(blankRuns.size()).arg(keyframeDist));
+}
+
+void BitstreamCommDetector::FindAudioChanges(void)
+{
+    const uint64_t count = frameStats.size();
+    uint64_t histogram[32];
+    uint64_t i;
+    int last = -1;
+
+    memset(histogram, 0, sizeof(histogram));
+    audioChanges.clear();
+    showDialnorm = -1;
+
+    for (i = 0; i < count; i++)
+    {
+        int dialnorm = frameStats[i].dialnorm;
+        if (dialnorm < 0 || dialnorm > 31)
+            continue;
+        histogram[dialnorm]++;
+        if (last >= 0 && dialnorm != last)
+            audioChanges[i] = dialnorm;
+        last = dialnorm;
+    }
+
+    for (int level = 0; level < 32; level++)
+    {
+        if (histogram[level] &&
+            (showDialnorm < 0 || histogram[level] > histogram[showDialnorm]))
+        {
+            showDialnorm = level;
+        }
+    }
+
+    LOG(VB_COMMFLAG, LOG_INFO,
+        QString("BitstreamCommDetector: %1 dialogue level changes, "
+                "show level -%2 dB")
+            .arg(audioChanges.size()).arg(showDialnorm));
+}
+
+bool BitstreamCommDetector::IsSpotLength(uint64_t frames) const
+{
+    static const int spots[] = { 5, 10, 15, 20, 30, 40, 45, 60, 90, 120 };
+
+    // Boundaries are only as precise as the keyframe spacing
+    double tolerance = fps * (aggressiveDetection ? 0.5 : 1.0);
+    tolerance = max(tolerance, (double)keyframeDist);
+
+    for (uint i = 0; i < sizeof(spots) / sizeof(spots[0]); i++)
+    {
+        if (fabs((double)frames - spots[i] * fps) <= tolerance)
+            return true;
+    }
+    return false;
+}
+
+bool BitstreamCommDetector::HasForeignAudio(uint64_t start,
+                                            uint64_t end) const
+{
+    if (audioChanges.isEmpty())
+        return false;
+
+    uint64_t known = 0, foreign = 0;
+    for (uint64_t i = start; i <= end && i < frameStats.size(); i++)
+    {
+        int dialnorm = frameStats[i].dialnorm;
+        if (dialnorm < 0)
+            continue;
+        known++;
+        if (dialnorm != showDialnorm)
+            foreign++;
+    }
+    return known && (foreign * 2 > known);
+}
+
+void BitstreamCommDetector::BuildCommBreakList(void)
+{
+    const uint64_t count = frameStats.size();
+    const uint64_t minBreak = (uint64_t)(minCommBreakLength * fps);
+    const uint64_t maxBreak = (uint64_t)(maxCommBreakLength * fps);
+    const uint64_t minShow  = (uint64_t)(minShowLength * fps);
+
+    // Every blank run and dialogue level change may start a new segment
+    QMap<uint64_t, bool> candidates;
+    candidates[0] = true;
+    candidates[count] = true;
+    frame_range_map_t::const_iterator bit = blankRuns.begin();
+    for (; bit != blankRuns.end(); ++bit)
+        candidates[bit.key()] = true;
+    QMap<uint64_t, int>::const_iterator ait = audioChanges.begin();
+    for (; ait != audioChanges.end(); ++ait)
+        candidates[ait.key()] = true;
+
+    vector<uint64_t> bounds;
+    QMap<uint64_t, bool>::const_iterator cit = candidates.begin();
+    for (; cit != candidates.end(); ++cit)
+    {
+        if (bounds.empty() || cit.key() == count ||
+            cit.key() - bounds.back() >= (uint64_t)(fps / 2))
+        {
+            bounds.push_back(cit.key());
+        }
+    }
+
+    // Runs of commercial length (or sounding like one) segments make breaks
+    frame_range_map_t breaks;
+    uint64_t breakStart = 0;
+    bool inBreak = false;
+    for (uint i = 0; i + 1 < bounds.size(); i++)
+    {
+        uint64_t start = bounds[i], end = bounds[i + 1] - 1;
+        bool comm = IsSpotLength(end - start + 1) ||
+                    HasForeignAudio(start, end);
+        if (comm && !inBreak)
+        {
+            breakStart = start;
+            inBreak = true;
+        }
+        else if (!comm && inBreak)
+        {
+            breaks[breakStart] = start - 1;
+            inBreak = false;
+        }
+    }
+    if (inBreak)
+        breaks[breakStart] = count - 1;
+
+    // Too short a show between two breaks is part of both
+    frame_range_map_t merged;
+    frame_range_map_t::iterator it = breaks.begin();
+    for (; it != breaks.end(); ++it)
+    {
+        frame_range_map_t::iterator prev = merged.end();
+        if (!merged.isEmpty())
+            --prev;
+        if (prev != merged.end() && it.key() - *prev < minShow &&
+            *it - prev.key() + 1 <= maxBreak)
+        {
+            *prev = *it;
+        }
+        else
+        {
+            merged[it.key()] = *it;
+        }
+    }
+
+    commBreakMap.clear();
+    for (it = merged.begin(); it != merged.end(); ++it)
+    {
+        uint64_t start = it.key(), end = *it, length = end - start + 1;
+        bool atEdge = (start == 0) || (end + 1 >= count);
+
+        if (length < minBreak && !atEdge)
+            continue;
+        if (length > maxBreak && !HasForeignAudio(start, end))
+            continue;
+
+        commBreakMap[start] = MARK_COMM_START;
+        commBreakMap[end]   = MARK_COMM_END;
+    }
+
+    LOG(VB_COMMFLAG, LOG_INFO,
+        QString("BitstreamCommDetector: %1 segments, %2 breaks")
+            .arg(bounds.size() - 1).arg(commBreakMap.size() / 2));
+}
+
+void BitstreamCommDetector::GetCommercialBreakList(frm_dir_map_t &comms)
+{
+    comms = commBreakMap;
+}
+
+void BitstreamCommDetector::PrintFullMap(
+    ostream &out, const frm_dir_map_t *comm_breaks, bool verbose) const
+{
+    if (verbose)
+        out << "  frame     size key luma_avg luma_max dialnorm mark" << endl;
+
+    for (uint64_t i = 0; i < frameStats.size(); i++)
+    {
+        const BitstreamFrameStats &stats = frameStats[i];
+        frm_dir_map_t::const_iterator mit = comm_breaks ?
+            comm_breaks->find(i) : frm_dir_map_t::const_iterator();
+        bool marked = comm_breaks && mit != comm_breaks->end();
+
+        if (!stats.keyframe && !marked)
+            continue;
+
+        QString line = QString("%1 %2 %3 %4 %5 %6 ")
+            .arg(i, 7).arg(stats.size, 8).arg(stats.keyframe ? 1 : 0, 3)
+            .arg(stats.decoded ? QString::number(stats.luma_avg) : "-", 8)
+            .arg(stats.decoded ? QString::number(stats.luma_max) : "-", 8)
+            .arg((int)stats.dialnorm, 8);
+        if (marked)
+        {
+            line += (verbose) ?
+                toString((MarkTypes)*mit) : QString::number(*mit);
+        }
+        out << line.toAscii().constData() << "\n";
+    }
+
+    out << flush;
+}
+
+/* vim: set expandtab tabstop=4 shiftwidth=4: */
@@ -0,0 +1,92 @@
+#ifndef _BITSTREAM_COMMDETECTOR_H_
+#define _BITSTREAM_COMMDETECTOR_H_
+
+// Qt headers
+#include <QObject>
+#include <QMap>
+#include <QTime>
+
+// MythTV headers
+#include "programinfo.h"
+#include "decoderbase.h"
+
+// Commercial Flagging headers
+#include "CommDetectorBase.h"
+
+class MythCommFlagPlayer;
+
+/** \class BitstreamCommDetector
+ *  \brief Flags commercials from what the bitstream says about each frame,
+ *         without decoding anything but keyframes.
+ *
+ *  Blank frames are found from the brightness of decoded keyframes and the
+ *  coded size of the frames around them, and AC-3 dialogue normalization
+ *  changes mark where differently produced material starts.  Breaks are
+ *  then built from the spacing of those boundaries, as with blank frame
+ *  detection in ClassicCommDetector.
+ *
+ *  CommDetectFastKeyframeStep trades accuracy for speed: every Nth keyframe
+ *  is decoded, and with 0 blank keyframes are only guessed from their size.
+ */
+class BitstreamCommDetector : public CommDetectorBase
+{
+    Q_OBJECT
+
+  public:
+    BitstreamCommDetector(SkipType commDetectMethod, bool showProgress,
+                          bool fullSpeed, MythCommFlagPlayer *player,
+                          const QDateTime &recordingStartedAt,
+                          const QDateTime &recordingStopsAt);
+
+    bool go();
+    void GetCommercialBreakList(frm_dir_map_t &comms);
+
+    void PrintFullMap(
+        ostream &out, const frm_dir_map_t *comm_breaks, bool verbose) const;
+
+    void ScanProgress(int percentage);
+
+  protected:
+    virtual ~BitstreamCommDetector() {}
+
+  private:
+    typedef QMap<uint64_t, uint64_t> frame_range_map_t;
+
+    void FindBlankFrames(void);
+    void FindAudioChanges(void);
+    void BuildCommBreakList(void);
+    bool IsSpotLength(uint64_t frames) const;
+    bool HasForeignAudio(uint64_t start, uint64_t end) const;
+
+    SkipType commDetectMethod;
+    bool showProgress;
+    bool fullSpeed;
+    MythCommFlagPlayer *player;
+    QDateTime recordingStartedAt;
+    QDateTime recordingStopsAt;
+
+    double fps;
+    uint64_t keyframeDist;
+    bool aggressiveDetection;
+    uint keyframeStep;
+    uint blankSizePercent;
+    int darkBrightness;
+    int dimBrightness;
+    int dimAverage;
+    int minCommBreakLength;
+    int maxCommBreakLength;
+    int minShowLength;
+
+    QTime flagTime;
+    int prevPercent;
+
+    bitstream_stats_t frameStats;
+    int showDialnorm;
+    frame_range_map_t blankRuns;        ///< first blank frame -> last
+    QMap<uint64_t, int> audioChanges;   ///< frame -> new dialnorm
+    frm_dir_map_t commBreakMap;
+};
+
+#endif
+
+/* vim: set expandtab tabstop=4 shiftwidth=4: */
@@ -12,12 +12,15 @@ using namespace std;
 
 // Qt headers
 #include <QString>
+#include <QThread>
+#include <QSemaphore>
 
 // MythTV headers
 #include "mythmiscutil.h"
 #include "mythcontext.h"
 #include "programinfo.h"
 #include "mythplayer.h"
+#include "mthread.h"
 
 // Commercial Flagging headers
 #include "ClassicCommDetector.h"
@@ -36,6 +39,73 @@ enum frameFormats {
     COMM_FORMAT_MAX
 } FrameFormats;
 
+/** \brief Checks frames for scene changes and the station logo while
+ *         ClassicCommDetector::ProcessFrame() looks for blank frames.
+ *
+ *  The frame is only read, and the scene change result is reported on the
+ *  flagging thread, so the frame info ends up the same as when everything
+ *  runs on one thread.
+ */
+class FrameCheckThread : public MThread
+{
+  public:
+    FrameCheckThread(SceneChangeDetectorBase *scd, LogoDetectorBase *ld) :
+        MThread("CommFlagCheck"), sceneChangeDetector(scd),
+        logoDetector(ld), frame(NULL), logoPresent(false), stopping(false)
+    {
+    }
+
+    ~FrameCheckThread()
+    {
+        stopping = true;
+        todo.release();
+        wait();
+    }
+
+    /// Starts checking a frame; it must not change until Result() returns.
+    void Check(unsigned char *framePtr)
+    {
+        frame = framePtr;
+        todo.release();
+    }
+
+    /// Waits for the checks to finish and returns whether the logo is there.
+    bool Result(void)
+    {
+        done.acquire();
+        return logoPresent;
+    }
+
+  protected:
+    virtual void run(void)
+    {
+        RunProlog();
+        while (true)
+        {
+            todo.acquire();
+            if (stopping)
+                break;
+
+            if (sceneChangeDetector)
+                sceneChangeDetector->analyzeFrame(frame);
+            logoPresent = logoDetector &&
+                logoDetector->doesThisFrameContainTheFoundLogo(frame);
+
+            done.release();
+        }
+        RunEpilog();
+    }
+
+  private:
+    SceneChangeDetectorBase *sceneChangeDetector;
+    LogoDetectorBase        *logoDetector;
+    unsigned char           *frame;
+    bool                     logoPresent;
+    volatile bool            stopping;
+    QSemaphore               todo;
+    QSemaphore               done;
+};
+
 static QString toStringFrameMaskValues(int mask, bool verbose)
 {
     QString msg;
@@ -142,7 +212,7 @@ ClassicCommDetector::ClassicCommDetector(SkipType commDetectMethod_in,
     sceneHasChanged(false),                    stationLogoPresent(false),
     lastFrameWasBlank(false),                  lastFrameWasSceneChange(false),
     decoderFoundAspectChanges(false),          sceneChangeDetector(0),
-    player(player_in),
+    frameCheckThread(0),                       player(player_in),
     startedAt(startedAt_in),                   stopsAt(stopsAt_in),
     recordingStartedAt(recordingStartedAt_in),
     recordingStopsAt(recordingStopsAt_in),     aggressiveDetection(false),
@@ -400,6 +470,23 @@ bool ClassicCommDetector::go()
 
     SetVideoParams(aspect);
 
+    /*
+     * With CPUs to spare, look for scene changes and the logo on a second
+     * thread while ProcessFrame() looks for blank frames.
+     */
+    int threads = gCoreContext->GetNumSetting("CommDetectThreads", 0);
+    if (threads <= 0)
+        threads = QThread::idealThreadCount();
+    bool checkScene = commDetectMethod & COMM_DETECT_SCENE;
+    bool checkLogo = logoInfoAvailable && (commDetectMethod & COMM_DETECT_LOGO);
+    if (fullSpeed && threads > 1 && (checkScene || checkLogo))
+    {
+        frameCheckThread = new FrameCheckThread(
+            checkScene ? sceneChangeDetector : NULL,
+            checkLogo ? logoDetector : NULL);
+        frameCheckThread->start();
+    }
+
     emit breathe();
 
     player->ResetTotalDuration();
@@ -432,6 +519,8 @@ bool ClassicCommDetector::go()
             if (m_bStop)
             {
                 player->DiscardVideoFrame(currentFrame);
+                delete frameCheckThread;
+                frameCheckThread = NULL;
                 return false;
             }
         }
@@ -572,6 +661,9 @@ bool ClassicCommDetector::go()
         player->DiscardVideoFrame(currentFrame);
     }
 
+    delete frameCheckThread;
+    frameCheckThread = NULL;
+
     if (showProgress)
     {
         float elapsed = flagTime.elapsed() / 1000.0;
@@ -806,10 +898,10 @@ void ClassicCommDetector::ProcessFrame(VideoFrame *frame,
     if (commDetectMethod & COMM_DETECT_BLANKS)
         frameIsBlank = false;
 
-    if (commDetectMethod & COMM_DETECT_SCENE)
-    {
+    if (frameCheckThread)
+        frameCheckThread->Check(framePtr);
+    else if (commDetectMethod & COMM_DETECT_SCENE)
         sceneChangeDetector->processFrame(framePtr);
-    }
 
     stationLogoPresent = false;
 
@@ -935,7 +1027,15 @@ void ClassicCommDetector::ProcessFrame(VideoFrame *frame,
             frameIsBlank = true;
     }
 
-    if ((logoInfoAvailable) && (commDetectMethod & COMM_DETECT_LOGO))
+    if (frameCheckThread)
+    {
+        // The scene change only touches the frame's scene change flag and
+        // percentage, so reporting it this late changes nothing.
+        stationLogoPresent = frameCheckThread->Result();
+        if (commDetectMethod & COMM_DETECT_SCENE)
+            sceneChangeDetector->reportFrame();
+    }
+    else if ((logoInfoAvailable) && (commDetectMethod & COMM_DETECT_LOGO))
     {
         stationLogoPresent =
             logoDetector->doesThisFrameContainTheFoundLogo(framePtr);
@@ -19,6 +19,7 @@
 class MythPlayer;
 class LogoDetectorBase;
 class SceneChangeDetectorBase;
+class FrameCheckThread;
 
 enum frameMaskValues {
     COMM_FRAME_SKIPPED       = 0x0001,
@@ -172,6 +173,7 @@ class ClassicCommDetector : public CommDetectorBase
         bool decoderFoundAspectChanges;
 
         SceneChangeDetectorBase* sceneChangeDetector;
+        FrameCheckThread* frameCheckThread;
 
 protected:
         MythPlayer *player;
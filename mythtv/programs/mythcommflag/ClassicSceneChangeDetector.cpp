@@ -10,6 +10,7 @@ ClassicSceneChangeDetector::ClassicSceneChangeDetector(unsigned int width,
     SceneChangeDetectorBase(width,height),
     frameNumber(0),
     previousFrameWasSceneChange(false),
+    similarity(0.0f),
     xspacing(xspacing_in),
     yspacing(yspacing_in),
     commdetectborder(commdetectborder_in)
@@ -25,16 +26,19 @@ void ClassicSceneChangeDetector::deleteLater(void)
     SceneChangeDetectorBase::deleteLater();
 }
 
-void ClassicSceneChangeDetector::processFrame(unsigned char* frame)
+void ClassicSceneChangeDetector::analyzeFrame(unsigned char* frame)
 {
     histogram->generateFromImage(frame, width, height, commdetectborder,
                                  width-commdetectborder, commdetectborder,
                                  height-commdetectborder, xspacing, yspacing);
-    float similar = histogram->calculateSimilarityWith(*previousHistogram);
+    similarity = histogram->calculateSimilarityWith(*previousHistogram);
+}
 
-    bool isSceneChange = (similar < .85 && !previousFrameWasSceneChange);
+void ClassicSceneChangeDetector::reportFrame(void)
+{
+    bool isSceneChange = (similarity < .85 && !previousFrameWasSceneChange);
 
-    emit(haveNewInformation(frameNumber,isSceneChange,similar));
+    emit(haveNewInformation(frameNumber,isSceneChange,similarity));
     previousFrameWasSceneChange = isSceneChange;
 
     std::swap(histogram,previousHistogram);
@@ -13,7 +13,8 @@ class ClassicSceneChangeDetector : public SceneChangeDetectorBase
         unsigned int yspacing);
     virtual void deleteLater(void);
 
-    void processFrame(unsigned char* frame);
+    void analyzeFrame(unsigned char* frame);
+    void reportFrame(void);
 
   private:
     ~ClassicSceneChangeDetector() {}
@@ -23,6 +24,7 @@ class ClassicSceneChangeDetector : public SceneChangeDetectorBase
     Histogram* previousHistogram;
     unsigned int frameNumber;
     bool previousFrameWasSceneChange;
+    float similarity;
     unsigned int xspacing, yspacing;
     unsigned int commdetectborder;
 };
@@ -12,11 +12,16 @@ using namespace std;
 // Qt headers
 #include <QDir>
 #include <QFileInfo>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
 
 // MythTV headers
 #include "compat.h"
 #include "mythdb.h"
+#include "mythcorecontext.h"
 #include "mythlogging.h"
+#include "mthread.h"
 #include "mythplayer.h"
 #include "programinfo.h"
 #include "channelutil.h"
@@ -193,6 +198,281 @@ bool searchingForLogo(TemplateFinder *tf, const FrameAnalyzerItem &pass)
     return it != pass.end();
 }
 
+/*
+ * Number of decoded frames that can be waiting for the analyzer threads. The
+ * player reuses its buffers as soon as a frame is discarded, so every queued
+ * frame is a private copy.
+ */
+const int kPipelineDepth = 8;
+
+/*
+ * Bounded queue of frames shared by the analyzer threads of one pass. Each
+ * thread sees every frame, in order, and a slot is reused once every thread
+ * still analyzing has released it.
+ */
+class FrameQueue
+{
+public:
+    FrameQueue(int nslots, int nconsumers);
+    ~FrameQueue();
+
+    bool push(const VideoFrame *frame);
+    const VideoFrame *peek(long long seq);
+    void release(long long seq);
+    long long retire(void);
+    bool active(void);
+    void waitForIdle(void);
+    void close(void);
+
+private:
+    struct Slot
+    {
+        VideoFrame      frame;
+        int             bufsize;
+        int             pending;            /* threads yet to release it */
+    };
+
+    QMutex              lock;
+    QWaitCondition      cond;
+    vector<Slot>        slots;
+    long long           head;               /* frames pushed so far */
+    int                 busy;               /* slots not yet released */
+    int                 consumers;          /* threads still analyzing */
+    bool                closed;
+};
+
+FrameQueue::FrameQueue(int nslots, int nconsumers)
+    : slots(nslots), head(0), busy(0), consumers(nconsumers), closed(false)
+{
+    for (unsigned int ii = 0; ii < slots.size(); ii++)
+    {
+        memset(&slots[ii].frame, 0, sizeof(slots[ii].frame));
+        slots[ii].bufsize = 0;
+        slots[ii].pending = 0;
+    }
+}
+
+FrameQueue::~FrameQueue()
+{
+    for (unsigned int ii = 0; ii < slots.size(); ii++)
+        av_free(slots[ii].frame.buf);
+}
+
+/* Copy a frame into the queue, waiting for a free slot. */
+bool FrameQueue::push(const VideoFrame *frame)
+{
+    QMutexLocker locker(&lock);
+
+    Slot &slot = slots[head % slots.size()];
+    while (slot.pending && consumers)
+        cond.wait(&lock);
+    if (!consumers)
+        return false;
+
+    /* The slot is ours until head moves past it. */
+    locker.unlock();
+
+    unsigned char *buf = slot.frame.buf;
+    if (slot.bufsize < frame->size)
+    {
+        av_free(buf);
+        buf = (unsigned char *)av_malloc(frame->size);
+        if (!buf)
+        {
+            LOG(VB_COMMFLAG, LOG_ERR, "FrameQueue::push out of memory");
+            slot.frame.buf = NULL;
+            slot.bufsize = 0;
+            return false;
+        }
+        slot.bufsize = frame->size;
+    }
+    slot.frame = *frame;
+    slot.frame.buf = buf;
+    memcpy(buf, frame->buf, frame->size);
+
+    locker.relock();
+    slot.pending = consumers;
+    busy++;
+    head++;
+    cond.wakeAll();
+    return true;
+}
+
+/* Return frame "seq", or NULL once the queue is closed and drained. */
+const VideoFrame *FrameQueue::peek(long long seq)
+{
+    QMutexLocker locker(&lock);
+    while (seq >= head && !closed)
+        cond.wait(&lock);
+    if (seq >= head)
+        return NULL;
+    return &slots[seq % slots.size()].frame;
+}
+
+void FrameQueue::release(long long seq)
+{
+    QMutexLocker locker(&lock);
+    Slot &slot = slots[seq % slots.size()];
+    if (--slot.pending == 0)
+    {
+        busy--;
+        cond.wakeAll();
+    }
+}
+
+/*
+ * Called by a thread with no analyzers left. Frames pushed from now on are
+ * not meant for it; it still has to release those already queued, which are
+ * the ones before the returned sequence number.
+ */
+long long FrameQueue::retire(void)
+{
+    QMutexLocker locker(&lock);
+    consumers--;
+    cond.wakeAll();
+    return head;
+}
+
+bool FrameQueue::active(void)
+{
+    QMutexLocker locker(&lock);
+    return consumers > 0;
+}
+
+/* Wait until every queued frame has been analyzed. */
+void FrameQueue::waitForIdle(void)
+{
+    QMutexLocker locker(&lock);
+    while (busy)
+        cond.wait(&lock);
+}
+
+void FrameQueue::close(void)
+{
+    QMutexLocker locker(&lock);
+    closed = true;
+    cond.wakeAll();
+}
+
+/*
+ * Runs a group of analyzers over every frame of the queue. The analyzers of
+ * a group share per-frame state, the groups share none.
+ */
+class AnalyzerThread : public MThread
+{
+public:
+    AnalyzerThread(FrameQueue *q, const FrameAnalyzerItem &group)
+        : MThread("CommFlagAnalyzer"), analyzers(group), queue(q) { }
+    ~AnalyzerThread() { wait(); }
+
+    FrameAnalyzerItem       analyzers;
+    FrameAnalyzerItem       finishedAnalyzers;
+
+protected:
+    virtual void run(void);
+
+private:
+    FrameQueue              *queue;
+};
+
+void AnalyzerThread::run(void)
+{
+    RunProlog();
+
+    FrameAnalyzerItem deadAnalyzers;
+    const VideoFrame *frame;
+    long long seq = 0;
+
+    while (!analyzers.empty() && (frame = queue->peek(seq)))
+    {
+        (void)processFrame(analyzers, finishedAnalyzers, deadAnalyzers,
+                           frame, frame->frameNumber);
+        queue->release(seq++);
+    }
+
+    if (analyzers.empty())
+    {
+        long long last = queue->retire();
+        for (; seq < last; seq++)
+            queue->release(seq);
+    }
+
+    RunEpilog();
+}
+
+/*
+ * Analyzes the frames of one pass on one thread per group of analyzers,
+ * while the calling thread keeps fetching frames from the player. Every
+ * analyzer sees the same frames, in the same order, as it would when the
+ * pass is run serially.
+ */
+class FramePipeline
+{
+public:
+    FramePipeline(const FrameAnalyzerItem &pass,
+                  const vector<FrameAnalyzerItem> &groups);
+    ~FramePipeline();
+
+    bool push(const VideoFrame *frame) { return queue.push(frame); }
+    bool active(void) { return queue.active(); }
+    void collect(FrameAnalyzerItem &pass, FrameAnalyzerItem &finished);
+
+private:
+    FrameAnalyzerItem           order;
+    FrameQueue                  queue;
+    vector<AnalyzerThread*>     threads;
+};
+
+FramePipeline::FramePipeline(const FrameAnalyzerItem &pass,
+                             const vector<FrameAnalyzerItem> &groups)
+    : order(pass), queue(kPipelineDepth, groups.size())
+{
+    for (unsigned int ii = 0; ii < groups.size(); ii++)
+    {
+        threads.push_back(new AnalyzerThread(&queue, groups[ii]));
+        threads.back()->start();
+    }
+}
+
+FramePipeline::~FramePipeline()
+{
+    queue.close();
+    for (unsigned int ii = 0; ii < threads.size(); ii++)
+        delete threads[ii];
+}
+
+/*
+ * Wait for the queued frames to be analyzed and report which analyzers are
+ * still running and which have finished, in the order of the serial pass.
+ */
+void FramePipeline::collect(FrameAnalyzerItem &pass,
+                            FrameAnalyzerItem &finished)
+{
+    queue.waitForIdle();
+
+    pass.clear();
+    finished.clear();
+    for (FrameAnalyzerItem::const_iterator it = order.begin();
+         it != order.end(); ++it)
+    {
+        for (unsigned int ii = 0; ii < threads.size(); ii++)
+        {
+            const AnalyzerThread *thread = threads[ii];
+            if (std::find(thread->analyzers.begin(), thread->analyzers.end(),
+                          *it) != thread->analyzers.end())
+            {
+                pass.push_back(*it);
+            }
+            else if (std::find(thread->finishedAnalyzers.begin(),
+                               thread->finishedAnalyzers.end(),
+                               *it) != thread->finishedAnalyzers.end())
+            {
+                finished.push_back(*it);
+            }
+        }
+    }
+}
+
 };  // namespace
 
 namespace commDetector2 {
@@ -323,7 +603,7 @@ CommDetector2::CommDetector2(
     finished(false),                currentFrameNumber(0),
     logoFinder(NULL),               logoMatcher(NULL),
     blankFrameDetector(NULL),       sceneChangeDetector(NULL),
-    debugdir("")
+    debugdir(""),                   analysisThreads(1)
 {
     FrameAnalyzerItem        pass0, pass1;
     PGMConverter            *pgmConverter = NULL;
@@ -333,6 +613,20 @@ CommDetector2::CommDetector2(
     if (useDB)
         debugdir = debugDirectory(chanid, recstartts);
 
+    /*
+     * Number of threads analyzing frames when a pass can be pipelined (see
+     * CommDetector2::go); 0 means one per CPU.
+     */
+    analysisThreads = gCoreContext->GetNumSetting("CommDetectThreads", 0);
+    if (analysisThreads <= 0)
+        analysisThreads = QThread::idealThreadCount();
+
+    /*
+     * The analyzers of a pipelined pass share one PGMConverter, which then
+     * keeps the images of every frame that may still be queued.
+     */
+    int pgmImages = analysisThreads > 1 ? kPipelineDepth : 1;
+
     /*
      * Look for blank frames to use as delimiters between commercial and
      * non-commercial segments.
@@ -340,7 +634,7 @@ CommDetector2::CommDetector2(
     if ((commDetectMethod & COMM_DETECT_2_BLANK))
     {
         if (!pgmConverter)
-            pgmConverter = new PGMConverter();
+            pgmConverter = new PGMConverter(pgmImages);
 
         if (!borderDetector)
             borderDetector = new BorderDetector();
@@ -366,7 +660,7 @@ CommDetector2::CommDetector2(
     if ((commDetectMethod & COMM_DETECT_2_SCENE))
     {
         if (!pgmConverter)
-            pgmConverter = new PGMConverter();
+            pgmConverter = new PGMConverter(pgmImages);
 
         if (!borderDetector)
             borderDetector = new BorderDetector();
@@ -396,7 +690,7 @@ CommDetector2::CommDetector2(
         CannyEdgeDetector       *cannyEdgeDetector = NULL;
 
         if (!pgmConverter)
-            pgmConverter = new PGMConverter();
+            pgmConverter = new PGMConverter(pgmImages);
 
         if (!borderDetector)
             borderDetector = new BorderDetector();
@@ -414,8 +708,8 @@ CommDetector2::CommDetector2(
 
         if (!logoMatcher)
         {
-            logoMatcher = new TemplateMatcher(pgmConverter, cannyEdgeDetector,
-                    logoFinder, debugdir);
+            logoMatcher = new TemplateMatcher(pgmConverter,
+                    cannyEdgeDetector, logoFinder, debugdir);
             pass1.push_back(logoMatcher);
         }
     }
@@ -520,6 +814,49 @@ int CommDetector2::computeBreaks(long long nframes)
     return 0;
 }
 
+/*
+ * Split a pass into groups of analyzers that can run on separate threads,
+ * or return no groups if the pass has to run serially.
+ */
+vector<FrameAnalyzerItem> CommDetector2::pipelineGroups(
+        const FrameAnalyzerItem &pass) const
+{
+    vector<FrameAnalyzerItem> groups;
+
+    /*
+     * The TemplateFinder skips frames, and the next frame of a pass depends
+     * on what every analyzer asks for. The other analyzers want every frame,
+     * so the frames can be fetched ahead of the analysis.
+     */
+    if (analysisThreads < 2 || searchingForLogo(logoFinder, pass))
+        return groups;
+
+    /* The blank frame and scene change detectors share a HistogramAnalyzer. */
+    FrameAnalyzerItem histogramUsers;
+    FrameAnalyzerItem::const_iterator it = pass.begin();
+    for (; it != pass.end(); ++it)
+    {
+        if (*it == blankFrameDetector || *it == sceneChangeDetector)
+            histogramUsers.push_back(*it);
+        else
+            groups.push_back(FrameAnalyzerItem(1, *it));
+    }
+    if (!histogramUsers.empty())
+        groups.insert(groups.begin(), histogramUsers);
+
+    while ((int)groups.size() > analysisThreads)
+    {
+        FrameAnalyzerItem &last = groups[groups.size() - 2];
+        last.insert(last.end(), groups.back().begin(), groups.back().end());
+        groups.pop_back();
+    }
+
+    if (groups.size() < 2)
+        groups.clear();
+
+    return groups;
+}
+
 bool CommDetector2::go(void)
 {
     int minlag = 7; // seconds
@@ -576,6 +913,23 @@ bool CommDetector2::go(void)
             return false;
         }
 
+        /*
+         * Once the recording is complete and we may use the whole CPU, run
+         * the analyzers of this pass on threads of their own.
+         */
+        FramePipeline *pipeline = NULL;
+        if (postprocessing && fullSpeed)
+        {
+            vector<FrameAnalyzerItem> groups = pipelineGroups(*currentPass);
+            if (!groups.empty())
+            {
+                LOG(VB_COMMFLAG, LOG_INFO,
+                    QString("CommDetector2::go analyzing on %1 threads")
+                        .arg(groups.size()));
+                pipeline = new FramePipeline(*currentPass, groups);
+            }
+        }
+
         player->DiscardVideoFrame(player->GetRawVideoFrame(0));
         long long nextFrame = -1;
         currentFrameNumber = 0;
@@ -591,7 +945,8 @@ bool CommDetector2::go(void)
         clock.start();
         passTime.start();
         memset(&getframetime, 0, sizeof(getframetime));
-        while (!(*currentPass).empty() && !player->GetEof())
+        while ((pipeline ? pipeline->active() : !(*currentPass).empty()) &&
+               !player->GetEof())
         {
             struct timeval start, end, elapsedtv;
 
@@ -621,6 +976,7 @@ bool CommDetector2::go(void)
                 if (m_bStop)
                 {
                     player->DiscardVideoFrame(currentFrame);
+                    delete pipeline;
                     return false;
                 }
             }
@@ -639,9 +995,25 @@ bool CommDetector2::go(void)
                         nframes, passno, npasses);
             }
 
-            nextFrame = processFrame(
-                *currentPass, finishedAnalyzers,
-                deadAnalyzers, currentFrame, currentFrameNumber);
+            if (pipeline)
+            {
+                /* Every analyzer of a pipelined pass wants the next frame. */
+                if (!pipeline->push(currentFrame) && pipeline->active())
+                {
+                    LOG(VB_COMMFLAG, LOG_ERR, QString("CommDetector2::go "
+                        "could not queue frame %1").arg(currentFrameNumber));
+                    player->DiscardVideoFrame(currentFrame);
+                    delete pipeline;
+                    return false;
+                }
+                nextFrame = currentFrameNumber + 1;
+            }
+            else
+            {
+                nextFrame = processFrame(
+                    *currentPass, finishedAnalyzers,
+                    deadAnalyzers, currentFrame, currentFrameNumber);
+            }
 
             if (((currentFrameNumber >= 1) &&
                  (((nextFrame * 10) / nframes) !=
@@ -677,6 +1049,9 @@ bool CommDetector2::go(void)
             {
                 frm_dir_map_t breakMap;
 
+                if (pipeline)
+                    pipeline->collect(*currentPass, finishedAnalyzers);
+
                 GetCommercialBreakList(breakMap);
 
                 frm_dir_map_t::const_iterator ii, jj;
@@ -703,6 +1078,12 @@ bool CommDetector2::go(void)
             player->DiscardVideoFrame(currentFrame);
         }
 
+        if (pipeline)
+        {
+            pipeline->collect(*currentPass, finishedAnalyzers);
+            delete pipeline;
+        }
+
         // Save total duration only on the last pass, which hopefully does
         // no skipping.
         if (passno + 1 == npasses)
@@ -55,6 +55,8 @@ class CommDetector2 : public CommDetectorBase
     void reportState(int elapsed_sec, long long frameno, long long nframes,
             unsigned int passno, unsigned int npasses);
     int computeBreaks(long long nframes);
+    vector<FrameAnalyzerItem> pipelineGroups(
+            const FrameAnalyzerItem &pass) const;
 
   private:
     enum SkipTypes          commDetectMethod;
@@ -81,6 +83,7 @@ class CommDetector2 : public CommDetectorBase
     SceneChangeDetector     *sceneChangeDetector;
 
     QString                 debugdir;
+    int                     analysisThreads;
 };
 
 #endif  /* !_COMMDETECTOR2_H_ */
@@ -2,6 +2,8 @@
 #include "ClassicCommDetector.h"
 #include "CommDetector2.h"
 #include "PrePostRollFlagger.h"
+#include "BitstreamCommDetector.h"
+#include "mythcommflagplayer.h"
 
 class MythPlayer;
 class RemoteEncoder;
@@ -25,6 +27,14 @@ CommDetectorFactory::makeCommDetector(
                                       recordingStartedAt, recordingStopsAt);
     }
 
+    MythCommFlagPlayer *cfp = dynamic_cast<MythCommFlagPlayer*>(player);
+    if ((commDetectMethod & COMM_DETECT_FAST) && cfp)
+    {
+        return new BitstreamCommDetector(commDetectMethod, showProgress,
+                                         fullSpeed, cfp, recordingStartedAt,
+                                         recordingStopsAt);
+    }
+
     if ((commDetectMethod & COMM_DETECT_2))
     {
         return new CommDetector2(
@@ -1,5 +1,6 @@
 // ANSI C headers
 #include <cstdlib>
+#include <cstring>
 
 // C++ headers
 #include <algorithm>
@@ -7,6 +8,13 @@ using namespace std;
 
 #include "mythconfig.h"
 
+#if defined(__SSE2__) && defined(__SSE2_MATH__)
+#include <emmintrin.h>
+#define EDGE_SSE2 1
+#else
+#define EDGE_SSE2 0
+#endif
+
 // avlib/ffmpeg headers
 extern "C" {
 #include "libavcodec/avcodec.h"        // AVPicture
@@ -17,6 +25,7 @@ extern "C" {
 #include "mythplayer.h"
 
 // Commercial Flagging headers
+#include "pgm.h"
 #include "FrameAnalyzer.h"
 #include "EdgeDetector.h"
 
@@ -24,6 +33,67 @@ namespace edgeDetector {
 
 using namespace frameAnalyzer;
 
+static void
+exclude_span(int rr, int width, int excluderow, int excludecol,
+        int excludewidth, int excludeheight, int *x0, int *x1)
+{
+    /*
+     * The columns [x0, x1) of row "rr" that are inside the exclusion
+     * rectangle (rrccinrect), clipped to [0, width).
+     */
+    if (rr < excluderow || rr >= excluderow + excludeheight)
+    {
+        *x0 = *x1 = width;
+        return;
+    }
+    *x0 = min(max(excludecol, 0), width);
+    *x1 = min(max(excludecol + excludewidth, *x0), width);
+}
+
+static void
+sgm_line(unsigned int *sgm, const unsigned char *rr0,
+        const unsigned char *rr1, int count)
+{
+    int             cc, dx, dy;
+
+    for (cc = 0; cc < count; cc++)
+    {
+        dx = rr1[cc + 1] - rr0[cc];     /* southeast - northwest */
+        dy = rr1[cc] - rr0[cc + 1];     /* southwest - northeast */
+        sgm[cc] = dx * dx + dy * dy;
+    }
+}
+
+#if EDGE_SSE2
+static void
+sgm_line_sse2(unsigned int *sgm, const unsigned char *rr0,
+        const unsigned char *rr1, int count)
+{
+    /* Eight pixels at a time; dx * dx + dy * dy is a single pmaddwd. */
+    const __m128i   zero = _mm_setzero_si128();
+    int             cc;
+
+    for (cc = 0; cc + 8 <= count; cc += 8)
+    {
+        __m128i nw = _mm_unpacklo_epi8(
+                _mm_loadl_epi64((const __m128i *)(rr0 + cc)), zero);
+        __m128i ne = _mm_unpacklo_epi8(
+                _mm_loadl_epi64((const __m128i *)(rr0 + cc + 1)), zero);
+        __m128i sw = _mm_unpacklo_epi8(
+                _mm_loadl_epi64((const __m128i *)(rr1 + cc)), zero);
+        __m128i se = _mm_unpacklo_epi8(
+                _mm_loadl_epi64((const __m128i *)(rr1 + cc + 1)), zero);
+        __m128i dx = _mm_sub_epi16(se, nw);
+        __m128i dy = _mm_sub_epi16(sw, ne);
+        __m128i lo = _mm_unpacklo_epi16(dx, dy);
+        __m128i hi = _mm_unpackhi_epi16(dx, dy);
+        _mm_storeu_si128((__m128i *)(sgm + cc), _mm_madd_epi16(lo, lo));
+        _mm_storeu_si128((__m128i *)(sgm + cc + 4), _mm_madd_epi16(hi, hi));
+    }
+    sgm_line(sgm + cc, rr0 + cc, rr1 + cc, count - cc);
+}
+#endif /* EDGE_SSE2 */
+
 unsigned int *
 sgm_init_exclude(unsigned int *sgm, const AVPicture *src, int srcheight,
         int excluderow, int excludecol, int excludewidth, int excludeheight)
@@ -36,26 +106,28 @@ sgm_init_exclude(unsigned int *sgm, const AVPicture *src, int srcheight,
      * that pixel: how much it differs from its neighbors.
      */
     const int       srcwidth = src->linesize[0];
-    int             rr, cc, dx, dy, rr2, cc2;
+    int             rr, rr2, cc2, x0, x1;
     unsigned char   *rr0, *rr1;
+    void            (*line)(unsigned int *, const unsigned char *,
+                            const unsigned char *, int);
+
+    line = sgm_line;
+#if EDGE_SSE2
+    if (pgm_use_sse2())
+        line = sgm_line_sse2;
+#endif
 
     memset(sgm, 0, srcwidth * srcheight * sizeof(*sgm));
     rr2 = srcheight - 1;
     cc2 = srcwidth - 1;
     for (rr = 0; rr < rr2; rr++)
     {
-        for (cc = 0; cc < cc2; cc++)
-        {
-            if (!rrccinrect(rr, cc, excluderow, excludecol,
-                        excludewidth, excludeheight))
-            {
-                rr0 = &src->data[0][rr * srcwidth + cc];
-                rr1 = &src->data[0][(rr + 1) * srcwidth + cc];
-                dx = rr1[1] - rr0[0];   /* southeast - northwest */
-                dy = rr1[0] - rr0[1];   /* southwest - northeast */
-                sgm[rr * srcwidth + cc] = dx * dx + dy * dy;
-            }
-        }
+        rr0 = &src->data[0][rr * srcwidth];
+        rr1 = &src->data[0][(rr + 1) * srcwidth];
+        exclude_span(rr, cc2, excluderow, excludecol,
+                excludewidth, excludeheight, &x0, &x1);
+        line(sgm + rr * srcwidth, rr0, rr1, x0);
+        line(sgm + rr * srcwidth + x1, rr0 + x1, rr1 + x1, cc2 - x1);
     }
     return sgm;
 }
@@ -68,11 +140,48 @@ sgm_init(unsigned int *sgm, const AVPicture *src, int srcheight)
 }
 #endif /* LATER */
 
-static int sort_ascending(const void *aa, const void *bb)
+static void
+mark_line(unsigned char *dst, const unsigned int *sgm, int count,
+        unsigned int thresholdval)
 {
-    return *(unsigned int*)aa - *(unsigned int*)bb;
+    int             cc;
+
+    for (cc = 0; cc < count; cc++)
+    {
+        if (sgm[cc] >= thresholdval)
+            dst[cc] = UCHAR_MAX;
+    }
 }
 
+#if EDGE_SSE2
+static void
+mark_line_sse2(unsigned char *dst, const unsigned int *sgm, int count,
+        unsigned int thresholdval)
+{
+    /*
+     * SGM values are at most 2 * 255 * 255, so a signed compare against
+     * thresholdval - 1 is safe, and the saturating packs turn the all-ones
+     * compare results into UCHAR_MAX bytes.
+     */
+    const __m128i   below = _mm_set1_epi32((int)thresholdval - 1);
+    int             cc;
+
+    for (cc = 0; cc + 16 <= count; cc += 16)
+    {
+        const __m128i *in = (const __m128i *)(sgm + cc);
+        __m128i m0 = _mm_cmpgt_epi32(_mm_loadu_si128(in + 0), below);
+        __m128i m1 = _mm_cmpgt_epi32(_mm_loadu_si128(in + 1), below);
+        __m128i m2 = _mm_cmpgt_epi32(_mm_loadu_si128(in + 2), below);
+        __m128i m3 = _mm_cmpgt_epi32(_mm_loadu_si128(in + 3), below);
+        __m128i mm = _mm_packs_epi16(_mm_packs_epi32(m0, m1),
+                _mm_packs_epi32(m2, m3));
+        __m128i *out = (__m128i *)(dst + cc);
+        _mm_storeu_si128(out, _mm_or_si128(_mm_loadu_si128(out), mm));
+    }
+    mark_line(dst + cc, sgm + cc, count - cc, thresholdval);
+}
+#endif /* EDGE_SSE2 */
+
 static int
 edge_mark(AVPicture *dst, int dstheight,
         int extratop, int extraright, int extrabottom, int extraleft,
@@ -91,39 +200,40 @@ edge_mark(AVPicture *dst, int dstheight,
 
     const int           dstwidth = dst->linesize[0];
     const int           padded_width = extraleft + dstwidth + extraright;
-    unsigned int        thresholdval;
-    int                 nn, dstnn, ii, rr, cc, first, last, last2;
+    unsigned int        thresholdval, newthresholdval, val;
+    int                 nn, dstnn, ii, rr, x0, x1, first;
+    const unsigned int  *sgmrow;
+    void                (*mark)(unsigned char *, const unsigned int *, int,
+                                unsigned int);
 
     (void)extrabottom;  /* gcc */
 
+    mark = mark_line;
+#if EDGE_SSE2
+    if (pgm_use_sse2())
+        mark = mark_line_sse2;
+#endif
+
     /*
      * sgm: SGM values of padded (convolved) image
      *
-     * sgmsorted: sorted SGM values of unexcluded areas of unpadded image (same
-     * dimensions as "dst").
+     * sgmsorted: SGM values of unexcluded areas of unpadded image (same
+     * dimensions as "dst"), partitioned around the percentile.
      */
     nn = 0;
     for (rr = 0; rr < dstheight; rr++)
     {
-        for (cc = 0; cc < dstwidth; cc++)
-        {
-            if (!rrccinrect(rr, cc, excluderow, excludecol,
-                        excludewidth, excludeheight))
-            {
-                sgmsorted[nn++] = sgm[(extratop + rr) * padded_width +
-                    extraleft + cc];
-            }
-        }
+        sgmrow = sgm + (extratop + rr) * padded_width + extraleft;
+        exclude_span(rr, dstwidth, excluderow, excludecol,
+                excludewidth, excludeheight, &x0, &x1);
+        memcpy(sgmsorted + nn, sgmrow, x0 * sizeof(*sgmsorted));
+        nn += x0;
+        memcpy(sgmsorted + nn, sgmrow + x1,
+                (dstwidth - x1) * sizeof(*sgmsorted));
+        nn += dstwidth - x1;
     }
 
     dstnn = dstwidth * dstheight;
-#if 0
-    assert(nn == dstnn -
-            (min(max(0, excluderow + excludeheight), dstheight) -
-                min(max(0, excluderow), dstheight)) *
-            (min(max(0, excludecol + excludewidth), dstwidth) -
-                min(max(0, excludecol), dstwidth)));
-#endif
     memset(dst->data[0], 0, dstnn * sizeof(*dst->data[0]));
 
     if (!nn)
@@ -132,29 +242,36 @@ edge_mark(AVPicture *dst, int dstheight,
             return 0;
     }
 
-    qsort(sgmsorted, nn, sizeof(*sgmsorted), sort_ascending);
-
-    ii = percentile * nn / 100;
+    /*
+     * Only the percentile value and its neighbours in sorted order are
+     * needed, so select rather than sort.
+     */
+    ii = min(percentile * nn / 100, nn - 1);
+    nth_element(sgmsorted, sgmsorted + ii, sgmsorted + nn);
     thresholdval = sgmsorted[ii];
 
+    /*
+     * "first" is where the run of thresholdval would start in the sorted
+     * values; newthresholdval is the next unique value after it, if any.
+     */
+    first = 0;
+    newthresholdval = thresholdval;
+    for (ii = 0; ii < nn; ii++)
+    {
+        val = sgmsorted[ii];
+        if (val < thresholdval)
+            first++;
+        else if (val > thresholdval &&
+                (newthresholdval == thresholdval || val < newthresholdval))
+            newthresholdval = val;
+    }
+
     /*
      * Try not to pick up too many edges, and eliminate degenerate edge-less
      * cases.
      */
-    for (first = ii; first > 0 && sgmsorted[first] == thresholdval; first--) ;
-    if (sgmsorted[first] != thresholdval)
-        first++;
     if (first * 100 / nn < MINTHRESHOLDPCT)
     {
-        unsigned int    newthresholdval;
-
-        last2 = nn - 1;
-        for (last = ii; last < last2 && sgmsorted[last] == thresholdval;
-                last++) ;
-        if (sgmsorted[last] != thresholdval)
-            last--;
-
-        newthresholdval = sgmsorted[min(last + 1, nn - 1)];
         if (thresholdval == newthresholdval)
         {
             /* Degenerate case; no edges (e.g., blank frame). */
@@ -167,14 +284,12 @@ edge_mark(AVPicture *dst, int dstheight,
     /* sgm is a padded matrix; dst is the unpadded matrix. */
     for (rr = 0; rr < dstheight; rr++)
     {
-        for (cc = 0; cc < dstwidth; cc++)
-        {
-            if (!rrccinrect(rr, cc, excluderow, excludecol,
-                        excludewidth, excludeheight) &&
-                    sgm[(extratop + rr) * padded_width + extraleft + cc] >=
-                        thresholdval)
-                dst->data[0][rr * dstwidth + cc] = UCHAR_MAX;
-        }
+        sgmrow = sgm + (extratop + rr) * padded_width + extraleft;
+        exclude_span(rr, dstwidth, excluderow, excludecol,
+                excludewidth, excludeheight, &x0, &x1);
+        mark(dst->data[0] + rr * dstwidth, sgmrow, x0, thresholdval);
+        mark(dst->data[0] + rr * dstwidth + x1, sgmrow + x1,
+                dstwidth - x1, thresholdval);
     }
     return 0;
 }
@@ -16,15 +16,19 @@
 
 using namespace commDetector2;
 
-PGMConverter::PGMConverter(void)
-    : frameno(-1)
-    , width(-1)
+PGMConverter::PGMConverter(int nimages)
+    : width(-1)
     , height(-1)
+    , images(nimages)
 #ifdef PGM_CONVERT_GREYSCALE
     , time_reported(false)
 #endif /* PGM_CONVERT_GREYSCALE */
 {
-    memset(&pgm, 0, sizeof(pgm));
+    for (unsigned int ii = 0; ii < images.size(); ii++)
+    {
+        images[ii].frameno = -1;
+        memset(&images[ii].pgm, 0, sizeof(images[ii].pgm));
+    }
     memset(&convert_time, 0, sizeof(convert_time));
 }
 
@@ -32,14 +36,19 @@ PGMConverter::~PGMConverter(void)
 {
     width = -1;
 #ifdef PGM_CONVERT_GREYSCALE
-    avpicture_free(&pgm);
-    memset(&pgm, 0, sizeof(pgm));
+    for (unsigned int ii = 0; ii < images.size(); ii++)
+    {
+        avpicture_free(&images[ii].pgm);
+        memset(&images[ii].pgm, 0, sizeof(images[ii].pgm));
+    }
 #endif /* PGM_CONVERT_GREYSCALE */
 }
 
 int
 PGMConverter::MythPlayerInited(const MythPlayer *player)
 {
+    QMutexLocker locker(&lock);
+
 #ifdef PGM_CONVERT_GREYSCALE
     time_reported = false;
     memset(&convert_time, 0, sizeof(convert_time));
@@ -53,12 +62,16 @@ PGMConverter::MythPlayerInited(const MythPlayer *player)
     height = buf_dim.height();
 
 #ifdef PGM_CONVERT_GREYSCALE
-    if (avpicture_alloc(&pgm, PIX_FMT_GRAY8, width, height))
+    for (unsigned int ii = 0; ii < images.size(); ii++)
     {
-        LOG(VB_COMMFLAG, LOG_ERR, QString("PGMConverter::MythPlayerInited "
-                                          "avpicture_alloc pgm (%1x%2) failed")
-                .arg(width).arg(height));
-        return -1;
+        if (avpicture_alloc(&images[ii].pgm, PIX_FMT_GRAY8, width, height))
+        {
+            LOG(VB_COMMFLAG, LOG_ERR, QString("PGMConverter::MythPlayerInited "
+                                              "avpicture_alloc pgm (%1x%2) "
+                                              "failed")
+                    .arg(width).arg(height));
+            return -1;
+        }
     }
     LOG(VB_COMMFLAG, LOG_INFO, QString("PGMConverter::MythPlayerInited "
                                        "using true greyscale conversion"));
@@ -77,9 +90,23 @@ PGMConverter::getImage(const VideoFrame *frame, long long _frameno,
 #ifdef PGM_CONVERT_GREYSCALE
     struct timeval      start, end, elapsed;
 #endif /* PGM_CONVERT_GREYSCALE */
-
-    if (frameno == _frameno)
-        goto out;
+    QMutexLocker        locker(&lock);
+    Image               *image = &images[0];
+
+    /*
+     * Frames are analyzed in order, so the image of the oldest frame is the
+     * one no analyzer is looking at any more.
+     */
+    for (unsigned int ii = 0; ii < images.size(); ii++)
+    {
+        if (images[ii].frameno == _frameno)
+        {
+            image = &images[ii];
+            goto out;
+        }
+        if (images[ii].frameno < image->frameno)
+            image = &images[ii];
+    }
 
     if (!frame->buf)
     {
@@ -87,15 +114,18 @@ PGMConverter::getImage(const VideoFrame *frame, long long _frameno,
         goto error;
     }
 
+    image->frameno = -1;
+
 #ifdef PGM_CONVERT_GREYSCALE
     (void)gettimeofday(&start, NULL);
-    if (pgm_fill(&pgm, frame))
+    if (pgm_fill(&image->pgm, frame))
         goto error;
     (void)gettimeofday(&end, NULL);
     timersub(&end, &start, &elapsed);
     timeradd(&convert_time, &elapsed, &convert_time);
 #else  /* !PGM_CONVERT_GREYSCALE */
-    if (avpicture_fill(&pgm, frame->buf, PIX_FMT_GRAY8, width, height) == -1)
+    if (avpicture_fill(&image->pgm, frame->buf, PIX_FMT_GRAY8,
+                       width, height) == -1)
     {
         LOG(VB_COMMFLAG, LOG_ERR,
             QString("PGMConverter::getImage error at frame %1 (%2x%3)")
@@ -104,12 +134,12 @@ PGMConverter::getImage(const VideoFrame *frame, long long _frameno,
     }
 #endif /* !PGM_CONVERT_GREYSCALE */
 
-    frameno = _frameno;
+    image->frameno = _frameno;
 
 out:
     *pwidth = width;
     *pheight = height;
-    return &pgm;
+    return &image->pgm;
 
 error:
     return NULL;
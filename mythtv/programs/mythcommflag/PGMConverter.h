@@ -7,6 +7,10 @@
 #ifndef __PGMCONVERTER_H__
 #define __PGMCONVERTER_H__
 
+#include <vector>
+
+#include <QMutex>
+
 extern "C" {
 #include "libavcodec/avcodec.h"    /* AVPicture */
 }
@@ -26,11 +30,16 @@ class MythPlayer;
  */
 #define PGM_CONVERT_GREYSCALE
 
+/*
+ * A converter can be shared by analyzers running on different threads. It
+ * then keeps the images of the last "nimages" frames, so an image stays
+ * valid while the other threads convert up to nimages - 1 later frames.
+ */
 class PGMConverter
 {
 public:
     /* Ctor/dtor. */
-    PGMConverter(void);
+    PGMConverter(int nimages = 1);
     ~PGMConverter(void);
 
     int MythPlayerInited(const MythPlayer *player);
@@ -39,9 +48,15 @@ public:
     int reportTime(void);
 
 private:
-    long long       frameno;            /* frame number */
+    struct Image
+    {
+        long long   frameno;            /* frame number */
+        AVPicture   pgm;                /* grayscale frame */
+    };
+
+    QMutex          lock;
     int             width, height;      /* frame dimensions */
-    AVPicture       pgm;                /* grayscale frame */
+    std::vector<Image> images;
 #ifdef PGM_CONVERT_GREYSCALE
     struct timeval  convert_time;
     bool            time_reported;
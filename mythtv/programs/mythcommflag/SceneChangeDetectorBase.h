@@ -11,7 +11,14 @@ class SceneChangeDetectorBase : public QObject
     SceneChangeDetectorBase(unsigned int w, unsigned int h) :
         width(w), height(h) {}
 
-    virtual void processFrame(unsigned char *frame) = 0;
+    /*
+     * analyzeFrame() does the work on the pixels and may run on another
+     * thread, reportFrame() emits the result on the caller's thread.
+     */
+    virtual void analyzeFrame(unsigned char *frame) = 0;
+    virtual void reportFrame(void) = 0;
+    virtual void processFrame(unsigned char *frame)
+        { analyzeFrame(frame); reportFrame(); }
 
   signals:
     void haveNewInformation(unsigned int framenum, bool scenechange,
@@ -115,6 +115,7 @@ static QMap<QString,SkipTypes> *init_skip_types(void)
     (*tmp)["d2_blank"]    = COMM_DETECT_2_BLANK;
     (*tmp)["d2_scene"]    = COMM_DETECT_2_SCENE;
     (*tmp)["d2_all"]      = COMM_DETECT_2_ALL;
+    (*tmp)["fast"]        = COMM_DETECT_FAST_BLANK;
     return tmp;
 }
 
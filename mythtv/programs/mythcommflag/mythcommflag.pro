@@ -26,6 +26,7 @@ HEADERS += HistogramAnalyzer.h
 HEADERS += BlankFrameDetector.h
 HEADERS += SceneChangeDetector.h
 HEADERS += PrePostRollFlagger.h
+HEADERS += BitstreamCommDetector.h
 
 HEADERS += LogoDetectorBase.h SceneChangeDetectorBase.h
 HEADERS += SlotRelayer.h CustomEventRelayer.h
@@ -47,6 +48,7 @@ SOURCES += HistogramAnalyzer.cpp
 SOURCES += BlankFrameDetector.cpp
 SOURCES += SceneChangeDetector.cpp
 SOURCES += PrePostRollFlagger.cpp
+SOURCES += BitstreamCommDetector.cpp
 
 SOURCES += main.cpp commandlineparser.cpp
 
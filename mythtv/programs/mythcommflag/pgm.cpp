@@ -1,8 +1,24 @@
 #include <climits>
+#include <cstring>
+
+#include "mythconfig.h"
 
 extern "C" {
 #include "libavcodec/avcodec.h"
+#include "libavutil/cpu.h"
 }
+
+/*
+ * Only where doubles are already done in SSE2 registers, so the vector
+ * convolution rounds exactly like the scalar one (x87 does not).
+ */
+#if defined(__SSE2__) && defined(__SSE2_MATH__)
+#include <emmintrin.h>
+#define PGM_SSE2 1
+#else
+#define PGM_SSE2 0
+#endif
+
 #include "frame.h"
 #include "mythlogging.h"
 #include "myth_imgconvert.h"
@@ -25,10 +41,33 @@ static enum PixelFormat pixelTypeOfVideoFrameType(VideoFrameType codec)
     return PIX_FMT_NONE;
 }
 
+int pgm_use_sse2(void)
+{
+    static int use_sse2 = -1;
+
+    if (use_sse2 < 0)
+        use_sse2 = PGM_SSE2 && (av_get_cpu_flags() & AV_CPU_FLAG_SSE2) ? 1 : 0;
+    return use_sse2;
+}
+
 int pgm_fill(AVPicture *dst, const VideoFrame *frame)
 {
     enum PixelFormat        srcfmt;
     AVPicture               src;
+    int                     rr;
+
+    if (frame->codec == FMT_YV12 && dst->linesize[0] >= frame->width)
+    {
+        /*
+         * The greyscale image is just the luma plane; copy it rather than
+         * go through swscale (which does the same copy, but serialized
+         * behind the lock in myth_sws_img_convert).
+         */
+        for (rr = 0; rr < frame->height; rr++)
+            memcpy(dst->data[0] + rr * dst->linesize[0],
+                    frame->buf + rr * frame->width, frame->width);
+        return 0;
+    }
 
     if ((srcfmt = pixelTypeOfVideoFrameType(frame->codec)) == PIX_FMT_NONE)
     {
@@ -231,6 +270,69 @@ int pgm_overlay(AVPicture *dst, const AVPicture *s1, int s1height,
     return 0;
 }
 
+static void convolve_line(unsigned char *dst, const unsigned char *src,
+                          int count, int step, const double *mask,
+                          int mask_radius)
+{
+    /* dst[cc] = sum of mask[ii + mask_radius] * src[cc + ii * step] */
+    int             ii, cc;
+    double          sum;
+
+    for (cc = 0; cc < count; cc++)
+    {
+        sum = 0;
+        for (ii = -mask_radius; ii <= mask_radius; ii++)
+            sum += mask[ii + mask_radius] * src[cc + ii * step];
+        dst[cc] = (unsigned char)(sum + 0.5);
+    }
+}
+
+#if PGM_SSE2
+static inline __m128i load4_epi32(const unsigned char *src)
+{
+    int             val;
+
+    memcpy(&val, src, sizeof(val));
+    __m128i px = _mm_unpacklo_epi8(_mm_cvtsi32_si128(val),
+            _mm_setzero_si128());
+    return _mm_unpacklo_epi16(px, _mm_setzero_si128());
+}
+
+static void convolve_line_sse2(unsigned char *dst, const unsigned char *src,
+                               int count, int step, const double *mask,
+                               int mask_radius)
+{
+    /*
+     * Four pixels at a time, two per register, accumulating in the same
+     * order as convolve_line() so the results are identical.
+     */
+    const __m128d   half = _mm_set1_pd(0.5);
+    int             ii, cc, val;
+
+    for (cc = 0; cc + 4 <= count; cc += 4)
+    {
+        __m128d lo = _mm_setzero_pd();
+        __m128d hi = _mm_setzero_pd();
+        for (ii = -mask_radius; ii <= mask_radius; ii++)
+        {
+            __m128d mm = _mm_set1_pd(mask[ii + mask_radius]);
+            __m128i px = load4_epi32(src + cc + ii * step);
+            lo = _mm_add_pd(lo, _mm_mul_pd(mm, _mm_cvtepi32_pd(px)));
+            px = _mm_shuffle_epi32(px, _MM_SHUFFLE(3, 2, 3, 2));
+            hi = _mm_add_pd(hi, _mm_mul_pd(mm, _mm_cvtepi32_pd(px)));
+        }
+        __m128i out = _mm_unpacklo_epi64(
+                _mm_cvttpd_epi32(_mm_add_pd(lo, half)),
+                _mm_cvttpd_epi32(_mm_add_pd(hi, half)));
+        out = _mm_packs_epi32(out, out);
+        out = _mm_packus_epi16(out, out);
+        val = _mm_cvtsi128_si32(out);
+        memcpy(dst + cc, &val, sizeof(val));
+    }
+    convolve_line(dst + cc, src + cc, count - cc, step, mask, mask_radius);
+}
+#endif /* PGM_SSE2 */
+
 int pgm_convolve_radial(AVPicture *dst, AVPicture *s1, AVPicture *s2,
                         const AVPicture *src, int srcheight,
                         const double *mask, int mask_radius)
@@ -251,8 +353,15 @@ int pgm_convolve_radial(AVPicture *dst, AVPicture *s1, AVPicture *s2,
     const int       srcwidth = src->linesize[0];
     const int       newwidth = srcwidth + 2 * mask_radius;
     const int       newheight = srcheight + 2 * mask_radius;
-    int             ii, rr, cc, rr2, cc2;
-    double          sum;
+    int             rr, rr2, offset;
+    void            (*convolve)(unsigned char *, const unsigned char *,
+                                int, int, const double *, int);
+
+    convolve = convolve_line;
+#if PGM_SSE2
+    if (pgm_use_sse2())
+        convolve = convolve_line_sse2;
+#endif
 
     /* Get a padded copy of the src image for use by the convolutions. */
     if (pgm_expand_uniform(s1, src, srcheight, mask_radius))
@@ -264,34 +373,19 @@ int pgm_convolve_radial(AVPicture *dst, AVPicture *s1, AVPicture *s2,
 
     /* "s1" convolve with column vector => "s2" */
     rr2 = mask_radius + srcheight;
-    cc2 = mask_radius + srcwidth;
     for (rr = mask_radius; rr < rr2; rr++)
     {
-        for (cc = mask_radius; cc < cc2; cc++)
-        {
-            sum = 0;
-            for (ii = -mask_radius; ii <= mask_radius; ii++)
-            {
-                sum += mask[ii + mask_radius] *
-                    s1->data[0][(rr + ii) * newwidth + cc];
-            }
-            s2->data[0][rr * newwidth + cc] = (unsigned char)(sum + 0.5);
-        }
+        offset = rr * newwidth + mask_radius;
+        convolve(s2->data[0] + offset, s1->data[0] + offset, srcwidth,
+                newwidth, mask, mask_radius);
     }
 
     /* "s2" convolve with row vector => "dst" */
     for (rr = mask_radius; rr < rr2; rr++)
     {
-        for (cc = mask_radius; cc < cc2; cc++)
-        {
-            sum = 0;
-            for (ii = -mask_radius; ii <= mask_radius; ii++)
-            {
-                sum += mask[ii + mask_radius] *
-                    s2->data[0][rr * newwidth + cc + ii];
-            }
-            dst->data[0][rr * newwidth + cc] = (unsigned char)(sum + 0.5);
-        }
+        offset = rr * newwidth + mask_radius;
+        convolve(dst->data[0] + offset, s2->data[0] + offset, srcwidth,
+                1, mask, mask_radius);
     }
 
     return 0;
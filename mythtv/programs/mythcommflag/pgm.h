@@ -10,6 +10,9 @@
 struct VideoFrame_;
 struct AVPicture;
 
+/* Non-zero if the SSE2 versions of the image kernels can be used. */
+int pgm_use_sse2(void);
+
 int pgm_fill(struct AVPicture *dst, const struct VideoFrame_ *frame);
 int pgm_read(unsigned char *buf, int width, int height, const char *filename);
 int pgm_write(const unsigned char *buf, int width, int height,
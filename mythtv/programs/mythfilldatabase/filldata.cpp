@@ -323,25 +323,48 @@ bool FillData::GrabDDData(Source source, int poffset,
 }
 
 // XMLTV stuff
+
+/// Stores the channels and programmes of an XMLTV file as it is parsed
+class FillDataXMLTVHandler : public XMLTVHandler
+{
+  public:
+    FillDataXMLTVHandler(FillData &filldata, int sourceid) :
+        m_filldata(filldata), m_sourceid(sourceid), m_programs(0) {}
+
+    void HandleChannels(QList<ChanInfo> &chanlist)
+    {
+        m_filldata.chan_data.handleChannels(m_sourceid, &chanlist);
+        m_filldata.icon_data.UpdateSourceIcons(m_sourceid);
+    }
+
+    void HandlePrograms(QMap<QString, QList<ProgInfo> > &proglist)
+    {
+        QMap<QString, QList<ProgInfo> >::const_iterator it = proglist.begin();
+        for (; it != proglist.end(); ++it)
+            m_programs += (*it).size();
+        m_filldata.prog_data.HandlePrograms(m_sourceid, proglist);
+    }
+
+    uint GetProgramCount(void) const { return m_programs; }
+
+  private:
+    FillData &m_filldata;
+    int       m_sourceid;
+    uint      m_programs;
+};
+
 bool FillData::GrabDataFromFile(int id, QString &filename)
 {
-    QList<ChanInfo> chanlist;
-    QMap<QString, QList<ProgInfo> > proglist;
+    FillDataXMLTVHandler handler(*this, id);
 
-    if (!xmltv_parser.parseFile(filename, &chanlist, &proglist))
+    if (!xmltv_parser.parseFile(filename, handler))
         return false;
 
-    chan_data.handleChannels(id, &chanlist);
-    icon_data.UpdateSourceIcons(id);
-    if (proglist.count() == 0)
+    if (handler.GetProgramCount() == 0)
     {
         LOG(VB_GENERAL, LOG_INFO, "No programs found in data.");
         endofdata = true;
     }
-    else
-    {
-        prog_data.HandlePrograms(id, proglist);
-    }
     return true;
 }
 
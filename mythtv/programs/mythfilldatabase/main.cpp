@@ -87,6 +87,7 @@ int main(int argc, char *argv[])
     bool from_dd_file = false;
     int sourceid = -1;
     QString fromddfile_lineupid;
+    QList<int> updated_sources;
 
     MythFillDatabaseCommandLineParser cmdline;
     if (!cmdline.Parse(argc, argv))
@@ -376,6 +377,7 @@ int main(int argc, char *argv[])
     else if (from_xawfile)
     {
         fill_data.readXawtvChannels(fromxawfile_id, fromxawfile_name);
+        updated_sources << fromxawfile_id;
     }
     else if (from_file)
     {
@@ -402,6 +404,7 @@ int main(int argc, char *argv[])
         {
             return GENERIC_EXIT_NOT_OK;
         }
+        updated_sources << fromfile_id;
 
         updateLastRunEnd(query);
 
@@ -430,6 +433,7 @@ int main(int argc, char *argv[])
     {
         fill_data.GrabDataFromDDFile(
             fromfile_id, fromfile_offset, fromfile_name, fromddfile_lineupid);
+        updated_sources << fromfile_id;
     }
     else
     {
@@ -494,6 +498,10 @@ int main(int argc, char *argv[])
             LOG(VB_GENERAL, LOG_ERR, "Failed to fetch some program info");
         else
             LOG(VB_GENERAL, LOG_NOTICE, "Data fetching complete.");
+
+        SourceList::const_iterator it = sourcelist.begin();
+        for (; it != sourcelist.end(); ++it)
+            updated_sources << (*it).id;
     }
 
     if (fill_data.only_update_channels && !fill_data.need_post_grab_proc)
@@ -768,7 +776,19 @@ int main(int argc, char *argv[])
             "| the master backend is restarted.                            |\n"
             "===============================================================");
 
-    if (grab_data || mark_repeats)
+    // Marking repeats and first/last showings can change listings on any
+    // source, which needs a complete match. Only an incremental scheduler
+    // is asked to match just the sources we fetched listings for, flags
+    // changed on other sources are then picked up by its next full match.
+    if (grab_data && !updated_sources.empty() &&
+        gCoreContext->GetNumSetting("SchedIncremental", 0))
+    {
+        QList<int>::const_iterator it = updated_sources.begin();
+        for (; it != updated_sources.end(); ++it)
+            ScheduledRecording::RescheduleMatch(0, *it, 0, QDateTime(),
+                                                "MythFillDatabase");
+    }
+    else if (grab_data || mark_repeats)
         ScheduledRecording::RescheduleMatch(0, 0, 0, QDateTime(),
                                             "MythFillDatabase");
 
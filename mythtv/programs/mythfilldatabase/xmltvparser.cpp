@@ -4,7 +4,9 @@
 #include <QFile>
 #include <QStringList>
 #include <QDateTime>
+#include <QSet>
 #include <QDomDocument>
+#include <QXmlStreamReader>
 #include <QUrl>
 
 // C++ headers
@@ -25,6 +27,9 @@
 #include "channeldata.h"
 #include "fillutil.h"
 
+/// Number of programmes of finished channels passed on together
+static const uint kHandleProgramsBatch = 5000;
+
 XMLTVParser::XMLTVParser() : isJapan(false), current_year(0)
 {
     current_year = MythDate::current().date().toString("yyyy").toUInt();
@@ -581,34 +586,109 @@ ProgInfo *XMLTVParser::parseProgram(
     return pginfo;
 }
 
-bool XMLTVParser::parseFile(
-    QString filename, QList<ChanInfo> *chanlist,
-    QMap<QString, QList<ProgInfo> > *proglist)
+/// Reads the current element and its children into a DOM element
+static QDomElement readElement(QXmlStreamReader &xml, QDomDocument &doc)
 {
-    QDomDocument doc;
-    QFile f;
+    QDomElement element = doc.createElement(xml.name().toString());
 
-    if (!dash_open(f, filename, QIODevice::ReadOnly))
+    QXmlStreamAttributes attrs = xml.attributes();
+    for (int i = 0; i < attrs.size(); i++)
     {
-        LOG(VB_GENERAL, LOG_ERR,
-            QString("Error unable to open '%1' for reading.") .arg(filename));
-        return false;
+        element.setAttribute(attrs[i].name().toString(),
+                             attrs[i].value().toString());
     }
 
-    QString errorMsg = "unknown";
-    int errorLine = 0;
-    int errorColumn = 0;
-
-    if (!doc.setContent(&f, &errorMsg, &errorLine, &errorColumn))
+    while (!xml.atEnd())
     {
-        LOG(VB_GENERAL, LOG_ERR, QString("Error in %1:%2: %3")
-            .arg(errorLine).arg(errorColumn).arg(errorMsg));
+        xml.readNext();
+        if (xml.isStartElement())
+        {
+            element.appendChild(readElement(xml, doc));
+        }
+        else if (xml.isCharacters() && !xml.isWhitespace())
+        {
+            // QDomDocument merges adjacent text, so do the same here
+            QDomText last = element.lastChild().toText();
+            if (!last.isNull())
+                last.appendData(xml.text().toString());
+            else
+                element.appendChild(doc.createTextNode(xml.text().toString()));
+        }
+        else if (xml.isEndElement())
+        {
+            break;
+        }
+    }
 
-        f.close();
-        return true;
+    return element;
+}
+
+/** \brief Checks whether the programmes of an XMLTV file can be handed
+ *         over while the file is read.
+ *
+ *   That's the case when the file is well formed, all channels come
+ *   before the first programme and the programmes are grouped by channel.
+ *   Only the element names and the channel attributes are looked at.
+ */
+static bool can_stream(QIODevice &dev)
+{
+    QXmlStreamReader xml(&dev);
+
+    if (!xml.readNextStartElement())
+        return false;
+
+    bool programmes = false;
+    QString last_channel;
+    QSet<QString> seen_channels;
+
+    while (xml.readNextStartElement())
+    {
+        if (xml.name() == "channel")
+        {
+            if (programmes)
+                return false;
+        }
+        else if (xml.name() == "programme")
+        {
+            programmes = true;
+            QString channel = xml.attributes().value("channel").toString();
+            if (channel != last_channel)
+            {
+                if (seen_channels.contains(channel))
+                    return false;
+                seen_channels.insert(channel);
+                last_channel = channel;
+            }
+        }
+        xml.skipCurrentElement();
     }
 
-    f.close();
+    return !xml.hasError();
+}
+
+/** \brief Parses an XMLTV file and passes its contents to a handler.
+ *
+ *   The file is read with QXmlStreamReader, and only one channel or
+ *   programme element at a time is turned into a DOM tree for
+ *   parseChannel() and parseProgram().
+ *
+ *   If a quick first pass over the file shows that it is well formed,
+ *   lists all channels first and has its programmes grouped by channel,
+ *   the programmes are passed on as soon as the file moves on to the next
+ *   channel, so memory use does not grow with the size of the listings.
+ *   Otherwise, and when reading from a pipe, everything is passed on at
+ *   the end, and nothing at all if the file turns out to be broken.
+ */
+bool XMLTVParser::parseFile(QString filename, XMLTVHandler &handler)
+{
+    QFile f;
+
+    if (!dash_open(f, filename, QIODevice::ReadOnly))
+    {
+        LOG(VB_GENERAL, LOG_ERR,
+            QString("Error unable to open '%1' for reading.") .arg(filename));
+        return false;
+    }
 
     // now we calculate the localTimezoneOffset, so that we can fix
     // the programdata if needed
@@ -632,11 +712,33 @@ bool XMLTVParser::parseFile(
         }
     }
 
-    QDomElement docElem = doc.documentElement();
+    bool stream = false;
+    if (!f.isSequential())
+    {
+        stream = can_stream(f);
+        f.reset();
+        if (!stream)
+        {
+            LOG(VB_XMLTV, LOG_INFO, QString("%1 is not grouped by channel, "
+                "reading all of it before handling it").arg(filename));
+        }
+    }
 
-    QUrl baseUrl(docElem.attribute("source-data-url", ""));
+    QXmlStreamReader xml(&f);
+
+    if (!xml.readNextStartElement())
+    {
+        LOG(VB_GENERAL, LOG_ERR, QString("Error in %1:%2: %3")
+            .arg(xml.lineNumber()).arg(xml.columnNumber())
+            .arg(xml.errorString()));
 
-    QUrl sourceUrl(docElem.attribute("source-info-url", ""));
+        f.close();
+        return true;
+    }
+
+    QUrl baseUrl(xml.attributes().value("source-data-url").toString());
+
+    QUrl sourceUrl(xml.attributes().value("source-info-url").toString());
     if (sourceUrl.toString() == "http://labs.zap2it.com/")
     {
         LOG(VB_GENERAL, LOG_ERR, "Don't use tv_grab_na_dd, use the"
@@ -649,86 +751,143 @@ bool XMLTVParser::parseFile(
     QString groupingTitle;
     QString groupingDesc;
 
-    QDomNode n = docElem.firstChild();
-    while (!n.isNull())
+    QList<ChanInfo> chanlist;
+    bool channels_handled = false;
+
+    // Programmes of the channel being read, and of channels that are
+    // finished but not yet handed over
+    QMap<QString, QList<ProgInfo> > proglist;
+    QMap<QString, QList<ProgInfo> > donelist;
+    uint done_count = 0;
+    QString last_channel;
+
+    QDomDocument doc;
+
+    while (xml.readNextStartElement())
     {
-        QDomElement e = n.toElement();
-        if (!e.isNull())
+        if (xml.name() == "channel")
         {
-            if (e.tagName() == "channel")
+            QDomElement e = readElement(xml, doc);
+            ChanInfo *chinfo = parseChannel(e, baseUrl);
+            chanlist.push_back(*chinfo);
+            delete chinfo;
+            continue;
+        }
+
+        if (xml.name() != "programme")
+        {
+            xml.skipCurrentElement();
+            continue;
+        }
+
+        if (stream && !channels_handled)
+        {
+            handler.HandleChannels(chanlist);
+            chanlist.clear();
+            channels_handled = true;
+        }
+
+        QDomElement e = readElement(xml, doc);
+        ProgInfo *pginfo = parseProgram(e, localTimezoneOffset);
+
+        if (stream && pginfo->channel != last_channel)
+        {
+            if (!last_channel.isEmpty() && proglist.contains(last_channel))
             {
-                ChanInfo *chinfo = parseChannel(e, baseUrl);
-                chanlist->push_back(*chinfo);
-                delete chinfo;
+                done_count += proglist[last_channel].size();
+                donelist[last_channel] = proglist.take(last_channel);
+                if (done_count >= kHandleProgramsBatch)
+                {
+                    handler.HandlePrograms(donelist);
+                    donelist.clear();
+                    done_count = 0;
+                }
             }
-            else if (e.tagName() == "programme")
-            {
-                ProgInfo *pginfo = parseProgram(e, localTimezoneOffset);
+            last_channel = pginfo->channel;
+        }
 
-                if (pginfo->startts == pginfo->endts)
-                {
-                    /* Not a real program : just a grouping marker */
-                    if (!pginfo->title.isEmpty())
-                        groupingTitle = pginfo->title + " : ";
+        if (pginfo->startts == pginfo->endts)
+        {
+            /* Not a real program : just a grouping marker */
+            if (!pginfo->title.isEmpty())
+                groupingTitle = pginfo->title + " : ";
 
-                    if (!pginfo->description.isEmpty())
-                        groupingDesc = pginfo->description + " : ";
-                }
-                else
+            if (!pginfo->description.isEmpty())
+                groupingDesc = pginfo->description + " : ";
+        }
+        else
+        {
+            if (pginfo->clumpidx.isEmpty())
+            {
+                if (!groupingTitle.isEmpty())
                 {
-                    if (pginfo->clumpidx.isEmpty())
-                    {
-                        if (!groupingTitle.isEmpty())
-                        {
-                            pginfo->title.prepend(groupingTitle);
-                            groupingTitle.clear();
-                        }
+                    pginfo->title.prepend(groupingTitle);
+                    groupingTitle.clear();
+                }
 
-                        if (!groupingDesc.isEmpty())
-                        {
-                            pginfo->description.prepend(groupingDesc);
-                            groupingDesc.clear();
-                        }
+                if (!groupingDesc.isEmpty())
+                {
+                    pginfo->description.prepend(groupingDesc);
+                    groupingDesc.clear();
+                }
 
-                        (*proglist)[pginfo->channel].push_back(*pginfo);
-                    }
-                    else
-                    {
-                        /* append all titles/descriptions from one clump */
-                        if (pginfo->clumpidx.toInt() == 0)
-                        {
-                            aggregatedTitle.clear();
-                            aggregatedDesc.clear();
-                        }
+                proglist[pginfo->channel].push_back(*pginfo);
+            }
+            else
+            {
+                /* append all titles/descriptions from one clump */
+                if (pginfo->clumpidx.toInt() == 0)
+                {
+                    aggregatedTitle.clear();
+                    aggregatedDesc.clear();
+                }
 
-                        if (!pginfo->title.isEmpty())
-                        {
-                            if (!aggregatedTitle.isEmpty())
-                                aggregatedTitle.append(" | ");
-                            aggregatedTitle.append(pginfo->title);
-                        }
+                if (!pginfo->title.isEmpty())
+                {
+                    if (!aggregatedTitle.isEmpty())
+                        aggregatedTitle.append(" | ");
+                    aggregatedTitle.append(pginfo->title);
+                }
 
-                        if (!pginfo->description.isEmpty())
-                        {
-                            if (!aggregatedDesc.isEmpty())
-                                aggregatedDesc.append(" | ");
-                            aggregatedDesc.append(pginfo->description);
-                        }
-                        if (pginfo->clumpidx.toInt() ==
-                            pginfo->clumpmax.toInt() - 1)
-                        {
-                            pginfo->title = aggregatedTitle;
-                            pginfo->description = aggregatedDesc;
-                            (*proglist)[pginfo->channel].push_back(*pginfo);
-                        }
-                    }
+                if (!pginfo->description.isEmpty())
+                {
+                    if (!aggregatedDesc.isEmpty())
+                        aggregatedDesc.append(" | ");
+                    aggregatedDesc.append(pginfo->description);
+                }
+                if (pginfo->clumpidx.toInt() ==
+                    pginfo->clumpmax.toInt() - 1)
+                {
+                    pginfo->title = aggregatedTitle;
+                    pginfo->description = aggregatedDesc;
+                    proglist[pginfo->channel].push_back(*pginfo);
                 }
-                delete pginfo;
             }
         }
-        n = n.nextSibling();
+        delete pginfo;
     }
 
+    f.close();
+
+    if (xml.hasError())
+    {
+        LOG(VB_GENERAL, LOG_ERR, QString("Error in %1:%2: %3")
+            .arg(xml.lineNumber()).arg(xml.columnNumber())
+            .arg(xml.errorString()));
+
+        // When streaming this only happens if the file changed since the
+        // first pass, and what was handed over so far can't be taken back.
+        return true;
+    }
+
+    if (!channels_handled)
+        handler.HandleChannels(chanlist);
+
+    if (!donelist.empty())
+        handler.HandlePrograms(donelist);
+
+    if (!proglist.empty())
+        handler.HandlePrograms(proglist);
+
     return true;
 }
-
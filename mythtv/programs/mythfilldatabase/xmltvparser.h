@@ -11,6 +11,18 @@ class ChanInfo;
 class QUrl;
 class QDomElement;
 
+/// Receives the data of an XMLTV file while XMLTVParser reads it
+class XMLTVHandler
+{
+  public:
+    virtual ~XMLTVHandler() {}
+
+    /// Called once with all channels, before any programmes
+    virtual void HandleChannels(QList<ChanInfo> &chanlist) = 0;
+    /// Called with the programmes of one or more channels
+    virtual void HandlePrograms(QMap<QString, QList<ProgInfo> > &proglist) = 0;
+};
+
 class XMLTVParser
 {
   public:
@@ -18,9 +30,7 @@ class XMLTVParser
 
     ChanInfo *parseChannel(QDomElement &element, QUrl &baseUrl);
     ProgInfo *parseProgram(QDomElement &element, int localTimezoneOffset);
-    bool parseFile(
-        QString filename, QList<ChanInfo> *chanlist,
-        QMap<QString, QList<ProgInfo> > *proglist);
+    bool parseFile(QString filename, XMLTVHandler &handler);
 
 
   public:
@@ -2285,6 +2285,32 @@ static GlobalCheckBox *GRSchedMoveHigher()
     return bc;
 }
 
+static GlobalCheckBox *GRSchedIncremental()
+{
+    GlobalCheckBox *bc = new GlobalCheckBox("SchedIncremental");
+    bc->setLabel(QObject::tr("Incremental rescheduling"));
+    bc->setHelpText(QObject::tr("Reuse the matching programs of recording "
+                    "rules not affected by a change instead of reloading "
+                    "them all from the database on every reschedule. This "
+                    "makes rescheduling faster on systems with many rules "
+                    "and tuners. Everything is still reloaded at least "
+                    "once an hour."));
+    bc->setValue(false);
+    return bc;
+}
+
+static GlobalSpinBox *GRSchedBulkDelay()
+{
+    GlobalSpinBox *bs = new GlobalSpinBox("SchedBulkDelay", 0, 300, 5);
+    bs->setLabel(QObject::tr("Guide update reschedule delay (secs)"));
+    bs->setHelpText(QObject::tr("Reschedules requested by guide data updates "
+                    "are held back this long so that several updates can be "
+                    "handled in one pass. Changes made by users are always "
+                    "handled right away."));
+    bs->setValue(10);
+    return bs;
+}
+
 static GlobalComboBox *GRSchedOpenEnd()
 {
     GlobalComboBox *bc = new GlobalComboBox("SchedOpenEnd");
@@ -3541,6 +3567,8 @@ GeneralRecPrioritiesSettings::GeneralRecPrioritiesSettings()
     sched->setLabel(QObject::tr("Scheduler Options"));
 
     sched->addChild(GRSchedMoveHigher());
+    sched->addChild(GRSchedIncremental());
+    sched->addChild(GRSchedBulkDelay());
     sched->addChild(GRSchedOpenEnd());
     sched->addChild(GRPrefInputRecPriority());
     sched->addChild(GRHDTVRecPriority());
@@ -6,6 +6,7 @@
 
 #include <QCoreApplication>
 #include <QRunnable>
+#include <QMap>
 
 #include "programinfocache.h"
 #include "mthreadpool.h"
@@ -27,6 +28,62 @@ static void free_vec(VPI_ptr &v)
     }
 }
 
+// The last recording list received from the backend. This outlives the
+// ProgramInfoCache instances so that reopening the recordings screen only
+// transfers the recordings which changed since it was last loaded.
+static QMutex                    s_synced_lock;
+static QMap<QString,ProgramInfo> s_synced;
+static uint                      s_synced_epoch      = 0;
+static uint                      s_synced_generation = 0;
+
+/** \brief Brings the local copy of the backend's recording list up to date
+ *         and returns a copy of it, or NULL if the backend can't be reached.
+ */
+static VPI_ptr load_synced_list(void)
+{
+    QMutexLocker locker(&s_synced_lock);
+
+    uint epoch      = s_synced_epoch;
+    uint generation = s_synced_generation;
+    bool full       = false;
+    vector<ProgramInfo*> changed;
+    QStringList removed;
+
+    if (!RemoteGetRecordingsSince(epoch, generation, full, changed, removed))
+        return NULL;
+
+    if (full)
+        s_synced.clear();
+
+    QStringList::const_iterator rit = removed.begin();
+    for (; rit != removed.end(); ++rit)
+        s_synced.remove(*rit);
+
+    vector<ProgramInfo*>::iterator cit = changed.begin();
+    for (; cit != changed.end(); ++cit)
+    {
+        s_synced[(*cit)->MakeUniqueKey()] = **cit;
+        delete *cit;
+    }
+
+    LOG(VB_GENERAL, LOG_DEBUG,
+        QString("Recording list %1 from generation %2 to %3: "
+                "%4 changed, %5 removed")
+            .arg(full ? "loaded" : "updated").arg(s_synced_generation)
+            .arg(generation).arg(changed.size()).arg(removed.size()));
+
+    s_synced_epoch      = epoch;
+    s_synced_generation = generation;
+
+    VPI_ptr list = new vector<ProgramInfo*>;
+    list->reserve(s_synced.size());
+    QMap<QString,ProgramInfo>::const_iterator it = s_synced.begin();
+    for (; it != s_synced.end(); ++it)
+        list->push_back(new ProgramInfo(*it));
+
+    return list;
+}
+
 class ProgramInfoLoader : public QRunnable
 {
   public:
@@ -78,9 +135,9 @@ void ProgramInfoCache::Load(const bool updateUI)
 
     locker.unlock();
     /**/
-    // Get an unsorted list (sort = 0) from RemoteGetRecordedList
-    // we sort the list later anyway.
-    vector<ProgramInfo*> *tmp = RemoteGetRecordedList(0);
+    // Get an unsorted list, updated with just the changes since the last
+    // load, we sort the list later anyway.
+    vector<ProgramInfo*> *tmp = load_synced_list();
     /**/
     locker.relock();
 
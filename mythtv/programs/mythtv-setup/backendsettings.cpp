@@ -193,6 +193,20 @@ static HostCheckBox *TruncateDeletes()
     return hc;
 };
 
+static HostCheckBox *RecordWithDirectIO()
+{
+    HostCheckBox *hc = new HostCheckBox("RecordWithDirectIO");
+    hc->setLabel(QObject::tr("Write recordings with direct I/O"));
+    hc->setValue(false);
+    hc->setHelpText(QObject::tr("If enabled, recordings made on this backend "
+                    "are queued in a preallocated lock-free buffer and "
+                    "written bypassing the operating system's file cache "
+                    "where the filesystem allows it. This helps backends "
+                    "with many simultaneous recordings, but Live TV and "
+                    "in-progress playback will have to read from disk."));
+    return hc;
+};
+
 static GlobalCheckBox *DeletesFollowLinks()
 {
     GlobalCheckBox *gc = new GlobalCheckBox("DeletesFollowLinks");
@@ -204,6 +218,21 @@ static GlobalCheckBox *DeletesFollowLinks()
     return gc;
 };
 
+static GlobalCheckBox *SeekIndexFiles()
+{
+    GlobalCheckBox *gc = new GlobalCheckBox("SeekIndexFiles");
+    gc->setLabel(QObject::tr("Write seek index files"));
+    gc->setValue(false);
+    gc->setHelpText(QObject::tr("If enabled, the seek table of each new "
+                    "recording is also written to a compact file next to "
+                    "it. Players with local access to the recording load "
+                    "it from there rather than from the database, which "
+                    "makes opening long recordings much quicker. Use "
+                    "'mythutil --buildseekindex' to convert existing "
+                    "recordings."));
+    return gc;
+};
+
 static GlobalSpinBox *HDRingbufferSize()
 {
     GlobalSpinBox *bs = new GlobalSpinBox(
@@ -589,6 +618,32 @@ static HostSpinBox *JobQueueCheckFrequency()
     return gc;
 };
 
+static HostSpinBox *JobQueueMaxCPULoad()
+{
+    HostSpinBox *gc = new HostSpinBox("JobQueueMaxCPULoad", 0, 200, 5);
+    gc->setLabel(QObject::tr("Maximum CPU load for new jobs (%)"));
+    gc->setHelpText(QObject::tr("If set, no further job is started on this "
+                    "backend while its load average is above this "
+                    "percentage of its CPUs, even if fewer than the maximum "
+                    "number of simultaneous jobs are running. "
+                    "Set to 0 to disable."));
+    gc->setValue(0);
+    return gc;
+};
+
+static GlobalCheckBox *JobQueueWakeOnEvents()
+{
+    GlobalCheckBox *gc = new GlobalCheckBox("JobQueueWakeOnEvents");
+    gc->setLabel(QObject::tr("Start jobs as soon as they are queued"));
+    gc->setHelpText(QObject::tr("If enabled, the Job Queue on each backend "
+                    "is told when a job is queued or finishes, and only "
+                    "checks the queue every five minutes otherwise. If "
+                    "disabled, the queue is checked at the frequency "
+                    "set for each backend."));
+    gc->setValue(true);
+    return gc;
+};
+
 static HostComboBox *JobQueueCPU()
 {
     HostComboBox *gc = new HostComboBox("JobQueueCPU");
@@ -778,6 +833,43 @@ static GlobalComboBox *UPNPWmpSource()
     return gc;
 };
 
+static HostCheckBox *VideoScanWatch()
+{
+    HostCheckBox *gc = new HostCheckBox("VideoScanWatch");
+    gc->setLabel(QObject::tr("Watch video directories for changes"));
+    gc->setValue(false);
+    gc->setHelpText(QObject::tr("If enabled, this backend watches the "
+                    "directories of its Videos storage group and adds "
+                    "or removes videos as files change, without a "
+                    "manual video scan. Takes effect when the backend "
+                    "is restarted."));
+    return gc;
+};
+
+static HostSpinBox *VideoScanReconcileInterval()
+{
+    HostSpinBox *gc = new HostSpinBox("VideoScanReconcileInterval",
+                                      0, 1440, 15);
+    gc->setLabel(QObject::tr("Video directory check interval (mins)"));
+    gc->setValue(60);
+    gc->setHelpText(QObject::tr("Changes made by other machines to a "
+                    "network file system are not reported to the "
+                    "watching backend. The directories are checked for "
+                    "them this often. Set to 0 to disable."));
+    return gc;
+};
+
+static HostSpinBox *VideoScanThreads()
+{
+    HostSpinBox *gc = new HostSpinBox("VideoScanThreads", 1, 16, 1);
+    gc->setLabel(QObject::tr("Video scan threads"));
+    gc->setValue(4);
+    gc->setHelpText(QObject::tr("Number of video directories a full video "
+                    "scan started by this backend lists at the same "
+                    "time."));
+    return gc;
+};
+
 static GlobalCheckBox *MythFillEnabled()
 {
     GlobalCheckBox *bc = new GlobalCheckBox("MythFillEnabled");
@@ -814,6 +906,18 @@ static GlobalSpinBox *MythFillMaxHour()
     return bs;
 }
 
+static GlobalSpinBox *MythFillImportThreads()
+{
+    GlobalSpinBox *bs = new GlobalSpinBox("MythFillImportThreads", 1, 16, 1);
+    bs->setLabel(QObject::tr("Guide data import threads"));
+    bs->setValue(1);
+    bs->setHelpText(QObject::tr("Number of channels whose guide data is "
+                    "written to the database at the same time. Values "
+                    "above one can shorten a full listings refresh "
+                    "considerably on a multi-core database server."));
+    return bs;
+}
+
 static GlobalCheckBox *MythFillGrabberSuggestsTime()
 {
     GlobalCheckBox *bc = new GlobalCheckBox("MythFillGrabberSuggestsTime");
@@ -868,6 +972,7 @@ class MythFillSettings : public TriggeredConfigurationGroup
          settings->addChild(MythFillMinHour());
          settings->addChild(MythFillMaxHour());
          settings->addChild(MythFillGrabberSuggestsTime());
+         settings->addChild(MythFillImportThreads());
          addTarget("1", settings);
 
          // show nothing if fillEnabled is off
@@ -932,6 +1037,8 @@ BackendSettings::BackendSettings() {
     fmh1->addChild(DeletesFollowLinks());
     fmh1->addChild(TruncateDeletes());
     fm->addChild(fmh1);
+    fm->addChild(RecordWithDirectIO());
+    fm->addChild(SeekIndexFiles());
     fm->addChild(HDRingbufferSize());
     fm->addChild(StorageScheduler());
     group2->addChild(fm);
@@ -952,6 +1059,13 @@ BackendSettings::BackendSettings() {
     group2a1->addChild(EITCrawIdleStart());
     addChild(group2a1);
 
+    VerticalConfigurationGroup* group2a2 = new VerticalConfigurationGroup(false);
+    group2a2->setLabel(QObject::tr("Video Scanning (Backend-Specific)"));
+    group2a2->addChild(VideoScanWatch());
+    group2a2->addChild(VideoScanReconcileInterval());
+    group2a2->addChild(VideoScanThreads());
+    addChild(group2a2);
+
     VerticalConfigurationGroup* group3 = new VerticalConfigurationGroup(false);
     group3->setLabel(QObject::tr("Shutdown/Wakeup Options"));
     group3->addChild(startupCommand());
@@ -991,6 +1105,7 @@ BackendSettings::BackendSettings() {
     VerticalConfigurationGroup* group5 = new VerticalConfigurationGroup(false);
     group5->setLabel(QObject::tr("Job Queue (Backend-Specific)"));
     group5->addChild(JobQueueMaxSimultaneousJobs());
+    group5->addChild(JobQueueMaxCPULoad());
     group5->addChild(JobQueueCheckFrequency());
 
     HorizontalConfigurationGroup* group5a =
@@ -1018,6 +1133,7 @@ BackendSettings::BackendSettings() {
     VerticalConfigurationGroup* group6 = new VerticalConfigurationGroup(false);
     group6->setLabel(QObject::tr("Job Queue (Global)"));
     group6->addChild(JobsRunOnRecordHost());
+    group6->addChild(JobQueueWakeOnEvents());
     group6->addChild(AutoCommflagWhileRecording());
     group6->addChild(JobQueueCommFlagCommand());
     group6->addChild(JobQueueTranscodeCommand());
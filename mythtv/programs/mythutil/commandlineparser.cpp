@@ -63,6 +63,14 @@ void MythUtilCommandLineParser::LoadArguments(void)
                 "Clear the commercial skip list.", "")
                 ->SetGroup("Recording Markup")
                 ->SetRequiredChild(QStringList("chanid") << "starttime")
+        << add("--buildseekindex", "buildseekindex", false,
+                "Write seek index files for recordings stored on this host.",
+                "Copies the seek table of each recording from the database "
+                "into a seek index file next to it, which is then used in "
+                "preference to the database. Use --chanid and --starttime "
+                "to convert a single recording.")
+                ->SetGroup("Recording Markup")
+                ->SetChild(QStringList("chanid") << "starttime")
 
         // backendutils.cpp
         << add("--resched", "resched", false,
@@ -4,6 +4,9 @@
 // libmyth* includes
 #include "exitcodes.h"
 #include "mythlogging.h"
+#include "seekindexfile.h"
+#include "mythdb.h"
+#include "mythcorecontext.h"
 
 // Local includes
 #include "markuputils.h"
@@ -166,6 +169,87 @@ static int ClearSkipList(const MythUtilCommandLineParser &cmdline)
     return SetMarkupList(cmdline, QString("skiplist"), QString(""));
 }
 
+/// Copies the recordedseek rows of a recording into its seek index file
+static bool BuildSeekIndex(ProgramInfo &pginfo)
+{
+    QString path = pginfo.GetPlaybackURL(false, true);
+    if (SeekIndexFile::PathFor(path).isEmpty())
+    {
+        LOG(VB_GENERAL, LOG_INFO, QString("Skipping %1, not stored locally")
+                .arg(pginfo.GetBasename()));
+        return true;
+    }
+
+    MSqlQuery query(MSqlQuery::InitCon());
+    query.prepare("SELECT type, mark, offset FROM recordedseek"
+                  " WHERE chanid = :CHANID"
+                  " AND starttime = :STARTTIME ;");
+    query.bindValue(":CHANID", pginfo.GetChanID());
+    query.bindValue(":STARTTIME", pginfo.GetRecordingStartTime());
+
+    if (!query.exec())
+    {
+        MythDB::DBError("BuildSeekIndex", query);
+        return false;
+    }
+
+    pos_map_by_type_t maps;
+    uint count = 0;
+    while (query.next())
+    {
+        maps[(MarkTypes)query.value(0).toInt()]
+            [query.value(1).toULongLong()] = query.value(2).toULongLong();
+        count++;
+    }
+
+    if (!SeekIndexFile::Write(path, maps))
+    {
+        LOG(VB_GENERAL, LOG_ERR, QString("Could not write seek index for %1")
+                .arg(path));
+        return false;
+    }
+
+    LOG(VB_GENERAL, LOG_INFO, QString("Wrote %1 entries to %2")
+            .arg(count).arg(SeekIndexFile::PathFor(path)));
+    return true;
+}
+
+static int BuildSeekIndexes(const MythUtilCommandLineParser &cmdline)
+{
+    if (cmdline.toBool("chanid"))
+    {
+        ProgramInfo pginfo;
+        if (!GetProgramInfo(cmdline, pginfo))
+            return GENERIC_EXIT_NO_RECORDING_DATA;
+        return BuildSeekIndex(pginfo) ? GENERIC_EXIT_OK : GENERIC_EXIT_NOT_OK;
+    }
+
+    MSqlQuery query(MSqlQuery::InitCon());
+    query.prepare("SELECT chanid, starttime FROM recorded"
+                  " WHERE hostname = :HOSTNAME ;");
+    query.bindValue(":HOSTNAME", gCoreContext->GetHostName());
+
+    if (!query.exec())
+    {
+        MythDB::DBError("BuildSeekIndexes", query);
+        return GENERIC_EXIT_DB_ERROR;
+    }
+
+    uint failed = 0;
+    while (query.next())
+    {
+        ProgramInfo pginfo(query.value(0).toUInt(),
+                           MythDate::as_utc(query.value(1).toDateTime()));
+        if (!pginfo.GetChanID() || !BuildSeekIndex(pginfo))
+            failed++;
+    }
+
+    cout << QString("Built seek indexes for %1 recordings, %2 failed\n")
+        .arg(query.size() - failed).arg(failed).toLocal8Bit().constData();
+
+    return failed ? GENERIC_EXIT_NOT_OK : GENERIC_EXIT_OK;
+}
+
 void registerMarkupUtils(UtilMap &utilMap)
 {
     utilMap["gencutlist"]             = &CopySkipListToCutList;
@@ -175,6 +259,7 @@ void registerMarkupUtils(UtilMap &utilMap)
     utilMap["getskiplist"]            = &GetSkipList;
     utilMap["setskiplist"]            = &SetSkipList;
     utilMap["clearskiplist"]          = &ClearSkipList;
+    utilMap["buildseekindex"]         = &BuildSeekIndexes;
 }
 
 /* vim: set expandtab tabstop=4 shiftwidth=4: */